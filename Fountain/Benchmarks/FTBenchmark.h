@@ -0,0 +1,51 @@
+//
+//  FTBenchmark.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 07.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+typedef NS_ENUM(NSUInteger, FTBenchmarkOutputFormat) {
+    FTBenchmarkOutputFormatJSON,
+    FTBenchmarkOutputFormatCSV
+};
+
+/*! <code>FTBenchmark</code> runs the scenarios of the benchmark tool and writes one record
+    per scenario to the standard output, either as a JSON object per line or as CSV.
+
+    A record contains the number of operations, the elapsed time, the operations per second,
+    the growth of the heap (number of blocks and bytes still allocated after the scenario),
+    the peak resident memory of the process so far and the number of callbacks received by
+    the observers of the scenario. The number of allocated blocks is only available on
+    Darwin and reported as <code>null</code> (or empty in CSV) otherwise.
+ */
+@interface FTBenchmark : NSObject
+
+#pragma mark Life-cycle
+- (instancetype)initWithOutputFormat:(FTBenchmarkOutputFormat)outputFormat;
+
+#pragma mark Output Format
+@property (nonatomic, readonly) FTBenchmarkOutputFormat outputFormat;
+
+#pragma mark Filter
+
+// Only scenarios, whose name contains the filter, are run. Defaults to nil (all scenarios).
+@property (nonatomic, copy) NSString *filter;
+
+#pragma mark Measuring
+
+// Runs the block once inside of an autorelease pool. The block returns the number of
+// operations it has performed. The callbacks of the observers are counted from the
+// start of the block.
+- (void)measureScenario:(NSString *)scenario
+                subject:(NSString *)subject
+                   size:(NSUInteger)size
+              observers:(NSArray *)observers
+                  block:(NSUInteger (^)(void))block;
+
+- (BOOL)shouldRunScenario:(NSString *)scenario subject:(NSString *)subject;
+
+@end
@@ -0,0 +1,179 @@
+//
+//  FTBenchmark.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 07.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#include <sys/resource.h>
+#include <time.h>
+
+#if __APPLE__
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+#import "FTBenchmarkObserver.h"
+
+#import "FTBenchmark.h"
+
+typedef struct {
+    long long blocks;
+    long long bytes;
+} FTBenchmarkHeap;
+
+static double FTBenchmarkTime(void);
+static FTBenchmarkHeap FTBenchmarkHeapInUse(void);
+static long long FTBenchmarkPeakMemory(void);
+
+@implementation FTBenchmark {
+    BOOL _didWriteHeader;
+}
+
+#pragma mark Life-cycle
+
+- (instancetype)initWithOutputFormat:(FTBenchmarkOutputFormat)outputFormat
+{
+    self = [super init];
+    if (self) {
+        _outputFormat = outputFormat;
+    }
+    return self;
+}
+
+#pragma mark Measuring
+
+- (BOOL)shouldRunScenario:(NSString *)scenario subject:(NSString *)subject
+{
+    if (_filter == nil) {
+        return YES;
+    }
+    NSString *name = [NSString stringWithFormat:@"%@.%@", subject, scenario];
+    return [name rangeOfString:_filter].location != NSNotFound;
+}
+
+- (void)measureScenario:(NSString *)scenario
+                subject:(NSString *)subject
+                   size:(NSUInteger)size
+              observers:(NSArray *)observers
+                  block:(NSUInteger (^)(void))block
+{
+    if ([self shouldRunScenario:scenario subject:subject] == NO) {
+        return;
+    }
+
+    for (FTBenchmarkObserver *observer in observers) {
+        [observer reset];
+    }
+
+    FTBenchmarkHeap heapBefore = FTBenchmarkHeapInUse();
+    double start = FTBenchmarkTime();
+
+    NSUInteger numberOfOperations = 0;
+    @autoreleasepool {
+        numberOfOperations = block();
+    }
+
+    double duration = FTBenchmarkTime() - start;
+    FTBenchmarkHeap heapAfter = FTBenchmarkHeapInUse();
+
+    NSUInteger numberOfCallbacks = 0;
+    for (FTBenchmarkObserver *observer in observers) {
+        numberOfCallbacks += observer.numberOfCallbacks;
+    }
+
+    FTBenchmarkHeap heapGrowth = {
+        heapBefore.blocks < 0 ? -1 : heapAfter.blocks - heapBefore.blocks,
+        heapAfter.bytes - heapBefore.bytes};
+
+    [self ft_writeScenario:scenario
+                   subject:subject
+                      size:size
+        numberOfOperations:numberOfOperations
+                  duration:duration
+                heapGrowth:heapGrowth
+                peakMemory:FTBenchmarkPeakMemory()
+         numberOfCallbacks:numberOfCallbacks];
+}
+
+#pragma mark Output
+
+- (void)ft_writeScenario:(NSString *)scenario
+                 subject:(NSString *)subject
+                    size:(NSUInteger)size
+      numberOfOperations:(NSUInteger)numberOfOperations
+                duration:(double)duration
+              heapGrowth:(FTBenchmarkHeap)heapGrowth
+              peakMemory:(long long)peakMemory
+       numberOfCallbacks:(NSUInteger)numberOfCallbacks
+{
+    double operationsPerSecond = duration > 0 ? numberOfOperations / duration : 0;
+
+    switch (_outputFormat) {
+    case FTBenchmarkOutputFormatJSON: {
+        NSString *allocations = heapGrowth.blocks < 0 ? @"null" : [NSString stringWithFormat:@"%lld", heapGrowth.blocks];
+        printf("{\"subject\":\"%s\",\"scenario\":\"%s\",\"size\":%lu,\"operations\":%lu,\"seconds\":%.6f,"
+               "\"ops_per_sec\":%.1f,\"allocations\":%s,\"allocated_bytes\":%lld,\"peak_memory_bytes\":%lld,\"callbacks\":%lu}\n",
+               [subject UTF8String], [scenario UTF8String], (unsigned long)size, (unsigned long)numberOfOperations, duration,
+               operationsPerSecond, [allocations UTF8String], heapGrowth.bytes, peakMemory, (unsigned long)numberOfCallbacks);
+        break;
+    }
+
+    case FTBenchmarkOutputFormatCSV: {
+        if (_didWriteHeader == NO) {
+            printf("subject,scenario,size,operations,seconds,ops_per_sec,allocations,allocated_bytes,peak_memory_bytes,callbacks\n");
+            _didWriteHeader = YES;
+        }
+        NSString *allocations = heapGrowth.blocks < 0 ? @"" : [NSString stringWithFormat:@"%lld", heapGrowth.blocks];
+        printf("%s,%s,%lu,%lu,%.6f,%.1f,%s,%lld,%lld,%lu\n",
+               [subject UTF8String], [scenario UTF8String], (unsigned long)size, (unsigned long)numberOfOperations, duration,
+               operationsPerSecond, [allocations UTF8String], heapGrowth.bytes, peakMemory, (unsigned long)numberOfCallbacks);
+        break;
+    }
+    }
+
+    fflush(stdout);
+}
+
+@end
+
+#pragma mark - Measurements
+
+static double FTBenchmarkTime(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static FTBenchmarkHeap FTBenchmarkHeapInUse(void)
+{
+#if __APPLE__
+    malloc_statistics_t statistics;
+    malloc_zone_statistics(NULL, &statistics);
+    FTBenchmarkHeap heap = {statistics.blocks_in_use, statistics.size_in_use};
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+    FTBenchmarkHeap heap = {-1, (long long)info.uordblks + (long long)info.hblkhd};
+#elif defined(__GLIBC__)
+    struct mallinfo info = mallinfo();
+    FTBenchmarkHeap heap = {-1, (long long)(unsigned int)info.uordblks + (long long)(unsigned int)info.hblkhd};
+#else
+    FTBenchmarkHeap heap = {-1, 0};
+#endif
+    return heap;
+}
+
+static long long FTBenchmarkPeakMemory(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if __APPLE__
+    // Darwin reports the maximum resident set size in bytes, Linux in kilobytes.
+    return usage.ru_maxrss;
+#else
+    return (long long)usage.ru_maxrss * 1024;
+#endif
+}
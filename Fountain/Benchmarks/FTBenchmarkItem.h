@@ -0,0 +1,21 @@
+//
+//  FTBenchmarkItem.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 07.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FTMutableClusterSet.h"
+
+@interface FTBenchmarkItem : NSObject
+- (instancetype)initWithValue:(NSInteger)value;
+@property (nonatomic, assign) NSInteger value;
+@end
+
+// Items, whose values differ by less than 10, are in the same cluster.
+@interface FTBenchmarkClusterComperator : FTClusterComperator
+
+@end
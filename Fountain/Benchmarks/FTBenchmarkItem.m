@@ -0,0 +1,31 @@
+//
+//  FTBenchmarkItem.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 07.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTBenchmarkItem.h"
+
+@implementation FTBenchmarkItem
+
+- (instancetype)initWithValue:(NSInteger)value
+{
+    self = [super init];
+    if (self) {
+        _value = value;
+    }
+    return self;
+}
+
+@end
+
+@implementation FTBenchmarkClusterComperator
+
+- (BOOL)compareObject:(FTBenchmarkItem *)object1 toObject:(FTBenchmarkItem *)object2
+{
+    return labs(object1.value - object2.value) < 10;
+}
+
+@end
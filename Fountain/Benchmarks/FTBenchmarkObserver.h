@@ -0,0 +1,22 @@
+//
+//  FTBenchmarkObserver.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 07.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FTDataSourceObserver.h"
+
+/*! <code>FTBenchmarkObserver</code> counts the callbacks it receives from a data source.
+    It does not implement <code>dataSource:didApplyChangeSet:</code>, so that the data
+    sources send the individual section and item callbacks.
+ */
+@interface FTBenchmarkObserver : NSObject <FTDataSourceObserver>
+
+@property (nonatomic, readonly) NSUInteger numberOfCallbacks;
+- (void)reset;
+
+@end
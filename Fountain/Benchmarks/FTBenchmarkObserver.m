@@ -0,0 +1,80 @@
+//
+//  FTBenchmarkObserver.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 07.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTBenchmarkObserver.h"
+
+@implementation FTBenchmarkObserver
+
+- (void)reset
+{
+    _numberOfCallbacks = 0;
+}
+
+#pragma mark FTDataSourceObserver
+
+- (void)dataSourceWillReset:(id<FTDataSource>)dataSource
+{
+    _numberOfCallbacks++;
+}
+
+- (void)dataSourceDidReset:(id<FTDataSource>)dataSource
+{
+    _numberOfCallbacks++;
+}
+
+- (void)dataSourceWillChange:(id<FTDataSource>)dataSource
+{
+    _numberOfCallbacks++;
+}
+
+- (void)dataSourceDidChange:(id<FTDataSource>)dataSource
+{
+    _numberOfCallbacks++;
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didInsertSections:(NSIndexSet *)sections
+{
+    _numberOfCallbacks++;
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didDeleteSections:(NSIndexSet *)sections
+{
+    _numberOfCallbacks++;
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didChangeSections:(NSIndexSet *)sections
+{
+    _numberOfCallbacks++;
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didMoveSection:(NSInteger)section toSection:(NSInteger)newSection
+{
+    _numberOfCallbacks++;
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didInsertItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    _numberOfCallbacks++;
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didDeleteItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    _numberOfCallbacks++;
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didChangeItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    _numberOfCallbacks++;
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didMoveItemAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath
+{
+    _numberOfCallbacks++;
+}
+
+@end
@@ -0,0 +1,556 @@
+//
+//  main.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 07.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FTCombinedDataSource.h"
+#import "FTMutableArray.h"
+#import "FTMutableClusterSet.h"
+#import "FTMutableSet.h"
+#import "FTPrepareHandlerRegistry.h"
+
+#import "FTBenchmark.h"
+#import "FTBenchmarkItem.h"
+#import "FTBenchmarkObserver.h"
+
+static void FTBenchmarkPrintUsage(void);
+static NSUInteger FTBenchmarkRandom(NSUInteger upperBound);
+static NSArray *FTBenchmarkItems(NSUInteger count, NSUInteger range);
+static NSArray *FTBenchmarkSortedItems(NSArray *items);
+static NSArray *FTBenchmarkSortDescriptors(void);
+
+static void FTBenchmarkSets(FTBenchmark *benchmark, NSString *subject, NSUInteger size, NSUInteger numberOfOperations, id (^makeSet)(NSArray *sortedItems));
+static void FTBenchmarkArray(FTBenchmark *benchmark, NSUInteger size, NSUInteger numberOfOperations);
+static void FTBenchmarkCombinedDataSource(FTBenchmark *benchmark, NSUInteger numberOfChildren, NSUInteger numberOfOperations);
+static void FTBenchmarkObserverFanOut(FTBenchmark *benchmark, NSUInteger numberOfObservers, NSUInteger numberOfOperations);
+static void FTBenchmarkPrepareHandlerRegistry(FTBenchmark *benchmark, NSUInteger numberOfItems, NSUInteger numberOfOperations);
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool {
+
+        FTBenchmarkOutputFormat outputFormat = FTBenchmarkOutputFormatJSON;
+        NSUInteger maximumSize = 100000;
+        NSUInteger numberOfOperations = 1000;
+        unsigned int seed = 1;
+        NSString *filter = nil;
+
+        for (int i = 1; i < argc; i++) {
+            NSString *argument = [NSString stringWithUTF8String:argv[i]];
+            NSString *value = i + 1 < argc ? [NSString stringWithUTF8String:argv[i + 1]] : nil;
+
+            if ([argument isEqualToString:@"--format"] && value) {
+                if ([value isEqualToString:@"json"]) {
+                    outputFormat = FTBenchmarkOutputFormatJSON;
+                } else if ([value isEqualToString:@"csv"]) {
+                    outputFormat = FTBenchmarkOutputFormatCSV;
+                } else {
+                    FTBenchmarkPrintUsage();
+                    return 1;
+                }
+            } else if ([argument isEqualToString:@"--max-size"] && [value longLongValue] > 0) {
+                maximumSize = (NSUInteger)[value longLongValue];
+            } else if ([argument isEqualToString:@"--operations"] && [value longLongValue] > 0) {
+                numberOfOperations = (NSUInteger)[value longLongValue];
+            } else if ([argument isEqualToString:@"--seed"] && value) {
+                seed = (unsigned int)[value longLongValue];
+            } else if ([argument isEqualToString:@"--filter"] && value) {
+                filter = value;
+            } else {
+                FTBenchmarkPrintUsage();
+                return [argument isEqualToString:@"--help"] ? 0 : 1;
+            }
+            i++;
+        }
+
+        srandom(seed);
+
+        FTBenchmark *benchmark = [[FTBenchmark alloc] initWithOutputFormat:outputFormat];
+        benchmark.filter = filter;
+
+        for (NSUInteger size = 1000; size <= maximumSize; size *= 10) {
+            @autoreleasepool {
+                FTBenchmarkSets(benchmark, @"FTMutableSet[array]", size, numberOfOperations, ^id(NSArray *sortedItems) {
+                    return [[FTMutableSet alloc] initWithSortedObjects:sortedItems
+                                                       sortDescriptors:FTBenchmarkSortDescriptors()
+                                                  includeEmptySections:NO
+                                                               storage:FTMutableSetStorageArray];
+                });
+                FTBenchmarkSets(benchmark, @"FTMutableSet[tree]", size, numberOfOperations, ^id(NSArray *sortedItems) {
+                    return [[FTMutableSet alloc] initWithSortedObjects:sortedItems
+                                                       sortDescriptors:FTBenchmarkSortDescriptors()
+                                                  includeEmptySections:NO
+                                                               storage:FTMutableSetStorageTree];
+                });
+                FTBenchmarkSets(benchmark, @"FTMutableClusterSet", size, numberOfOperations, ^id(NSArray *sortedItems) {
+                    return [[FTMutableClusterSet alloc] initWithSortedObjects:sortedItems
+                                                              sortDescriptors:FTBenchmarkSortDescriptors()
+                                                                   comperator:[[FTBenchmarkClusterComperator alloc] init]];
+                });
+                FTBenchmarkArray(benchmark, size, numberOfOperations);
+            }
+        }
+
+        for (NSUInteger numberOfChildren = 10; numberOfChildren <= 1000; numberOfChildren *= 10) {
+            @autoreleasepool {
+                FTBenchmarkCombinedDataSource(benchmark, numberOfChildren, numberOfOperations);
+            }
+        }
+
+        for (NSUInteger numberOfObservers = 1; numberOfObservers <= 1000; numberOfObservers *= 10) {
+            @autoreleasepool {
+                FTBenchmarkObserverFanOut(benchmark, numberOfObservers, numberOfOperations);
+            }
+        }
+
+        for (NSUInteger size = 1000; size <= maximumSize; size *= 10) {
+            @autoreleasepool {
+                FTBenchmarkPrepareHandlerRegistry(benchmark, size, numberOfOperations);
+            }
+        }
+    }
+    return 0;
+}
+
+#pragma mark - Sets
+
+// Runs the scenarios for FTMutableSet and FTMutableClusterSet. The
+// block creates the set with the already sorted items.
+static void FTBenchmarkSets(FTBenchmark *benchmark, NSString *subject, NSUInteger size, NSUInteger numberOfOperations, id (^makeSet)(NSArray *sortedItems))
+{
+    NSUInteger range = size * 10;
+    NSUInteger count = MIN(numberOfOperations, size);
+    FTBenchmarkObserver *observer = [[FTBenchmarkObserver alloc] init];
+
+    if ([benchmark shouldRunScenario:@"load" subject:subject]) {
+        NSArray *items = FTBenchmarkItems(size, range);
+        __block id set = nil;
+        [benchmark measureScenario:@"load"
+                           subject:subject
+                              size:size
+                         observers:@[ observer ]
+                             block:^NSUInteger {
+                                 set = makeSet(@[]);
+                                 [set addObserver:observer];
+                                 [set addObjectsFromArray:items];
+                                 return size;
+                             }];
+        [set removeObserver:observer];
+    }
+
+    if ([benchmark shouldRunScenario:@"insert" subject:subject]) {
+        id set = makeSet(FTBenchmarkSortedItems(FTBenchmarkItems(size, range)));
+        NSArray *items = FTBenchmarkItems(count, range);
+        [set addObserver:observer];
+        [benchmark measureScenario:@"insert"
+                           subject:subject
+                              size:size
+                         observers:@[ observer ]
+                             block:^NSUInteger {
+                                 for (id item in items) {
+                                     [set addObject:item];
+                                 }
+                                 return count;
+                             }];
+        [set removeObserver:observer];
+    }
+
+    if ([benchmark shouldRunScenario:@"delete" subject:subject]) {
+        NSMutableArray *items = [FTBenchmarkSortedItems(FTBenchmarkItems(size, range)) mutableCopy];
+        id set = makeSet(items);
+        [set addObserver:observer];
+        [benchmark measureScenario:@"delete"
+                           subject:subject
+                              size:size
+                         observers:@[ observer ]
+                             block:^NSUInteger {
+                                 for (NSUInteger i = 0; i < count; i++) {
+                                     NSUInteger index = FTBenchmarkRandom([items count]);
+                                     [set removeObject:items[index]];
+                                     [items replaceObjectAtIndex:index withObject:[items lastObject]];
+                                     [items removeLastObject];
+                                 }
+                                 return count;
+                             }];
+        [set removeObserver:observer];
+    }
+
+    if ([benchmark shouldRunScenario:@"update" subject:subject]) {
+        NSArray *items = FTBenchmarkSortedItems(FTBenchmarkItems(size, range));
+        id set = makeSet(items);
+        [set addObserver:observer];
+        [benchmark measureScenario:@"update"
+                           subject:subject
+                              size:size
+                         observers:@[ observer ]
+                             block:^NSUInteger {
+                                 for (NSUInteger i = 0; i < count; i++) {
+                                     FTBenchmarkItem *item = items[FTBenchmarkRandom(size)];
+                                     item.value = FTBenchmarkRandom(range);
+                                     [set addObject:item];
+                                 }
+                                 return count;
+                             }];
+        [set removeObserver:observer];
+    }
+
+    if ([benchmark shouldRunScenario:@"resort" subject:subject]) {
+        NSArray *items = FTBenchmarkSortedItems(FTBenchmarkItems(size, range));
+        id set = makeSet(items);
+        [set addObserver:observer];
+        [benchmark measureScenario:@"resort"
+                           subject:subject
+                              size:size
+                         observers:@[ observer ]
+                             block:^NSUInteger {
+                                 [set performBatchUpdate:^{
+                                     for (FTBenchmarkItem *item in items) {
+                                         item.value = FTBenchmarkRandom(range);
+                                         [set addObject:item];
+                                     }
+                                 }];
+                                 return size;
+                             }];
+        [set removeObserver:observer];
+    }
+}
+
+#pragma mark - Array
+
+static void FTBenchmarkArray(FTBenchmark *benchmark, NSUInteger size, NSUInteger numberOfOperations)
+{
+    NSString *subject = @"FTMutableArray";
+    NSUInteger range = size * 10;
+    NSUInteger count = MIN(numberOfOperations, size);
+    FTBenchmarkObserver *observer = [[FTBenchmarkObserver alloc] init];
+
+    if ([benchmark shouldRunScenario:@"load" subject:subject]) {
+        NSArray *items = FTBenchmarkItems(size, range);
+        __block FTMutableArray *array = nil;
+        [benchmark measureScenario:@"load"
+                           subject:subject
+                              size:size
+                         observers:@[ observer ]
+                             block:^NSUInteger {
+                                 array = [[FTMutableArray alloc] init];
+                                 [array addObserver:observer];
+                                 [array addObjectsFromArray:items];
+                                 return size;
+                             }];
+        [array removeObserver:observer];
+    }
+
+    if ([benchmark shouldRunScenario:@"insert" subject:subject]) {
+        FTMutableArray *array = [FTMutableArray arrayWithArray:FTBenchmarkItems(size, range)];
+        NSArray *items = FTBenchmarkItems(count, range);
+        [array addObserver:observer];
+        [benchmark measureScenario:@"insert"
+                           subject:subject
+                              size:size
+                         observers:@[ observer ]
+                             block:^NSUInteger {
+                                 for (id item in items) {
+                                     [array insertObject:item atIndex:FTBenchmarkRandom([array count] + 1)];
+                                 }
+                                 return count;
+                             }];
+        [array removeObserver:observer];
+    }
+
+    if ([benchmark shouldRunScenario:@"delete" subject:subject]) {
+        FTMutableArray *array = [FTMutableArray arrayWithArray:FTBenchmarkItems(size, range)];
+        [array addObserver:observer];
+        [benchmark measureScenario:@"delete"
+                           subject:subject
+                              size:size
+                         observers:@[ observer ]
+                             block:^NSUInteger {
+                                 for (NSUInteger i = 0; i < count; i++) {
+                                     [array removeObjectAtIndex:FTBenchmarkRandom([array count])];
+                                 }
+                                 return count;
+                             }];
+        [array removeObserver:observer];
+    }
+
+    if ([benchmark shouldRunScenario:@"update" subject:subject]) {
+        FTMutableArray *array = [FTMutableArray arrayWithArray:FTBenchmarkItems(size, range)];
+        [array addObserver:observer];
+        [benchmark measureScenario:@"update"
+                           subject:subject
+                              size:size
+                         observers:@[ observer ]
+                             block:^NSUInteger {
+                                 for (NSUInteger i = 0; i < count; i++) {
+                                     NSUInteger index = FTBenchmarkRandom(size);
+                                     FTBenchmarkItem *item = array[index];
+                                     item.value = FTBenchmarkRandom(range);
+                                     [array replaceObjectAtIndex:index withObject:item];
+                                 }
+                                 return count;
+                             }];
+        [array removeObserver:observer];
+    }
+
+    if ([benchmark shouldRunScenario:@"resort" subject:subject]) {
+        FTMutableArray *array = [FTMutableArray arrayWithArray:FTBenchmarkItems(size, range)];
+        [array addObserver:observer];
+        [benchmark measureScenario:@"resort"
+                           subject:subject
+                              size:size
+                         observers:@[ observer ]
+                             block:^NSUInteger {
+                                 [array replaceAllObjectsWithObjects:FTBenchmarkSortedItems(array)];
+                                 return size;
+                             }];
+        [array removeObserver:observer];
+    }
+}
+
+#pragma mark - Combined Data Source
+
+// Each child is an FTMutableArray with 100 items in one section.
+static void FTBenchmarkCombinedDataSource(FTBenchmark *benchmark, NSUInteger numberOfChildren, NSUInteger numberOfOperations)
+{
+    NSString *subject = @"FTCombinedDataSource";
+    NSUInteger numberOfItems = 100;
+    FTBenchmarkObserver *observer = [[FTBenchmarkObserver alloc] init];
+
+    NSMutableArray *children = [[NSMutableArray alloc] initWithCapacity:numberOfChildren];
+    for (NSUInteger i = 0; i < numberOfChildren; i++) {
+        [children addObject:[FTMutableArray arrayWithArray:FTBenchmarkItems(numberOfItems, numberOfItems)]];
+    }
+
+    FTCombinedDataSource *dataSource = [[FTCombinedDataSource alloc] initWithDataSources:children];
+    [dataSource addObserver:observer];
+
+    [benchmark measureScenario:@"lookup"
+                       subject:subject
+                          size:numberOfChildren
+                     observers:@[]
+                         block:^NSUInteger {
+                             for (NSUInteger i = 0; i < numberOfOperations; i++) {
+                                 NSUInteger section = FTBenchmarkRandom([dataSource numberOfSections]);
+                                 NSUInteger item = FTBenchmarkRandom([dataSource numberOfItemsInSection:section]);
+                                 NSIndexPath *indexPath = [[NSIndexPath indexPathWithIndex:section] indexPathByAddingIndex:item];
+                                 id<FTDataSource> child = [dataSource dataSourceOfIndexPath:indexPath];
+                                 [dataSource convertIndexPath:indexPath toDataSource:child];
+                                 [dataSource itemAtIndexPath:indexPath];
+                             }
+                             return numberOfOperations;
+                         }];
+
+    // The item index is built before measuring the lookups.
+    dataSource.indexesItems = YES;
+    [dataSource indexPathsOfItem:[children[0] firstObject]];
+
+    [benchmark measureScenario:@"reverse-lookup"
+                       subject:subject
+                          size:numberOfChildren
+                     observers:@[]
+                         block:^NSUInteger {
+                             for (NSUInteger i = 0; i < numberOfOperations; i++) {
+                                 FTMutableArray *child = children[FTBenchmarkRandom(numberOfChildren)];
+                                 [dataSource indexPathsOfItem:child[FTBenchmarkRandom([child count])]];
+                             }
+                             return numberOfOperations;
+                         }];
+
+    dataSource.indexesItems = NO;
+
+    [benchmark measureScenario:@"change"
+                       subject:subject
+                          size:numberOfChildren
+                     observers:@[ observer ]
+                         block:^NSUInteger {
+                             for (NSUInteger i = 0; i < numberOfOperations; i++) {
+                                 FTMutableArray *child = children[FTBenchmarkRandom(numberOfChildren)];
+                                 [child insertObject:[[FTBenchmarkItem alloc] initWithValue:i] atIndex:FTBenchmarkRandom([child count] + 1)];
+                             }
+                             return numberOfOperations;
+                         }];
+
+    [dataSource removeObserver:observer];
+}
+
+#pragma mark - Observer Fan-Out
+
+static void FTBenchmarkObserverFanOut(FTBenchmark *benchmark, NSUInteger numberOfObservers, NSUInteger numberOfOperations)
+{
+    NSUInteger size = 1000;
+    FTMutableArray *array = [FTMutableArray arrayWithArray:FTBenchmarkItems(size, size)];
+
+    NSMutableArray *observers = [[NSMutableArray alloc] initWithCapacity:numberOfObservers];
+    for (NSUInteger i = 0; i < numberOfObservers; i++) {
+        FTBenchmarkObserver *observer = [[FTBenchmarkObserver alloc] init];
+        [array addObserver:observer];
+        [observers addObject:observer];
+    }
+
+    [benchmark measureScenario:@"fan-out"
+                       subject:@"FTMutableArray"
+                          size:numberOfObservers
+                     observers:observers
+                         block:^NSUInteger {
+                             for (NSUInteger i = 0; i < numberOfOperations; i++) {
+                                 [array insertObject:[[FTBenchmarkItem alloc] initWithValue:i] atIndex:FTBenchmarkRandom([array count] + 1)];
+                             }
+                             return numberOfOperations;
+                         }];
+
+    for (FTBenchmarkObserver *observer in observers) {
+        [array removeObserver:observer];
+    }
+}
+
+#pragma mark - Prepare Handler Registry
+
+// Resolves the handlers of 15 predicates, like the cell prepare handlers of
+// an adapter: 5 using the position of the item, 5 checking the class and 5
+// checking a value of the item. The "evaluate" scenario is the baseline of
+// evaluating the predicates in order. The results of the registry are
+// compared with the baseline before measuring, and the tool fails, if they
+// differ.
+static void FTBenchmarkPrepareHandlerRegistry(FTBenchmark *benchmark, NSUInteger numberOfItems, NSUInteger numberOfOperations)
+{
+    NSString *subject = @"FTPrepareHandlerRegistry";
+    if ([benchmark shouldRunScenario:@"resolve" subject:subject] == NO &&
+        [benchmark shouldRunScenario:@"evaluate" subject:subject] == NO) {
+        return;
+    }
+
+    NSMutableArray *predicates = [[NSMutableArray alloc] init];
+    for (NSUInteger i = 0; i < 5; i++) {
+        [predicates addObject:[NSPredicate predicateWithFormat:@"$ITEM == %lu AND $SECTION == 0", (unsigned long)(i * 7)]];
+    }
+    for (Class aClass in @[ [NSDate class], [NSData class], [NSURL class], [NSString class], [NSNumber class] ]) {
+        [predicates addObject:[NSComparisonPredicate predicateWithLeftExpression:[NSExpression expressionForEvaluatedObject]
+                                                                 rightExpression:[NSExpression expressionForConstantValue:aClass]
+                                                                  customSelector:@selector(isKindOfClass:)]];
+    }
+    for (NSUInteger i = 1; i <= 5; i++) {
+        [predicates addObject:[NSPredicate predicateWithFormat:@"value < %lu", (unsigned long)(numberOfItems * i / 5)]];
+    }
+
+    FTPrepareHandlerRegistry *registry = [[FTPrepareHandlerRegistry alloc] init];
+    for (NSUInteger i = 0; i < [predicates count]; i++) {
+        [registry addHandler:[[FTPrepareHandler alloc] initWithPredicate:predicates[i]
+                                                         reuseIdentifier:[NSString stringWithFormat:@"%lu", (unsigned long)i]
+                                                                   block:nil]];
+    }
+
+    // Every tenth item is a string, the others are benchmark items.
+    NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:numberOfItems];
+    for (NSUInteger i = 0; i < numberOfItems; i++) {
+        if (i % 10 == 0) {
+            [items addObject:[NSString stringWithFormat:@"%lu", (unsigned long)i]];
+        } else {
+            [items addObject:[[FTBenchmarkItem alloc] initWithValue:FTBenchmarkRandom(numberOfItems)]];
+        }
+    }
+
+    NSArray *handlers = registry.handlers;
+    NSUInteger (^evaluate)(id, NSDictionary *) = ^NSUInteger(id item, NSDictionary *variables) {
+        for (NSUInteger i = 0; i < [predicates count]; i++) {
+            if ([predicates[i] evaluateWithObject:item substitutionVariables:variables]) {
+                return i;
+            }
+        }
+        return NSNotFound;
+    };
+
+    for (NSUInteger i = 0; i < numberOfItems; i++) {
+        NSDictionary *variables = @{ @"SECTION" : @(0),
+                                     @"ITEM" : @(i),
+                                     @"ROW" : @(i) };
+        FTPrepareHandler *handler = [registry handlerForItem:items[i]
+                                       substitutionVariables:^NSDictionary * {
+                                           return variables;
+                                       }];
+        NSUInteger expectedIndex = evaluate(items[i], variables);
+        NSUInteger index = handler ? [handlers indexOfObjectIdenticalTo:handler] : NSNotFound;
+        if (index != expectedIndex) {
+            [NSException raise:NSInternalInconsistencyException
+                        format:@"*** %s: Resolved handler %lu for item %lu instead of handler %lu.",
+                               __PRETTY_FUNCTION__, (unsigned long)index, (unsigned long)i, (unsigned long)expectedIndex];
+        }
+    }
+
+    [benchmark measureScenario:@"evaluate"
+                       subject:subject
+                          size:numberOfItems
+                     observers:@[]
+                         block:^NSUInteger {
+                             for (NSUInteger i = 0; i < numberOfOperations; i++) {
+                                 NSUInteger index = FTBenchmarkRandom(numberOfItems);
+                                 NSDictionary *variables = @{ @"SECTION" : @(0),
+                                                              @"ITEM" : @(index),
+                                                              @"ROW" : @(index) };
+                                 evaluate(items[index], variables);
+                             }
+                             return numberOfOperations;
+                         }];
+
+    [benchmark measureScenario:@"resolve"
+                       subject:subject
+                          size:numberOfItems
+                     observers:@[]
+                         block:^NSUInteger {
+                             for (NSUInteger i = 0; i < numberOfOperations; i++) {
+                                 NSUInteger index = FTBenchmarkRandom(numberOfItems);
+                                 [registry handlerForItem:items[index]
+                                    substitutionVariables:^NSDictionary * {
+                                        return @{ @"SECTION" : @(0),
+                                                  @"ITEM" : @(index),
+                                                  @"ROW" : @(index) };
+                                    }];
+                             }
+                             return numberOfOperations;
+                         }];
+}
+
+#pragma mark - Helper
+
+static void FTBenchmarkPrintUsage(void)
+{
+    fprintf(stderr, "usage: Benchmarks [--format json|csv] [--max-size n] [--operations n] [--seed n] [--filter name]\n"
+                    "\n"
+                    "  --format      output format, one JSON object per line (default) or CSV\n"
+                    "  --max-size    largest number of items of the container scenarios (default 100000)\n"
+                    "  --operations  number of single operations per scenario (default 1000)\n"
+                    "  --seed        seed of the random numbers (default 1)\n"
+                    "  --filter      only run scenarios, whose name (subject.scenario) contains the filter\n");
+}
+
+static NSUInteger FTBenchmarkRandom(NSUInteger upperBound)
+{
+    if (upperBound == 0) {
+        return 0;
+    }
+    unsigned long long value = ((unsigned long long)random() << 31) | (unsigned long long)random();
+    return (NSUInteger)(value % upperBound);
+}
+
+static NSArray *FTBenchmarkItems(NSUInteger count, NSUInteger range)
+{
+    NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [items addObject:[[FTBenchmarkItem alloc] initWithValue:FTBenchmarkRandom(range)]];
+    }
+    return items;
+}
+
+static NSArray *FTBenchmarkSortedItems(NSArray *items)
+{
+    return [items sortedArrayUsingDescriptors:FTBenchmarkSortDescriptors()];
+}
+
+static NSArray *FTBenchmarkSortDescriptors(void)
+{
+    return @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+}
@@ -0,0 +1,47 @@
+//
+//  FTAggregatingInstrumentationSink.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 08.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FTInstrumentation.h"
+
+/*! <code>FTAggregatingInstrumentationSink</code> keeps the finished spans in memory and
+    aggregates them by their name. It can be used in tests or to dump percentiles of the
+    durations after a run (e.g., <code>[FTInstrumentation setSink:sink]</code> ...
+    <code>NSLog(@"%@", [sink report])</code>).
+
+    The sink is thread-safe. Spans are kept until the sink is reset.
+ */
+@interface FTAggregatingInstrumentationSink : NSObject <FTInstrumentationSink>
+
+#pragma mark Spans
+@property (nonatomic, readonly) NSArray *spanNames;
+- (NSUInteger)numberOfSpansWithName:(NSString *)name;
+- (NSArray *)spansWithName:(NSString *)name;
+
+#pragma mark Aggregation
+
+// The percentile is a value between 0 and 1 (e.g., 0.99). Returns 0, if there are no spans with the name.
+- (NSTimeInterval)percentile:(double)percentile ofDurationsOfSpansWithName:(NSString *)name;
+- (NSTimeInterval)percentile:(double)percentile ofDurationsOfPhase:(NSString *)phase ofSpansWithName:(NSString *)name;
+
+// Returns the sum of the counts for the key of all spans with the name.
+- (NSUInteger)totalCount:(NSString *)key ofSpansWithName:(NSString *)name;
+
+// Returns the delivery durations of all spans with the name, summed up per class of the observers.
+- (NSDictionary *)observerDeliveryDurationsOfSpansWithName:(NSString *)name;
+
+#pragma mark Report
+
+// Returns a text with the p50, p90, p99 and max durations of the spans and their phases per name.
+- (NSString *)report;
+
+#pragma mark Reset
+- (void)reset;
+
+@end
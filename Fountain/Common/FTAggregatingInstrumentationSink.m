@@ -0,0 +1,185 @@
+//
+//  FTAggregatingInstrumentationSink.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 08.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTAggregatingInstrumentationSink.h"
+
+static NSTimeInterval FTAggregatingInstrumentationSinkPercentile(NSArray *values, double percentile);
+
+@interface FTAggregatingInstrumentationSink () {
+    dispatch_queue_t _queue;
+    NSMutableDictionary *_spansByName;
+}
+
+@end
+
+@implementation FTAggregatingInstrumentationSink
+
+#pragma mark Life-cycle
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _queue = dispatch_queue_create("de.tobias-kraentzer.Fountain.FTAggregatingInstrumentationSink", DISPATCH_QUEUE_SERIAL);
+        _spansByName = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+#pragma mark FTInstrumentationSink
+
+- (void)instrumentationDidFinishSpan:(FTInstrumentationSpan *)span
+{
+    dispatch_sync(_queue, ^{
+        NSMutableArray *spans = _spansByName[span.name];
+        if (spans == nil) {
+            spans = [[NSMutableArray alloc] init];
+            _spansByName[span.name] = spans;
+        }
+        [spans addObject:span];
+    });
+}
+
+#pragma mark Spans
+
+- (NSArray *)spanNames
+{
+    __block NSArray *names = nil;
+    dispatch_sync(_queue, ^{
+        names = [[_spansByName allKeys] sortedArrayUsingSelector:@selector(compare:)];
+    });
+    return names;
+}
+
+- (NSUInteger)numberOfSpansWithName:(NSString *)name
+{
+    return [[self spansWithName:name] count];
+}
+
+- (NSArray *)spansWithName:(NSString *)name
+{
+    __block NSArray *spans = nil;
+    dispatch_sync(_queue, ^{
+        spans = [_spansByName[name] copy] ?: @[];
+    });
+    return spans;
+}
+
+#pragma mark Aggregation
+
+- (NSTimeInterval)percentile:(double)percentile ofDurationsOfSpansWithName:(NSString *)name
+{
+    NSArray *durations = [[self spansWithName:name] valueForKey:@"duration"];
+    return FTAggregatingInstrumentationSinkPercentile(durations, percentile);
+}
+
+- (NSTimeInterval)percentile:(double)percentile ofDurationsOfPhase:(NSString *)phase ofSpansWithName:(NSString *)name
+{
+    NSMutableArray *durations = [[NSMutableArray alloc] init];
+    for (FTInstrumentationSpan *span in [self spansWithName:name]) {
+        NSNumber *duration = span.phaseDurations[phase];
+        if (duration) {
+            [durations addObject:duration];
+        }
+    }
+    return FTAggregatingInstrumentationSinkPercentile(durations, percentile);
+}
+
+- (NSUInteger)totalCount:(NSString *)key ofSpansWithName:(NSString *)name
+{
+    NSUInteger total = 0;
+    for (FTInstrumentationSpan *span in [self spansWithName:name]) {
+        total += [span.counts[key] unsignedIntegerValue];
+    }
+    return total;
+}
+
+- (NSDictionary *)observerDeliveryDurationsOfSpansWithName:(NSString *)name
+{
+    NSMutableDictionary *durations = [[NSMutableDictionary alloc] init];
+    for (FTInstrumentationSpan *span in [self spansWithName:name]) {
+        [span.observerDeliveryDurations enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSNumber *duration, BOOL *stop) {
+            durations[key] = @([durations[key] doubleValue] + [duration doubleValue]);
+        }];
+    }
+    return durations;
+}
+
+#pragma mark Report
+
+- (NSString *)report
+{
+    NSMutableString *report = [[NSMutableString alloc] init];
+
+    for (NSString *name in self.spanNames) {
+        NSArray *spans = [self spansWithName:name];
+
+        [report appendFormat:@"%@ (%lu spans): p50 = %.6f, p90 = %.6f, p99 = %.6f, max = %.6f\n",
+                             name,
+                             (unsigned long)[spans count],
+                             [self percentile:0.5 ofDurationsOfSpansWithName:name],
+                             [self percentile:0.9 ofDurationsOfSpansWithName:name],
+                             [self percentile:0.99 ofDurationsOfSpansWithName:name],
+                             [self percentile:1.0 ofDurationsOfSpansWithName:name]];
+
+        NSMutableSet *phases = [[NSMutableSet alloc] init];
+        NSMutableSet *keys = [[NSMutableSet alloc] init];
+        for (FTInstrumentationSpan *span in spans) {
+            [phases addObjectsFromArray:[span.phaseDurations allKeys]];
+            [keys addObjectsFromArray:[span.counts allKeys]];
+        }
+
+        for (NSString *phase in [[phases allObjects] sortedArrayUsingSelector:@selector(compare:)]) {
+            [report appendFormat:@"    %@: p50 = %.6f, p90 = %.6f, p99 = %.6f, max = %.6f\n",
+                                 phase,
+                                 [self percentile:0.5 ofDurationsOfPhase:phase ofSpansWithName:name],
+                                 [self percentile:0.9 ofDurationsOfPhase:phase ofSpansWithName:name],
+                                 [self percentile:0.99 ofDurationsOfPhase:phase ofSpansWithName:name],
+                                 [self percentile:1.0 ofDurationsOfPhase:phase ofSpansWithName:name]];
+        }
+
+        for (NSString *key in [[keys allObjects] sortedArrayUsingSelector:@selector(compare:)]) {
+            [report appendFormat:@"    %@: %lu\n", key, (unsigned long)[self totalCount:key ofSpansWithName:name]];
+        }
+
+        NSDictionary *deliveryDurations = [self observerDeliveryDurationsOfSpansWithName:name];
+        for (NSString *observerClass in [[deliveryDurations allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+            [report appendFormat:@"    -> %@: %.6f\n", observerClass, [deliveryDurations[observerClass] doubleValue]];
+        }
+    }
+
+    return report;
+}
+
+#pragma mark Reset
+
+- (void)reset
+{
+    dispatch_sync(_queue, ^{
+        [_spansByName removeAllObjects];
+    });
+}
+
+@end
+
+#pragma mark - Percentile
+
+static NSTimeInterval FTAggregatingInstrumentationSinkPercentile(NSArray *values, double percentile)
+{
+    if ([values count] == 0) {
+        return 0;
+    }
+
+    // Nearest-rank method: the smallest value, for which at least the
+    // given fraction of all values is less than or equal.
+
+    NSArray *sortedValues = [values sortedArrayUsingSelector:@selector(compare:)];
+    double rank = ceil(MAX(0, MIN(1, percentile)) * [sortedValues count]);
+    NSUInteger index = rank < 1 ? 0 : (NSUInteger)rank - 1;
+    return [sortedValues[index] doubleValue];
+}
@@ -0,0 +1,124 @@
+//
+//  FTChangeSet.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 22.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FTObserverRegistry.h"
+
+@protocol FTDataSource;
+@protocol FTDataSourceObserver;
+
+/*! <code>FTChangeSet</code> describes all changes of a data source between a call to
+    <code>dataSourceWillChange:</code> and <code>dataSourceDidChange:</code>.
+
+    The indexes follow the same conventions as the individual observer callbacks:
+    deleted and changed sections and items refer to the state before the changes,
+    inserted sections and items refer to the state after the changes.
+ */
+@interface FTChangeSet : NSObject <NSCopying, NSMutableCopying>
+
+#pragma mark Sections
+@property (nonatomic, readonly) NSIndexSet *insertedSections;
+@property (nonatomic, readonly) NSIndexSet *deletedSections;
+@property (nonatomic, readonly) NSIndexSet *changedSections;
+- (void)enumerateSectionMovesUsingBlock:(void (^)(NSUInteger section, NSUInteger newSection, BOOL *stop))block;
+
+#pragma mark Items
+- (NSIndexSet *)insertedItemsInSection:(NSUInteger)section;
+- (NSIndexSet *)deletedItemsInSection:(NSUInteger)section;
+- (NSIndexSet *)changedItemsInSection:(NSUInteger)section;
+
+// The blocks are called once per section with items in ascending order of the sections.
+- (void)enumerateInsertedItemsUsingBlock:(void (^)(NSUInteger section, NSIndexSet *items, BOOL *stop))block;
+- (void)enumerateDeletedItemsUsingBlock:(void (^)(NSUInteger section, NSIndexSet *items, BOOL *stop))block;
+- (void)enumerateChangedItemsUsingBlock:(void (^)(NSUInteger section, NSIndexSet *items, BOOL *stop))block;
+- (void)enumerateItemMovesUsingBlock:(void (^)(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop))block;
+
+#pragma mark Properties
+@property (nonatomic, readonly, getter=isEmpty) BOOL empty;
+
+#pragma mark Computing Change Sets
+
+// Returns the changes between two states of a data source. Each state is given as an array
+// of sections, each containing the array of its items, and an array with the section item
+// of each section (NSNull for sections without a section item). Sections are matched by
+// their section items, sections without a section item by their position. Items are matched
+// by equality, also across sections. Matched items and section items, which are not
+// identical or which are contained in changedItems, are reported as changed. This includes
+// moved items, which are reported as moved and as changed at their index before the changes.
++ (FTChangeSet *)changeSetFromSections:(NSArray *)sections
+                          sectionItems:(NSArray *)sectionItems
+                            toSections:(NSArray *)newSections
+                          sectionItems:(NSArray *)newSectionItems
+                          changedItems:(NSSet *)changedItems;
+
+#pragma mark Applying Changes
+
+// Returns NO, if the deleted, changed or moved sections and items don't exist in a
+// state with the given number of items (as NSNumber) per section.
+- (BOOL)isValidForNumberOfItemsInSections:(NSArray *)numberOfItemsInSections;
+
+// Applies the changes to a state, given as an array with a mutable array of the items
+// of each section and a mutable array with the section item of each section. Inserted
+// items and section items are requested from the blocks with their index in the new
+// state (NSNull is used for nil). Moved items and sections keep their objects. Returns
+// NO, if the changes don't match the state, which is undefined in that case.
+- (BOOL)applyToSections:(NSMutableArray *)sections
+                sectionItems:(NSMutableArray *)sectionItems
+           insertedItemBlock:(id (^)(NSIndexPath *indexPath))insertedItemBlock
+    insertedSectionItemBlock:(id (^)(NSUInteger section))insertedSectionItemBlock;
+
+// Returns the index of a section of the state before the changes in the state after the
+// changes, or NSNotFound, if the section has been deleted.
+- (NSUInteger)sectionAfterChangesOfSection:(NSUInteger)section;
+
+// Returns the index path of an item of the state before the changes in the state after the
+// changes, or nil, if the item or its section has been deleted.
+- (NSIndexPath *)indexPathAfterChangesOfItemAtIndexPath:(NSIndexPath *)indexPath;
+
+#pragma mark Notifying Observers
+
+// Sends the changes as individual callbacks to the observer. This is used
+// for observers, which do not implement dataSource:didApplyChangeSet:.
+- (void)notifyObserver:(id<FTDataSourceObserver>)observer ofChangesInDataSource:(id<FTDataSource>)dataSource;
+
+// Same as above, but only the given methods are called on the observer.
+- (void)notifyObserver:(id<FTDataSourceObserver>)observer implementingMethods:(FTDataSourceObserverMethods)methods ofChangesInDataSource:(id<FTDataSource>)dataSource;
+
+@end
+
+@interface FTMutableChangeSet : FTChangeSet
+
+#pragma mark Sections
+- (void)insertSections:(NSIndexSet *)sections;
+- (void)deleteSections:(NSIndexSet *)sections;
+- (void)changeSections:(NSIndexSet *)sections;
+- (void)moveSection:(NSUInteger)section toSection:(NSUInteger)newSection;
+
+#pragma mark Items
+- (void)insertItemsAtIndexes:(NSIndexSet *)indexes inSection:(NSUInteger)section;
+- (void)deleteItemsAtIndexes:(NSIndexSet *)indexes inSection:(NSUInteger)section;
+- (void)changeItemsAtIndexes:(NSIndexSet *)indexes inSection:(NSUInteger)section;
+- (void)moveItemAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath;
+
+- (void)insertItemsAtIndexPaths:(NSArray *)indexPaths;
+- (void)deleteItemsAtIndexPaths:(NSArray *)indexPaths;
+- (void)changeItemsAtIndexPaths:(NSArray *)indexPaths;
+
+#pragma mark Combining Change Sets
+
+// Adds all changes of the given change set with the sections shifted by the offset.
+- (void)addChangesFromChangeSet:(FTChangeSet *)changeSet sectionOffset:(NSUInteger)offset;
+
+#pragma mark Removing Changes
+
+// The index paths refer to the state before the changes.
+- (void)removeChangedItemsAtIndexPaths:(NSArray *)indexPaths;
+- (void)removeAllChanges;
+
+@end
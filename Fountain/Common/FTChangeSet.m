@@ -0,0 +1,955 @@
+//
+//  FTChangeSet.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 22.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTDataSourceObserver.h"
+#import "FTObserverRegistry.h"
+
+#import "FTChangeSet.h"
+
+typedef struct {
+    NSUInteger section;
+    NSUInteger newSection;
+} FTChangeSetSectionMove;
+
+typedef struct {
+    NSUInteger section;
+    NSUInteger item;
+    NSUInteger newSection;
+    NSUInteger newItem;
+} FTChangeSetItemMove;
+
+static void FTChangeSetCopyItems(NSDictionary *source, NSMutableDictionary *destination);
+static void FTChangeSetEnumerateItems(NSDictionary *itemsBySection, void (^block)(NSUInteger, NSIndexSet *, BOOL *));
+static NSUInteger FTChangeSetNumberOfItems(NSDictionary *itemsBySection);
+static NSArray *FTChangeSetIndexPaths(NSUInteger section, NSIndexSet *items);
+static NSMutableIndexSet *FTChangeSetItems(NSMutableDictionary *itemsBySection, NSUInteger section);
+static void FTChangeSetAddIndexPaths(NSMutableDictionary *itemsBySection, NSArray *indexPaths);
+static NSIndexSet *FTChangeSetShiftedIndexes(NSIndexSet *indexes, NSUInteger offset);
+static NSIndexPath *FTChangeSetIndexPath(NSUInteger section, NSUInteger item);
+static BOOL FTChangeSetIsChangedItem(id item, id newItem, NSSet *changedItems);
+static NSUInteger FTChangeSetIndexAfterChanges(NSUInteger index, NSIndexSet *removedIndexes, NSIndexSet *insertedIndexes);
+static NSIndexSet *FTIndexesOfLongestIncreasingSubsequence(const NSUInteger *values, NSUInteger count);
+
+@interface FTChangeSet () {
+  @public
+    NSMutableIndexSet *_insertedSections;
+    NSMutableIndexSet *_deletedSections;
+    NSMutableIndexSet *_changedSections;
+    NSMutableData *_sectionMoves;
+
+    NSMutableDictionary *_insertedItems;
+    NSMutableDictionary *_deletedItems;
+    NSMutableDictionary *_changedItems;
+    NSMutableData *_itemMoves;
+}
+
+@end
+
+@implementation FTChangeSet
+
+#pragma mark Life-cycle
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _insertedSections = [[NSMutableIndexSet alloc] init];
+        _deletedSections = [[NSMutableIndexSet alloc] init];
+        _changedSections = [[NSMutableIndexSet alloc] init];
+        _sectionMoves = [[NSMutableData alloc] init];
+
+        _insertedItems = [[NSMutableDictionary alloc] init];
+        _deletedItems = [[NSMutableDictionary alloc] init];
+        _changedItems = [[NSMutableDictionary alloc] init];
+        _itemMoves = [[NSMutableData alloc] init];
+    }
+    return self;
+}
+
+- (instancetype)initWithChangeSet:(FTChangeSet *)changeSet
+{
+    self = [self init];
+    if (self) {
+        [_insertedSections addIndexes:changeSet->_insertedSections];
+        [_deletedSections addIndexes:changeSet->_deletedSections];
+        [_changedSections addIndexes:changeSet->_changedSections];
+        [_sectionMoves appendData:changeSet->_sectionMoves];
+
+        FTChangeSetCopyItems(changeSet->_insertedItems, _insertedItems);
+        FTChangeSetCopyItems(changeSet->_deletedItems, _deletedItems);
+        FTChangeSetCopyItems(changeSet->_changedItems, _changedItems);
+        [_itemMoves appendData:changeSet->_itemMoves];
+    }
+    return self;
+}
+
+static void FTChangeSetCopyItems(NSDictionary *source, NSMutableDictionary *destination)
+{
+    [source enumerateKeysAndObjectsUsingBlock:^(NSNumber *section, NSIndexSet *items, BOOL *stop) {
+        [destination setObject:[items mutableCopy] forKey:section];
+    }];
+}
+
+#pragma mark Sections
+
+- (NSIndexSet *)insertedSections
+{
+    return _insertedSections;
+}
+
+- (NSIndexSet *)deletedSections
+{
+    return _deletedSections;
+}
+
+- (NSIndexSet *)changedSections
+{
+    return _changedSections;
+}
+
+- (void)enumerateSectionMovesUsingBlock:(void (^)(NSUInteger, NSUInteger, BOOL *))block
+{
+    const FTChangeSetSectionMove *moves = [_sectionMoves bytes];
+    NSUInteger count = [_sectionMoves length] / sizeof(FTChangeSetSectionMove);
+
+    BOOL stop = NO;
+    for (NSUInteger i = 0; i < count && stop == NO; i++) {
+        block(moves[i].section, moves[i].newSection, &stop);
+    }
+}
+
+#pragma mark Items
+
+- (NSIndexSet *)insertedItemsInSection:(NSUInteger)section
+{
+    return [_insertedItems objectForKey:@(section)] ?: [NSIndexSet indexSet];
+}
+
+- (NSIndexSet *)deletedItemsInSection:(NSUInteger)section
+{
+    return [_deletedItems objectForKey:@(section)] ?: [NSIndexSet indexSet];
+}
+
+- (NSIndexSet *)changedItemsInSection:(NSUInteger)section
+{
+    return [_changedItems objectForKey:@(section)] ?: [NSIndexSet indexSet];
+}
+
+- (void)enumerateInsertedItemsUsingBlock:(void (^)(NSUInteger, NSIndexSet *, BOOL *))block
+{
+    FTChangeSetEnumerateItems(_insertedItems, block);
+}
+
+- (void)enumerateDeletedItemsUsingBlock:(void (^)(NSUInteger, NSIndexSet *, BOOL *))block
+{
+    FTChangeSetEnumerateItems(_deletedItems, block);
+}
+
+- (void)enumerateChangedItemsUsingBlock:(void (^)(NSUInteger, NSIndexSet *, BOOL *))block
+{
+    FTChangeSetEnumerateItems(_changedItems, block);
+}
+
+static void FTChangeSetEnumerateItems(NSDictionary *itemsBySection, void (^block)(NSUInteger, NSIndexSet *, BOOL *))
+{
+    NSArray *sections = [[itemsBySection allKeys] sortedArrayUsingSelector:@selector(compare:)];
+
+    BOOL stop = NO;
+    for (NSNumber *section in sections) {
+        NSIndexSet *items = [itemsBySection objectForKey:section];
+        if ([items count] > 0) {
+            block([section unsignedIntegerValue], items, &stop);
+            if (stop) {
+                break;
+            }
+        }
+    }
+}
+
+- (void)enumerateItemMovesUsingBlock:(void (^)(NSIndexPath *, NSIndexPath *, BOOL *))block
+{
+    const FTChangeSetItemMove *moves = [_itemMoves bytes];
+    NSUInteger count = [_itemMoves length] / sizeof(FTChangeSetItemMove);
+
+    BOOL stop = NO;
+    for (NSUInteger i = 0; i < count && stop == NO; i++) {
+        NSUInteger indexes[] = {moves[i].section, moves[i].item};
+        NSUInteger newIndexes[] = {moves[i].newSection, moves[i].newItem};
+        block([NSIndexPath indexPathWithIndexes:indexes length:2],
+              [NSIndexPath indexPathWithIndexes:newIndexes length:2],
+              &stop);
+    }
+}
+
+#pragma mark Properties
+
+- (BOOL)isEmpty
+{
+    return [_insertedSections count] == 0 &&
+           [_deletedSections count] == 0 &&
+           [_changedSections count] == 0 &&
+           [_sectionMoves length] == 0 &&
+           FTChangeSetNumberOfItems(_insertedItems) == 0 &&
+           FTChangeSetNumberOfItems(_deletedItems) == 0 &&
+           FTChangeSetNumberOfItems(_changedItems) == 0 &&
+           [_itemMoves length] == 0;
+}
+
+static NSUInteger FTChangeSetNumberOfItems(NSDictionary *itemsBySection)
+{
+    NSUInteger count = 0;
+    for (NSIndexSet *items in [itemsBySection objectEnumerator]) {
+        count += [items count];
+    }
+    return count;
+}
+
+#pragma mark Notifying Observers
+
+- (void)notifyObserver:(id<FTDataSourceObserver>)observer ofChangesInDataSource:(id<FTDataSource>)dataSource
+{
+    [self notifyObserver:observer
+        implementingMethods:[FTObserverRegistry methodsImplementedByObserver:observer]
+        ofChangesInDataSource:dataSource];
+}
+
+- (void)notifyObserver:(id<FTDataSourceObserver>)observer implementingMethods:(FTDataSourceObserverMethods)methods ofChangesInDataSource:(id<FTDataSource>)dataSource
+{
+    if (methods & FTDataSourceObserverMethodDidDeleteItems) {
+        [self enumerateDeletedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+            [observer dataSource:dataSource didDeleteItemsAtIndexPaths:FTChangeSetIndexPaths(section, items)];
+        }];
+    }
+
+    if ([_deletedSections count] > 0 && (methods & FTDataSourceObserverMethodDidDeleteSections)) {
+        [observer dataSource:dataSource didDeleteSections:[_deletedSections copy]];
+    }
+
+    if ([_insertedSections count] > 0 && (methods & FTDataSourceObserverMethodDidInsertSections)) {
+        [observer dataSource:dataSource didInsertSections:[_insertedSections copy]];
+    }
+
+    if (methods & FTDataSourceObserverMethodDidInsertItems) {
+        [self enumerateInsertedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+            [observer dataSource:dataSource didInsertItemsAtIndexPaths:FTChangeSetIndexPaths(section, items)];
+        }];
+    }
+
+    if ([_changedSections count] > 0 && (methods & FTDataSourceObserverMethodDidChangeSections)) {
+        [observer dataSource:dataSource didChangeSections:[_changedSections copy]];
+    }
+
+    if (methods & FTDataSourceObserverMethodDidChangeItems) {
+        [self enumerateChangedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+            [observer dataSource:dataSource didChangeItemsAtIndexPaths:FTChangeSetIndexPaths(section, items)];
+        }];
+    }
+
+    if (methods & FTDataSourceObserverMethodDidMoveSection) {
+        [self enumerateSectionMovesUsingBlock:^(NSUInteger section, NSUInteger newSection, BOOL *stop) {
+            [observer dataSource:dataSource didMoveSection:section toSection:newSection];
+        }];
+    }
+
+    if (methods & FTDataSourceObserverMethodDidMoveItem) {
+        [self enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+            [observer dataSource:dataSource didMoveItemAtIndexPath:indexPath toIndexPath:newIndexPath];
+        }];
+    }
+}
+
+static NSArray *FTChangeSetIndexPaths(NSUInteger section, NSIndexSet *items)
+{
+    NSMutableArray *indexPaths = [[NSMutableArray alloc] initWithCapacity:[items count]];
+    [items enumerateIndexesUsingBlock:^(NSUInteger item, BOOL *stop) {
+        NSUInteger indexes[] = {section, item};
+        [indexPaths addObject:[NSIndexPath indexPathWithIndexes:indexes length:2]];
+    }];
+    return indexPaths;
+}
+
+#pragma mark Computing Change Sets
+
++ (FTChangeSet *)changeSetFromSections:(NSArray *)sections
+                          sectionItems:(NSArray *)sectionItems
+                            toSections:(NSArray *)newSections
+                          sectionItems:(NSArray *)newSectionItems
+                          changedItems:(NSSet *)changedItems
+{
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+    NSNull *null = [NSNull null];
+
+    NSUInteger numberOfSections = [sections count];
+    NSUInteger newNumberOfSections = [newSections count];
+
+    // Match the sections. Sections with a section item are matched by the
+    // equality of their section items, sections without a section item are
+    // matched by their position.
+
+    NSMapTable *indexesOfSectionItems = [NSMapTable strongToStrongObjectsMapTable];
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        id sectionItem = sectionItems[section];
+        if (sectionItem != null) {
+            NSMutableIndexSet *indexes = [indexesOfSectionItems objectForKey:sectionItem];
+            if (indexes == nil) {
+                indexes = [[NSMutableIndexSet alloc] init];
+                [indexesOfSectionItems setObject:indexes forKey:sectionItem];
+            }
+            [indexes addIndex:section];
+        }
+    }
+
+    NSMutableData *sectionMatchesData = [[NSMutableData alloc] initWithLength:newNumberOfSections * sizeof(NSUInteger)];
+    NSUInteger *sectionMatches = [sectionMatchesData mutableBytes];
+
+    NSMutableIndexSet *deletedSections = [[NSMutableIndexSet alloc] initWithIndexesInRange:NSMakeRange(0, numberOfSections)];
+    NSMutableIndexSet *insertedSections = [[NSMutableIndexSet alloc] init];
+    NSMutableIndexSet *changedSections = [[NSMutableIndexSet alloc] init];
+
+    for (NSUInteger newSection = 0; newSection < newNumberOfSections; newSection++) {
+        id sectionItem = newSectionItems[newSection];
+        NSUInteger section = NSNotFound;
+        if (sectionItem != null) {
+            NSMutableIndexSet *indexes = [indexesOfSectionItems objectForKey:sectionItem];
+            if ([indexes count] > 0) {
+                section = [indexes firstIndex];
+                [indexes removeIndex:section];
+            }
+        } else if (newSection < numberOfSections && sectionItems[newSection] == null) {
+            section = newSection;
+        }
+
+        sectionMatches[newSection] = section;
+        if (section == NSNotFound) {
+            [insertedSections addIndex:newSection];
+        } else {
+            [deletedSections removeIndex:section];
+        }
+    }
+
+    NSIndexSet *stableSections = FTIndexesOfLongestIncreasingSubsequence(sectionMatches, newNumberOfSections);
+    for (NSUInteger newSection = 0; newSection < newNumberOfSections; newSection++) {
+        NSUInteger section = sectionMatches[newSection];
+        if (section == NSNotFound) {
+            continue;
+        } else if ([stableSections containsIndex:newSection]) {
+            id sectionItem = newSectionItems[newSection];
+            if (sectionItem != null && FTChangeSetIsChangedItem(sectionItems[section], sectionItem, changedItems)) {
+                [changedSections addIndex:section];
+            }
+        } else {
+            [changeSet moveSection:section toSection:newSection];
+        }
+    }
+
+    [changeSet deleteSections:deletedSections];
+    [changeSet insertSections:insertedSections];
+    [changeSet changeSections:changedSections];
+
+    // Skip the common prefix and suffix of each pair of matched sections. Equal
+    // items, which are not identical or which are marked as changed, are
+    // reported as changed.
+
+    NSMutableArray *deletedItems = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+    NSMutableArray *changedItemIndexes = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        [deletedItems addObject:[[NSMutableIndexSet alloc] init]];
+        [changedItemIndexes addObject:[[NSMutableIndexSet alloc] init]];
+    }
+
+    NSMutableData *rangesData = [[NSMutableData alloc] initWithLength:newNumberOfSections * sizeof(NSRange)];
+    NSRange *newRanges = [rangesData mutableBytes];
+
+    NSMapTable *indexPathsOfItems = [NSMapTable strongToStrongObjectsMapTable];
+
+    for (NSUInteger newSection = 0; newSection < newNumberOfSections; newSection++) {
+        NSUInteger section = sectionMatches[newSection];
+        if (section == NSNotFound) {
+            continue;
+        }
+
+        NSArray *items = sections[section];
+        NSArray *newItems = newSections[newSection];
+        NSMutableIndexSet *changedIndexes = changedItemIndexes[section];
+
+        NSUInteger count = [items count];
+        NSUInteger newCount = [newItems count];
+
+        NSUInteger start = 0;
+        while (start < count && start < newCount && [items[start] isEqual:newItems[start]]) {
+            if (FTChangeSetIsChangedItem(items[start], newItems[start], changedItems)) {
+                [changedIndexes addIndex:start];
+            }
+            start++;
+        }
+
+        NSUInteger end = count;
+        NSUInteger newEnd = newCount;
+        while (end > start && newEnd > start && [items[end - 1] isEqual:newItems[newEnd - 1]]) {
+            if (FTChangeSetIsChangedItem(items[end - 1], newItems[newEnd - 1], changedItems)) {
+                [changedIndexes addIndex:end - 1];
+            }
+            end--;
+            newEnd--;
+        }
+
+        newRanges[newSection] = NSMakeRange(start, newEnd - start);
+
+        for (NSUInteger index = start; index < end; index++) {
+            id item = items[index];
+            NSMutableArray *indexPaths = [indexPathsOfItems objectForKey:item];
+            if (indexPaths == nil) {
+                indexPaths = [[NSMutableArray alloc] init];
+                [indexPathsOfItems setObject:indexPaths forKey:item];
+            }
+            [indexPaths addObject:FTChangeSetIndexPath(section, index)];
+        }
+        [deletedItems[section] addIndexesInRange:NSMakeRange(start, end - start)];
+    }
+
+    // Match the remaining items by equality (Heckel) across all matched
+    // sections. Multiple occurrences of an item are matched in the order of
+    // their appearance. Within a pair of matched sections, the items in the
+    // longest increasing subsequence of their previous indexes keep their
+    // relative order. All other matched items are reported as moved, which
+    // yields the minimal number of moves. A moved item, which is changed, is
+    // also reported as changed at its previous index.
+
+    for (NSUInteger newSection = 0; newSection < newNumberOfSections; newSection++) {
+        NSUInteger section = sectionMatches[newSection];
+        if (section == NSNotFound) {
+            continue;
+        }
+
+        NSArray *items = sections[section];
+        NSArray *newItems = newSections[newSection];
+        NSRange range = newRanges[newSection];
+
+        NSMutableData *matchesData = [[NSMutableData alloc] initWithLength:range.length * sizeof(NSUInteger)];
+        NSUInteger *matches = [matchesData mutableBytes];
+        NSMutableIndexSet *insertedIndexes = [[NSMutableIndexSet alloc] init];
+
+        for (NSUInteger offset = 0; offset < range.length; offset++) {
+            NSUInteger newIndex = range.location + offset;
+            NSMutableArray *indexPaths = [indexPathsOfItems objectForKey:newItems[newIndex]];
+            matches[offset] = NSNotFound;
+            if ([indexPaths count] > 0) {
+                NSIndexPath *indexPath = indexPaths[0];
+                [indexPaths removeObjectAtIndex:0];
+
+                NSUInteger matchedSection = [indexPath indexAtPosition:0];
+                NSUInteger index = [indexPath indexAtPosition:1];
+                [deletedItems[matchedSection] removeIndex:index];
+
+                if (matchedSection == section) {
+                    matches[offset] = index;
+                } else {
+                    [changeSet moveItemAtIndexPath:indexPath toIndexPath:FTChangeSetIndexPath(newSection, newIndex)];
+                    if (FTChangeSetIsChangedItem(sections[matchedSection][index], newItems[newIndex], changedItems)) {
+                        [changedItemIndexes[matchedSection] addIndex:index];
+                    }
+                }
+            } else {
+                [insertedIndexes addIndex:newIndex];
+            }
+        }
+
+        NSIndexSet *stableOffsets = FTIndexesOfLongestIncreasingSubsequence(matches, range.length);
+        for (NSUInteger offset = 0; offset < range.length; offset++) {
+            NSUInteger index = matches[offset];
+            NSUInteger newIndex = range.location + offset;
+            if (index == NSNotFound) {
+                continue;
+            }
+            if ([stableOffsets containsIndex:offset] == NO) {
+                [changeSet moveItemAtIndexPath:FTChangeSetIndexPath(section, index)
+                                   toIndexPath:FTChangeSetIndexPath(newSection, newIndex)];
+            }
+            if (FTChangeSetIsChangedItem(items[index], newItems[newIndex], changedItems)) {
+                [changedItemIndexes[section] addIndex:index];
+            }
+        }
+
+        if ([insertedIndexes count] > 0) {
+            [changeSet insertItemsAtIndexes:insertedIndexes inSection:newSection];
+        }
+    }
+
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        if ([deletedItems[section] count] > 0) {
+            [changeSet deleteItemsAtIndexes:deletedItems[section] inSection:section];
+        }
+        if ([changedItemIndexes[section] count] > 0) {
+            [changeSet changeItemsAtIndexes:changedItemIndexes[section] inSection:section];
+        }
+    }
+
+    return changeSet;
+}
+
+static NSIndexPath *FTChangeSetIndexPath(NSUInteger section, NSUInteger item)
+{
+    NSUInteger indexes[] = {section, item};
+    return [NSIndexPath indexPathWithIndexes:indexes length:2];
+}
+
+static BOOL FTChangeSetIsChangedItem(id item, id newItem, NSSet *changedItems)
+{
+    return item != newItem || [changedItems containsObject:newItem];
+}
+
+#pragma mark Applying Changes
+
+- (BOOL)isValidForNumberOfItemsInSections:(NSArray *)numberOfItemsInSections
+{
+    NSUInteger numberOfSections = [numberOfItemsInSections count];
+
+    if ([_deletedSections count] > 0 && [_deletedSections lastIndex] >= numberOfSections) {
+        return NO;
+    }
+
+    if ([_changedSections count] > 0 && [_changedSections lastIndex] >= numberOfSections) {
+        return NO;
+    }
+
+    __block BOOL valid = YES;
+
+    [self enumerateSectionMovesUsingBlock:^(NSUInteger section, NSUInteger newSection, BOOL *stop) {
+        if (section >= numberOfSections) {
+            valid = NO;
+            *stop = YES;
+        }
+    }];
+
+    void (^validateItems)(NSUInteger, NSIndexSet *, BOOL *) = ^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        if (section >= numberOfSections || [items lastIndex] >= [numberOfItemsInSections[section] unsignedIntegerValue]) {
+            valid = NO;
+            *stop = YES;
+        }
+    };
+
+    [self enumerateDeletedItemsUsingBlock:validateItems];
+    [self enumerateChangedItemsUsingBlock:validateItems];
+
+    [self enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        validateItems([indexPath indexAtPosition:0], [NSIndexSet indexSetWithIndex:[indexPath indexAtPosition:1]], stop);
+    }];
+
+    return valid;
+}
+
+- (BOOL)applyToSections:(NSMutableArray *)sections
+                sectionItems:(NSMutableArray *)sectionItems
+           insertedItemBlock:(id (^)(NSIndexPath *))insertedItemBlock
+    insertedSectionItemBlock:(id (^)(NSUInteger))insertedSectionItemBlock
+{
+    NSMutableArray *numberOfItemsInSections = [[NSMutableArray alloc] initWithCapacity:[sections count]];
+    for (NSArray *items in sections) {
+        [numberOfItemsInSections addObject:@([items count])];
+    }
+
+    if ([self isValidForNumberOfItemsInSections:numberOfItemsInSections] == NO) {
+        return NO;
+    }
+
+    // Moved sections and items are removed together with the deleted sections
+    // and items (relative to the previous state) and inserted again together
+    // with the inserted sections and items (relative to the new state).
+
+    NSMutableArray *removedItems = [[NSMutableArray alloc] initWithCapacity:[sections count]];
+    for (NSUInteger section = 0; section < [sections count]; section++) {
+        [removedItems addObject:[[NSMutableIndexSet alloc] init]];
+    }
+
+    [self enumerateDeletedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [removedItems[section] addIndexes:items];
+    }];
+
+    NSMutableArray *insertedItems = [[NSMutableArray alloc] init];
+    [self enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        NSUInteger section = [indexPath indexAtPosition:0];
+        NSUInteger item = [indexPath indexAtPosition:1];
+        [removedItems[section] addIndex:item];
+        [insertedItems addObject:@[ newIndexPath, sections[section][item] ]];
+    }];
+
+    NSMutableIndexSet *removedSections = [_deletedSections mutableCopy];
+    NSMutableArray *insertedSections = [[NSMutableArray alloc] init];
+    [self enumerateSectionMovesUsingBlock:^(NSUInteger section, NSUInteger newSection, BOOL *stop) {
+        [removedSections addIndex:section];
+        [insertedSections addObject:@[ @(newSection), sectionItems[section], sections[section] ]];
+    }];
+
+    [sections enumerateObjectsUsingBlock:^(NSMutableArray *items, NSUInteger section, BOOL *stop) {
+        [items removeObjectsAtIndexes:removedItems[section]];
+    }];
+    [sections removeObjectsAtIndexes:removedSections];
+    [sectionItems removeObjectsAtIndexes:removedSections];
+
+    // Insert the sections
+
+    [_insertedSections enumerateIndexesUsingBlock:^(NSUInteger section, BOOL *stop) {
+        id sectionItem = (insertedSectionItemBlock ? insertedSectionItemBlock(section) : nil) ?: [NSNull null];
+        [insertedSections addObject:@[ @(section), sectionItem, [[NSMutableArray alloc] init] ]];
+    }];
+
+    [insertedSections sortUsingComparator:^NSComparisonResult(NSArray *a, NSArray *b) {
+        return [a[0] compare:b[0]];
+    }];
+
+    for (NSArray *insertedSection in insertedSections) {
+        NSUInteger section = [insertedSection[0] unsignedIntegerValue];
+        if (section > [sections count]) {
+            return NO;
+        }
+        [sectionItems insertObject:insertedSection[1] atIndex:section];
+        [sections insertObject:insertedSection[2] atIndex:section];
+    }
+
+    // Insert the items
+
+    [self enumerateInsertedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [items enumerateIndexesUsingBlock:^(NSUInteger item, BOOL *stop) {
+            NSIndexPath *indexPath = FTChangeSetIndexPath(section, item);
+            id insertedItem = (insertedItemBlock ? insertedItemBlock(indexPath) : nil) ?: [NSNull null];
+            [insertedItems addObject:@[ indexPath, insertedItem ]];
+        }];
+    }];
+
+    [insertedItems sortUsingComparator:^NSComparisonResult(NSArray *a, NSArray *b) {
+        return [a[0] compare:b[0]];
+    }];
+
+    for (NSArray *insertedItem in insertedItems) {
+        NSIndexPath *indexPath = insertedItem[0];
+        NSUInteger section = [indexPath indexAtPosition:0];
+        NSUInteger item = [indexPath indexAtPosition:1];
+        if (section >= [sections count] || item > [sections[section] count]) {
+            return NO;
+        }
+        [sections[section] insertObject:insertedItem[1] atIndex:item];
+    }
+
+    return YES;
+}
+
+- (NSUInteger)sectionAfterChangesOfSection:(NSUInteger)section
+{
+    if ([_deletedSections containsIndex:section]) {
+        return NSNotFound;
+    }
+
+    NSMutableIndexSet *removedSections = [_deletedSections mutableCopy];
+    NSMutableIndexSet *insertedSections = [_insertedSections mutableCopy];
+    __block NSUInteger newSection = NSNotFound;
+    [self enumerateSectionMovesUsingBlock:^(NSUInteger from, NSUInteger to, BOOL *stop) {
+        [removedSections addIndex:from];
+        [insertedSections addIndex:to];
+        if (from == section) {
+            newSection = to;
+        }
+    }];
+
+    return newSection != NSNotFound ? newSection : FTChangeSetIndexAfterChanges(section, removedSections, insertedSections);
+}
+
+- (NSIndexPath *)indexPathAfterChangesOfItemAtIndexPath:(NSIndexPath *)indexPath
+{
+    NSUInteger section = [indexPath indexAtPosition:0];
+    NSUInteger item = [indexPath indexAtPosition:1];
+
+    NSUInteger newSection = [self sectionAfterChangesOfSection:section];
+    if (newSection == NSNotFound || [[self deletedItemsInSection:section] containsIndex:item]) {
+        return nil;
+    }
+
+    // Moved items are removed from the section before and inserted into
+    // the section after the changes, like deleted and inserted items.
+
+    NSMutableIndexSet *removedItems = [[self deletedItemsInSection:section] mutableCopy];
+    NSMutableIndexSet *insertedItems = [[self insertedItemsInSection:newSection] mutableCopy];
+    __block NSIndexPath *newIndexPath = nil;
+    [self enumerateItemMovesUsingBlock:^(NSIndexPath *from, NSIndexPath *to, BOOL *stop) {
+        if ([from isEqual:indexPath]) {
+            newIndexPath = to;
+            *stop = YES;
+        }
+        if ([from indexAtPosition:0] == section) {
+            [removedItems addIndex:[from indexAtPosition:1]];
+        }
+        if ([to indexAtPosition:0] == newSection) {
+            [insertedItems addIndex:[to indexAtPosition:1]];
+        }
+    }];
+
+    return newIndexPath ?: FTChangeSetIndexPath(newSection, FTChangeSetIndexAfterChanges(item, removedItems, insertedItems));
+}
+
+static NSUInteger FTChangeSetIndexAfterChanges(NSUInteger index, NSIndexSet *removedIndexes, NSIndexSet *insertedIndexes)
+{
+    // The removed indexes refer to the state before, the inserted indexes to
+    // the state after the changes.
+
+    NSUInteger newIndex = index - [removedIndexes countOfIndexesInRange:NSMakeRange(0, index)];
+    NSUInteger insertedIndex = [insertedIndexes firstIndex];
+    while (insertedIndex != NSNotFound && insertedIndex <= newIndex) {
+        newIndex++;
+        insertedIndex = [insertedIndexes indexGreaterThanIndex:insertedIndex];
+    }
+    return newIndex;
+}
+
+#pragma mark NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    return [[FTChangeSet alloc] initWithChangeSet:self];
+}
+
+#pragma mark NSMutableCopying
+
+- (id)mutableCopyWithZone:(NSZone *)zone
+{
+    return [[FTMutableChangeSet alloc] initWithChangeSet:self];
+}
+
+#pragma mark NSObject
+
+- (NSString *)description
+{
+    NSMutableString *description = [NSMutableString stringWithFormat:@"<%@: %p", NSStringFromClass([self class]), (__bridge void *)self];
+
+    if ([_deletedSections count] > 0) {
+        [description appendFormat:@" deleted sections: %@", _deletedSections];
+    }
+    if ([_insertedSections count] > 0) {
+        [description appendFormat:@" inserted sections: %@", _insertedSections];
+    }
+    if ([_changedSections count] > 0) {
+        [description appendFormat:@" changed sections: %@", _changedSections];
+    }
+    [self enumerateDeletedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [description appendFormat:@" deleted items in section %lu: %@", (unsigned long)section, items];
+    }];
+    [self enumerateInsertedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [description appendFormat:@" inserted items in section %lu: %@", (unsigned long)section, items];
+    }];
+    [self enumerateChangedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [description appendFormat:@" changed items in section %lu: %@", (unsigned long)section, items];
+    }];
+    [self enumerateSectionMovesUsingBlock:^(NSUInteger section, NSUInteger newSection, BOOL *stop) {
+        [description appendFormat:@" moved section: %lu -> %lu", (unsigned long)section, (unsigned long)newSection];
+    }];
+    [self enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        [description appendFormat:@" moved item: (%lu, %lu) -> (%lu, %lu)",
+                                  (unsigned long)[indexPath indexAtPosition:0], (unsigned long)[indexPath indexAtPosition:1],
+                                  (unsigned long)[newIndexPath indexAtPosition:0], (unsigned long)[newIndexPath indexAtPosition:1]];
+    }];
+
+    [description appendString:@">"];
+    return description;
+}
+
+@end
+
+@implementation FTMutableChangeSet
+
+#pragma mark Sections
+
+- (void)insertSections:(NSIndexSet *)sections
+{
+    [_insertedSections addIndexes:sections];
+}
+
+- (void)deleteSections:(NSIndexSet *)sections
+{
+    [_deletedSections addIndexes:sections];
+}
+
+- (void)changeSections:(NSIndexSet *)sections
+{
+    [_changedSections addIndexes:sections];
+}
+
+- (void)moveSection:(NSUInteger)section toSection:(NSUInteger)newSection
+{
+    FTChangeSetSectionMove move = {section, newSection};
+    [_sectionMoves appendBytes:&move length:sizeof(FTChangeSetSectionMove)];
+}
+
+#pragma mark Items
+
+- (void)insertItemsAtIndexes:(NSIndexSet *)indexes inSection:(NSUInteger)section
+{
+    [FTChangeSetItems(_insertedItems, section) addIndexes:indexes];
+}
+
+- (void)deleteItemsAtIndexes:(NSIndexSet *)indexes inSection:(NSUInteger)section
+{
+    [FTChangeSetItems(_deletedItems, section) addIndexes:indexes];
+}
+
+- (void)changeItemsAtIndexes:(NSIndexSet *)indexes inSection:(NSUInteger)section
+{
+    [FTChangeSetItems(_changedItems, section) addIndexes:indexes];
+}
+
+- (void)moveItemAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath
+{
+    FTChangeSetItemMove move = {[indexPath indexAtPosition:0], [indexPath indexAtPosition:1],
+                                [newIndexPath indexAtPosition:0], [newIndexPath indexAtPosition:1]};
+    [_itemMoves appendBytes:&move length:sizeof(FTChangeSetItemMove)];
+}
+
+- (void)insertItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    FTChangeSetAddIndexPaths(_insertedItems, indexPaths);
+}
+
+- (void)deleteItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    FTChangeSetAddIndexPaths(_deletedItems, indexPaths);
+}
+
+- (void)changeItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    FTChangeSetAddIndexPaths(_changedItems, indexPaths);
+}
+
+static NSMutableIndexSet *FTChangeSetItems(NSMutableDictionary *itemsBySection, NSUInteger section)
+{
+    NSMutableIndexSet *items = [itemsBySection objectForKey:@(section)];
+    if (items == nil) {
+        items = [[NSMutableIndexSet alloc] init];
+        [itemsBySection setObject:items forKey:@(section)];
+    }
+    return items;
+}
+
+static void FTChangeSetAddIndexPaths(NSMutableDictionary *itemsBySection, NSArray *indexPaths)
+{
+    for (NSIndexPath *indexPath in indexPaths) {
+        [FTChangeSetItems(itemsBySection, [indexPath indexAtPosition:0]) addIndex:[indexPath indexAtPosition:1]];
+    }
+}
+
+#pragma mark Combining Change Sets
+
+- (void)addChangesFromChangeSet:(FTChangeSet *)changeSet sectionOffset:(NSUInteger)offset
+{
+    [_insertedSections addIndexes:FTChangeSetShiftedIndexes(changeSet->_insertedSections, offset)];
+    [_deletedSections addIndexes:FTChangeSetShiftedIndexes(changeSet->_deletedSections, offset)];
+    [_changedSections addIndexes:FTChangeSetShiftedIndexes(changeSet->_changedSections, offset)];
+
+    [changeSet enumerateSectionMovesUsingBlock:^(NSUInteger section, NSUInteger newSection, BOOL *stop) {
+        [self moveSection:section + offset toSection:newSection + offset];
+    }];
+
+    [changeSet enumerateInsertedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [self insertItemsAtIndexes:items inSection:section + offset];
+    }];
+    [changeSet enumerateDeletedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [self deleteItemsAtIndexes:items inSection:section + offset];
+    }];
+    [changeSet enumerateChangedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [self changeItemsAtIndexes:items inSection:section + offset];
+    }];
+
+    const FTChangeSetItemMove *moves = [changeSet->_itemMoves bytes];
+    NSUInteger count = [changeSet->_itemMoves length] / sizeof(FTChangeSetItemMove);
+    for (NSUInteger i = 0; i < count; i++) {
+        FTChangeSetItemMove move = moves[i];
+        move.section += offset;
+        move.newSection += offset;
+        [_itemMoves appendBytes:&move length:sizeof(FTChangeSetItemMove)];
+    }
+}
+
+static NSIndexSet *FTChangeSetShiftedIndexes(NSIndexSet *indexes, NSUInteger offset)
+{
+    if (offset == 0 || [indexes count] == 0) {
+        return indexes;
+    }
+    NSMutableIndexSet *shiftedIndexes = [indexes mutableCopy];
+    [shiftedIndexes shiftIndexesStartingAtIndex:0 by:offset];
+    return shiftedIndexes;
+}
+
+#pragma mark Removing Changes
+
+- (void)removeChangedItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    for (NSIndexPath *indexPath in indexPaths) {
+        NSNumber *section = @([indexPath indexAtPosition:0]);
+        NSMutableIndexSet *items = [_changedItems objectForKey:section];
+        [items removeIndex:[indexPath indexAtPosition:1]];
+        if ([items count] == 0) {
+            [_changedItems removeObjectForKey:section];
+        }
+    }
+}
+
+- (void)removeAllChanges
+{
+    [_insertedSections removeAllIndexes];
+    [_deletedSections removeAllIndexes];
+    [_changedSections removeAllIndexes];
+    [_sectionMoves setLength:0];
+
+    [_insertedItems removeAllObjects];
+    [_deletedItems removeAllObjects];
+    [_changedItems removeAllObjects];
+    [_itemMoves setLength:0];
+}
+
+@end
+
+#pragma mark Longest Increasing Subsequence
+
+static NSIndexSet *FTIndexesOfLongestIncreasingSubsequence(const NSUInteger *values, NSUInteger count)
+{
+    // Patience sorting: tails[k] is the position of the smallest value ending an
+    // increasing subsequence of length k + 1. Values of NSNotFound are skipped.
+
+    NSMutableData *tailsData = [[NSMutableData alloc] initWithLength:count * sizeof(NSUInteger)];
+    NSMutableData *predecessorsData = [[NSMutableData alloc] initWithLength:count * sizeof(NSUInteger)];
+    NSUInteger *tails = [tailsData mutableBytes];
+    NSUInteger *predecessors = [predecessorsData mutableBytes];
+
+    NSUInteger length = 0;
+    for (NSUInteger position = 0; position < count; position++) {
+        if (values[position] == NSNotFound) {
+            continue;
+        }
+
+        NSUInteger low = 0;
+        NSUInteger high = length;
+        while (low < high) {
+            NSUInteger mid = low + (high - low) / 2;
+            if (values[tails[mid]] < values[position]) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+
+        predecessors[position] = low > 0 ? tails[low - 1] : NSNotFound;
+        tails[low] = position;
+        if (low == length) {
+            length++;
+        }
+    }
+
+    NSMutableIndexSet *positions = [[NSMutableIndexSet alloc] init];
+    NSUInteger position = length > 0 ? tails[length - 1] : NSNotFound;
+    while (position != NSNotFound) {
+        [positions addIndex:position];
+        position = predecessors[position];
+    }
+    return positions;
+}
@@ -0,0 +1,53 @@
+//
+//  FTCoalescingDataSource.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 30.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FTDataSource.h"
+#import "FTReverseDataSource.h"
+
+/*! <code>FTCoalescingDataSource</code> wraps another data source and coalesces its changes.
+
+    The changes of the wrapped data source are buffered until the end of the current run loop
+    turn or, if an interval is given, until the interval has passed since the first buffered
+    change. Then the net change between the published state and the current state of the
+    wrapped data source is reported to the observers as one batch: an item inserted and
+    deleted again within the window is not reported at all and multiple changes of the same
+    item are reported once. If the wrapped data source resets within the window, its state is
+    read again and the difference to the published state is reported as well (the observers
+    are not reset).
+
+    The data source methods always read the published state. The changes of the batches of the
+    wrapped data source are applied to a copy of the published state, which only reads the
+    inserted and changed items from the wrapped data source. Items and sections are matched by
+    equality. The wrapper is meant to be used on the main thread.
+ */
+@interface FTCoalescingDataSource : NSObject <FTDataSource, FTReverseDataSource>
+
+#pragma mark Life-cycle
+- (instancetype)initWithDataSource:(id<FTDataSource>)dataSource;
+- (instancetype)initWithDataSource:(id<FTDataSource>)dataSource interval:(NSTimeInterval)interval;
+
+#pragma mark Data Source
+@property (nonatomic, readonly) id<FTDataSource> dataSource;
+
+#pragma mark Interval
+
+// The time changes are buffered before they are published. An interval of 0
+// (the default) publishes the changes at the end of the current run loop turn.
+@property (nonatomic, readonly) NSTimeInterval interval;
+
+#pragma mark Publishing Changes
+
+// Returns YES, if the wrapped data source has changed since the last time the changes have been published.
+@property (nonatomic, readonly) BOOL hasPendingChanges;
+
+// Publishes the pending changes immediately instead of waiting for the window to end.
+- (void)flush;
+
+@end
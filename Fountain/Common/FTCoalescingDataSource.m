@@ -0,0 +1,460 @@
+//
+//  FTCoalescingDataSource.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 30.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTChangeSet.h"
+#import "FTDataSourceObserver.h"
+#import "FTObserverRegistry.h"
+
+#import "FTCoalescingDataSource.h"
+
+@interface FTCoalescingDataSource () <FTDataSourceChangeSetObserver> {
+    FTObserverRegistry *_observers;
+
+    // Published state (sections with their items and the section items, NSNull
+    // for sections without a section item)
+    NSArray *_sections;
+    NSArray *_sectionItems;
+
+    // State of the wrapped data source after its last batch. The state is a
+    // mutable copy of the published state, to which the change sets of the
+    // batches are applied. It is nil, if there are no pending changes or if
+    // the state has to be read from the wrapped data source (e.g., after a
+    // reset of the wrapped data source).
+    NSMutableArray *_currentSections;
+    NSMutableArray *_currentSectionItems;
+    BOOL _needsSnapshot;
+
+    FTMutableChangeSet *_dataSourceChangeSet;
+    NSMutableSet *_changedItems;
+    BOOL _flushScheduled;
+}
+
+@end
+
+@implementation FTCoalescingDataSource
+
+#pragma mark Life-cycle
+
+- (instancetype)initWithDataSource:(id<FTDataSource>)dataSource
+{
+    return [self initWithDataSource:dataSource interval:0];
+}
+
+- (instancetype)initWithDataSource:(id<FTDataSource>)dataSource interval:(NSTimeInterval)interval
+{
+    self = [super init];
+    if (self) {
+        _dataSource = dataSource;
+        _interval = MAX(interval, 0);
+        _observers = [[FTObserverRegistry alloc] init];
+        _dataSourceChangeSet = [[FTMutableChangeSet alloc] init];
+        _changedItems = [[NSMutableSet alloc] init];
+
+        [self ft_takeSnapshotOfDataSource];
+        _sections = _currentSections;
+        _sectionItems = _currentSectionItems;
+        _currentSections = nil;
+        _currentSectionItems = nil;
+
+        [_dataSource addObserver:self];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [_dataSource removeObserver:self];
+}
+
+#pragma mark Snapshot
+
+- (void)ft_takeSnapshotOfDataSource
+{
+    NSUInteger numberOfSections = [_dataSource numberOfSections];
+
+    NSMutableArray *sections = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+    NSMutableArray *sectionItems = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        NSUInteger numberOfItems = [_dataSource numberOfItemsInSection:section];
+        NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:numberOfItems];
+        for (NSUInteger item = 0; item < numberOfItems; item++) {
+            NSUInteger indexes[] = {section, item};
+            [items addObject:[_dataSource itemAtIndexPath:[NSIndexPath indexPathWithIndexes:indexes length:2]]];
+        }
+        [sections addObject:items];
+        [sectionItems addObject:[_dataSource sectionItemForSection:section] ?: [NSNull null]];
+    }
+
+    _currentSections = sections;
+    _currentSectionItems = sectionItems;
+}
+
+- (void)ft_beginCurrentState
+{
+    // The first batch of a window copies the published state. The items are
+    // not read from the wrapped data source.
+
+    NSMutableArray *sections = [[NSMutableArray alloc] initWithCapacity:[_sections count]];
+    for (NSArray *items in _sections) {
+        [sections addObject:[items mutableCopy]];
+    }
+
+    _currentSections = sections;
+    _currentSectionItems = [_sectionItems mutableCopy];
+}
+
+- (BOOL)ft_applyChangeSetToCurrentState:(FTChangeSet *)changeSet
+{
+    // Only the inserted and changed items are read from the wrapped data
+    // source. Changed items are read again, because the wrapped data source
+    // can replace an item with another object.
+
+    id<FTDataSource> dataSource = _dataSource;
+    BOOL success = [changeSet applyToSections:_currentSections
+        sectionItems:_currentSectionItems
+        insertedItemBlock:^id(NSIndexPath *indexPath) {
+            return [dataSource itemAtIndexPath:indexPath];
+        }
+        insertedSectionItemBlock:^id(NSUInteger section) {
+            return [dataSource sectionItemForSection:section];
+        }];
+
+    if (success == NO) {
+        return NO;
+    }
+
+    __block BOOL valid = YES;
+    [changeSet enumerateChangedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [items enumerateIndexesUsingBlock:^(NSUInteger item, BOOL *stop) {
+            NSUInteger indexes[] = {section, item};
+            NSIndexPath *newIndexPath = [changeSet indexPathAfterChangesOfItemAtIndexPath:[NSIndexPath indexPathWithIndexes:indexes length:2]];
+            if (newIndexPath) {
+                NSUInteger newSection = [newIndexPath indexAtPosition:0];
+                NSUInteger newItem = [newIndexPath indexAtPosition:1];
+                if (newSection < [_currentSections count] && newItem < [_currentSections[newSection] count]) {
+                    _currentSections[newSection][newItem] = [dataSource itemAtIndexPath:newIndexPath];
+                } else {
+                    valid = NO;
+                    *stop = YES;
+                }
+            }
+        }];
+        *stop = !valid;
+    }];
+
+    // Changed sections are read again completely, because the number of
+    // items of a changed section can differ.
+
+    [[changeSet changedSections] enumerateIndexesUsingBlock:^(NSUInteger section, BOOL *stop) {
+        NSUInteger newSection = [changeSet sectionAfterChangesOfSection:section];
+        if (newSection < [_currentSections count]) {
+            NSUInteger numberOfItems = [dataSource numberOfItemsInSection:newSection];
+            NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:numberOfItems];
+            for (NSUInteger item = 0; item < numberOfItems; item++) {
+                NSUInteger indexes[] = {newSection, item};
+                [items addObject:[dataSource itemAtIndexPath:[NSIndexPath indexPathWithIndexes:indexes length:2]]];
+            }
+            _currentSections[newSection] = items;
+            _currentSectionItems[newSection] = [dataSource sectionItemForSection:newSection] ?: [NSNull null];
+        }
+    }];
+
+    return valid;
+}
+
+- (void)ft_collectChangedItems
+{
+    // The changed sections and items refer to the state before the batch of
+    // the wrapped data source, which is still the current state. The objects
+    // are kept (and later matched by equality), because the indexes do not
+    // survive the following batches.
+
+    NSArray *sections = _currentSections;
+    NSArray *sectionItems = _currentSectionItems;
+
+    [[_dataSourceChangeSet changedSections] enumerateIndexesUsingBlock:^(NSUInteger section, BOOL *stop) {
+        if (section < [sectionItems count] && sectionItems[section] != [NSNull null]) {
+            [_changedItems addObject:sectionItems[section]];
+        }
+        if (section < [sections count]) {
+            [_changedItems addObjectsFromArray:sections[section]];
+        }
+    }];
+
+    [_dataSourceChangeSet enumerateChangedItemsUsingBlock:^(NSUInteger section, NSIndexSet *indexes, BOOL *stop) {
+        if (section < [sections count]) {
+            NSArray *items = sections[section];
+            [indexes enumerateIndexesUsingBlock:^(NSUInteger item, BOOL *stop) {
+                if (item < [items count]) {
+                    [_changedItems addObject:items[item]];
+                }
+            }];
+        }
+    }];
+}
+
+#pragma mark Publishing Changes
+
+- (BOOL)hasPendingChanges
+{
+    return _currentSections != nil || _needsSnapshot;
+}
+
+- (void)ft_scheduleFlush
+{
+    if (_flushScheduled == NO) {
+        _flushScheduled = YES;
+        [self performSelector:@selector(flush) withObject:nil afterDelay:_interval inModes:@[ NSRunLoopCommonModes ]];
+    }
+}
+
+- (void)flush
+{
+    if (_flushScheduled) {
+        _flushScheduled = NO;
+        [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(flush) object:nil];
+    }
+
+    if ([self hasPendingChanges] == NO) {
+        return;
+    }
+
+    // The wrapped data source is only read completely, if the changes could
+    // not be tracked (e.g., after a reset of the wrapped data source).
+
+    if (_needsSnapshot) {
+        [self ft_takeSnapshotOfDataSource];
+        _needsSnapshot = NO;
+    }
+
+    NSArray *sections = _currentSections;
+    NSArray *sectionItems = _currentSectionItems;
+    _currentSections = nil;
+    _currentSectionItems = nil;
+
+    FTChangeSet *changeSet = [FTChangeSet changeSetFromSections:_sections
+                                                   sectionItems:_sectionItems
+                                                     toSections:sections
+                                                   sectionItems:sectionItems
+                                                   changedItems:_changedItems];
+    [_changedItems removeAllObjects];
+
+    if ([changeSet isEmpty]) {
+        // The changes cancelled each other out.
+        _sections = sections;
+        _sectionItems = sectionItems;
+        return;
+    }
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodWillChange) {
+            [observer dataSourceWillChange:self];
+        }
+    }];
+
+    _sections = sections;
+    _sectionItems = sectionItems;
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidApplyChangeSet) {
+            [(id<FTDataSourceChangeSetObserver>)observer dataSource:self didApplyChangeSet:changeSet];
+        } else {
+            [changeSet notifyObserver:observer implementingMethods:methods ofChangesInDataSource:self];
+        }
+    }];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidChange) {
+            [observer dataSourceDidChange:self];
+        }
+    }];
+}
+
+#pragma mark FTDataSource
+
+#pragma mark Getting Item and Section Metrics
+
+- (NSUInteger)numberOfSections
+{
+    return [_sections count];
+}
+
+- (NSUInteger)numberOfItemsInSection:(NSUInteger)section
+{
+    if (section >= [_sections count]) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. %ld].", __PRETTY_FUNCTION__, (long)section, (long)[_sections count]];
+    }
+
+    return [_sections[section] count];
+}
+
+#pragma mark Getting Items and Sections
+
+- (id)sectionItemForSection:(NSUInteger)section
+{
+    if (section >= [_sections count]) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. %ld].", __PRETTY_FUNCTION__, (long)section, (long)[_sections count]];
+    }
+
+    id sectionItem = _sectionItems[section];
+    return sectionItem == [NSNull null] ? nil : sectionItem;
+}
+
+- (id)itemAtIndexPath:(NSIndexPath *)indexPath
+{
+    if ([indexPath length] != 2) {
+        [NSException raise:NSInvalidArgumentException format:@"*** %s: length of index path must be 2, got an index path with length %lu.", __PRETTY_FUNCTION__, (unsigned long)[indexPath length]];
+    }
+
+    NSUInteger section = [indexPath indexAtPosition:0];
+    NSUInteger item = [indexPath indexAtPosition:1];
+
+    if (section >= [_sections count]) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. %ld].", __PRETTY_FUNCTION__, (long)section, (long)[_sections count]];
+    }
+
+    return [_sections[section] objectAtIndex:item];
+}
+
+#pragma mark Observer
+
+- (NSArray *)observers
+{
+    return [_observers observers];
+}
+
+- (void)addObserver:(id<FTDataSourceObserver>)observer
+{
+    [_observers addObserver:observer];
+}
+
+- (void)removeObserver:(id<FTDataSourceObserver>)observer
+{
+    [_observers removeObserver:observer];
+}
+
+#pragma mark FTReverseDataSource
+
+- (NSIndexSet *)sectionsOfSectionItem:(id)sectionItem
+{
+    return [_sectionItems indexesOfObjectsPassingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) {
+        return [obj isEqual:sectionItem];
+    }];
+}
+
+- (NSArray *)indexPathsOfItem:(id)item
+{
+    NSMutableArray *indexPaths = [[NSMutableArray alloc] init];
+    [_sections enumerateObjectsUsingBlock:^(NSArray *items, NSUInteger section, BOOL *stop) {
+        [items enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+            if ([obj isEqual:item]) {
+                NSUInteger indexes[] = {section, idx};
+                [indexPaths addObject:[NSIndexPath indexPathWithIndexes:indexes length:2]];
+            }
+        }];
+    }];
+    return indexPaths;
+}
+
+#pragma mark - FTDataSourceObserver
+
+#pragma mark Reload
+
+- (void)dataSourceDidReset:(id<FTDataSource>)dataSource
+{
+    // The items changed during a reset are unknown. Only the items, which
+    // are no longer identical, are reported as changed. The state of the
+    // wrapped data source is read once, when the changes are published.
+
+    [_dataSourceChangeSet removeAllChanges];
+    _currentSections = nil;
+    _currentSectionItems = nil;
+    _needsSnapshot = YES;
+    [self ft_scheduleFlush];
+}
+
+#pragma mark Begin End Updates
+
+- (void)dataSourceDidChange:(id<FTDataSource>)dataSource
+{
+    if ([_dataSourceChangeSet isEmpty]) {
+        return;
+    }
+
+    if (_needsSnapshot == NO) {
+        if (_currentSections == nil) {
+            [self ft_beginCurrentState];
+        }
+
+        [self ft_collectChangedItems];
+
+        if ([self ft_applyChangeSetToCurrentState:_dataSourceChangeSet] == NO) {
+            // The changes don't match the tracked state.
+            _currentSections = nil;
+            _currentSectionItems = nil;
+            _needsSnapshot = YES;
+        }
+    }
+
+    [_dataSourceChangeSet removeAllChanges];
+    [self ft_scheduleFlush];
+}
+
+#pragma mark Manage Sections
+
+- (void)dataSource:(id<FTDataSource>)dataSource didInsertSections:(NSIndexSet *)sections
+{
+    [_dataSourceChangeSet insertSections:sections];
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didDeleteSections:(NSIndexSet *)sections
+{
+    [_dataSourceChangeSet deleteSections:sections];
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didChangeSections:(NSIndexSet *)sections
+{
+    [_dataSourceChangeSet changeSections:sections];
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didMoveSection:(NSInteger)section toSection:(NSInteger)newSection
+{
+    [_dataSourceChangeSet moveSection:section toSection:newSection];
+}
+
+#pragma mark Manage Items
+
+- (void)dataSource:(id<FTDataSource>)dataSource didInsertItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    [_dataSourceChangeSet insertItemsAtIndexPaths:indexPaths];
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didDeleteItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    [_dataSourceChangeSet deleteItemsAtIndexPaths:indexPaths];
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didChangeItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    [_dataSourceChangeSet changeItemsAtIndexPaths:indexPaths];
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didMoveItemAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath
+{
+    [_dataSourceChangeSet moveItemAtIndexPath:indexPath toIndexPath:newIndexPath];
+}
+
+#pragma mark FTDataSourceChangeSetObserver
+
+- (void)dataSource:(id<FTDataSource>)dataSource didApplyChangeSet:(FTChangeSet *)changeSet
+{
+    [_dataSourceChangeSet addChangesFromChangeSet:changeSet sectionOffset:0];
+}
+
+@end
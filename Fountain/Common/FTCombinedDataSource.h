@@ -32,4 +32,13 @@
 - (NSIndexPath *)convertIndexPath:(NSIndexPath *)indexPath toDataSource:(id<FTDataSource>)dataSource;
 - (NSIndexPath *)convertIndexPath:(NSIndexPath *)indexPath fromDataSource:(id<FTDataSource>)dataSource;
 
+#pragma mark Item Index
+
+// If set, the combined data source keeps track of the data sources containing an
+// item or section item, and the reverse lookups only ask those data sources. The index
+// is built with the first lookup and updated with the changes of the data sources.
+// Data sources loading their items on demand (conforming to FTPrefetchingDataSource)
+// are not indexed and always asked.
+@property (nonatomic, readwrite) BOOL indexesItems;
+
 @end
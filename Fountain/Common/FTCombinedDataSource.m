@@ -6,15 +6,33 @@
 //  Copyright © 2015 Tobias Kräntzer. All rights reserved.
 //
 
+#import "FTChangeSet.h"
 #import "FTDataSourceObserver.h"
+#import "FTInstrumentation.h"
+#import "FTObserverRegistry.h"
+#import "FTPrefetchingDataSource.h"
+#import "FTPrefixSums.h"
 
 #import "FTCombinedDataSource.h"
 
-@interface FTCombinedDataSource () <FTDataSourceObserver> {
-    NSHashTable *_observers;
-    NSMutableArray *_sectionRanges;
+@interface FTCombinedDataSource () <FTDataSourceChangeSetObserver> {
+    FTObserverRegistry *_observers;
+    NSMapTable *_indexesOfDataSources;
+    FTPrefixSums *_numbersOfSections;
 
     NSUInteger _dataSourceChangeCallCount;
+    FTMutableChangeSet *_changeSet;
+    FTInstrumentationSpan *_instrumentationSpan;
+
+    NSMapTable *_dataSourceIndexesOfItems;
+    NSMapTable *_dataSourceIndexesOfSectionItems;
+    NSMutableArray *_itemsOfDataSources;
+    NSMutableArray *_sectionItemsOfDataSources;
+    NSMutableArray *_indexedSectionsOfDataSources;
+    NSMutableArray *_indexedSectionItemsOfDataSources;
+    NSMutableArray *_itemIndexChangeSetsOfDataSources;
+    NSMutableIndexSet *_dataSourcesWithStaleItemIndex;
+    NSIndexSet *_dataSourcesWithoutItemIndex;
 }
 
 @end
@@ -28,18 +46,24 @@
     self = [super init];
     if (self) {
         _dataSources = [dataSources copy];
-        _observers = [NSHashTable weakObjectsHashTable];
-        _sectionRanges = [[NSMutableArray alloc] init];
+        _observers = [[FTObserverRegistry alloc] init];
+        _indexesOfDataSources = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                      valueOptions:NSPointerFunctionsStrongMemory];
+        _changeSet = [[FTMutableChangeSet alloc] init];
 
-        NSUInteger offset = 0;
-        for (id<FTDataSource> dataSource in _dataSources) {
+        NSUInteger *numbersOfSections = malloc(sizeof(NSUInteger) * MAX([_dataSources count], 1));
+        [_dataSources enumerateObjectsUsingBlock:^(id<FTDataSource> dataSource, NSUInteger idx, BOOL *stop) {
             [dataSource addObserver:self];
 
-            NSUInteger numberOfSections = [dataSource numberOfSections];
-            [_sectionRanges addObject:[NSValue valueWithRange:NSMakeRange(offset, numberOfSections)]];
+            // If a data source is added more than once, it is routed to its first occurrence.
+            if ([_indexesOfDataSources objectForKey:dataSource] == nil) {
+                [_indexesOfDataSources setObject:@(idx) forKey:dataSource];
+            }
 
-            offset += numberOfSections;
-        }
+            numbersOfSections[idx] = [dataSource numberOfSections];
+        }];
+        _numbersOfSections = [[FTPrefixSums alloc] initWithValues:numbersOfSections count:[_dataSources count]];
+        free(numbersOfSections);
     }
     return self;
 }
@@ -48,23 +72,13 @@
 
 - (id<FTDataSource>)dataSourceOfIndexPath:(NSIndexPath *)indexPath
 {
-    for (id<FTDataSource> dataSource in _dataSources) {
-        NSRange range = [self sectionRangeOfDataSource:dataSource];
-        if (NSLocationInRange([indexPath indexAtPosition:0], range)) {
-            return dataSource;
-        }
-    }
-    return nil;
+    return [self dataSourceOfSection:[indexPath indexAtPosition:0]];
 }
 
 - (id<FTDataSource>)dataSourceOfSection:(NSUInteger)section
 {
-    NSUInteger dataSourceIndex = [_sectionRanges indexOfObjectPassingTest:^BOOL(NSValue *value, NSUInteger idx, BOOL *stop) {
-        NSRange range = [value rangeValue];
-        return NSLocationInRange(section, range);
-    }];
-
-    if (dataSourceIndex != NSNotFound) {
+    NSUInteger dataSourceIndex = [_numbersOfSections indexOfPosition:section offset:NULL];
+    if (dataSourceIndex < [_dataSources count]) {
         return [_dataSources objectAtIndex:dataSourceIndex];
     } else {
         return nil;
@@ -73,28 +87,25 @@
 
 - (NSRange)sectionRangeOfDataSource:(id<FTDataSource>)dataSource
 {
-    NSUInteger dataSourceIndex = [_dataSources indexOfObject:dataSource];
-    return [[_sectionRanges objectAtIndex:dataSourceIndex] rangeValue];
+    NSUInteger dataSourceIndex = [self ft_indexOfDataSource:dataSource];
+    return NSMakeRange([_numbersOfSections sumOfValuesBeforeIndex:dataSourceIndex],
+                       [_numbersOfSections valueAtIndex:dataSourceIndex]);
 }
 
-- (void)setSectionRange:(NSRange)range ofDataSource:(id<FTDataSource>)dataSource
+- (void)setNumberOfSections:(NSUInteger)numberOfSections ofDataSource:(id<FTDataSource>)dataSource
 {
-    NSUInteger dataSourceIndex = [_dataSources indexOfObject:dataSource];
-    [_sectionRanges replaceObjectAtIndex:dataSourceIndex withObject:[NSValue valueWithRange:range]];
-
-    NSUInteger offset = NSMaxRange(range);
-
-    dataSourceIndex++;
-    while (dataSourceIndex < [_sectionRanges count]) {
-
-        NSRange range = [[_sectionRanges objectAtIndex:dataSourceIndex] rangeValue];
-        range.location = offset;
-        [_sectionRanges replaceObjectAtIndex:dataSourceIndex withObject:[NSValue valueWithRange:range]];
-
-        offset += range.length;
+    NSUInteger dataSourceIndex = [self ft_indexOfDataSource:dataSource];
+    [_numbersOfSections setValue:numberOfSections atIndex:dataSourceIndex];
+}
 
-        dataSourceIndex++;
+- (NSUInteger)ft_indexOfDataSource:(id<FTDataSource>)dataSource
+{
+    NSNumber *dataSourceIndex = [_indexesOfDataSources objectForKey:dataSource];
+    if (dataSourceIndex == nil) {
+        [NSException raise:NSInvalidArgumentException
+                    format:@"*** %s: %@ is not one of the combined data sources.", __PRETTY_FUNCTION__, dataSource];
     }
+    return [dataSourceIndex unsignedIntegerValue];
 }
 
 - (NSUInteger)convertSection:(NSUInteger)section toDataSource:(id<FTDataSource>)dataSource
@@ -139,15 +150,345 @@
     }
 }
 
+#pragma mark Item Index
+
+- (void)setIndexesItems:(BOOL)indexesItems
+{
+    if (_indexesItems == indexesItems) {
+        return;
+    }
+
+    _indexesItems = indexesItems;
+
+    if (_indexesItems) {
+        _dataSourceIndexesOfItems = [NSMapTable strongToStrongObjectsMapTable];
+        _dataSourceIndexesOfSectionItems = [NSMapTable strongToStrongObjectsMapTable];
+        _itemsOfDataSources = [[NSMutableArray alloc] initWithCapacity:[_dataSources count]];
+        _sectionItemsOfDataSources = [[NSMutableArray alloc] initWithCapacity:[_dataSources count]];
+        _indexedSectionsOfDataSources = [[NSMutableArray alloc] initWithCapacity:[_dataSources count]];
+        _indexedSectionItemsOfDataSources = [[NSMutableArray alloc] initWithCapacity:[_dataSources count]];
+        _itemIndexChangeSetsOfDataSources = [[NSMutableArray alloc] initWithCapacity:[_dataSources count]];
+        for (NSUInteger i = 0; i < [_dataSources count]; i++) {
+            [_itemsOfDataSources addObject:[[NSCountedSet alloc] init]];
+            [_sectionItemsOfDataSources addObject:[[NSCountedSet alloc] init]];
+            [_indexedSectionsOfDataSources addObject:[[NSMutableArray alloc] init]];
+            [_indexedSectionItemsOfDataSources addObject:[[NSMutableArray alloc] init]];
+            [_itemIndexChangeSetsOfDataSources addObject:[[FTMutableChangeSet alloc] init]];
+        }
+        _dataSourcesWithStaleItemIndex = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [_dataSources count])];
+
+        // Data sources loading their items on demand (e.g., a faulting FTFetchedDataSource)
+        // are not indexed, because that would load all items. They are always asked.
+        _dataSourcesWithoutItemIndex = [_dataSources indexesOfObjectsPassingTest:^BOOL(id<FTDataSource> dataSource, NSUInteger idx, BOOL *stop) {
+            return [dataSource conformsToProtocol:@protocol(FTPrefetchingDataSource)];
+        }];
+    } else {
+        _dataSourceIndexesOfItems = nil;
+        _dataSourceIndexesOfSectionItems = nil;
+        _itemsOfDataSources = nil;
+        _sectionItemsOfDataSources = nil;
+        _indexedSectionsOfDataSources = nil;
+        _indexedSectionItemsOfDataSources = nil;
+        _itemIndexChangeSetsOfDataSources = nil;
+        _dataSourcesWithStaleItemIndex = nil;
+        _dataSourcesWithoutItemIndex = nil;
+    }
+}
+
+- (NSArray *)ft_dataSourcesForLookupOfItem:(id)item sectionItem:(BOOL)sectionItem
+{
+    if (_indexesItems == NO) {
+        return _dataSources;
+    }
+
+    [self ft_updateStaleItemIndex];
+
+    NSMapTable *itemIndex = sectionItem ? _dataSourceIndexesOfSectionItems : _dataSourceIndexesOfItems;
+    NSMutableIndexSet *dataSourceIndexes = [_dataSourcesWithoutItemIndex mutableCopy];
+    [dataSourceIndexes addIndexes:[itemIndex objectForKey:item] ?: [NSIndexSet indexSet]];
+    return [_dataSources objectsAtIndexes:dataSourceIndexes];
+}
+
+- (BOOL)ft_indexesItemsOfDataSourceAtIndex:(NSUInteger)dataSourceIndex
+{
+    id<FTDataSource> dataSource = [_dataSources objectAtIndex:dataSourceIndex];
+    return [dataSource conformsToProtocol:@protocol(FTReverseDataSource)] &&
+           ![_dataSourcesWithoutItemIndex containsIndex:dataSourceIndex];
+}
+
+- (void)ft_invalidateItemIndexOfDataSource:(id<FTDataSource>)dataSource
+{
+    if (_indexesItems) {
+        NSUInteger dataSourceIndex = [self ft_indexOfDataSource:dataSource];
+        [_dataSourcesWithStaleItemIndex addIndex:dataSourceIndex];
+        [[_itemIndexChangeSetsOfDataSources objectAtIndex:dataSourceIndex] removeAllChanges];
+    }
+}
+
+- (FTMutableChangeSet *)ft_itemIndexChangeSetOfDataSource:(id<FTDataSource>)dataSource
+{
+    // Collects the individual callbacks of a data source, which are applied
+    // to the index together, when the data source did change.
+
+    if (_indexesItems) {
+        NSUInteger dataSourceIndex = [self ft_indexOfDataSource:dataSource];
+        if ([self ft_indexesItemsOfDataSourceAtIndex:dataSourceIndex]) {
+            return [_itemIndexChangeSetsOfDataSources objectAtIndex:dataSourceIndex];
+        }
+    }
+    return nil;
+}
+
+- (void)ft_updateItemIndexOfDataSource:(id<FTDataSource>)dataSource withChangeSet:(FTChangeSet *)changeSet
+{
+    if (_indexesItems == NO) {
+        return;
+    }
+
+    NSUInteger dataSourceIndex = [self ft_indexOfDataSource:dataSource];
+    if ([_dataSourcesWithStaleItemIndex containsIndex:dataSourceIndex] ||
+        ![self ft_indexesItemsOfDataSourceAtIndex:dataSourceIndex] ||
+        [changeSet isEmpty]) {
+        return;
+    }
+
+    NSMutableArray *sections = [_indexedSectionsOfDataSources objectAtIndex:dataSourceIndex];
+    NSMutableArray *sectionItems = [_indexedSectionItemsOfDataSources objectAtIndex:dataSourceIndex];
+
+    NSMutableArray *numberOfItemsInSections = [[NSMutableArray alloc] initWithCapacity:[sections count]];
+    for (NSArray *items in sections) {
+        [numberOfItemsInSections addObject:@([items count])];
+    }
+
+    if (![changeSet isValidForNumberOfItemsInSections:numberOfItemsInSections]) {
+        // The changes don't match the indexed items.
+        [_dataSourcesWithStaleItemIndex addIndex:dataSourceIndex];
+        return;
+    }
+
+    // Only the objects leaving the index are removed before applying the
+    // changes: the deleted items and section items, and the previous objects
+    // of the changed items. Moved items keep their objects, also if they are
+    // moved out of a deleted section.
+
+    NSMutableSet *movedItems = [[NSMutableSet alloc] init];
+    [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        [movedItems addObject:indexPath];
+    }];
+
+    [[changeSet deletedSections] enumerateIndexesUsingBlock:^(NSUInteger section, BOOL *stop) {
+        [self ft_unindexSectionItem:sectionItems[section] ofDataSourceAtIndex:dataSourceIndex];
+        [sections[section] enumerateObjectsUsingBlock:^(id item, NSUInteger idx, BOOL *stop) {
+            NSUInteger indexes[] = {section, idx};
+            if (![movedItems containsObject:[NSIndexPath indexPathWithIndexes:indexes length:2]]) {
+                [self ft_unindexItem:item ofDataSourceAtIndex:dataSourceIndex];
+            }
+        }];
+    }];
+
+    [changeSet enumerateDeletedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        if (![[changeSet deletedSections] containsIndex:section]) {
+            [items enumerateIndexesUsingBlock:^(NSUInteger item, BOOL *stop) {
+                [self ft_unindexItem:sections[section][item] ofDataSourceAtIndex:dataSourceIndex];
+            }];
+        }
+    }];
+
+    // Changed sections are read again completely after applying the changes,
+    // therefore changed items ending up in these sections are skipped here.
+
+    NSMutableIndexSet *changedSections = [[NSMutableIndexSet alloc] init];
+    [[changeSet changedSections] enumerateIndexesUsingBlock:^(NSUInteger section, BOOL *stop) {
+        NSUInteger newSection = [changeSet sectionAfterChangesOfSection:section];
+        if (newSection != NSNotFound) {
+            [changedSections addIndex:newSection];
+        }
+    }];
+
+    NSMutableArray *changedItems = [[NSMutableArray alloc] init];
+    [changeSet enumerateChangedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [items enumerateIndexesUsingBlock:^(NSUInteger item, BOOL *stop) {
+            NSUInteger indexes[] = {section, item};
+            NSIndexPath *newIndexPath = [changeSet indexPathAfterChangesOfItemAtIndexPath:[NSIndexPath indexPathWithIndexes:indexes length:2]];
+            if (newIndexPath && ![changedSections containsIndex:[newIndexPath indexAtPosition:0]]) {
+                [self ft_unindexItem:sections[section][item] ofDataSourceAtIndex:dataSourceIndex];
+                [changedItems addObject:newIndexPath];
+            }
+        }];
+    }];
+
+    // Only the inserted items are read from the data source. Moved items keep
+    // their objects.
+
+    BOOL success = [changeSet applyToSections:sections
+        sectionItems:sectionItems
+        insertedItemBlock:^id(NSIndexPath *indexPath) {
+            return [self ft_indexItemAtIndexPath:indexPath ofDataSourceAtIndex:dataSourceIndex];
+        }
+        insertedSectionItemBlock:^id(NSUInteger section) {
+            return [self ft_indexSectionItemOfSection:section ofDataSourceAtIndex:dataSourceIndex];
+        }];
+
+    if (success == NO) {
+        [_dataSourcesWithStaleItemIndex addIndex:dataSourceIndex];
+        return;
+    }
+
+    for (NSIndexPath *indexPath in changedItems) {
+        NSUInteger section = [indexPath indexAtPosition:0];
+        NSUInteger item = [indexPath indexAtPosition:1];
+        sections[section][item] = [self ft_indexItemAtIndexPath:indexPath ofDataSourceAtIndex:dataSourceIndex];
+    }
+
+    // The objects of a changed section after applying the changes (including
+    // the items moved into the section) are replaced by the current ones.
+
+    [changedSections enumerateIndexesUsingBlock:^(NSUInteger section, BOOL *stop) {
+        [self ft_unindexSectionItem:sectionItems[section] ofDataSourceAtIndex:dataSourceIndex];
+        for (id item in sections[section]) {
+            [self ft_unindexItem:item ofDataSourceAtIndex:dataSourceIndex];
+        }
+        sectionItems[section] = [self ft_indexSectionItemOfSection:section ofDataSourceAtIndex:dataSourceIndex];
+        sections[section] = [self ft_indexItemsInSection:section ofDataSourceAtIndex:dataSourceIndex];
+    }];
+}
+
+- (void)ft_updateStaleItemIndex
+{
+    [_dataSourcesWithStaleItemIndex enumerateIndexesUsingBlock:^(NSUInteger dataSourceIndex, BOOL *stop) {
+
+        [self ft_removeObjects:[_itemsOfDataSources objectAtIndex:dataSourceIndex]
+                 fromItemIndex:_dataSourceIndexesOfItems
+               dataSourceIndex:dataSourceIndex];
+        [self ft_removeObjects:[_sectionItemsOfDataSources objectAtIndex:dataSourceIndex]
+                 fromItemIndex:_dataSourceIndexesOfSectionItems
+               dataSourceIndex:dataSourceIndex];
+
+        NSMutableArray *sections = [_indexedSectionsOfDataSources objectAtIndex:dataSourceIndex];
+        NSMutableArray *sectionItems = [_indexedSectionItemsOfDataSources objectAtIndex:dataSourceIndex];
+        [sections removeAllObjects];
+        [sectionItems removeAllObjects];
+
+        id<FTDataSource> dataSource = [_dataSources objectAtIndex:dataSourceIndex];
+        if ([self ft_indexesItemsOfDataSourceAtIndex:dataSourceIndex]) {
+            for (NSUInteger section = 0; section < [dataSource numberOfSections]; section++) {
+                [sectionItems addObject:[self ft_indexSectionItemOfSection:section ofDataSourceAtIndex:dataSourceIndex]];
+                [sections addObject:[self ft_indexItemsInSection:section ofDataSourceAtIndex:dataSourceIndex]];
+            }
+        }
+    }];
+    [_dataSourcesWithStaleItemIndex removeAllIndexes];
+}
+
+- (NSMutableArray *)ft_indexItemsInSection:(NSUInteger)section ofDataSourceAtIndex:(NSUInteger)dataSourceIndex
+{
+    id<FTDataSource> dataSource = [_dataSources objectAtIndex:dataSourceIndex];
+    NSUInteger numberOfItems = [dataSource numberOfItemsInSection:section];
+
+    NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:numberOfItems];
+    for (NSUInteger item = 0; item < numberOfItems; item++) {
+        NSUInteger indexes[] = {section, item};
+        [items addObject:[self ft_indexItemAtIndexPath:[NSIndexPath indexPathWithIndexes:indexes length:2]
+                                   ofDataSourceAtIndex:dataSourceIndex]];
+    }
+    return items;
+}
+
+- (id)ft_indexItemAtIndexPath:(NSIndexPath *)indexPath ofDataSourceAtIndex:(NSUInteger)dataSourceIndex
+{
+    id<FTDataSource> dataSource = [_dataSources objectAtIndex:dataSourceIndex];
+    id item = [dataSource itemAtIndexPath:indexPath];
+    if (item) {
+        [self ft_addObject:item
+                 toObjects:[_itemsOfDataSources objectAtIndex:dataSourceIndex]
+                 itemIndex:_dataSourceIndexesOfItems
+           dataSourceIndex:dataSourceIndex];
+    }
+    return item ?: [NSNull null];
+}
+
+- (id)ft_indexSectionItemOfSection:(NSUInteger)section ofDataSourceAtIndex:(NSUInteger)dataSourceIndex
+{
+    id<FTDataSource> dataSource = [_dataSources objectAtIndex:dataSourceIndex];
+    id sectionItem = [dataSource sectionItemForSection:section];
+    if (sectionItem) {
+        [self ft_addObject:sectionItem
+                 toObjects:[_sectionItemsOfDataSources objectAtIndex:dataSourceIndex]
+                 itemIndex:_dataSourceIndexesOfSectionItems
+           dataSourceIndex:dataSourceIndex];
+    }
+    return sectionItem ?: [NSNull null];
+}
+
+- (void)ft_unindexItem:(id)item ofDataSourceAtIndex:(NSUInteger)dataSourceIndex
+{
+    if (item != [NSNull null]) {
+        [self ft_removeObject:item
+                  fromObjects:[_itemsOfDataSources objectAtIndex:dataSourceIndex]
+                    itemIndex:_dataSourceIndexesOfItems
+              dataSourceIndex:dataSourceIndex];
+    }
+}
+
+- (void)ft_unindexSectionItem:(id)sectionItem ofDataSourceAtIndex:(NSUInteger)dataSourceIndex
+{
+    if (sectionItem != [NSNull null]) {
+        [self ft_removeObject:sectionItem
+                  fromObjects:[_sectionItemsOfDataSources objectAtIndex:dataSourceIndex]
+                    itemIndex:_dataSourceIndexesOfSectionItems
+              dataSourceIndex:dataSourceIndex];
+    }
+}
+
+- (void)ft_addObject:(id)object toObjects:(NSCountedSet *)objects itemIndex:(NSMapTable *)itemIndex dataSourceIndex:(NSUInteger)dataSourceIndex
+{
+    // The objects are counted, because a data source can contain an
+    // object more than once.
+
+    [objects addObject:object];
+    if ([objects countForObject:object] > 1) {
+        return;
+    }
+
+    NSMutableIndexSet *dataSourceIndexes = [itemIndex objectForKey:object];
+    if (dataSourceIndexes == nil) {
+        dataSourceIndexes = [[NSMutableIndexSet alloc] init];
+        [itemIndex setObject:dataSourceIndexes forKey:object];
+    }
+    [dataSourceIndexes addIndex:dataSourceIndex];
+}
+
+- (void)ft_removeObject:(id)object fromObjects:(NSCountedSet *)objects itemIndex:(NSMapTable *)itemIndex dataSourceIndex:(NSUInteger)dataSourceIndex
+{
+    [objects removeObject:object];
+    if ([objects countForObject:object] > 0) {
+        return;
+    }
+
+    NSMutableIndexSet *dataSourceIndexes = [itemIndex objectForKey:object];
+    [dataSourceIndexes removeIndex:dataSourceIndex];
+    if ([dataSourceIndexes count] == 0) {
+        [itemIndex removeObjectForKey:object];
+    }
+}
+
+- (void)ft_removeObjects:(NSCountedSet *)objects fromItemIndex:(NSMapTable *)itemIndex dataSourceIndex:(NSUInteger)dataSourceIndex
+{
+    for (id object in objects) {
+        NSMutableIndexSet *dataSourceIndexes = [itemIndex objectForKey:object];
+        [dataSourceIndexes removeIndex:dataSourceIndex];
+        if ([dataSourceIndexes count] == 0) {
+            [itemIndex removeObjectForKey:object];
+        }
+    }
+    [objects removeAllObjects];
+}
+
 #pragma mark Getting Item and Section Metrics
 
 - (NSUInteger)numberOfSections
 {
-    NSUInteger numberOfSections = 0;
-    for (id<FTDataSource> dataSource in _dataSources) {
-        numberOfSections += [dataSource numberOfSections];
-    }
-    return numberOfSections;
+    return [_numbersOfSections totalSum];
 }
 
 - (NSUInteger)numberOfItemsInSection:(NSUInteger)section
@@ -185,12 +526,12 @@
 - (NSIndexSet *)sectionsOfSectionItem:(id)sectionItem
 {
     NSMutableIndexSet *sections = [[NSMutableIndexSet alloc] init];
-    for (id<FTDataSource> dataSource in _dataSources) {
+    for (id<FTDataSource> dataSource in [self ft_dataSourcesForLookupOfItem:sectionItem sectionItem:YES]) {
         if ([dataSource conformsToProtocol:@protocol(FTReverseDataSource)]) {
             id<FTReverseDataSource> reverseDataSource = (id<FTReverseDataSource>)dataSource;
             NSMutableIndexSet *dataSourceSections = [[reverseDataSource sectionsOfSectionItem:sectionItem] mutableCopy];
             NSRange sectionRange = [self sectionRangeOfDataSource:dataSource];
-            [dataSourceSections shiftIndexesStartingAtIndex:0 by:-1 * sectionRange.location];
+            [dataSourceSections shiftIndexesStartingAtIndex:0 by:sectionRange.location];
             [sections addIndexes:dataSourceSections];
         }
     }
@@ -202,7 +543,7 @@
 - (NSArray *)indexPathsOfItem:(id)item
 {
     NSMutableArray *indexPaths = [[NSMutableArray alloc] init];
-    for (id<FTDataSource> dataSource in _dataSources) {
+    for (id<FTDataSource> dataSource in [self ft_dataSourcesForLookupOfItem:item sectionItem:NO]) {
         if ([dataSource conformsToProtocol:@protocol(FTReverseDataSource)]) {
             id<FTReverseDataSource> reverseDataSource = (id<FTReverseDataSource>)dataSource;
             for (NSIndexPath *indexPath in [reverseDataSource indexPathsOfItem:item]) {
@@ -217,17 +558,17 @@
 
 - (NSArray *)observers
 {
-    return [_observers allObjects];
+    return [_observers observers];
 }
 
 - (void)addObserver:(id<FTDataSourceObserver>)observer
 {
-    [_observers addObject:observer];
+    [_observers addObserver:observer];
 }
 
 - (void)removeObserver:(id<FTDataSourceObserver>)observer
 {
-    [_observers removeObject:observer];
+    [_observers removeObserver:observer];
 }
 
 #pragma mark - FTMutableDataSource
@@ -378,6 +719,8 @@
 
 - (void)dataSourceDidReset:(id<FTDataSource>)dataSource
 {
+    [self ft_invalidateItemIndexOfDataSource:dataSource];
+
     NSInteger numberOfSections = [dataSource numberOfSections];
 
     NSRange sectionRange = [self sectionRangeOfDataSource:dataSource];
@@ -400,21 +743,33 @@
         deletedSections = [NSIndexSet indexSetWithIndexesInRange:deletedRange];
     }
 
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([deletedSections count] > 0 && [observer respondsToSelector:@selector(dataSource:didDeleteSections:)]) {
+    if (deletedSections) {
+        [_changeSet deleteSections:deletedSections];
+    }
+    if (insertedSections) {
+        [_changeSet insertSections:insertedSections];
+    }
+    [_changeSet changeSections:changedSections];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidApplyChangeSet) {
+            return;
+        }
+
+        if ([deletedSections count] > 0 && (methods & FTDataSourceObserverMethodDidDeleteSections)) {
             [observer dataSource:self didDeleteSections:deletedSections];
         }
 
-        if ([insertedSections count] > 0 && [observer respondsToSelector:@selector(dataSource:didInsertSections:)]) {
+        if ([insertedSections count] > 0 && (methods & FTDataSourceObserverMethodDidInsertSections)) {
             [observer dataSource:self didInsertSections:insertedSections];
         }
 
-        if ([changedSections count] > 0 && [observer respondsToSelector:@selector(dataSource:didChangeSections:)]) {
+        if ([changedSections count] > 0 && (methods & FTDataSourceObserverMethodDidChangeSections)) {
             [observer dataSource:self didChangeSections:changedSections];
         }
-    }
+    }];
 
-    [self setSectionRange:newSectionRange ofDataSource:dataSource];
+    [self setNumberOfSections:numberOfSections ofDataSource:dataSource];
 
     [self dataSourceDidChange:dataSource];
 }
@@ -424,26 +779,57 @@
 - (void)dataSourceWillChange:(id<FTDataSource>)dataSource
 {
     if (_dataSourceChangeCallCount == 0) {
-        for (id<FTDataSourceObserver> observer in self.observers) {
-            if ([observer respondsToSelector:@selector(dataSourceWillChange:)]) {
+        _instrumentationSpan = [FTInstrumentationSpan spanWithName:@"FTCombinedDataSource.batch"];
+        _observers.instrumentationSpan = _instrumentationSpan;
+        [_instrumentationSpan beginPhase:@"notify"];
+
+        [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+            if (methods & FTDataSourceObserverMethodWillChange) {
                 [observer dataSourceWillChange:self];
             }
-        }
+        }];
+
+        [_instrumentationSpan endPhase];
     }
 
+    [_instrumentationSpan addCount:1 forKey:@"children"];
+
     _dataSourceChangeCallCount++;
 }
 
 - (void)dataSourceDidChange:(id<FTDataSource>)dataSource
 {
+    FTMutableChangeSet *itemIndexChangeSet = [self ft_itemIndexChangeSetOfDataSource:dataSource];
+    if (itemIndexChangeSet && ![itemIndexChangeSet isEmpty]) {
+        [self ft_updateItemIndexOfDataSource:dataSource withChangeSet:itemIndexChangeSet];
+        [itemIndexChangeSet removeAllChanges];
+    }
+
     _dataSourceChangeCallCount--;
 
     if (_dataSourceChangeCallCount == 0) {
-        for (id<FTDataSourceObserver> observer in self.observers) {
-            if ([observer respondsToSelector:@selector(dataSourceDidChange:)]) {
+
+        [_instrumentationSpan beginPhase:@"notify"];
+
+        FTChangeSet *changeSet = [_changeSet copy];
+        [_changeSet removeAllChanges];
+
+        [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+            if (methods & FTDataSourceObserverMethodDidApplyChangeSet) {
+                [(id<FTDataSourceChangeSetObserver>)observer dataSource:self didApplyChangeSet:changeSet];
+            }
+        }];
+
+        [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+            if (methods & FTDataSourceObserverMethodDidChange) {
                 [observer dataSourceDidChange:self];
             }
-        }
+        }];
+
+        FTInstrumentationSpan *span = _instrumentationSpan;
+        _instrumentationSpan = nil;
+        _observers.instrumentationSpan = nil;
+        [span finish];
     }
 }
 
@@ -451,118 +837,189 @@
 
 - (void)dataSource:(id<FTDataSource>)dataSource didInsertSections:(NSIndexSet *)dataSourceSections
 {
+    [[self ft_itemIndexChangeSetOfDataSource:dataSource] insertSections:dataSourceSections];
+
     NSRange sectionRange = [self sectionRangeOfDataSource:dataSource];
-    sectionRange.length += [dataSourceSections count];
-    [self setSectionRange:sectionRange ofDataSource:dataSource];
+    [self setNumberOfSections:sectionRange.length + [dataSourceSections count] ofDataSource:dataSource];
 
     NSMutableIndexSet *sections = [dataSourceSections mutableCopy];
     [sections shiftIndexesStartingAtIndex:0 by:sectionRange.location];
 
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didInsertSections:)]) {
+    [_changeSet insertSections:sections];
+    [_instrumentationSpan addCount:[sections count] forKey:@"sections"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidInsertSections) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self didInsertSections:sections];
         }
-    }
+    }];
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didDeleteSections:(NSIndexSet *)dataSourceSections
 {
+    [[self ft_itemIndexChangeSetOfDataSource:dataSource] deleteSections:dataSourceSections];
+
     NSRange sectionRange = [self sectionRangeOfDataSource:dataSource];
-    sectionRange.length -= [dataSourceSections count];
-    [self setSectionRange:sectionRange ofDataSource:dataSource];
+    [self setNumberOfSections:sectionRange.length - [dataSourceSections count] ofDataSource:dataSource];
 
     NSMutableIndexSet *sections = [dataSourceSections mutableCopy];
     [sections shiftIndexesStartingAtIndex:0 by:sectionRange.location];
 
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didDeleteSections:)]) {
+    [_changeSet deleteSections:sections];
+    [_instrumentationSpan addCount:[sections count] forKey:@"sections"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidDeleteSections) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self didDeleteSections:sections];
         }
-    }
+    }];
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didChangeSections:(NSIndexSet *)dataSourceSections
 {
+    [[self ft_itemIndexChangeSetOfDataSource:dataSource] changeSections:dataSourceSections];
+
     NSRange sectionRange = [self sectionRangeOfDataSource:dataSource];
 
     NSMutableIndexSet *sections = [dataSourceSections mutableCopy];
     [sections shiftIndexesStartingAtIndex:0 by:sectionRange.location];
 
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didChangeSections:)]) {
+    [_changeSet changeSections:sections];
+    [_instrumentationSpan addCount:[sections count] forKey:@"sections"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidChangeSections) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self didChangeSections:sections];
         }
-    }
+    }];
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didMoveSection:(NSInteger)dataSourceSection toSection:(NSInteger)newDataSourceSection
 {
+    [[self ft_itemIndexChangeSetOfDataSource:dataSource] moveSection:dataSourceSection toSection:newDataSourceSection];
+
     NSRange sectionRange = [self sectionRangeOfDataSource:dataSource];
 
     NSInteger section = dataSourceSection + sectionRange.location;
     NSInteger newSection = newDataSourceSection + sectionRange.location;
 
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didMoveSection:toSection:)]) {
+    [_changeSet moveSection:section toSection:newSection];
+    [_instrumentationSpan addCount:1 forKey:@"sections"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidMoveSection) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self didMoveSection:section toSection:newSection];
         }
-    }
+    }];
 }
 
 #pragma mark Manage Items
 
 - (void)dataSource:(id<FTDataSource>)dataSource didInsertItemsAtIndexPaths:(NSArray *)sectionIndexPaths
 {
+    [[self ft_itemIndexChangeSetOfDataSource:dataSource] insertItemsAtIndexPaths:sectionIndexPaths];
+
     NSMutableArray *indexPaths = [[NSMutableArray alloc] init];
     for (NSIndexPath *indexPath in sectionIndexPaths) {
         [indexPaths addObject:[self convertIndexPath:indexPath fromDataSource:dataSource]];
     }
 
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didInsertItemsAtIndexPaths:)]) {
+    [_changeSet insertItemsAtIndexPaths:indexPaths];
+    [_instrumentationSpan addCount:[indexPaths count] forKey:@"items"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidInsertItems) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self didInsertItemsAtIndexPaths:indexPaths];
         }
-    }
+    }];
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didDeleteItemsAtIndexPaths:(NSArray *)sectionIndexPaths
 {
+    [[self ft_itemIndexChangeSetOfDataSource:dataSource] deleteItemsAtIndexPaths:sectionIndexPaths];
+
     NSMutableArray *indexPaths = [[NSMutableArray alloc] init];
     for (NSIndexPath *indexPath in sectionIndexPaths) {
         [indexPaths addObject:[self convertIndexPath:indexPath fromDataSource:dataSource]];
     }
 
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didDeleteItemsAtIndexPaths:)]) {
+    [_changeSet deleteItemsAtIndexPaths:indexPaths];
+    [_instrumentationSpan addCount:[indexPaths count] forKey:@"items"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidDeleteItems) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self didDeleteItemsAtIndexPaths:indexPaths];
         }
-    }
+    }];
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didChangeItemsAtIndexPaths:(NSArray *)sectionIndexPaths
 {
+    [[self ft_itemIndexChangeSetOfDataSource:dataSource] changeItemsAtIndexPaths:sectionIndexPaths];
+
     NSMutableArray *indexPaths = [[NSMutableArray alloc] init];
     for (NSIndexPath *indexPath in sectionIndexPaths) {
         [indexPaths addObject:[self convertIndexPath:indexPath fromDataSource:dataSource]];
     }
 
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didChangeItemsAtIndexPaths:)]) {
+    [_changeSet changeItemsAtIndexPaths:indexPaths];
+    [_instrumentationSpan addCount:[indexPaths count] forKey:@"items"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidChangeItems) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self didChangeItemsAtIndexPaths:indexPaths];
         }
-    }
+    }];
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didMoveItemAtIndexPath:(NSIndexPath *)sectionIndexPath toIndexPath:(NSIndexPath *)newSectionIndexPath
 {
+    [[self ft_itemIndexChangeSetOfDataSource:dataSource] moveItemAtIndexPath:sectionIndexPath toIndexPath:newSectionIndexPath];
+
     NSIndexPath *indexPath = [self convertIndexPath:sectionIndexPath fromDataSource:dataSource];
     NSIndexPath *newIndexPath = [self convertIndexPath:newSectionIndexPath fromDataSource:dataSource];
 
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didMoveItemAtIndexPath:toIndexPath:)]) {
+    [_changeSet moveItemAtIndexPath:indexPath toIndexPath:newIndexPath];
+    [_instrumentationSpan addCount:1 forKey:@"items"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidMoveItem) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self didMoveItemAtIndexPath:indexPath toIndexPath:newIndexPath];
         }
-    }
+    }];
+}
+
+#pragma mark Change Sets
+
+- (void)dataSource:(id<FTDataSource>)dataSource didApplyChangeSet:(FTChangeSet *)dataSourceChangeSet
+{
+    NSRange sectionRange = [self sectionRangeOfDataSource:dataSource];
+
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+    [changeSet addChangesFromChangeSet:dataSourceChangeSet sectionOffset:sectionRange.location];
+    [_changeSet addChangesFromChangeSet:changeSet sectionOffset:0];
+    [_instrumentationSpan addCount:1 forKey:@"changeSets"];
+
+    NSUInteger numberOfSections = sectionRange.length;
+    numberOfSections += [[dataSourceChangeSet insertedSections] count];
+    numberOfSections -= [[dataSourceChangeSet deletedSections] count];
+    [self setNumberOfSections:numberOfSections ofDataSource:dataSource];
+
+    [self ft_updateItemIndexOfDataSource:dataSource withChangeSet:dataSourceChangeSet];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (!(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
+            [changeSet notifyObserver:observer implementingMethods:methods ofChangesInDataSource:self];
+        }
+    }];
 }
 
 @end
@@ -0,0 +1,46 @@
+//
+//  FTCompiledPredicate.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 01.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/*! <code>FTCompiledPredicate</code> evaluates an <code>NSPredicate</code> without interpreting
+    the predicate on each evaluation.
+
+    The common forms of predicates are translated into blocks once: comparisons of key paths,
+    the evaluated object, constants and substitution variables with the operators ==, !=, <,
+    <=, >, >=, IN, CONTAINS, BEGINSWITH and ENDSWITH (also case and diacritic insensitive),
+    class checks with isKindOfClass: and isMemberOfClass:, and their combinations with AND, OR
+    and NOT. Key paths are split once and object properties are read through a cached method
+    implementation. All other parts of a predicate are evaluated by the predicate itself.
+
+    A compiled predicate caches the accessors of the evaluated objects and must not be
+    evaluated on multiple threads at the same time.
+ */
+@interface FTCompiledPredicate : NSObject
+
+#pragma mark Life-cycle
+
+// A nil predicate is compiled into a predicate, which always evaluates to YES.
++ (instancetype)compiledPredicateWithPredicate:(NSPredicate *)predicate;
+- (instancetype)initWithPredicate:(NSPredicate *)predicate;
+
+#pragma mark Predicate
+@property (nonatomic, readonly) NSPredicate *predicate;
+
+// YES, if the predicate could be compiled without falling back to the evaluation of NSPredicate.
+@property (nonatomic, readonly, getter=isCompiled) BOOL compiled;
+
+// YES, if the evaluation may need substitution variables. This is the case, if the predicate
+// references variables or if parts of it are evaluated by NSPredicate.
+@property (nonatomic, readonly) BOOL usesSubstitutionVariables;
+
+#pragma mark Evaluating the Predicate
+- (BOOL)evaluateWithObject:(id)object;
+- (BOOL)evaluateWithObject:(id)object substitutionVariables:(NSDictionary *)variables;
+
+@end
@@ -0,0 +1,511 @@
+//
+//  FTCompiledPredicate.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 01.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <objc/runtime.h>
+
+#import "FTCompiledPredicate.h"
+
+typedef BOOL (^FTPredicateBlock)(id object, NSDictionary *variables);
+typedef id (^FTExpressionBlock)(id object, NSDictionary *variables);
+
+typedef struct {
+    BOOL fallback;
+    BOOL usesVariables;
+} FTCompilationState;
+
+static FTPredicateBlock FTCompilePredicate(NSPredicate *predicate, FTCompilationState *state);
+static FTPredicateBlock FTCompileCompoundPredicate(NSCompoundPredicate *predicate, FTCompilationState *state);
+static FTPredicateBlock FTCompileComparisonPredicate(NSComparisonPredicate *predicate, FTCompilationState *state);
+static FTPredicateBlock FTFallbackPredicate(NSPredicate *predicate, FTCompilationState *state);
+static FTExpressionBlock FTCompileExpression(NSExpression *expression, FTCompilationState *state);
+static FTExpressionBlock FTCompileKeyPath(NSString *keyPath, FTExpressionBlock operand);
+static FTExpressionBlock FTCompileKey(NSString *key);
+static BOOL FTUsesDefaultKeyValueCoding(Class cls);
+static BOOL FTCompareValues(id lhs, id rhs, NSPredicateOperatorType operatorType, NSStringCompareOptions options);
+static BOOL FTIsEqualValue(id lhs, id rhs, NSStringCompareOptions options);
+static BOOL FTContainsValue(id collection, id value, NSStringCompareOptions options);
+
+@interface FTCompiledPredicate () {
+    FTPredicateBlock _block;
+}
+
+@end
+
+@implementation FTCompiledPredicate
+
+#pragma mark Life-cycle
+
++ (instancetype)compiledPredicateWithPredicate:(NSPredicate *)predicate
+{
+    return [[self alloc] initWithPredicate:predicate];
+}
+
+- (instancetype)init
+{
+    return [self initWithPredicate:nil];
+}
+
+- (instancetype)initWithPredicate:(NSPredicate *)predicate
+{
+    self = [super init];
+    if (self) {
+        _predicate = [predicate copy] ?: [NSPredicate predicateWithValue:YES];
+
+        FTCompilationState state = {NO, NO};
+        _block = FTCompilePredicate(_predicate, &state);
+        _compiled = state.fallback == NO;
+        _usesSubstitutionVariables = state.usesVariables;
+    }
+    return self;
+}
+
+#pragma mark Evaluating the Predicate
+
+- (BOOL)evaluateWithObject:(id)object
+{
+    return _block(object, nil);
+}
+
+- (BOOL)evaluateWithObject:(id)object substitutionVariables:(NSDictionary *)variables
+{
+    return _block(object, variables);
+}
+
+#pragma mark NSObject
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p predicate: %@ compiled: %@>", NSStringFromClass([self class]), (__bridge void *)self, _predicate, _compiled ? @"YES" : @"NO"];
+}
+
+@end
+
+#pragma mark Predicates
+
+static FTPredicateBlock FTCompilePredicate(NSPredicate *predicate, FTCompilationState *state)
+{
+    if ([predicate isKindOfClass:[NSCompoundPredicate class]]) {
+        return FTCompileCompoundPredicate((NSCompoundPredicate *)predicate, state);
+    } else if ([predicate isKindOfClass:[NSComparisonPredicate class]]) {
+        return FTCompileComparisonPredicate((NSComparisonPredicate *)predicate, state);
+    }
+
+    // The constant predicates are private subclasses of NSPredicate, which
+    // can only be identified by their format.
+
+    NSString *format = [predicate predicateFormat];
+    if ([format isEqualToString:@"TRUEPREDICATE"]) {
+        return ^BOOL(id object, NSDictionary *variables) {
+            return YES;
+        };
+    } else if ([format isEqualToString:@"FALSEPREDICATE"]) {
+        return ^BOOL(id object, NSDictionary *variables) {
+            return NO;
+        };
+    }
+
+    return FTFallbackPredicate(predicate, state);
+}
+
+static FTPredicateBlock FTCompileCompoundPredicate(NSCompoundPredicate *predicate, FTCompilationState *state)
+{
+    NSMutableArray *blocks = [[NSMutableArray alloc] init];
+    for (NSPredicate *subpredicate in predicate.subpredicates) {
+        [blocks addObject:FTCompilePredicate(subpredicate, state)];
+    }
+
+    switch (predicate.compoundPredicateType) {
+    case NSNotPredicateType: {
+        FTPredicateBlock block = [blocks firstObject];
+        if (block == nil) {
+            break;
+        }
+        return ^BOOL(id object, NSDictionary *variables) {
+            return !block(object, variables);
+        };
+    }
+
+    case NSAndPredicateType:
+        return ^BOOL(id object, NSDictionary *variables) {
+            for (FTPredicateBlock block in blocks) {
+                if (block(object, variables) == NO) {
+                    return NO;
+                }
+            }
+            return YES;
+        };
+
+    case NSOrPredicateType:
+        return ^BOOL(id object, NSDictionary *variables) {
+            for (FTPredicateBlock block in blocks) {
+                if (block(object, variables)) {
+                    return YES;
+                }
+            }
+            return NO;
+        };
+    }
+
+    return FTFallbackPredicate(predicate, state);
+}
+
+static FTPredicateBlock FTCompileComparisonPredicate(NSComparisonPredicate *predicate, FTCompilationState *state)
+{
+    NSComparisonPredicateOptions supportedOptions = NSCaseInsensitivePredicateOption | NSDiacriticInsensitivePredicateOption | NSNormalizedPredicateOption;
+    if (predicate.comparisonPredicateModifier != NSDirectPredicateModifier ||
+        (predicate.options & ~supportedOptions) != 0) {
+        return FTFallbackPredicate(predicate, state);
+    }
+
+    FTCompilationState expressionState = *state;
+    FTExpressionBlock lhs = FTCompileExpression(predicate.leftExpression, &expressionState);
+    FTExpressionBlock rhs = FTCompileExpression(predicate.rightExpression, &expressionState);
+    if (lhs == nil || rhs == nil) {
+        return FTFallbackPredicate(predicate, state);
+    }
+
+    NSPredicateOperatorType operatorType = predicate.predicateOperatorType;
+
+    if (operatorType == NSCustomSelectorPredicateOperatorType) {
+        SEL selector = predicate.customSelector;
+        if (selector == @selector(isKindOfClass:)) {
+            *state = expressionState;
+            return ^BOOL(id object, NSDictionary *variables) {
+                return [lhs(object, variables) isKindOfClass:rhs(object, variables)];
+            };
+        } else if (selector == @selector(isMemberOfClass:)) {
+            *state = expressionState;
+            return ^BOOL(id object, NSDictionary *variables) {
+                return [lhs(object, variables) isMemberOfClass:rhs(object, variables)];
+            };
+        }
+        return FTFallbackPredicate(predicate, state);
+    }
+
+    switch (operatorType) {
+    case NSLessThanPredicateOperatorType:
+    case NSLessThanOrEqualToPredicateOperatorType:
+    case NSGreaterThanPredicateOperatorType:
+    case NSGreaterThanOrEqualToPredicateOperatorType:
+    case NSEqualToPredicateOperatorType:
+    case NSNotEqualToPredicateOperatorType:
+    case NSInPredicateOperatorType:
+    case NSContainsPredicateOperatorType:
+    case NSBeginsWithPredicateOperatorType:
+    case NSEndsWithPredicateOperatorType:
+        break;
+
+    default:
+        return FTFallbackPredicate(predicate, state);
+    }
+
+    NSStringCompareOptions options = 0;
+    if (predicate.options & NSCaseInsensitivePredicateOption) {
+        options |= NSCaseInsensitiveSearch;
+    }
+    if (predicate.options & NSDiacriticInsensitivePredicateOption) {
+        options |= NSDiacriticInsensitiveSearch;
+    }
+
+    *state = expressionState;
+    return ^BOOL(id object, NSDictionary *variables) {
+        return FTCompareValues(lhs(object, variables), rhs(object, variables), operatorType, options);
+    };
+}
+
+static FTPredicateBlock FTFallbackPredicate(NSPredicate *predicate, FTCompilationState *state)
+{
+    // Parts of the predicate, which can not be compiled, are evaluated by
+    // the predicate itself. Whether they need variables is unknown.
+
+    state->fallback = YES;
+    state->usesVariables = YES;
+
+    return ^BOOL(id object, NSDictionary *variables) {
+        return [predicate evaluateWithObject:object substitutionVariables:variables ?: @{}];
+    };
+}
+
+#pragma mark Expressions
+
+static FTExpressionBlock FTCompileExpression(NSExpression *expression, FTCompilationState *state)
+{
+    switch (expression.expressionType) {
+    case NSConstantValueExpressionType: {
+        id value = expression.constantValue;
+        return ^id(id object, NSDictionary *variables) {
+            return value;
+        };
+    }
+
+    case NSEvaluatedObjectExpressionType:
+        return ^id(id object, NSDictionary *variables) {
+            return object;
+        };
+
+    case NSVariableExpressionType: {
+        NSString *variable = expression.variable;
+        state->usesVariables = YES;
+        return ^id(id object, NSDictionary *variables) {
+            return [variables objectForKey:variable];
+        };
+    }
+
+    case NSKeyPathExpressionType: {
+        FTExpressionBlock operand = nil;
+        if (expression.operand.expressionType != NSEvaluatedObjectExpressionType) {
+            operand = FTCompileExpression(expression.operand, state);
+            if (operand == nil) {
+                return nil;
+            }
+        }
+        return FTCompileKeyPath(expression.keyPath, operand);
+    }
+
+    case NSAggregateExpressionType: {
+        NSMutableArray *values = [[NSMutableArray alloc] init];
+        for (NSExpression *element in expression.collection) {
+            if (element.expressionType != NSConstantValueExpressionType || element.constantValue == nil) {
+                return nil;
+            }
+            [values addObject:element.constantValue];
+        }
+        return ^id(id object, NSDictionary *variables) {
+            return values;
+        };
+    }
+
+    default:
+        return nil;
+    }
+}
+
+static FTExpressionBlock FTCompileKeyPath(NSString *keyPath, FTExpressionBlock operand)
+{
+    // Key paths with collection operators are left to KVC, all other
+    // key paths are split into their keys once.
+
+    FTExpressionBlock keyPathBlock = nil;
+    if ([keyPath rangeOfString:@"@"].location != NSNotFound) {
+        keyPathBlock = ^id(id object, NSDictionary *variables) {
+            return [object valueForKeyPath:keyPath];
+        };
+    } else {
+        NSMutableArray *keyBlocks = [[NSMutableArray alloc] init];
+        for (NSString *key in [keyPath componentsSeparatedByString:@"."]) {
+            [keyBlocks addObject:FTCompileKey(key)];
+        }
+        if ([keyBlocks count] == 1) {
+            keyPathBlock = [keyBlocks firstObject];
+        } else {
+            keyPathBlock = ^id(id object, NSDictionary *variables) {
+                for (FTExpressionBlock keyBlock in keyBlocks) {
+                    object = keyBlock(object, variables);
+                    if (object == nil) {
+                        break;
+                    }
+                }
+                return object;
+            };
+        }
+    }
+
+    if (operand == nil) {
+        return keyPathBlock;
+    }
+
+    return ^id(id object, NSDictionary *variables) {
+        return keyPathBlock(operand(object, variables), variables);
+    };
+}
+
+static FTExpressionBlock FTCompileKey(NSString *key)
+{
+    // The getter of the key is resolved once per class of the evaluated
+    // objects. It is called directly, if it returns an object, if KVC
+    // would not prefer another accessor (get<Key>) and if the class does
+    // not override the lookup of KVC. Otherwise the value is read with
+    // valueForKey:.
+
+    SEL getter = NSSelectorFromString(key);
+    SEL prefixedGetter = NSSelectorFromString([NSString stringWithFormat:@"get%@%@", [[key substringToIndex:MIN(1, [key length])] uppercaseString], [key substringFromIndex:MIN(1, [key length])]]);
+
+    __block Class cachedClass = Nil;
+    __block IMP cachedImplementation = NULL;
+
+    return ^id(id object, NSDictionary *variables) {
+        if (object == nil) {
+            return nil;
+        }
+
+        Class cls = object_getClass(object);
+        if (cls != cachedClass) {
+            cachedClass = cls;
+            cachedImplementation = NULL;
+
+            Method method = class_getInstanceMethod(cls, getter);
+            if (method && class_getInstanceMethod(cls, prefixedGetter) == NULL && FTUsesDefaultKeyValueCoding(cls)) {
+                char returnType[2] = {0};
+                method_getReturnType(method, returnType, sizeof(returnType));
+                if (returnType[0] == _C_ID) {
+                    cachedImplementation = method_getImplementation(method);
+                }
+            }
+        }
+
+        if (cachedImplementation) {
+            return ((id(*)(id, SEL))cachedImplementation)(object, getter);
+        } else {
+            return [object valueForKey:key];
+        }
+    };
+}
+
+static BOOL FTUsesDefaultKeyValueCoding(Class cls)
+{
+    // Classes like NSDictionary or proxies override valueForKey: or
+    // valueForUndefinedKey: and return other values than their getters
+    // (e.g., the object for the key instead of the description). The
+    // implementation of NSManagedObject calls the accessors of the
+    // properties and is treated like the one of NSObject.
+
+    static IMP valueForKey = NULL;
+    static IMP valueForUndefinedKey = NULL;
+    static IMP managedObjectValueForKey = NULL;
+    static IMP managedObjectValueForUndefinedKey = NULL;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        valueForKey = class_getMethodImplementation([NSObject class], @selector(valueForKey:));
+        valueForUndefinedKey = class_getMethodImplementation([NSObject class], @selector(valueForUndefinedKey:));
+
+        Class managedObjectClass = NSClassFromString(@"NSManagedObject");
+        if (managedObjectClass) {
+            managedObjectValueForKey = class_getMethodImplementation(managedObjectClass, @selector(valueForKey:));
+            managedObjectValueForUndefinedKey = class_getMethodImplementation(managedObjectClass, @selector(valueForUndefinedKey:));
+        }
+    });
+
+    IMP implementation = class_getMethodImplementation(cls, @selector(valueForKey:));
+    IMP undefinedKeyImplementation = class_getMethodImplementation(cls, @selector(valueForUndefinedKey:));
+
+    if (implementation == valueForKey) {
+        return undefinedKeyImplementation == valueForUndefinedKey;
+    } else if (implementation == managedObjectValueForKey) {
+        return undefinedKeyImplementation == managedObjectValueForUndefinedKey;
+    } else {
+        return NO;
+    }
+}
+
+#pragma mark Comparing Values
+
+static BOOL FTCompareValues(id lhs, id rhs, NSPredicateOperatorType operatorType, NSStringCompareOptions options)
+{
+    if (lhs == [NSNull null]) {
+        lhs = nil;
+    }
+    if (rhs == [NSNull null]) {
+        rhs = nil;
+    }
+
+    switch (operatorType) {
+    case NSEqualToPredicateOperatorType:
+        return FTIsEqualValue(lhs, rhs, options);
+
+    case NSNotEqualToPredicateOperatorType:
+        return !FTIsEqualValue(lhs, rhs, options);
+
+    case NSInPredicateOperatorType:
+        return FTContainsValue(rhs, lhs, options);
+
+    case NSContainsPredicateOperatorType:
+        return FTContainsValue(lhs, rhs, options);
+
+    case NSBeginsWithPredicateOperatorType:
+    case NSEndsWithPredicateOperatorType: {
+        if (![lhs isKindOfClass:[NSString class]] || ![rhs isKindOfClass:[NSString class]]) {
+            return NO;
+        }
+        options |= NSAnchoredSearch;
+        if (operatorType == NSEndsWithPredicateOperatorType) {
+            options |= NSBackwardsSearch;
+        }
+        return [lhs rangeOfString:rhs options:options].location != NSNotFound;
+    }
+
+    default: {
+        if (lhs == nil || rhs == nil || ![lhs respondsToSelector:@selector(compare:)]) {
+            return NO;
+        }
+
+        NSComparisonResult result;
+        if (options != 0 && [lhs isKindOfClass:[NSString class]] && [rhs isKindOfClass:[NSString class]]) {
+            result = [lhs compare:rhs options:options];
+        } else {
+            result = [lhs compare:rhs];
+        }
+
+        switch (operatorType) {
+        case NSLessThanPredicateOperatorType:
+            return result == NSOrderedAscending;
+        case NSLessThanOrEqualToPredicateOperatorType:
+            return result != NSOrderedDescending;
+        case NSGreaterThanPredicateOperatorType:
+            return result == NSOrderedDescending;
+        case NSGreaterThanOrEqualToPredicateOperatorType:
+            return result != NSOrderedAscending;
+        default:
+            return NO;
+        }
+    }
+    }
+}
+
+static BOOL FTIsEqualValue(id lhs, id rhs, NSStringCompareOptions options)
+{
+    if (lhs == rhs) {
+        return YES;
+    } else if (lhs == nil || rhs == nil) {
+        return NO;
+    } else if (options != 0 && [lhs isKindOfClass:[NSString class]] && [rhs isKindOfClass:[NSString class]]) {
+        return [lhs compare:rhs options:options] == NSOrderedSame;
+    } else {
+        return [lhs isEqual:rhs];
+    }
+}
+
+static BOOL FTContainsValue(id collection, id value, NSStringCompareOptions options)
+{
+    if (collection == nil) {
+        return NO;
+    }
+
+    if ([collection isKindOfClass:[NSString class]]) {
+        if (![value isKindOfClass:[NSString class]]) {
+            return NO;
+        }
+        return [collection rangeOfString:value options:options].location != NSNotFound;
+    }
+
+    if ([collection isKindOfClass:[NSDictionary class]]) {
+        collection = [collection allValues];
+    }
+
+    if (options == 0 || ![value isKindOfClass:[NSString class]]) {
+        return [collection respondsToSelector:@selector(containsObject:)] && [collection containsObject:value];
+    }
+
+    if ([collection conformsToProtocol:@protocol(NSFastEnumeration)]) {
+        for (id element in collection) {
+            if (FTIsEqualValue(value, element, options)) {
+                return YES;
+            }
+        }
+    }
+    return NO;
+}
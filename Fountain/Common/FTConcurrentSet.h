@@ -0,0 +1,66 @@
+//
+//  FTConcurrentSet.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 29.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FTDataSource.h"
+#import "FTReverseDataSource.h"
+
+/*! <code>FTConcurrentSet</code> is a data source with the semantics of <code>FTMutableSet</code>,
+    which can be mutated from any thread.
+
+    The mutations are applied to a private working copy on a background queue, where the
+    objects are sorted and the changes are computed. The result is published on the observer
+    queue as an immutable snapshot together with the change set of the mutations. The data
+    source methods always read the current snapshot and are meant to be called on the
+    observer queue, as are the methods to add and remove observers.
+ */
+@interface FTConcurrentSet : NSObject <FTDataSource, FTReverseDataSource>
+
+#pragma mark Life-cycle
+- (instancetype)initWithSortDescriptors:(NSArray *)sortDescriptors;
+- (instancetype)initWithSortDescriptors:(NSArray *)sortDescriptors includeEmptySections:(BOOL)includeEmptySections;
+- (instancetype)initWithSortDescriptors:(NSArray *)sortDescriptors
+                   includeEmptySections:(BOOL)includeEmptySections
+                          observerQueue:(dispatch_queue_t)observerQueue;
+
+#pragma mark Sort Descriptors
+@property (nonatomic, readonly) NSArray *sortDescriptors;
+
+#pragma mark Include Empty Sections
+@property (nonatomic, readonly) BOOL includeEmptySections;
+
+#pragma mark Observer Queue
+@property (nonatomic, readonly) dispatch_queue_t observerQueue;
+
+#pragma mark Snapshot
+
+// The objects of the current snapshot in sort order. This property can be read from any thread.
+@property (readonly) NSArray *allObjects;
+@property (readonly) NSUInteger count;
+
+#pragma mark Mutating the Set
+
+// The following methods can be called from any thread. The changes are published
+// asynchronously in the order the methods have been called.
+- (void)addObject:(id)object;
+- (void)addObjectsFromArray:(NSArray *)array;
+- (void)removeObject:(id)object;
+- (void)removeAllObjects;
+
+/** Performs multiple mutations as one change.
+
+ The updates block is called on a background queue with the working copy of the set, which behaves like an <code>FTMutableSet</code>. Adding an object, that is already a member of the set, updates the object. The working copy must not be used outside of the block.
+
+ @param updates The block that performs the insert, delete, and update operations.
+ @param completion A block, that is called on the observer queue after the changes have been published.
+ */
+- (void)performBatchUpdate:(void (^)(NSMutableSet *set))updates;
+- (void)performBatchUpdate:(void (^)(NSMutableSet *set))updates completion:(void (^)(void))completion;
+
+@end
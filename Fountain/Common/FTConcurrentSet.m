@@ -0,0 +1,292 @@
+//
+//  FTConcurrentSet.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 29.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTChangeSet.h"
+#import "FTDataSourceObserver.h"
+#import "FTMutableSet.h"
+#import "FTObserverRegistry.h"
+
+#import "FTConcurrentSet.h"
+
+@interface FTConcurrentSet () <FTDataSourceChangeSetObserver> {
+    FTObserverRegistry *_observers;
+
+    // Only accessed on the observer queue. The indexes of the objects in the
+    // current snapshot, created on demand by the first reverse lookup.
+    NSMapTable *_indexesOfObjects;
+
+    // Only accessed on the work queue
+    dispatch_queue_t _workQueue;
+    FTMutableSet *_workingSet;
+    FTChangeSet *_workingChangeSet;
+}
+@property (readwrite) NSArray *allObjects;
+@end
+
+@implementation FTConcurrentSet
+
+#pragma mark Life-cycle
+
+- (instancetype)init
+{
+    return [self initWithSortDescriptors:nil];
+}
+
+- (instancetype)initWithSortDescriptors:(NSArray *)sortDescriptors
+{
+    return [self initWithSortDescriptors:sortDescriptors includeEmptySections:YES];
+}
+
+- (instancetype)initWithSortDescriptors:(NSArray *)sortDescriptors includeEmptySections:(BOOL)includeEmptySections
+{
+    return [self initWithSortDescriptors:sortDescriptors
+                    includeEmptySections:includeEmptySections
+                           observerQueue:dispatch_get_main_queue()];
+}
+
+- (instancetype)initWithSortDescriptors:(NSArray *)sortDescriptors
+                   includeEmptySections:(BOOL)includeEmptySections
+                          observerQueue:(dispatch_queue_t)observerQueue
+{
+    self = [super init];
+    if (self) {
+        _observers = [[FTObserverRegistry alloc] init];
+        _observerQueue = observerQueue ?: dispatch_get_main_queue();
+
+        _workQueue = dispatch_queue_create("de.tobias-kraentzer.Fountain.FTConcurrentSet", DISPATCH_QUEUE_SERIAL);
+        _workingSet = [[FTMutableSet alloc] initWithSortDescriptors:sortDescriptors
+                                               includeEmptySections:includeEmptySections
+                                                            storage:FTMutableSetStorageTree];
+        [_workingSet addObserver:self];
+
+        _sortDescriptors = [_workingSet.sortDescriptors copy];
+        _includeEmptySections = includeEmptySections;
+
+        _allObjects = @[];
+    }
+    return self;
+}
+
+#pragma mark Snapshot
+
+- (NSUInteger)count
+{
+    return [self.allObjects count];
+}
+
+#pragma mark Mutating the Set
+
+- (void)addObject:(id)object
+{
+    [self performBatchUpdate:^(NSMutableSet *set) {
+        [set addObject:object];
+    }];
+}
+
+- (void)addObjectsFromArray:(NSArray *)array
+{
+    NSArray *objects = [array copy];
+    [self performBatchUpdate:^(NSMutableSet *set) {
+        [set addObjectsFromArray:objects];
+    }];
+}
+
+- (void)removeObject:(id)object
+{
+    [self performBatchUpdate:^(NSMutableSet *set) {
+        [set removeObject:object];
+    }];
+}
+
+- (void)removeAllObjects
+{
+    [self performBatchUpdate:^(NSMutableSet *set) {
+        [set removeAllObjects];
+    }];
+}
+
+- (void)performBatchUpdate:(void (^)(NSMutableSet *set))updates
+{
+    [self performBatchUpdate:updates completion:nil];
+}
+
+- (void)performBatchUpdate:(void (^)(NSMutableSet *set))updates completion:(void (^)(void))completion
+{
+    dispatch_async(_workQueue, ^{
+
+        // The working set reports the changes of the batch update as one
+        // change set via dataSource:didApplyChangeSet: (see below).
+
+        [_workingSet performBatchUpdate:^{
+            if (updates) {
+                updates(_workingSet);
+            }
+        }];
+
+        FTChangeSet *changeSet = _workingChangeSet;
+        _workingChangeSet = nil;
+
+        NSArray *objects = nil;
+        if (changeSet) {
+            objects = [_workingSet allObjects];
+        }
+
+        dispatch_async(_observerQueue, ^{
+            if (changeSet) {
+                [self ft_publishObjects:objects changeSet:changeSet];
+            }
+            if (completion) {
+                completion();
+            }
+        });
+    });
+}
+
+#pragma mark Publishing Snapshots
+
+- (void)ft_publishObjects:(NSArray *)objects changeSet:(FTChangeSet *)changeSet
+{
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodWillChange) {
+            [observer dataSourceWillChange:self];
+        }
+    }];
+
+    self.allObjects = objects;
+    _indexesOfObjects = nil;
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidApplyChangeSet) {
+            [(id<FTDataSourceChangeSetObserver>)observer dataSource:self didApplyChangeSet:changeSet];
+        } else {
+            [changeSet notifyObserver:observer implementingMethods:methods ofChangesInDataSource:self];
+        }
+    }];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidChange) {
+            [observer dataSourceDidChange:self];
+        }
+    }];
+}
+
+#pragma mark FTDataSourceChangeSetObserver
+
+- (void)dataSource:(id<FTDataSource>)dataSource didApplyChangeSet:(FTChangeSet *)changeSet
+{
+    if ([changeSet isEmpty] == NO) {
+        _workingChangeSet = changeSet;
+    }
+}
+
+#pragma mark FTDataSource
+
+#pragma mark Getting Item and Section Metrics
+
+- (NSUInteger)numberOfSections
+{
+    if (_includeEmptySections) {
+        return 1;
+    } else {
+        return [_allObjects count] > 0 ? 1 : 0;
+    }
+}
+
+- (NSUInteger)numberOfItemsInSection:(NSUInteger)section
+{
+    if (section != 0) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. 1].", __PRETTY_FUNCTION__, (long)section];
+    }
+
+    return [_allObjects count];
+}
+
+#pragma mark Getting Items and Sections
+
+- (id)sectionItemForSection:(NSUInteger)section
+{
+    if (section != 0) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. 1].", __PRETTY_FUNCTION__, (long)section];
+    }
+
+    return nil;
+}
+
+- (id)itemAtIndexPath:(NSIndexPath *)indexPath
+{
+    if ([indexPath length] != 2) {
+        [NSException raise:NSInvalidArgumentException format:@"*** %s: length of index path must be 2, got an index path with length %lu.", __PRETTY_FUNCTION__, (unsigned long)[indexPath length]];
+    }
+
+    NSUInteger section = [indexPath indexAtPosition:0];
+    NSUInteger item = [indexPath indexAtPosition:1];
+
+    if (section != 0) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. 1].", __PRETTY_FUNCTION__, (long)section];
+    }
+
+    return [_allObjects objectAtIndex:item];
+}
+
+#pragma mark Observer
+
+- (NSArray *)observers
+{
+    return [_observers observers];
+}
+
+- (void)addObserver:(id<FTDataSourceObserver>)observer
+{
+    [_observers addObserver:observer];
+}
+
+- (void)removeObserver:(id<FTDataSourceObserver>)observer
+{
+    [_observers removeObserver:observer];
+}
+
+#pragma mark FTReverseDataSource
+
+- (NSIndexSet *)sectionsOfSectionItem:(id)sectionItem
+{
+    return [NSIndexSet indexSet];
+}
+
+- (NSArray *)indexPathsOfItem:(id)item
+{
+    // The objects are looked up by equality like the members of the set. A
+    // search using the sort descriptors would miss objects, which have
+    // changed their sort keys after the snapshot has been published.
+
+    if (_indexesOfObjects == nil) {
+        _indexesOfObjects = [self ft_indexesOfObjects:_allObjects];
+    }
+
+    NSNumber *index = [_indexesOfObjects objectForKey:item];
+    if (index) {
+        NSUInteger indexes[] = {0, [index unsignedIntegerValue]};
+        return @[ [NSIndexPath indexPathWithIndexes:indexes length:2] ];
+    } else {
+        return @[];
+    }
+}
+
+#pragma mark Indexes of Objects
+
+- (NSMapTable *)ft_indexesOfObjects:(NSArray *)objects
+{
+    NSMapTable *indexes = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsStrongMemory
+                                                    valueOptions:NSPointerFunctionsStrongMemory
+                                                        capacity:[objects count]];
+    [objects enumerateObjectsUsingBlock:^(id object, NSUInteger idx, BOOL *stop) {
+        [indexes setObject:@(idx) forKey:object];
+    }];
+    return indexes;
+}
+
+@end
@@ -59,7 +59,7 @@
 
 /** Returns all observers observing the data source.
  
-    A data source must hold a weak reference to the observer. This can be achieved, if the observers are kept in a weak NSHashTable.
+    A data source must hold a weak reference to the observer. This can be achieved, if the observers are kept in an FTObserverRegistry or a weak NSHashTable.
  
     @return An array of all currently registerd observers.
  */
@@ -9,6 +9,7 @@
 #import <Foundation/Foundation.h>
 
 @protocol FTDataSource;
+@class FTChangeSet;
 
 /** FTDataSource uses the methods defined in this protocol to notify the observers about changes of the data source.
  */
@@ -110,3 +111,22 @@
 - (void)dataSource:(id<FTDataSource>)dataSource didMoveItemAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath;
 
 @end
+
+/** Observers, which conform to this protocol and implement dataSource:didApplyChangeSet:, receive all
+    changes of a data source as one change set instead of the individual section and item callbacks.
+ */
+@protocol FTDataSourceChangeSetObserver <FTDataSourceObserver>
+@optional
+
+#pragma mark Change Sets
+
+/** Notifies the receiver about all changes a data source has made since dataSourceWillChange:.
+ 
+    This method is called once right before dataSourceDidChange:. If the receiver implements this method, the data source does not send the individual section and item callbacks to the receiver.
+ 
+    @param dataSource The data source that sent this message.
+    @param changeSet A change set containing the inserted, deleted, changed and moved sections and items.
+ */
+- (void)dataSource:(id<FTDataSource>)dataSource didApplyChangeSet:(FTChangeSet *)changeSet;
+
+@end
@@ -0,0 +1,68 @@
+//
+//  FTFaultingSet.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 02.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <CoreData/CoreData.h>
+#import <Foundation/Foundation.h>
+
+#import "FTDataSource.h"
+#import "FTReverseDataSource.h"
+
+/*! <code>FTFaultingSet</code> is a set of managed objects, which only keeps the IDs of the
+    objects in memory, sorted by the sort descriptors.
+
+    The objects are fetched in batches of <code>batchSize</code> objects, if one of the objects
+    in a batch is accessed. At most <code>residentObjectLimit</code> objects are kept in memory,
+    the least recently used objects are released first. Items returned by the data source are
+    always the registered objects of the context, therefore the identity of an item does not
+    depend on whether the object is resident.
+
+    Objects added to the set are inserted by a binary search, which only faults the objects it
+    compares with. Objects with a temporary ID get a permanent ID, when they are added.
+
+    Reading the set never notifies the observers. Batch updates, which are performed while the
+    faults are fetched, are applied after the current run loop turn (or with the next batch).
+ */
+@interface FTFaultingSet : NSMutableSet <FTDataSource, FTReverseDataSource>
+
+#pragma mark Life-cycle
+
+// The object IDs must be sorted by the sort descriptors and must not contain duplicates.
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)context
+                                      entity:(NSEntityDescription *)entity
+                             sortDescriptors:(NSArray *)sortDescriptors
+                                   objectIDs:(NSArray *)objectIDs
+                                   batchSize:(NSUInteger)batchSize
+                         residentObjectLimit:(NSUInteger)residentObjectLimit;
+
+#pragma mark Properties
+@property (nonatomic, readonly) NSManagedObjectContext *context;
+@property (nonatomic, readonly) NSEntityDescription *entity;
+@property (nonatomic, readonly) NSArray *sortDescriptors;
+@property (nonatomic, readonly) NSUInteger batchSize;
+@property (nonatomic, readonly) NSUInteger residentObjectLimit;
+
+#pragma mark Resident Objects
+@property (nonatomic, readonly) NSUInteger numberOfResidentObjects;
+
+// The last error of fetching the faults or of obtaining the permanent IDs of inserted objects.
+// Objects, which could not be fetched, are returned as faults.
+@property (nonatomic, readonly) NSError *lastError;
+
+#pragma mark Prefetching Objects
+
+// The objects at the indexes are fetched at the end of the current run loop turn
+// with a single fetch request, unless the prefetching is cancelled before.
+- (void)prefetchObjectsAtIndexes:(NSIndexSet *)indexes;
+
+// Cancels pending prefetches. Objects, which are already resident, are released first.
+- (void)cancelPrefetchingObjectsAtIndexes:(NSIndexSet *)indexes;
+
+#pragma mark Batch Updates
+- (void)performBatchUpdate:(void (^)(void))updates;
+
+@end
@@ -0,0 +1,724 @@
+//
+//  FTFaultingSet.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 02.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTChangeSet.h"
+#import "FTDataSourceObserver.h"
+#import "FTObserverRegistry.h"
+#import "FTOrderStatisticTree.h"
+#import "NSSortDescriptor+Fountain.h"
+
+#import "FTFaultingSet.h"
+
+static NSManagedObjectID *FTFaultingSetObjectID(id object);
+static NSIndexPath *FTFaultingSetIndexPath(NSUInteger item);
+
+@interface FTFaultingSetEnumerator : NSEnumerator
+- (instancetype)initWithObjectIDs:(NSArray *)objectIDs context:(NSManagedObjectContext *)context;
+@end
+
+// An entry of the list of resident objects, which is ordered from the least
+// recently used to the most recently used object. The next entry is retained
+// by the list, the previous entry is not.
+@interface FTFaultingSetResidentObject : NSObject
+@property (nonatomic, strong) NSManagedObjectID *objectID;
+@property (nonatomic, strong) NSManagedObject *object;
+@property (nonatomic, strong) FTFaultingSetResidentObject *next;
+@property (nonatomic, unsafe_unretained) FTFaultingSetResidentObject *previous;
+@end
+
+@interface FTFaultingSet () {
+    FTObserverRegistry *_observers;
+    NSUInteger _batchUpdateCallCount;
+
+    NSComparator _comperator;
+
+    // The IDs of all objects in the set in sort order. The tree is used to look
+    // up the index of an object and to insert and remove objects in O(log n).
+    FTOrderStatisticTree *_objectIDs;
+
+    // The entries of the resident objects by their IDs and the list of the
+    // entries from the least recently used to the most recently used object.
+    // Using or releasing an object is done in constant time.
+    NSMutableDictionary *_residentObjects;
+    FTFaultingSetResidentObject *_leastRecentlyUsedObject;
+    FTFaultingSetResidentObject *_mostRecentlyUsedObject;
+
+    NSMutableOrderedSet *_prefetchedObjectIDs;
+    BOOL _prefetchScheduled;
+
+    // Batch updates, which are requested while faults are fetched, are
+    // performed after the current run loop turn.
+    BOOL _fetchingObjects;
+    NSMutableArray *_deferredBatchUpdates;
+
+    NSMutableSet *_insertedObjects;
+    NSMutableSet *_updatedObjects;
+    NSMutableSet *_deletedObjectIDs;
+}
+
+@end
+
+@implementation FTFaultingSet
+
+#pragma mark Life-cycle
+
+- (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)context
+                                      entity:(NSEntityDescription *)entity
+                             sortDescriptors:(NSArray *)sortDescriptors
+                                   objectIDs:(NSArray *)objectIDs
+                                   batchSize:(NSUInteger)batchSize
+                         residentObjectLimit:(NSUInteger)residentObjectLimit
+{
+    self = [super init];
+    if (self) {
+        _context = context;
+        _entity = entity;
+        _sortDescriptors = [sortDescriptors copy];
+        _batchSize = MAX(batchSize, 1);
+        _residentObjectLimit = MAX(residentObjectLimit, _batchSize);
+
+        _observers = [[FTObserverRegistry alloc] init];
+        _comperator = [NSSortDescriptor ft_comperatorUsingSortDescriptors:_sortDescriptors];
+
+        _objectIDs = [[FTOrderStatisticTree alloc] initWithArray:objectIDs ?: @[]];
+        _residentObjects = [[NSMutableDictionary alloc] init];
+        _prefetchedObjectIDs = [[NSMutableOrderedSet alloc] init];
+    }
+    return self;
+}
+
+#pragma mark NSSet
+
+- (NSUInteger)count
+{
+    return [_objectIDs count];
+}
+
+- (id)member:(id)object
+{
+    NSManagedObjectID *objectID = FTFaultingSetObjectID(object);
+    if (objectID && [_objectIDs containsObject:objectID]) {
+        return [self ft_residentObjectWithID:objectID] ?: [_context objectWithID:objectID];
+    } else {
+        return nil;
+    }
+}
+
+- (NSEnumerator *)objectEnumerator
+{
+    // The enumerator returns the registered objects (or faults) of the context
+    // without fetching them.
+    return [[FTFaultingSetEnumerator alloc] initWithObjectIDs:[_objectIDs copy] context:_context];
+}
+
+#pragma mark NSMutableSet
+
+- (void)addObject:(id)object
+{
+    if (![object isKindOfClass:[NSManagedObject class]]) {
+        [NSException raise:NSInvalidArgumentException format:@"*** %s: object must be a managed object, got an object of kind '%@'.", __PRETTY_FUNCTION__, NSStringFromClass([object class])];
+    }
+
+    [self performBatchUpdate:^{
+        NSManagedObjectID *objectID = [object objectID];
+        if ([_objectIDs containsObject:objectID]) {
+            [_updatedObjects addObject:object];
+        } else {
+            [_insertedObjects addObject:object];
+        }
+        [_deletedObjectIDs removeObject:objectID];
+    }];
+}
+
+- (void)removeObject:(id)object
+{
+    NSManagedObjectID *objectID = FTFaultingSetObjectID(object);
+    if (objectID == nil) {
+        return;
+    }
+
+    [self performBatchUpdate:^{
+        if ([_objectIDs containsObject:objectID]) {
+            [_deletedObjectIDs addObject:objectID];
+        }
+        [_insertedObjects removeObject:object];
+        [_updatedObjects removeObject:object];
+    }];
+}
+
+#pragma mark Resident Objects
+
+- (NSUInteger)numberOfResidentObjects
+{
+    return [_residentObjects count];
+}
+
+- (NSManagedObject *)ft_objectAtIndex:(NSUInteger)index
+{
+    NSManagedObjectID *objectID = [_objectIDs objectAtIndex:index];
+
+    FTFaultingSetResidentObject *residentObject = _residentObjects[objectID];
+    if (residentObject == nil) {
+        NSUInteger location = (index / _batchSize) * _batchSize;
+        NSRange range = NSMakeRange(location, MIN(_batchSize, [_objectIDs count] - location));
+        [self ft_fetchObjectsWithIDs:[_objectIDs subarrayWithRange:range]];
+
+        // The objects are not resident, if the fetch failed. In that case the
+        // object is returned as a fault.
+        return [self ft_residentObjectWithID:objectID] ?: [_context objectWithID:objectID];
+    } else {
+        [self ft_unlinkResidentObject:residentObject];
+        [self ft_appendResidentObject:residentObject];
+        return residentObject.object;
+    }
+}
+
+- (NSManagedObject *)ft_residentObjectWithID:(NSManagedObjectID *)objectID
+{
+    FTFaultingSetResidentObject *residentObject = _residentObjects[objectID];
+    return residentObject.object;
+}
+
+- (void)ft_fetchObjectsWithIDs:(NSArray *)objectIDs
+{
+    NSMutableArray *faults = [[NSMutableArray alloc] initWithCapacity:[objectIDs count]];
+    for (NSManagedObjectID *objectID in objectIDs) {
+        if (_residentObjects[objectID] == nil) {
+            [faults addObject:[_context objectWithID:objectID]];
+        }
+    }
+
+    if ([faults count] == 0) {
+        return;
+    }
+
+    // Fetching the faults with one request fulfills all of them at once. The
+    // registered objects are returned, therefore an object which has not been
+    // fetched (e.g., because it is not yet saved) is kept as it is.
+
+    // The request does not include the pending changes. Otherwise the context
+    // would process them and post a change notification, while the set is
+    // read. Batch updates caused by such a notification are deferred anyway.
+
+    NSFetchRequest *request = [[NSFetchRequest alloc] init];
+    request.entity = _entity;
+    request.predicate = [NSPredicate predicateWithFormat:@"SELF IN %@", faults];
+    request.returnsObjectsAsFaults = NO;
+    request.includesPendingChanges = NO;
+
+    _fetchingObjects = YES;
+    NSError *error = nil;
+    NSArray *result = [_context executeFetchRequest:request error:&error];
+    _fetchingObjects = NO;
+
+    if (result == nil) {
+        _lastError = error;
+        return;
+    }
+
+    for (NSManagedObject *object in faults) {
+        FTFaultingSetResidentObject *residentObject = _residentObjects[object.objectID];
+        if (residentObject) {
+            [self ft_unlinkResidentObject:residentObject];
+        } else {
+            residentObject = [[FTFaultingSetResidentObject alloc] init];
+            residentObject.objectID = object.objectID;
+            residentObject.object = object;
+            _residentObjects[object.objectID] = residentObject;
+        }
+        [self ft_appendResidentObject:residentObject];
+    }
+
+    [self ft_releaseLeastRecentlyUsedObjects];
+}
+
+- (void)ft_releaseLeastRecentlyUsedObjects
+{
+    // The objects are only released by the set. They are still registered in
+    // the context as long as they are used somewhere else.
+
+    while ([_residentObjects count] > _residentObjectLimit) {
+        FTFaultingSetResidentObject *residentObject = _leastRecentlyUsedObject;
+        [self ft_unlinkResidentObject:residentObject];
+        [_residentObjects removeObjectForKey:residentObject.objectID];
+    }
+}
+
+- (void)ft_releaseObjectWithID:(NSManagedObjectID *)objectID
+{
+    FTFaultingSetResidentObject *residentObject = _residentObjects[objectID];
+    if (residentObject) {
+        [self ft_unlinkResidentObject:residentObject];
+        [_residentObjects removeObjectForKey:objectID];
+    }
+    [_prefetchedObjectIDs removeObject:objectID];
+}
+
+#pragma mark Least Recently Used Objects
+
+- (void)ft_appendResidentObject:(FTFaultingSetResidentObject *)residentObject
+{
+    residentObject.previous = _mostRecentlyUsedObject;
+    residentObject.next = nil;
+    if (_mostRecentlyUsedObject) {
+        _mostRecentlyUsedObject.next = residentObject;
+    } else {
+        _leastRecentlyUsedObject = residentObject;
+    }
+    _mostRecentlyUsedObject = residentObject;
+}
+
+- (void)ft_prependResidentObject:(FTFaultingSetResidentObject *)residentObject
+{
+    residentObject.previous = nil;
+    residentObject.next = _leastRecentlyUsedObject;
+    if (_leastRecentlyUsedObject) {
+        _leastRecentlyUsedObject.previous = residentObject;
+    } else {
+        _mostRecentlyUsedObject = residentObject;
+    }
+    _leastRecentlyUsedObject = residentObject;
+}
+
+- (void)ft_unlinkResidentObject:(FTFaultingSetResidentObject *)residentObject
+{
+    // The entry is retained by the caller, while it is unlinked.
+
+    FTFaultingSetResidentObject *previous = residentObject.previous;
+    FTFaultingSetResidentObject *next = residentObject.next;
+
+    if (previous) {
+        previous.next = next;
+    } else {
+        _leastRecentlyUsedObject = next;
+    }
+
+    if (next) {
+        next.previous = previous;
+    } else {
+        _mostRecentlyUsedObject = previous;
+    }
+
+    residentObject.previous = nil;
+    residentObject.next = nil;
+}
+
+#pragma mark Prefetching Objects
+
+- (void)prefetchObjectsAtIndexes:(NSIndexSet *)indexes
+{
+    NSUInteger count = [_objectIDs count];
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+        if (idx >= count) {
+            *stop = YES;
+        } else {
+            NSManagedObjectID *objectID = [_objectIDs objectAtIndex:idx];
+            if (_residentObjects[objectID] == nil) {
+                [_prefetchedObjectIDs addObject:objectID];
+            }
+        }
+    }];
+
+    if ([_prefetchedObjectIDs count] > 0 && _prefetchScheduled == NO) {
+        _prefetchScheduled = YES;
+        [self performSelector:@selector(ft_prefetchObjects) withObject:nil afterDelay:0 inModes:@[ NSRunLoopCommonModes ]];
+    }
+}
+
+- (void)cancelPrefetchingObjectsAtIndexes:(NSIndexSet *)indexes
+{
+    NSUInteger count = [_objectIDs count];
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+        if (idx >= count) {
+            *stop = YES;
+        } else {
+            NSManagedObjectID *objectID = [_objectIDs objectAtIndex:idx];
+            [_prefetchedObjectIDs removeObject:objectID];
+            FTFaultingSetResidentObject *residentObject = _residentObjects[objectID];
+            if (residentObject) {
+                [self ft_unlinkResidentObject:residentObject];
+                [self ft_prependResidentObject:residentObject];
+            }
+        }
+    }];
+}
+
+- (void)ft_prefetchObjects
+{
+    _prefetchScheduled = NO;
+
+    // Objects beyond the limit would be released right away.
+    NSUInteger count = MIN([_prefetchedObjectIDs count], _residentObjectLimit);
+    NSArray *objectIDs = [[_prefetchedObjectIDs array] subarrayWithRange:NSMakeRange(0, count)];
+    [_prefetchedObjectIDs removeAllObjects];
+
+    [self ft_fetchObjectsWithIDs:objectIDs];
+}
+
+#pragma mark Batch Updates
+
+- (void)performBatchUpdate:(void (^)(void))updates
+{
+    if (updates && _fetchingObjects) {
+        [self ft_deferBatchUpdate:updates];
+    } else if (updates) {
+        if (_batchUpdateCallCount == 0) {
+
+            [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+                if (methods & FTDataSourceObserverMethodWillChange) {
+                    [observer dataSourceWillChange:self];
+                }
+            }];
+
+            _insertedObjects = [[NSMutableSet alloc] init];
+            _updatedObjects = [[NSMutableSet alloc] init];
+            _deletedObjectIDs = [[NSMutableSet alloc] init];
+        }
+
+        _batchUpdateCallCount++;
+
+        // Deferred updates are applied first to keep the order of the updates.
+        if (_deferredBatchUpdates) {
+            NSArray *deferredBatchUpdates = _deferredBatchUpdates;
+            _deferredBatchUpdates = nil;
+            for (void (^deferredUpdates)(void) in deferredBatchUpdates) {
+                deferredUpdates();
+            }
+        }
+
+        updates();
+
+        _batchUpdateCallCount--;
+
+        if (_batchUpdateCallCount == 0) {
+
+            FTChangeSet *changeSet = [self ft_applyChanges];
+
+            _insertedObjects = nil;
+            _updatedObjects = nil;
+            _deletedObjectIDs = nil;
+
+            [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+                if (methods & FTDataSourceObserverMethodDidApplyChangeSet) {
+                    [(id<FTDataSourceChangeSetObserver>)observer dataSource:self didApplyChangeSet:changeSet];
+                } else {
+                    [changeSet notifyObserver:observer implementingMethods:methods ofChangesInDataSource:self];
+                }
+            }];
+
+            [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+                if (methods & FTDataSourceObserverMethodDidChange) {
+                    [observer dataSourceDidChange:self];
+                }
+            }];
+        }
+    }
+}
+
+- (void)ft_deferBatchUpdate:(void (^)(void))updates
+{
+    // The observers must not be notified while the set is read (e.g., if the
+    // context posts a change notification during the fetch of the faults).
+
+    if (_deferredBatchUpdates == nil) {
+        _deferredBatchUpdates = [[NSMutableArray alloc] init];
+        [self performSelector:@selector(ft_performDeferredBatchUpdates) withObject:nil afterDelay:0 inModes:@[ NSRunLoopCommonModes ]];
+    }
+    [_deferredBatchUpdates addObject:[updates copy]];
+}
+
+- (void)ft_performDeferredBatchUpdates
+{
+    // The deferred updates could already have been applied with another batch.
+    if (_deferredBatchUpdates) {
+        [self performBatchUpdate:^{
+        }];
+    }
+}
+
+- (FTChangeSet *)ft_applyChanges
+{
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+
+    // Indexes of the deleted objects (before the update)
+
+    NSMutableIndexSet *deletedIndexes = [[NSMutableIndexSet alloc] init];
+    for (NSManagedObjectID *objectID in _deletedObjectIDs) {
+        [deletedIndexes addIndex:[_objectIDs indexOfObject:objectID]];
+        [self ft_releaseObjectWithID:objectID];
+    }
+
+    // Updated objects, which are still in order relative to the objects that
+    // stay in place, are only reported as changed. All other updated objects
+    // are moved. The check is repeated until no further object has to be moved,
+    // because moving an object changes the neighbours of the remaining objects.
+
+    NSMutableIndexSet *movedIndexes = [[NSMutableIndexSet alloc] init];
+    NSMutableIndexSet *changedIndexes = [[NSMutableIndexSet alloc] init];
+    for (NSManagedObject *object in _updatedObjects) {
+        [changedIndexes addIndex:[_objectIDs indexOfObject:object.objectID]];
+    }
+
+    BOOL moved = YES;
+    while (moved) {
+        moved = NO;
+        NSUInteger index = [changedIndexes firstIndex];
+        while (index != NSNotFound) {
+            if (![self ft_isObjectInOrderAtIndex:index excludingIndexes:deletedIndexes movedIndexes:movedIndexes]) {
+                [movedIndexes addIndex:index];
+                moved = YES;
+            }
+            index = [changedIndexes indexGreaterThanIndex:index];
+        }
+        [changedIndexes removeIndexes:movedIndexes];
+    }
+
+    // Remove the deleted and moved objects
+
+    NSMutableArray *objectsToInsert = [[_insertedObjects allObjects] mutableCopy];
+    NSMapTable *oldIndexesOfMovedObjects = [NSMapTable strongToStrongObjectsMapTable];
+    [movedIndexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+        NSManagedObject *object = [_context objectWithID:[_objectIDs objectAtIndex:idx]];
+        [oldIndexesOfMovedObjects setObject:@(idx) forKey:object];
+        [objectsToInsert addObject:object];
+    }];
+
+    NSMutableIndexSet *removedIndexes = [deletedIndexes mutableCopy];
+    [removedIndexes addIndexes:movedIndexes];
+    [removedIndexes enumerateIndexesWithOptions:NSEnumerationReverse
+                                     usingBlock:^(NSUInteger idx, BOOL *stop) {
+                                         [_objectIDs removeObjectAtIndex:idx];
+                                     }];
+
+    // Insert the new and moved objects in sort order. Each object is inserted
+    // after all objects with the same sort order, therefore the index of an
+    // object is not changed by the insertion of the following objects.
+
+    // Objects, which are not yet saved, get a permanent ID. Otherwise the ID
+    // kept in the set would no longer identify the object after saving it.
+
+    NSMutableArray *temporaryObjects = [[NSMutableArray alloc] init];
+    for (NSManagedObject *object in _insertedObjects) {
+        if (object.objectID.isTemporaryID) {
+            [temporaryObjects addObject:object];
+        }
+    }
+    if ([temporaryObjects count] > 0) {
+        NSError *error = nil;
+        if (![_context obtainPermanentIDsForObjects:temporaryObjects error:&error]) {
+            _lastError = error;
+        }
+    }
+
+    [objectsToInsert sortWithOptions:NSSortStable usingComparator:_comperator];
+
+    NSMutableIndexSet *insertedIndexes = [[NSMutableIndexSet alloc] init];
+    for (NSManagedObject *object in objectsToInsert) {
+        NSUInteger index = [self ft_insertionIndexOfObject:object];
+        [_objectIDs insertObject:object.objectID atIndex:index];
+
+        NSNumber *oldIndex = [oldIndexesOfMovedObjects objectForKey:object];
+        if (oldIndex) {
+            [changeSet moveItemAtIndexPath:FTFaultingSetIndexPath([oldIndex unsignedIntegerValue])
+                               toIndexPath:FTFaultingSetIndexPath(index)];
+        } else {
+            [insertedIndexes addIndex:index];
+        }
+    }
+
+    [changeSet deleteItemsAtIndexes:deletedIndexes inSection:0];
+    [changeSet insertItemsAtIndexes:insertedIndexes inSection:0];
+    [changeSet changeItemsAtIndexes:changedIndexes inSection:0];
+
+    return [changeSet copy];
+}
+
+- (BOOL)ft_isObjectInOrderAtIndex:(NSUInteger)index excludingIndexes:(NSIndexSet *)deletedIndexes movedIndexes:(NSIndexSet *)movedIndexes
+{
+    NSManagedObject *object = [_context objectWithID:[_objectIDs objectAtIndex:index]];
+
+    NSUInteger previousIndex = index;
+    while (previousIndex > 0) {
+        previousIndex--;
+        if (![deletedIndexes containsIndex:previousIndex] && ![movedIndexes containsIndex:previousIndex]) {
+            NSManagedObject *previousObject = [_context objectWithID:[_objectIDs objectAtIndex:previousIndex]];
+            if (_comperator(previousObject, object) == NSOrderedDescending) {
+                return NO;
+            }
+            break;
+        }
+    }
+
+    NSUInteger count = [_objectIDs count];
+    NSUInteger nextIndex = index + 1;
+    while (nextIndex < count) {
+        if (![deletedIndexes containsIndex:nextIndex] && ![movedIndexes containsIndex:nextIndex]) {
+            NSManagedObject *nextObject = [_context objectWithID:[_objectIDs objectAtIndex:nextIndex]];
+            if (_comperator(object, nextObject) == NSOrderedDescending) {
+                return NO;
+            }
+            break;
+        }
+        nextIndex++;
+    }
+
+    return YES;
+}
+
+- (NSUInteger)ft_insertionIndexOfObject:(NSManagedObject *)object
+{
+    // Binary search for the index after the last object, which is not ordered
+    // after the given object. Only the compared objects are faulted.
+
+    NSUInteger low = 0;
+    NSUInteger high = [_objectIDs count];
+    while (low < high) {
+        NSUInteger mid = low + (high - low) / 2;
+        NSManagedObjectID *objectID = [_objectIDs objectAtIndex:mid];
+        NSManagedObject *other = [self ft_residentObjectWithID:objectID] ?: [_context objectWithID:objectID];
+        if (_comperator(object, other) == NSOrderedAscending) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+#pragma mark FTDataSource
+
+#pragma mark Getting Item and Section Metrics
+
+- (NSUInteger)numberOfSections
+{
+    return 1;
+}
+
+- (NSUInteger)numberOfItemsInSection:(NSUInteger)section
+{
+    if (section != 0) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. 1].", __PRETTY_FUNCTION__, (long)section];
+    }
+
+    return [_objectIDs count];
+}
+
+#pragma mark Getting Items and Sections
+
+- (id)sectionItemForSection:(NSUInteger)section
+{
+    if (section != 0) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. 1].", __PRETTY_FUNCTION__, (long)section];
+    }
+
+    return nil;
+}
+
+- (id)itemAtIndexPath:(NSIndexPath *)indexPath
+{
+    if ([indexPath length] != 2) {
+        [NSException raise:NSInvalidArgumentException format:@"*** %s: length of index path must be 2, got an index path with length %lu.", __PRETTY_FUNCTION__, (unsigned long)[indexPath length]];
+    }
+
+    NSUInteger section = [indexPath indexAtPosition:0];
+    NSUInteger item = [indexPath indexAtPosition:1];
+
+    if (section != 0) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. 1].", __PRETTY_FUNCTION__, (long)section];
+    }
+
+    return [self ft_objectAtIndex:item];
+}
+
+#pragma mark Observer
+
+- (NSArray *)observers
+{
+    return [_observers observers];
+}
+
+- (void)addObserver:(id<FTDataSourceObserver>)observer
+{
+    [_observers addObserver:observer];
+}
+
+- (void)removeObserver:(id<FTDataSourceObserver>)observer
+{
+    [_observers removeObserver:observer];
+}
+
+#pragma mark FTReverseDataSource
+
+- (NSIndexSet *)sectionsOfSectionItem:(id)sectionItem
+{
+    return [NSIndexSet indexSet];
+}
+
+- (NSArray *)indexPathsOfItem:(id)item
+{
+    NSManagedObjectID *objectID = FTFaultingSetObjectID(item);
+    if (objectID == nil || ![_objectIDs containsObject:objectID]) {
+        return @[];
+    }
+
+    return @[ FTFaultingSetIndexPath([_objectIDs indexOfObject:objectID]) ];
+}
+
+@end
+
+#pragma mark -
+
+@implementation FTFaultingSetResidentObject
+@end
+
+@implementation FTFaultingSetEnumerator {
+    NSArray *_objectIDs;
+    NSManagedObjectContext *_context;
+    NSUInteger _index;
+}
+
+- (instancetype)initWithObjectIDs:(NSArray *)objectIDs context:(NSManagedObjectContext *)context
+{
+    self = [super init];
+    if (self) {
+        _objectIDs = objectIDs;
+        _context = context;
+        _index = 0;
+    }
+    return self;
+}
+
+- (id)nextObject
+{
+    if (_index < [_objectIDs count]) {
+        return [_context objectWithID:[_objectIDs objectAtIndex:_index++]];
+    } else {
+        return nil;
+    }
+}
+
+@end
+
+#pragma mark Object IDs and Index Paths
+
+static NSManagedObjectID *FTFaultingSetObjectID(id object)
+{
+    if ([object isKindOfClass:[NSManagedObject class]]) {
+        return [(NSManagedObject *)object objectID];
+    } else if ([object isKindOfClass:[NSManagedObjectID class]]) {
+        return object;
+    } else {
+        return nil;
+    }
+}
+
+static NSIndexPath *FTFaultingSetIndexPath(NSUInteger item)
+{
+    NSUInteger indexes[] = {0, item};
+    return [NSIndexPath indexPathWithIndexes:indexes length:2];
+}
@@ -12,13 +12,21 @@
 #import "FTMutableClusterSet.h"
 
 #import "FTDataSource.h"
+#import "FTPrefetchingDataSource.h"
 
 /*! <code>FTFetchedDataSource</code> is a data source that represents a set of objects from a
     managed object context.
+
+    Each change notification of the context is reported as a separate batch. Wrap the data
+    source in an <code>FTCoalescingDataSource</code> to publish bursts of changes as one batch.
+
+    For large result sets, set a <code>fetchBatchSize</code> before fetching the objects. The
+    data source then only keeps the IDs of the objects in memory and fetches the objects in
+    batches, when they are accessed or prefetched.
  
     @warning The cluster support is realized with <code>FTMutableClusterSet</code> which is currently in an experimental state.
  */
-@interface FTFetchedDataSource : NSObject <FTDataSource, FTReverseDataSource>
+@interface FTFetchedDataSource : NSObject <FTDataSource, FTReverseDataSource, FTPrefetchingDataSource>
 
 #pragma mark Life-cycle
 - (instancetype)initWithManagedObjectContext:(NSManagedObjectContext *)context
@@ -41,6 +49,18 @@
 @property (nonatomic, readonly) NSPredicate *predicate;
 @property (nonatomic, readonly) FTClusterComperator *clusterComperator;
 
+#pragma mark Faulting
+
+// If greater than 0, only the IDs of the fetched objects are kept in memory and the objects are
+// fetched in batches of this size. Must be set before fetching the objects. Faulting is not used
+// together with a cluster comperator. Sort descriptors, which can not be evaluated by the store
+// (e.g., with a comparator), require to fetch all objects once to sort them. Defaults to 0.
+@property (nonatomic, readwrite) NSUInteger fetchBatchSize;
+
+// The maximum number of objects kept in memory, if the objects are faulted. The least recently
+// used objects are released first. Defaults to 0, which is interpreted as 10 * fetchBatchSize.
+@property (nonatomic, readwrite) NSUInteger residentObjectLimit;
+
 #pragma mark Fetch Objects
 - (BOOL)fetchObject:(NSError **)error DEPRECATED_ATTRIBUTE;
 - (BOOL)fetchObjects:(NSError **)error;
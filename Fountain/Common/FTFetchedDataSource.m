@@ -6,16 +6,27 @@
 //  Copyright (c) 2015 Tobias Kräntzer. All rights reserved.
 //
 
+#import "FTCompiledPredicate.h"
 #import "FTDataSourceObserver.h"
+#import "FTFaultingSet.h"
+#import "FTInstrumentation.h"
 #import "FTMutableSet.h"
 #import "FTObserverProxy.h"
+#import "FTSortKeyCache.h"
+#import "NSArray+Fountain.h"
 
 #import "FTFetchedDataSource.h"
 
+static BOOL FTFetchedDataSourceCanSortInStore(NSArray *sortDescriptors);
+static BOOL FTFetchedDataSourceStoreOrderMatchesComparison(NSArray *sortDescriptors, NSEntityDescription *entity);
+static NSSet *FTFetchedDataSourceObjectsOfEntity(NSSet *objects, NSEntityDescription *entity);
+static NSIndexSet *FTFetchedDataSourceItemIndexes(NSArray *indexPaths);
+
 @interface FTFetchedDataSource () {
     NSMutableSet<FTDataSource, FTReverseDataSource> *_fetchedObjects;
     FTObserverProxy *_observers;
     NSPredicate *_filterPredicate;
+    FTCompiledPredicate *_compiledFetchPredicate;
 }
 
 @end
@@ -82,6 +93,14 @@
     return [NSCompoundPredicate andPredicateWithSubpredicates:predicates];
 }
 
+- (FTCompiledPredicate *)ft_compiledFetchPredicate
+{
+    if (_compiledFetchPredicate == nil) {
+        _compiledFetchPredicate = [[FTCompiledPredicate alloc] initWithPredicate:[self fetchPredicate]];
+    }
+    return _compiledFetchPredicate;
+}
+
 #pragma mark Fetch Objects
 
 - (BOOL)fetchObject:(NSError **)error
@@ -91,72 +110,34 @@
 
 - (BOOL)fetchObjects:(NSError **)error
 {
-    NSFetchRequest *request = [NSFetchRequest fetchRequestWithEntityName:_entity.name];
-    request.predicate = [self fetchPredicate];
+    FTInstrumentationSpan *span = [FTInstrumentationSpan spanWithName:@"FTFetchedDataSource.fetch"];
+    [span beginPhase:@"fetch"];
+
+    BOOL sortedByStore = FTFetchedDataSourceCanSortInStore(self.sortDescriptors);
+    NSFetchRequest *request = [self ft_fetchRequestSortedByStore:sortedByStore];
 
     NSArray *result = [_context executeFetchRequest:request error:error];
     if (result) {
-
-        for (id<FTDataSourceObserver> observer in self.observers) {
-            if ([observer respondsToSelector:@selector(dataSourceWillReset:)]) {
-                [observer dataSourceWillReset:self];
-            }
-        }
-
-        if (_clusterComperator) {
-            FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initSortDescriptors:self.sortDescriptors comperator:self.clusterComperator];
-            [set addObjectsFromArray:result];
-            [set addObserver:_observers];
-            _fetchedObjects = set;
-        } else {
-            FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:self.sortDescriptors];
-            [set addObjectsFromArray:result];
-            [set addObserver:_observers];
-            _fetchedObjects = set;
-        }
-
-        for (id<FTDataSourceObserver> observer in self.observers) {
-            if ([observer respondsToSelector:@selector(dataSourceDidReset:)]) {
-                [observer dataSourceDidReset:self];
-            }
-        }
-
+        [self ft_resetWithFetchedObjects:result sortedByStore:sortedByStore instrumentationSpan:span];
         return YES;
     } else {
+        [span finish];
         return NO;
     }
 }
 
 - (void)fetchObjectsWithCompletion:(void (^)(BOOL success, NSError *error))completion
 {
-    NSFetchRequest *request = [NSFetchRequest fetchRequestWithEntityName:_entity.name];
-    request.predicate = [self fetchPredicate];
+    BOOL sortedByStore = FTFetchedDataSourceCanSortInStore(self.sortDescriptors);
+    NSFetchRequest *request = [self ft_fetchRequestSortedByStore:sortedByStore];
 
     NSPersistentStoreAsynchronousFetchResultCompletionBlock resultBlock = ^(NSAsynchronousFetchResult *result) {
 
-        for (id<FTDataSourceObserver> observer in self.observers) {
-            if ([observer respondsToSelector:@selector(dataSourceWillReset:)]) {
-                [observer dataSourceWillReset:self];
-            }
-        }
+        // The time spent in the store is not part of the span, because the
+        // fetch is executed asynchronously on the queue of the context.
 
-        if (_clusterComperator) {
-            FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initSortDescriptors:self.sortDescriptors comperator:self.clusterComperator];
-            [set addObjectsFromArray:result.finalResult];
-            [set addObserver:_observers];
-            _fetchedObjects = set;
-        } else {
-            FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:self.sortDescriptors];
-            [set addObjectsFromArray:result.finalResult];
-            [set addObserver:_observers];
-            _fetchedObjects = set;
-        }
-
-        for (id<FTDataSourceObserver> observer in self.observers) {
-            if ([observer respondsToSelector:@selector(dataSourceDidReset:)]) {
-                [observer dataSourceDidReset:self];
-            }
-        }
+        FTInstrumentationSpan *span = [FTInstrumentationSpan spanWithName:@"FTFetchedDataSource.fetch"];
+        [self ft_resetWithFetchedObjects:result.finalResult sortedByStore:sortedByStore instrumentationSpan:span];
 
         if (completion) {
             completion(YES, nil);
@@ -177,12 +158,128 @@
     }];
 }
 
+- (void)ft_resetWithFetchedObjects:(NSArray *)objects sortedByStore:(BOOL)sortedByStore instrumentationSpan:(FTInstrumentationSpan *)span
+{
+    [span beginPhase:@"notify"];
+
+    for (id<FTDataSourceObserver> observer in self.observers) {
+        if ([observer respondsToSelector:@selector(dataSourceWillReset:)]) {
+            [observer dataSourceWillReset:self];
+        }
+    }
+
+    [span beginPhase:@"load"];
+
+    _fetchedObjects = [self ft_setWithFetchedObjects:objects sortedByStore:sortedByStore];
+    [_fetchedObjects addObserver:_observers];
+
+    [span beginPhase:@"notify"];
+
+    for (id<FTDataSourceObserver> observer in self.observers) {
+        if ([observer respondsToSelector:@selector(dataSourceDidReset:)]) {
+            [observer dataSourceDidReset:self];
+        }
+    }
+
+    [span addCount:[objects count] forKey:@"items"];
+    [span finish];
+}
+
+- (BOOL)ft_usesFaulting
+{
+    return _fetchBatchSize > 0 && _clusterComperator == nil;
+}
+
+- (BOOL)ft_fetchesObjectIDsSortedByStore:(BOOL)sortedByStore
+{
+    // Only the IDs are fetched, if the order of the store can be adopted
+    // without verifying it with the objects. The faulting set relies on this
+    // order to find the position of an object with the sort descriptors.
+
+    if ([self ft_usesFaulting] == NO) {
+        return NO;
+    } else if ([self.sortDescriptors count] == 0) {
+        return YES;
+    } else {
+        return sortedByStore && FTFetchedDataSourceStoreOrderMatchesComparison(self.sortDescriptors, _entity);
+    }
+}
+
+- (NSFetchRequest *)ft_fetchRequestSortedByStore:(BOOL)sortedByStore
+{
+    NSFetchRequest *request = [NSFetchRequest fetchRequestWithEntityName:_entity.name];
+    request.predicate = [self fetchPredicate];
+    request.sortDescriptors = sortedByStore ? self.sortDescriptors : nil;
+
+    if ([self ft_fetchesObjectIDsSortedByStore:sortedByStore]) {
+        request.resultType = NSManagedObjectIDResultType;
+    }
+
+    return request;
+}
+
+- (NSMutableSet<FTDataSource, FTReverseDataSource> *)ft_setWithFetchedObjects:(NSArray *)objects sortedByStore:(BOOL)sortedByStore
+{
+    if ([self ft_usesFaulting]) {
+        NSArray *objectIDs = objects;
+        if ([self ft_fetchesObjectIDsSortedByStore:sortedByStore] == NO) {
+
+            // The order of the store is verified like below, before the
+            // objects are turned into faults.
+
+            FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:self.sortDescriptors];
+            if (sortedByStore == NO || [objects ft_isSortedUsingComparator:[sortKeyCache comperator]] == NO) {
+                objects = [sortKeyCache sortedArrayFromObjects:objects];
+            }
+            objectIDs = [objects valueForKey:@"objectID"];
+        }
+        return [[FTFaultingSet alloc] initWithManagedObjectContext:_context
+                                                            entity:_entity
+                                                   sortDescriptors:self.sortDescriptors
+                                                         objectIDs:objectIDs
+                                                         batchSize:_fetchBatchSize
+                                               residentObjectLimit:_residentObjectLimit > 0 ? _residentObjectLimit : 10 * _fetchBatchSize];
+    }
+
+    if ([self.sortDescriptors count] == 0) {
+        if (_clusterComperator) {
+            FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initSortDescriptors:self.sortDescriptors comperator:self.clusterComperator];
+            [set addObjectsFromArray:objects];
+            return set;
+        } else {
+            return [[FTMutableSet alloc] initWithArray:objects];
+        }
+    }
+
+    // The store may order some values differently than the sort descriptors
+    // (e.g., strings with a different collation). The order of the fetched
+    // objects is therefore verified in O(n) and the objects are only sorted
+    // in memory, if the store did not (or could not) sort them.
+
+    FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:self.sortDescriptors];
+    if (sortedByStore == NO || [objects ft_isSortedUsingComparator:[sortKeyCache comperator]] == NO) {
+        objects = [sortKeyCache sortedArrayFromObjects:objects];
+    }
+
+    if (_clusterComperator) {
+        return [[FTMutableClusterSet alloc] initWithSortedObjects:objects sortDescriptors:self.sortDescriptors comperator:self.clusterComperator];
+    } else {
+        return [[FTMutableSet alloc] initWithSortedObjects:objects sortDescriptors:self.sortDescriptors];
+    }
+}
+
 #pragma mark Filter Result
 
 - (BOOL)filterResultWithPredicate:(NSPredicate *)predicate
                             error:(NSError **)error
 {
     _filterPredicate = predicate;
+    _compiledFetchPredicate = nil;
+
+    if ([_fetchedObjects isKindOfClass:[FTFaultingSet class]]) {
+        // Only the IDs of the objects are kept, the filtered result is fetched again.
+        return [self fetchObjects:error];
+    }
 
     NSFetchRequest *request = [NSFetchRequest fetchRequestWithEntityName:_entity.name];
     request.predicate = [self fetchPredicate];
@@ -221,6 +318,13 @@
                        completion:(void (^)(BOOL success, NSError *error))completion
 {
     _filterPredicate = predicate;
+    _compiledFetchPredicate = nil;
+
+    if ([_fetchedObjects isKindOfClass:[FTFaultingSet class]]) {
+        // Only the IDs of the objects are kept, the filtered result is fetched again.
+        [self fetchObjectsWithCompletion:completion];
+        return;
+    }
 
     NSFetchRequest *request = [NSFetchRequest fetchRequestWithEntityName:_entity.name];
     request.predicate = [self fetchPredicate];
@@ -274,38 +378,53 @@
 
 - (void)managedObjectContextObjectsDidChange:(NSNotification *)notification
 {
-    NSPredicate *entityPredicate = [NSPredicate predicateWithBlock:^BOOL(NSManagedObject *evaluatedObject, NSDictionary *bindings) {
-        return [evaluatedObject.entity isKindOfEntity:self.entity];
-    }];
+    FTInstrumentationSpan *span = [FTInstrumentationSpan spanWithName:@"FTFetchedDataSource.change"];
+    [span beginPhase:@"filter"];
+
+    FTCompiledPredicate *fetchPredicate = [self ft_compiledFetchPredicate];
 
     // Deleted Object
 
-    NSSet *deletedObjects = [notification.userInfo[NSDeletedObjectsKey] filteredSetUsingPredicate:entityPredicate];
+    NSSet *deletedObjects = FTFetchedDataSourceObjectsOfEntity(notification.userInfo[NSDeletedObjectsKey], self.entity);
 
     // Inserted Objects
 
-    NSSet *insertedObjects = [notification.userInfo[NSInsertedObjectsKey] filteredSetUsingPredicate:entityPredicate];
-    insertedObjects = [insertedObjects filteredSetUsingPredicate:[self fetchPredicate]];
+    NSMutableSet *insertedObjects = [[NSMutableSet alloc] init];
+    for (NSManagedObject *object in FTFetchedDataSourceObjectsOfEntity(notification.userInfo[NSInsertedObjectsKey], self.entity)) {
+        if ([fetchPredicate evaluateWithObject:object]) {
+            [insertedObjects addObject:object];
+        }
+    }
 
     // Updates
 
     NSMutableSet *updatedObjects = [[NSMutableSet alloc] init];
 
     if (notification.userInfo[NSUpdatedObjectsKey]) {
-        [updatedObjects unionSet:[notification.userInfo[NSUpdatedObjectsKey] filteredSetUsingPredicate:entityPredicate]];
+        [updatedObjects unionSet:FTFetchedDataSourceObjectsOfEntity(notification.userInfo[NSUpdatedObjectsKey], self.entity)];
     }
 
     if (notification.userInfo[NSRefreshedObjectsKey]) {
-        [updatedObjects unionSet:[notification.userInfo[NSRefreshedObjectsKey] filteredSetUsingPredicate:entityPredicate]];
+        [updatedObjects unionSet:FTFetchedDataSourceObjectsOfEntity(notification.userInfo[NSRefreshedObjectsKey], self.entity)];
     }
 
-    NSSet *updatedObjectsToInsert = [updatedObjects filteredSetUsingPredicate:[self fetchPredicate]];
-
-    NSMutableSet *updatedObjectsToRemove = [updatedObjects mutableCopy];
-    [updatedObjectsToRemove minusSet:updatedObjectsToInsert];
+    NSMutableSet *updatedObjectsToInsert = [[NSMutableSet alloc] init];
+    NSMutableSet *updatedObjectsToRemove = [[NSMutableSet alloc] init];
+    for (NSManagedObject *object in updatedObjects) {
+        if ([fetchPredicate evaluateWithObject:object]) {
+            [updatedObjectsToInsert addObject:object];
+        } else {
+            [updatedObjectsToRemove addObject:object];
+        }
+    }
 
     // Apply Updates
 
+    [span addCount:[deletedObjects count] forKey:@"deleted"];
+    [span addCount:[insertedObjects count] forKey:@"inserted"];
+    [span addCount:[updatedObjects count] forKey:@"updated"];
+    [span beginPhase:@"apply"];
+
     if ([deletedObjects count] > 0 ||
         [insertedObjects count] > 0 ||
         [updatedObjectsToRemove count] > 0 ||
@@ -325,8 +444,20 @@
                 [_fetchedObjects minusSet:updatedObjectsToRemove];
                 [_fetchedObjects unionSet:updatedObjectsToInsert];
             }];
+        } else if ([_fetchedObjects isKindOfClass:[FTFaultingSet class]]) {
+            // The faulting set can defer the updates. They are applied to
+            // this set, even if the objects have been fetched again since.
+            FTFaultingSet *fetchedObjects = (FTFaultingSet *)_fetchedObjects;
+            [fetchedObjects performBatchUpdate:^{
+                [fetchedObjects minusSet:deletedObjects];
+                [fetchedObjects unionSet:insertedObjects];
+                [fetchedObjects minusSet:updatedObjectsToRemove];
+                [fetchedObjects unionSet:updatedObjectsToInsert];
+            }];
         }
     }
+
+    [span finish];
 }
 
 #pragma mark FTDataSource
@@ -376,6 +507,23 @@
     [_observers removeObserver:observer];
 }
 
+#pragma mark FTPrefetchingDataSource
+
+- (void)prefetchItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    // Objects of an FTMutableSet or FTMutableClusterSet are always resident.
+    if ([_fetchedObjects isKindOfClass:[FTFaultingSet class]]) {
+        [(FTFaultingSet *)_fetchedObjects prefetchObjectsAtIndexes:FTFetchedDataSourceItemIndexes(indexPaths)];
+    }
+}
+
+- (void)cancelPrefetchingForItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    if ([_fetchedObjects isKindOfClass:[FTFaultingSet class]]) {
+        [(FTFaultingSet *)_fetchedObjects cancelPrefetchingObjectsAtIndexes:FTFetchedDataSourceItemIndexes(indexPaths)];
+    }
+}
+
 #pragma mark FTReverseDataSource
 
 #pragma mark Getting Section Indexes
@@ -393,3 +541,113 @@
 }
 
 @end
+
+#pragma mark Filtering Objects
+
+static NSSet *FTFetchedDataSourceObjectsOfEntity(NSSet *objects, NSEntityDescription *entity)
+{
+    NSMutableSet *result = [[NSMutableSet alloc] initWithCapacity:[objects count]];
+    for (NSManagedObject *object in objects) {
+        if ([object.entity isKindOfEntity:entity]) {
+            [result addObject:object];
+        }
+    }
+    return result;
+}
+
+#pragma mark Sorting Objects
+
+static BOOL FTFetchedDataSourceCanSortInStore(NSArray *sortDescriptors)
+{
+    // Only sort descriptors with a key path and one of the comparison
+    // selectors supported by the persistent stores can be passed to a fetch
+    // request. Sort descriptors with a comparator are only used in memory.
+
+    static NSSet *selectors = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        selectors = [NSSet setWithObjects:NSStringFromSelector(@selector(compare:)),
+                                          NSStringFromSelector(@selector(caseInsensitiveCompare:)),
+                                          NSStringFromSelector(@selector(localizedCompare:)),
+                                          NSStringFromSelector(@selector(localizedCaseInsensitiveCompare:)),
+                                          NSStringFromSelector(@selector(localizedStandardCompare:)), nil];
+    });
+
+    if ([sortDescriptors count] == 0) {
+        return NO;
+    }
+
+    for (NSSortDescriptor *sortDescriptor in sortDescriptors) {
+        if (sortDescriptor.key == nil || [sortDescriptor.key isEqualToString:@"self"]) {
+            return NO;
+        }
+        if (sortDescriptor.comparator != nil || sortDescriptor.selector == NULL) {
+            return NO;
+        }
+        if (![selectors containsObject:NSStringFromSelector(sortDescriptor.selector)]) {
+            return NO;
+        }
+    }
+
+    return YES;
+}
+
+static BOOL FTFetchedDataSourceStoreOrderMatchesComparison(NSArray *sortDescriptors, NSEntityDescription *entity)
+{
+    // The store orders numbers and dates by their value like compare:. Strings
+    // can be ordered with a different collation (e.g., by the SQLite store),
+    // therefore only sort descriptors using compare: on attributes with a
+    // numeric or date type are considered to match the order in memory.
+
+    for (NSSortDescriptor *sortDescriptor in sortDescriptors) {
+        if (sortDescriptor.selector != @selector(compare:)) {
+            return NO;
+        }
+
+        NSEntityDescription *currentEntity = entity;
+        NSAttributeDescription *attribute = nil;
+        for (NSString *key in [sortDescriptor.key componentsSeparatedByString:@"."]) {
+            if (attribute != nil || currentEntity == nil) {
+                return NO;
+            }
+            NSPropertyDescription *property = [[currentEntity propertiesByName] objectForKey:key];
+            if ([property isKindOfClass:[NSRelationshipDescription class]] && ![(NSRelationshipDescription *)property isToMany]) {
+                currentEntity = [(NSRelationshipDescription *)property destinationEntity];
+            } else if ([property isKindOfClass:[NSAttributeDescription class]]) {
+                attribute = (NSAttributeDescription *)property;
+            } else {
+                return NO;
+            }
+        }
+
+        switch (attribute.attributeType) {
+        case NSInteger16AttributeType:
+        case NSInteger32AttributeType:
+        case NSInteger64AttributeType:
+        case NSDecimalAttributeType:
+        case NSDoubleAttributeType:
+        case NSFloatAttributeType:
+        case NSBooleanAttributeType:
+        case NSDateAttributeType:
+            break;
+        default:
+            return NO;
+        }
+    }
+
+    return YES;
+}
+
+#pragma mark Index Paths
+
+static NSIndexSet *FTFetchedDataSourceItemIndexes(NSArray *indexPaths)
+{
+    // The fetched objects are always in the first section.
+    NSMutableIndexSet *indexes = [[NSMutableIndexSet alloc] init];
+    for (NSIndexPath *indexPath in indexPaths) {
+        if ([indexPath length] == 2 && [indexPath indexAtPosition:0] == 0) {
+            [indexes addIndex:[indexPath indexAtPosition:1]];
+        }
+    }
+    return indexes;
+}
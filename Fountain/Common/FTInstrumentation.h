@@ -0,0 +1,86 @@
+//
+//  FTInstrumentation.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 08.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class FTInstrumentationSpan;
+
+/*! A sink receives the finished spans of the instrumented data sources. The spans are
+    sent on the thread, on which the data source has been changed.
+ */
+@protocol FTInstrumentationSink <NSObject>
+- (void)instrumentationDidFinishSpan:(FTInstrumentationSpan *)span;
+@end
+
+/*! <code>FTInstrumentation</code> holds the sink for the spans of the data sources.
+
+    The instrumentation is disabled as long as no sink is set. In that case, the data sources
+    only check once per batch, if a span should be created, and neither allocate spans nor
+    count comparisons or measure the delivery to the observers.
+ */
+@interface FTInstrumentation : NSObject
+
+#pragma mark Sink
++ (id<FTInstrumentationSink>)sink;
++ (void)setSink:(id<FTInstrumentationSink>)sink;
+
+@end
+
+/*! <code>FTInstrumentationSpan</code> covers one batch (or fetch) of a data source.
+
+    The name of a span is the class of the data source followed by the operation (e.g.,
+    <code>FTMutableSet.batch</code>). A span contains the durations of the phases of the batch
+    (e.g., <code>update</code>, <code>delete</code>, <code>insert</code> and <code>notify</code>),
+    counts (e.g., the number of inserted items or of comparator invocations) and the time spent
+    delivering the changes to the observers, summed up per class of the observers.
+
+    Phases are not nested. Beginning a phase ends the current phase. The duration of a phase,
+    which is entered several times, is summed up. The time spent in the observers is included
+    in the durations of the phases.
+ */
+@interface FTInstrumentationSpan : NSObject
+
+#pragma mark Life-cycle
+
+// Returns nil, if the instrumentation is disabled.
++ (instancetype)spanWithName:(NSString *)name;
+
+- (instancetype)initWithName:(NSString *)name;
+
+#pragma mark Name
+@property (nonatomic, readonly) NSString *name;
+
+#pragma mark Timing
+@property (nonatomic, readonly) NSTimeInterval startTime;
+@property (nonatomic, readonly) NSTimeInterval duration;
+
+#pragma mark Phases
+- (void)beginPhase:(NSString *)phase;
+- (void)endPhase;
+@property (nonatomic, readonly) NSDictionary *phaseDurations;
+
+#pragma mark Counts
+- (void)addCount:(NSUInteger)count forKey:(NSString *)key;
+@property (nonatomic, readonly) NSDictionary *counts;
+
+// Returns a comparator, which counts its invocations as `comparisons` and calls the given comparator.
+- (NSComparator)countingComparator:(NSComparator)comparator;
+
+#pragma mark Observer Delivery
+
+// Calls the block and adds the elapsed time to the delivery duration of the class of the observer.
+- (void)measureDeliveryToObserver:(id)observer usingBlock:(void (^)(void))block;
+@property (nonatomic, readonly) NSDictionary *observerDeliveryDurations;
+
+#pragma mark Finishing
+
+// Ends the current phase and sends the span to the sink. Has no effect, if the span is already finished.
+- (void)finish;
+@property (nonatomic, readonly, getter=isFinished) BOOL finished;
+
+@end
@@ -0,0 +1,176 @@
+//
+//  FTInstrumentation.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 08.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTInstrumentation.h"
+
+static NSTimeInterval FTInstrumentationTime(void);
+
+static id<FTInstrumentationSink> FTInstrumentationCurrentSink = nil;
+static BOOL FTInstrumentationEnabled = NO;
+
+@implementation FTInstrumentation
+
+#pragma mark Sink
+
++ (id<FTInstrumentationSink>)sink
+{
+    @synchronized(self)
+    {
+        return FTInstrumentationCurrentSink;
+    }
+}
+
++ (void)setSink:(id<FTInstrumentationSink>)sink
+{
+    @synchronized(self)
+    {
+        FTInstrumentationCurrentSink = sink;
+        FTInstrumentationEnabled = sink != nil;
+    }
+}
+
+@end
+
+@interface FTInstrumentationSpan () {
+    NSMutableDictionary *_phaseDurations;
+    NSMutableDictionary *_counts;
+    NSMutableDictionary *_observerDeliveryDurations;
+    NSString *_currentPhase;
+    NSTimeInterval _currentPhaseStartTime;
+    NSUInteger _numberOfComparisons;
+}
+
+@end
+
+@implementation FTInstrumentationSpan
+
+#pragma mark Life-cycle
+
++ (instancetype)spanWithName:(NSString *)name
+{
+    if (FTInstrumentationEnabled == NO) {
+        return nil;
+    }
+    return [[self alloc] initWithName:name];
+}
+
+- (instancetype)initWithName:(NSString *)name
+{
+    self = [super init];
+    if (self) {
+        _name = [name copy];
+        _phaseDurations = [[NSMutableDictionary alloc] init];
+        _counts = [[NSMutableDictionary alloc] init];
+        _observerDeliveryDurations = [[NSMutableDictionary alloc] init];
+        _startTime = FTInstrumentationTime();
+    }
+    return self;
+}
+
+#pragma mark Phases
+
+- (void)beginPhase:(NSString *)phase
+{
+    [self endPhase];
+    _currentPhase = [phase copy];
+    _currentPhaseStartTime = FTInstrumentationTime();
+}
+
+- (void)endPhase
+{
+    if (_currentPhase) {
+        NSTimeInterval duration = FTInstrumentationTime() - _currentPhaseStartTime;
+        _phaseDurations[_currentPhase] = @([_phaseDurations[_currentPhase] doubleValue] + duration);
+        _currentPhase = nil;
+    }
+}
+
+- (NSDictionary *)phaseDurations
+{
+    return [_phaseDurations copy];
+}
+
+#pragma mark Counts
+
+- (void)addCount:(NSUInteger)count forKey:(NSString *)key
+{
+    _counts[key] = @([_counts[key] unsignedIntegerValue] + count);
+}
+
+- (NSDictionary *)counts
+{
+    NSMutableDictionary *counts = [_counts mutableCopy];
+    if (_numberOfComparisons > 0) {
+        counts[@"comparisons"] = @([counts[@"comparisons"] unsignedIntegerValue] + _numberOfComparisons);
+    }
+    return counts;
+}
+
+- (NSComparator)countingComparator:(NSComparator)comparator
+{
+    // The span is not retained by the comparator. Comparisons made after
+    // the span has been deallocated are not counted.
+
+    __weak typeof(self) _self = self;
+    return ^NSComparisonResult(id obj1, id obj2) {
+        typeof(self) span = _self;
+        if (span) {
+            span->_numberOfComparisons++;
+        }
+        return comparator(obj1, obj2);
+    };
+}
+
+#pragma mark Observer Delivery
+
+- (void)measureDeliveryToObserver:(id)observer usingBlock:(void (^)(void))block
+{
+    NSTimeInterval startTime = FTInstrumentationTime();
+    block();
+    NSTimeInterval duration = FTInstrumentationTime() - startTime;
+
+    NSString *key = NSStringFromClass([observer class]);
+    _observerDeliveryDurations[key] = @([_observerDeliveryDurations[key] doubleValue] + duration);
+}
+
+- (NSDictionary *)observerDeliveryDurations
+{
+    return [_observerDeliveryDurations copy];
+}
+
+#pragma mark Finishing
+
+- (void)finish
+{
+    if (_finished) {
+        return;
+    }
+
+    [self endPhase];
+    _duration = FTInstrumentationTime() - _startTime;
+    _finished = YES;
+
+    [[FTInstrumentation sink] instrumentationDidFinishSpan:self];
+}
+
+#pragma mark NSObject
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p; name = %@; duration = %f; phases = %@; counts = %@>",
+                                      NSStringFromClass([self class]), (__bridge void *)self, _name, _duration, self.phaseDurations, self.counts];
+}
+
+@end
+
+#pragma mark - Time
+
+static NSTimeInterval FTInstrumentationTime(void)
+{
+    return [[NSProcessInfo processInfo] systemUptime];
+}
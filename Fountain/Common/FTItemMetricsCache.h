@@ -0,0 +1,67 @@
+//
+//  FTItemMetricsCache.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 06.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FTDataSourceObserver.h"
+
+@protocol FTDataSource;
+
+typedef double (^FTItemMetricsCacheMeasuringBlock)(id item, NSIndexPath *indexPath, id<FTDataSource> dataSource);
+
+/*! <code>FTItemMetricsCache</code> caches a metric (like the height of a row) per item of a
+    data source and the running offsets of the items in their section.
+
+    The metrics are keyed by the identity of the items. The cache observes the data source
+    and shifts the cached metrics along with the inserted, deleted and moved sections and
+    items. Only the metrics of changed items are discarded. After a reset of the data source,
+    the metrics of the items, which are still contained, are reused.
+
+    Items, which have not been measured yet, contribute the estimated metric to the offsets.
+    The offsets are kept in <code>FTPrefixSums</code> per section, which are rebuilt, if the
+    section has been changed. The metrics are summed up with a resolution of 1/1024.
+ */
+@interface FTItemMetricsCache : NSObject <FTDataSourceChangeSetObserver>
+
+#pragma mark Life-cycle
+- (instancetype)initWithMeasuringBlock:(FTItemMetricsCacheMeasuringBlock)measuringBlock;
+
+#pragma mark Data Source
+@property (nonatomic, strong) id<FTDataSource> dataSource;
+
+#pragma mark Metrics
+
+// The metric of items, which have not been measured yet. Defaults to 44.
+@property (nonatomic, readwrite) double estimatedMetric;
+
+// Returns the cached metric or measures the item, if there is no cached metric.
+- (double)metricForItemAtIndexPath:(NSIndexPath *)indexPath;
+
+// Returns the cached metric or the estimated metric, the item is never measured.
+- (double)estimatedMetricForItemAtIndexPath:(NSIndexPath *)indexPath;
+
+- (BOOL)hasMetricForItemAtIndexPath:(NSIndexPath *)indexPath;
+
+#pragma mark Offsets
+
+// The offset of the item relative to the start of its section.
+- (double)offsetOfItemAtIndexPath:(NSIndexPath *)indexPath;
+
+// Returns the index path of the item, which covers the offset relative to the start
+// of the section, or nil, if the offset is beyond the total metric of the section.
+- (NSIndexPath *)indexPathOfItemAtOffset:(double)offset inSection:(NSUInteger)section;
+
+- (double)totalMetricOfSection:(NSUInteger)section;
+- (double)offsetOfSection:(NSUInteger)section;
+@property (nonatomic, readonly) double totalMetric;
+
+#pragma mark Invalidating Metrics
+- (void)invalidateMetricForItemAtIndexPath:(NSIndexPath *)indexPath;
+- (void)invalidateAllMetrics;
+
+@end
@@ -0,0 +1,527 @@
+//
+//  FTItemMetricsCache.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 06.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTChangeSet.h"
+#import "FTDataSource.h"
+#import "FTPrefixSums.h"
+
+#import "FTItemMetricsCache.h"
+
+static const double FTItemMetricsCacheResolution = 1024.0;
+
+static NSUInteger FTItemMetricsCacheValue(double metric);
+static double FTItemMetricsCacheMetric(NSUInteger value);
+static NSIndexPath *FTItemMetricsCacheIndexPath(NSUInteger section, NSUInteger item);
+
+@interface FTItemMetricsCache () {
+    FTItemMetricsCacheMeasuringBlock _measuringBlock;
+
+    // The items per section. Items, which have not been requested from the
+    // data source yet, are NSNull. The section items are always NSNull.
+    NSMutableArray *_sections;
+    NSMutableArray *_sectionItems;
+
+    // The metrics (as values of the prefix sums) by the identity of the items
+    NSMapTable *_metrics;
+
+    // The prefix sums per section and of the total metrics of the sections. The
+    // prefix sums of invalid sections have to be rebuilt before they are used.
+    NSMutableArray *_sums;
+    NSMutableIndexSet *_invalidSections;
+    FTPrefixSums *_sectionSums;
+
+    // The changes of the current batch
+    FTMutableChangeSet *_changes;
+
+    // Marks the changed items, while the changes are applied.
+    id _changedItemMarker;
+}
+
+@end
+
+@implementation FTItemMetricsCache
+
+#pragma mark Life-cycle
+
+- (instancetype)initWithMeasuringBlock:(FTItemMetricsCacheMeasuringBlock)measuringBlock
+{
+    self = [super init];
+    if (self) {
+        _measuringBlock = measuringBlock;
+        _estimatedMetric = 44;
+        _metrics = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+                                             valueOptions:NSPointerFunctionsStrongMemory
+                                                 capacity:0];
+        _changes = [[FTMutableChangeSet alloc] init];
+        _changedItemMarker = [[NSObject alloc] init];
+        [self ft_reset];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [_dataSource removeObserver:self];
+}
+
+#pragma mark Data Source
+
+- (void)setDataSource:(id<FTDataSource>)dataSource
+{
+    if (_dataSource != dataSource) {
+        [_dataSource removeObserver:self];
+        _dataSource = dataSource;
+        [_dataSource addObserver:self];
+        [self ft_reset];
+    }
+}
+
+#pragma mark Metrics
+
+- (void)setEstimatedMetric:(double)estimatedMetric
+{
+    if (_estimatedMetric != estimatedMetric) {
+        _estimatedMetric = estimatedMetric;
+        [self ft_invalidateAllSections];
+    }
+}
+
+- (double)metricForItemAtIndexPath:(NSIndexPath *)indexPath
+{
+    id item = [self ft_itemAtIndexPath:indexPath];
+    NSNumber *value = item ? [_metrics objectForKey:item] : nil;
+
+    if (value == nil) {
+        double metric = _measuringBlock ? _measuringBlock(item, indexPath, _dataSource) : _estimatedMetric;
+        value = @(FTItemMetricsCacheValue(metric));
+        if (item) {
+            [_metrics setObject:value forKey:item];
+        }
+        [self ft_setValue:[value unsignedIntegerValue] atIndexPath:indexPath];
+    }
+
+    return FTItemMetricsCacheMetric([value unsignedIntegerValue]);
+}
+
+- (double)estimatedMetricForItemAtIndexPath:(NSIndexPath *)indexPath
+{
+    id item = [self ft_itemAtIndexPath:indexPath];
+    NSNumber *value = item ? [_metrics objectForKey:item] : nil;
+    return value ? FTItemMetricsCacheMetric([value unsignedIntegerValue]) : _estimatedMetric;
+}
+
+- (BOOL)hasMetricForItemAtIndexPath:(NSIndexPath *)indexPath
+{
+    id item = [self ft_itemAtIndexPath:indexPath];
+    return item != nil && [_metrics objectForKey:item] != nil;
+}
+
+#pragma mark Offsets
+
+- (double)offsetOfItemAtIndexPath:(NSIndexPath *)indexPath
+{
+    [self ft_validateIndexPath:indexPath];
+
+    FTPrefixSums *sums = [self ft_sumsOfSection:[indexPath indexAtPosition:0]];
+    return FTItemMetricsCacheMetric([sums sumOfValuesBeforeIndex:[indexPath indexAtPosition:1]]);
+}
+
+- (NSIndexPath *)indexPathOfItemAtOffset:(double)offset inSection:(NSUInteger)section
+{
+    [self ft_validateSection:section];
+
+    FTPrefixSums *sums = [self ft_sumsOfSection:section];
+    NSUInteger item = [sums indexOfPosition:FTItemMetricsCacheValue(offset) offset:NULL];
+    return item < [sums count] ? FTItemMetricsCacheIndexPath(section, item) : nil;
+}
+
+- (double)totalMetricOfSection:(NSUInteger)section
+{
+    [self ft_validateSection:section];
+
+    FTPrefixSums *sums = [self ft_sumsOfSection:section];
+    return FTItemMetricsCacheMetric([sums totalSum]);
+}
+
+- (double)offsetOfSection:(NSUInteger)section
+{
+    if (section > [_sections count]) {
+        [NSException raise:NSRangeException format:@"*** %s: section %lu beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, (unsigned long)section, (unsigned long)[_sections count]];
+    }
+
+    [self ft_validateAllSections];
+    return FTItemMetricsCacheMetric([_sectionSums sumOfValuesBeforeIndex:section]);
+}
+
+- (double)totalMetric
+{
+    [self ft_validateAllSections];
+    return FTItemMetricsCacheMetric([_sectionSums totalSum]);
+}
+
+#pragma mark Invalidating Metrics
+
+- (void)invalidateMetricForItemAtIndexPath:(NSIndexPath *)indexPath
+{
+    id item = [self ft_itemAtIndexPath:indexPath];
+    if (item) {
+        [_metrics removeObjectForKey:item];
+    }
+    [self ft_setValue:FTItemMetricsCacheValue(_estimatedMetric) atIndexPath:indexPath];
+}
+
+- (void)invalidateAllMetrics
+{
+    [_metrics removeAllObjects];
+    [self ft_invalidateAllSections];
+}
+
+#pragma mark Items
+
+- (id)ft_itemAtIndexPath:(NSIndexPath *)indexPath
+{
+    [self ft_validateIndexPath:indexPath];
+
+    NSUInteger section = [indexPath indexAtPosition:0];
+    NSUInteger index = [indexPath indexAtPosition:1];
+
+    id item = _sections[section][index];
+    if (item == [NSNull null]) {
+        item = [_dataSource itemAtIndexPath:FTItemMetricsCacheIndexPath(section, index)];
+        if (item) {
+            _sections[section][index] = item;
+
+            // The item might have been measured before it was requested.
+            NSNumber *value = [_metrics objectForKey:item];
+            if (value) {
+                [self ft_setValue:[value unsignedIntegerValue] atIndexPath:indexPath];
+            }
+        }
+    }
+
+    return item;
+}
+
+- (void)ft_validateSection:(NSUInteger)section
+{
+    if (section >= [_sections count]) {
+        [NSException raise:NSRangeException format:@"*** %s: section %lu beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, (unsigned long)section, (unsigned long)[_sections count]];
+    }
+}
+
+- (void)ft_validateIndexPath:(NSIndexPath *)indexPath
+{
+    NSUInteger section = [indexPath indexAtPosition:0];
+    NSUInteger item = [indexPath indexAtPosition:1];
+
+    if ([indexPath length] != 2 || section >= [_sections count] || item >= [_sections[section] count]) {
+        [NSException raise:NSRangeException format:@"*** %s: index path %@ beyond bounds.", __PRETTY_FUNCTION__, indexPath];
+    }
+}
+
+#pragma mark Prefix Sums
+
+- (FTPrefixSums *)ft_sumsOfSection:(NSUInteger)section
+{
+    if ([_invalidSections containsIndex:section]) {
+        NSArray *items = _sections[section];
+        NSUInteger numberOfItems = [items count];
+        NSUInteger estimatedValue = FTItemMetricsCacheValue(_estimatedMetric);
+
+        NSMutableData *values = [[NSMutableData alloc] initWithLength:numberOfItems * sizeof(NSUInteger)];
+        NSUInteger *buffer = [values mutableBytes];
+
+        NSNull *null = [NSNull null];
+        for (NSUInteger idx = 0; idx < numberOfItems; idx++) {
+            id item = items[idx];
+            NSNumber *value = item != null ? [_metrics objectForKey:item] : nil;
+            buffer[idx] = value ? [value unsignedIntegerValue] : estimatedValue;
+        }
+
+        FTPrefixSums *sums = [[FTPrefixSums alloc] initWithValues:buffer count:numberOfItems];
+        _sums[section] = sums;
+        [_sectionSums setValue:[sums totalSum] atIndex:section];
+        [_invalidSections removeIndex:section];
+    }
+    return _sums[section];
+}
+
+- (void)ft_setValue:(NSUInteger)value atIndexPath:(NSIndexPath *)indexPath
+{
+    NSUInteger section = [indexPath indexAtPosition:0];
+    NSUInteger item = [indexPath indexAtPosition:1];
+
+    // Invalid sections pick up the value, if they are rebuilt.
+    if ([_invalidSections containsIndex:section] == NO) {
+        FTPrefixSums *sums = _sums[section];
+        NSUInteger currentValue = [sums valueAtIndex:item];
+        if (currentValue != value) {
+            [sums setValue:value atIndex:item];
+            [_sectionSums addValue:(NSInteger)(value - currentValue) toValueAtIndex:section];
+        }
+    }
+}
+
+- (void)ft_validateAllSections
+{
+    [[_invalidSections copy] enumerateIndexesUsingBlock:^(NSUInteger section, BOOL *stop) {
+        [self ft_sumsOfSection:section];
+    }];
+}
+
+- (void)ft_invalidateAllSections
+{
+    NSUInteger numberOfSections = [_sections count];
+
+    _sums = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        [_sums addObject:[NSNull null]];
+    }
+
+    _invalidSections = [[NSMutableIndexSet alloc] initWithIndexesInRange:NSMakeRange(0, numberOfSections)];
+    _sectionSums = [[FTPrefixSums alloc] initWithValues:NULL count:numberOfSections];
+}
+
+#pragma mark Applying Changes
+
+- (void)ft_reset
+{
+    [_changes removeAllChanges];
+
+    NSUInteger numberOfSections = [_dataSource numberOfSections];
+
+    _sections = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+    _sectionItems = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        NSUInteger numberOfItems = [_dataSource numberOfItemsInSection:section];
+        NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:numberOfItems];
+        for (NSUInteger item = 0; item < numberOfItems; item++) {
+            [items addObject:[NSNull null]];
+        }
+        [_sections addObject:items];
+        [_sectionItems addObject:[NSNull null]];
+    }
+
+    [self ft_invalidateAllSections];
+}
+
+- (void)ft_applyChanges
+{
+    if ([_changes isEmpty]) {
+        return;
+    }
+
+    FTChangeSet *changeSet = [_changes copy];
+    [_changes removeAllChanges];
+
+    NSUInteger numberOfSections = [_sections count];
+    NSNull *null = [NSNull null];
+
+    // The metrics of deleted items are discarded. Changed items are
+    // marked and their metrics are discarded after the changes are
+    // applied, because they might not have been requested yet.
+
+    void (^discardMetrics)(NSUInteger, NSIndexSet *, BOOL) = ^(NSUInteger section, NSIndexSet *items, BOOL markItems) {
+        if (section < numberOfSections && [items lastIndex] < [_sections[section] count]) {
+            NSMutableArray *sectionItems = _sections[section];
+            [items enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+                id item = sectionItems[idx];
+                if (item != null && item != _changedItemMarker) {
+                    [_metrics removeObjectForKey:item];
+                }
+                if (markItems) {
+                    sectionItems[idx] = _changedItemMarker;
+                }
+            }];
+        }
+    };
+
+    [changeSet.deletedSections enumerateIndexesUsingBlock:^(NSUInteger section, BOOL *stop) {
+        if (section < numberOfSections) {
+            discardMetrics(section, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [_sections[section] count])], NO);
+        }
+    }];
+
+    [changeSet.changedSections enumerateIndexesUsingBlock:^(NSUInteger section, BOOL *stop) {
+        if (section < numberOfSections) {
+            discardMetrics(section, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [_sections[section] count])], YES);
+        }
+    }];
+
+    [changeSet enumerateDeletedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        discardMetrics(section, items, NO);
+    }];
+
+    [changeSet enumerateChangedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        discardMetrics(section, items, YES);
+    }];
+
+    BOOL consistent = [changeSet applyToSections:_sections
+                                    sectionItems:_sectionItems
+                               insertedItemBlock:nil
+                        insertedSectionItemBlock:nil];
+
+    if (consistent == NO) {
+        [self ft_reset];
+        return;
+    }
+
+    // If the sections did not change, only the sections with changed items are rebuilt.
+
+    __block BOOL sectionsChanged = [changeSet.insertedSections count] > 0 || [changeSet.deletedSections count] > 0;
+    [changeSet enumerateSectionMovesUsingBlock:^(NSUInteger section, NSUInteger newSection, BOOL *stop) {
+        sectionsChanged = YES;
+        *stop = YES;
+    }];
+
+    NSMutableIndexSet *changedSections = [[NSMutableIndexSet alloc] init];
+
+    if (sectionsChanged) {
+        [self ft_invalidateAllSections];
+        [changedSections addIndexesInRange:NSMakeRange(0, [_sections count])];
+    } else {
+        void (^addSection)(NSUInteger, NSIndexSet *, BOOL *) = ^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+            [changedSections addIndex:section];
+        };
+        [changeSet enumerateInsertedItemsUsingBlock:addSection];
+        [changeSet enumerateDeletedItemsUsingBlock:addSection];
+        [changeSet enumerateChangedItemsUsingBlock:addSection];
+        [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+            [changedSections addIndex:[indexPath indexAtPosition:0]];
+            [changedSections addIndex:[newIndexPath indexAtPosition:0]];
+        }];
+        [changedSections addIndexes:changeSet.changedSections];
+        [_invalidSections addIndexes:changedSections];
+    }
+
+    // Discard the metrics of the changed items, which have not been requested before.
+
+    [changedSections enumerateIndexesUsingBlock:^(NSUInteger section, BOOL *stop) {
+        NSMutableArray *items = _sections[section];
+        NSIndexSet *markedItems = [items indexesOfObjectsPassingTest:^BOOL(id item, NSUInteger idx, BOOL *stop) {
+            return item == _changedItemMarker;
+        }];
+        [markedItems enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+            id item = [_dataSource itemAtIndexPath:FTItemMetricsCacheIndexPath(section, idx)];
+            if (item) {
+                [_metrics removeObjectForKey:item];
+            }
+            items[idx] = item ?: null;
+        }];
+    }];
+}
+
+#pragma mark FTDataSourceObserver
+
+- (void)dataSourceDidReset:(id<FTDataSource>)dataSource
+{
+    if (dataSource == _dataSource) {
+        [self ft_reset];
+    }
+}
+
+- (void)dataSourceWillChange:(id<FTDataSource>)dataSource
+{
+    if (dataSource == _dataSource) {
+        // Changes reported before a nested batch are relative to a different state.
+        [self ft_applyChanges];
+    }
+}
+
+- (void)dataSourceDidChange:(id<FTDataSource>)dataSource
+{
+    if (dataSource == _dataSource) {
+        [self ft_applyChanges];
+    }
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didInsertSections:(NSIndexSet *)sections
+{
+    if (dataSource == _dataSource) {
+        [_changes insertSections:sections];
+    }
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didDeleteSections:(NSIndexSet *)sections
+{
+    if (dataSource == _dataSource) {
+        [_changes deleteSections:sections];
+    }
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didChangeSections:(NSIndexSet *)sections
+{
+    if (dataSource == _dataSource) {
+        [_changes changeSections:sections];
+    }
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didMoveSection:(NSInteger)section toSection:(NSInteger)newSection
+{
+    if (dataSource == _dataSource) {
+        [_changes moveSection:section toSection:newSection];
+    }
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didInsertItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    if (dataSource == _dataSource) {
+        [_changes insertItemsAtIndexPaths:indexPaths];
+    }
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didDeleteItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    if (dataSource == _dataSource) {
+        [_changes deleteItemsAtIndexPaths:indexPaths];
+    }
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didChangeItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    if (dataSource == _dataSource) {
+        [_changes changeItemsAtIndexPaths:indexPaths];
+    }
+}
+
+- (void)dataSource:(id<FTDataSource>)dataSource didMoveItemAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath
+{
+    if (dataSource == _dataSource) {
+        [_changes moveItemAtIndexPath:indexPath toIndexPath:newIndexPath];
+    }
+}
+
+#pragma mark FTDataSourceChangeSetObserver
+
+- (void)dataSource:(id<FTDataSource>)dataSource didApplyChangeSet:(FTChangeSet *)changeSet
+{
+    if (dataSource == _dataSource) {
+        [_changes addChangesFromChangeSet:changeSet sectionOffset:0];
+    }
+}
+
+@end
+
+#pragma mark - Values
+
+static NSUInteger FTItemMetricsCacheValue(double metric)
+{
+    return metric > 0 ? (NSUInteger)llround(metric * FTItemMetricsCacheResolution) : 0;
+}
+
+static double FTItemMetricsCacheMetric(NSUInteger value)
+{
+    return (double)value / FTItemMetricsCacheResolution;
+}
+
+static NSIndexPath *FTItemMetricsCacheIndexPath(NSUInteger section, NSUInteger item)
+{
+    NSUInteger indexes[] = {section, item};
+    return [NSIndexPath indexPathWithIndexes:indexes length:2];
+}
@@ -16,7 +16,23 @@
  */
 @interface FTMutableArray : NSMutableArray <FTDataSource, FTReverseDataSource>
 
+// Replaces the objects with the given objects. The observers are notified about
+// the minimal set of insertions, deletions and moves between both contents.
 - (void)replaceAllObjectsWithObjects:(NSArray *)objects;
 - (void)moveObjectAtIndex:(NSUInteger)fromIndex toIndex:(NSUInteger)toIndex;
 
+#pragma mark Batch Updates
+
+/** Combines multiple insert, delete, replace and move operations to one change.
+ 
+ You can use this method in cases where you want to make multiple changes to the array and want to treat them as a single change. Use the blocked passed in the updates parameter to specify all of the operations you want to perform. The observer methods <code>dataSourceWillChange:</code> and <code>dataSourceDidChange:</code> are only called once for all operations performed in the batch update.
+ 
+ The change set of a batch update (see <code>FTDataSourceChangeSetObserver</code>) only contains the moves of <code>moveObjectAtIndex:toIndex:</code> and <code>replaceAllObjectsWithObjects:</code>, if this is the only operation of the batch update. Otherwise the affected objects are reported as deleted and inserted.
+ 
+ @note This method may safely be called reentrantly.
+ 
+ @param updates The block that performs the relevant insert, delete, replace and move operations.
+ */
+- (void)performBatchUpdate:(void (^)(void))updates;
+
 @end
@@ -6,14 +6,26 @@
 //  Copyright © 2015 Tobias Kräntzer. All rights reserved.
 //
 
+#import "FTChangeSet.h"
 #import "FTDataSourceObserver.h"
+#import "FTInstrumentation.h"
+#import "FTObserverRegistry.h"
 
 #import "FTMutableArray.h"
 
 @implementation FTMutableArray {
     NSMutableArray *_backingStore;
-    NSHashTable *_observers;
+    FTObserverRegistry *_observers;
     NSUInteger _batchUpdateCallCount;
+
+    FTMutableChangeSet *_changeSet;
+    NSMutableIndexSet *_insertedIndexes;
+    NSMutableIndexSet *_deletedIndexes;
+    NSMutableIndexSet *_changedIndexes;
+    NSIndexSet *_takenOverRemovedIndexes;
+    NSIndexSet *_takenOverInsertedIndexes;
+
+    FTInstrumentationSpan *_instrumentationSpan;
 }
 
 #pragma mark Life-cycle
@@ -33,7 +45,7 @@
     self = [super init];
     if (self) {
         _backingStore = backingStore;
-        _observers = [[NSHashTable alloc] init];
+        _observers = [[FTObserverRegistry alloc] init];
         _batchUpdateCallCount = 0;
     }
     return self;
@@ -43,19 +55,30 @@
 
 - (void)replaceAllObjectsWithObjects:(NSArray *)objects
 {
-    [self ft_performBatchUpdate:^{
-        [self removeAllObjects];
-        [self addObjectsFromArray:objects];
+    [self performBatchUpdate:^{
+        NSUInteger count = [_backingStore count];
+        FTChangeSet *changeSet = [self ft_changeSetFromObjects:_backingStore toObjects:objects];
+        [_backingStore setArray:objects];
+        [self ft_didApplyChangeSet:changeSet
+                    removedIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, count)]
+                   insertedIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [objects count])]];
     }];
 }
 
 - (void)moveObjectAtIndex:(NSUInteger)fromIndex toIndex:(NSUInteger)toIndex
 {
     if (fromIndex != toIndex) {
-        [self ft_performBatchUpdate:^{
-            id object = [self objectAtIndex:fromIndex];
-            [self removeObjectAtIndex:fromIndex];
-            [self insertObject:object atIndex:toIndex];
+        [self performBatchUpdate:^{
+            id object = [_backingStore objectAtIndex:fromIndex];
+            [_backingStore removeObjectAtIndex:fromIndex];
+            [_backingStore insertObject:object atIndex:toIndex];
+
+            FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+            [changeSet moveItemAtIndexPath:[[NSIndexPath indexPathWithIndex:0] indexPathByAddingIndex:fromIndex]
+                               toIndexPath:[[NSIndexPath indexPathWithIndex:0] indexPathByAddingIndex:toIndex]];
+            [self ft_didApplyChangeSet:changeSet
+                        removedIndexes:[NSIndexSet indexSetWithIndex:fromIndex]
+                       insertedIndexes:[NSIndexSet indexSetWithIndex:toIndex]];
         }];
     }
 }
@@ -76,102 +99,102 @@
 
 - (void)insertObject:(nonnull id)anObject atIndex:(NSUInteger)index
 {
-    [self ft_performBatchUpdate:^{
-
+    [self performBatchUpdate:^{
         [_backingStore insertObject:anObject atIndex:index];
+        [self ft_didInsertObjectsAtIndexes:[NSIndexSet indexSetWithIndex:index]];
+    }];
+}
 
-        NSIndexPath *indexPath = [[NSIndexPath indexPathWithIndex:0] indexPathByAddingIndex:index];
-
-        for (id<FTDataSourceObserver> observer in self.observers) {
-            if ([observer respondsToSelector:@selector(dataSource:didInsertItemsAtIndexPaths:)]) {
-                [observer dataSource:self didInsertItemsAtIndexPaths:@[ indexPath ]];
-            }
-        }
+- (void)insertObjects:(NSArray *)objects atIndexes:(NSIndexSet *)indexes
+{
+    [self performBatchUpdate:^{
+        [_backingStore insertObjects:objects atIndexes:indexes];
+        [self ft_didInsertObjectsAtIndexes:indexes];
     }];
 }
 
 - (void)removeObjectAtIndex:(NSUInteger)index
 {
-    [self ft_performBatchUpdate:^{
-
+    [self performBatchUpdate:^{
         [_backingStore removeObjectAtIndex:index];
-
-        NSIndexPath *indexPath = [[NSIndexPath indexPathWithIndex:0] indexPathByAddingIndex:index];
-
-        for (id<FTDataSourceObserver> observer in self.observers) {
-            if ([observer respondsToSelector:@selector(dataSource:didDeleteItemsAtIndexPaths:)]) {
-                [observer dataSource:self didDeleteItemsAtIndexPaths:@[ indexPath ]];
-            }
-        }
+        [self ft_didRemoveObjectsAtIndexes:[NSIndexSet indexSetWithIndex:index]];
     }];
 }
 
-- (void)addObject:(nonnull id)anObject
+- (void)removeObjectsAtIndexes:(NSIndexSet *)indexes
 {
-    [self ft_performBatchUpdate:^{
-
-        [_backingStore addObject:anObject];
+    [self performBatchUpdate:^{
+        [_backingStore removeObjectsAtIndexes:indexes];
+        [self ft_didRemoveObjectsAtIndexes:indexes];
+    }];
+}
 
-        NSUInteger index = [_backingStore count] - 1;
+- (void)removeObjectsInRange:(NSRange)range
+{
+    [self removeObjectsAtIndexes:[NSIndexSet indexSetWithIndexesInRange:range]];
+}
 
-        NSIndexPath *indexPath = [[NSIndexPath indexPathWithIndex:0] indexPathByAddingIndex:index];
+- (void)removeAllObjects
+{
+    [self removeObjectsInRange:NSMakeRange(0, [_backingStore count])];
+}
 
-        for (id<FTDataSourceObserver> observer in self.observers) {
-            if ([observer respondsToSelector:@selector(dataSource:didInsertItemsAtIndexPaths:)]) {
-                [observer dataSource:self didInsertItemsAtIndexPaths:@[ indexPath ]];
-            }
-        }
+- (void)addObject:(nonnull id)anObject
+{
+    [self performBatchUpdate:^{
+        [_backingStore addObject:anObject];
+        [self ft_didInsertObjectsAtIndexes:[NSIndexSet indexSetWithIndex:[_backingStore count] - 1]];
     }];
 }
 
 - (void)addObjectsFromArray:(NSArray *)otherArray
 {
-    [self ft_performBatchUpdate:^{
-        [super addObjectsFromArray:otherArray];
-    }];
+    [self insertObjects:otherArray atIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange([_backingStore count], [otherArray count])]];
 }
 
 - (void)removeLastObject
 {
-    [self ft_performBatchUpdate:^{
-
+    [self performBatchUpdate:^{
         [_backingStore removeLastObject];
-
-        NSUInteger index = [_backingStore count];
-
-        NSIndexPath *indexPath = [[NSIndexPath indexPathWithIndex:0] indexPathByAddingIndex:index];
-
-        for (id<FTDataSourceObserver> observer in self.observers) {
-            if ([observer respondsToSelector:@selector(dataSource:didDeleteItemsAtIndexPaths:)]) {
-                [observer dataSource:self didDeleteItemsAtIndexPaths:@[ indexPath ]];
-            }
-        }
+        [self ft_didRemoveObjectsAtIndexes:[NSIndexSet indexSetWithIndex:[_backingStore count]]];
     }];
 }
 
 - (void)replaceObjectAtIndex:(NSUInteger)index withObject:(nonnull id)anObject
 {
-    [self ft_performBatchUpdate:^{
-
+    [self performBatchUpdate:^{
         [_backingStore replaceObjectAtIndex:index withObject:anObject];
-
-        NSIndexPath *indexPath = [[NSIndexPath indexPathWithIndex:0] indexPathByAddingIndex:index];
-
-        for (id<FTDataSourceObserver> observer in self.observers) {
-            if ([observer respondsToSelector:@selector(dataSource:didChangeItemsAtIndexPaths:)]) {
-                [observer dataSource:self didChangeItemsAtIndexPaths:@[ indexPath ]];
-            }
-        }
+        [self ft_didReplaceObjectsAtIndexes:[NSIndexSet indexSetWithIndex:index]];
     }];
 }
 
 - (void)replaceObjectsAtIndexes:(NSIndexSet *)indexes withObjects:(NSArray *)objects
 {
-    [self ft_performBatchUpdate:^{
-        [super replaceObjectsAtIndexes:indexes withObjects:objects];
+    [self performBatchUpdate:^{
+        [_backingStore replaceObjectsAtIndexes:indexes withObjects:objects];
+        [self ft_didReplaceObjectsAtIndexes:indexes];
     }];
 }
 
+- (void)replaceObjectsInRange:(NSRange)range withObjectsFromArray:(NSArray *)otherArray
+{
+    [self performBatchUpdate:^{
+        [_backingStore replaceObjectsInRange:range withObjectsFromArray:otherArray];
+
+        // The objects in front are replaced, the remaining ones are removed or inserted.
+        NSUInteger numberOfReplacedObjects = MIN(range.length, [otherArray count]);
+        NSUInteger location = range.location + numberOfReplacedObjects;
+        [self ft_didReplaceObjectsAtIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(range.location, numberOfReplacedObjects)]];
+        [self ft_didRemoveObjectsAtIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(location, range.length - numberOfReplacedObjects)]];
+        [self ft_didInsertObjectsAtIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(location, [otherArray count] - numberOfReplacedObjects)]];
+    }];
+}
+
+- (void)replaceObjectsInRange:(NSRange)range withObjectsFromArray:(NSArray *)otherArray range:(NSRange)otherRange
+{
+    [self replaceObjectsInRange:range withObjectsFromArray:[otherArray subarrayWithRange:otherRange]];
+}
+
 #pragma mark NSCopying
 
 - (id)copyWithZone:(nullable NSZone *)zone
@@ -204,7 +227,7 @@
     self = [super initWithCoder:aDecoder];
     if (self) {
         _backingStore = [aDecoder decodeObjectOfClass:[NSMutableArray class] forKey:@"_backingStore"];
-        _observers = [[NSHashTable alloc] init];
+        _observers = [[FTObserverRegistry alloc] init];
         _batchUpdateCallCount = 0;
     }
     return self;
@@ -219,15 +242,23 @@
 
 #pragma mark Batch Updates
 
-- (void)ft_performBatchUpdate:(void (^)(void))updates
+- (void)performBatchUpdate:(void (^)(void))updates
 {
     if (updates) {
         if (_batchUpdateCallCount == 0) {
-            for (id<FTDataSourceObserver> observer in self.observers) {
-                if ([observer respondsToSelector:@selector(dataSourceWillChange:)]) {
+            _instrumentationSpan = [FTInstrumentationSpan spanWithName:@"FTMutableArray.batch"];
+            _observers.instrumentationSpan = _instrumentationSpan;
+            [_instrumentationSpan beginPhase:@"notify"];
+
+            [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+                if (methods & FTDataSourceObserverMethodWillChange) {
                     [observer dataSourceWillChange:self];
                 }
-            }
+            }];
+            [self ft_beginChangeSet];
+
+            // The mutations are applied and reported to the observers one by one.
+            [_instrumentationSpan beginPhase:@"mutate"];
         }
 
         _batchUpdateCallCount++;
@@ -237,13 +268,265 @@
         _batchUpdateCallCount--;
 
         if (_batchUpdateCallCount == 0) {
-            for (id<FTDataSourceObserver> observer in self.observers) {
-                if ([observer respondsToSelector:@selector(dataSourceDidChange:)]) {
+            [_instrumentationSpan beginPhase:@"notify"];
+
+            [self ft_endChangeSet];
+            [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+                if (methods & FTDataSourceObserverMethodDidChange) {
                     [observer dataSourceDidChange:self];
                 }
+            }];
+
+            [self ft_finishInstrumentationSpan];
+        }
+    }
+}
+
+#pragma mark Instrumentation
+
+- (void)ft_finishInstrumentationSpan
+{
+    if (_instrumentationSpan) {
+        FTInstrumentationSpan *span = _instrumentationSpan;
+        _instrumentationSpan = nil;
+        _observers.instrumentationSpan = nil;
+
+        [span addCount:[_backingStore count] forKey:@"items"];
+        [span finish];
+    }
+}
+
+#pragma mark Change Set
+
+- (void)ft_beginChangeSet
+{
+    if (_observers.implementedMethods & FTDataSourceObserverMethodDidApplyChangeSet) {
+        _changeSet = [[FTMutableChangeSet alloc] init];
+        _insertedIndexes = [[NSMutableIndexSet alloc] init];
+        _deletedIndexes = [[NSMutableIndexSet alloc] init];
+        _changedIndexes = [[NSMutableIndexSet alloc] init];
+    }
+}
+
+- (void)ft_endChangeSet
+{
+    if (_changeSet) {
+        [_changedIndexes removeIndexes:_deletedIndexes];
+
+        [_changeSet deleteItemsAtIndexes:_deletedIndexes inSection:0];
+        [_changeSet insertItemsAtIndexes:_insertedIndexes inSection:0];
+        [_changeSet changeItemsAtIndexes:_changedIndexes inSection:0];
+
+        FTChangeSet *changeSet = [_changeSet copy];
+
+        _changeSet = nil;
+        _insertedIndexes = nil;
+        _deletedIndexes = nil;
+        _changedIndexes = nil;
+        _takenOverRemovedIndexes = nil;
+        _takenOverInsertedIndexes = nil;
+
+        [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+            if (methods & FTDataSourceObserverMethodDidApplyChangeSet) {
+                [(id<FTDataSourceChangeSetObserver>)observer dataSource:self didApplyChangeSet:changeSet];
+            }
+        }];
+    }
+}
+
+// The mutations of the array are reported one by one, each relative to the state
+// after the previous mutation. The change set uses the indexes before the batch
+// update for deleted and changed objects and the indexes after the batch update for
+// inserted objects. The following methods translate between both representations.
+
+- (void)ft_didInsertObjectsAtIndexes:(NSIndexSet *)indexes
+{
+    if ([indexes count] == 0) {
+        return;
+    }
+
+    [self ft_recordInsertedIndexes:indexes];
+    [_instrumentationSpan addCount:[indexes count] forKey:@"inserted"];
+
+    __block NSArray *indexPaths = nil;
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidInsertItems) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
+            indexPaths = indexPaths ?: [self ft_indexPathsWithIndexes:indexes];
+            [observer dataSource:self didInsertItemsAtIndexPaths:indexPaths];
+        }
+    }];
+}
+
+- (void)ft_didRemoveObjectsAtIndexes:(NSIndexSet *)indexes
+{
+    if ([indexes count] == 0) {
+        return;
+    }
+
+    [self ft_recordRemovedIndexes:indexes];
+    [_instrumentationSpan addCount:[indexes count] forKey:@"deleted"];
+
+    __block NSArray *indexPaths = nil;
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidDeleteItems) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
+            indexPaths = indexPaths ?: [self ft_indexPathsWithIndexes:indexes];
+            [observer dataSource:self didDeleteItemsAtIndexPaths:indexPaths];
+        }
+    }];
+}
+
+- (void)ft_didReplaceObjectsAtIndexes:(NSIndexSet *)indexes
+{
+    if ([indexes count] == 0) {
+        return;
+    }
+
+    [self ft_recordReplacedIndexes:indexes];
+    [_instrumentationSpan addCount:[indexes count] forKey:@"changed"];
+
+    __block NSArray *indexPaths = nil;
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidChangeItems) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
+            indexPaths = indexPaths ?: [self ft_indexPathsWithIndexes:indexes];
+            [observer dataSource:self didChangeItemsAtIndexPaths:indexPaths];
+        }
+    }];
+}
+
+// Mutations, which rearrange the array as a whole (moving an object or replacing
+// all objects), are described by a change set of their own. It is taken over as it
+// is, if nothing else has been changed in the current batch update. Otherwise the
+// affected objects are recorded as removed and inserted again. If the batch update
+// continues after a change set has been taken over, the change set is replayed as
+// removed and inserted objects first.
+
+- (void)ft_didApplyChangeSet:(FTChangeSet *)changeSet removedIndexes:(NSIndexSet *)removedIndexes insertedIndexes:(NSIndexSet *)insertedIndexes
+{
+    if (_changeSet) {
+        if (_takenOverRemovedIndexes == nil && [_insertedIndexes count] == 0 && [_deletedIndexes count] == 0 && [_changedIndexes count] == 0) {
+            if ([changeSet isEmpty] == NO) {
+                [_changeSet addChangesFromChangeSet:changeSet sectionOffset:0];
+                _takenOverRemovedIndexes = [removedIndexes copy];
+                _takenOverInsertedIndexes = [insertedIndexes copy];
             }
+        } else {
+            [self ft_recordRemovedIndexes:removedIndexes];
+            [self ft_recordInsertedIndexes:insertedIndexes];
         }
     }
+
+    [_instrumentationSpan addCount:[removedIndexes count] forKey:@"deleted"];
+    [_instrumentationSpan addCount:[insertedIndexes count] forKey:@"inserted"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (!(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
+            [changeSet notifyObserver:observer implementingMethods:methods ofChangesInDataSource:self];
+        }
+    }];
+}
+
+- (void)ft_replayTakenOverChangeSet
+{
+    if (_takenOverRemovedIndexes) {
+        // The removed indexes refer to the array before the batch update,
+        // the inserted indexes to the current array.
+        [_changeSet removeAllChanges];
+        [_deletedIndexes addIndexes:_takenOverRemovedIndexes];
+        [_insertedIndexes addIndexes:_takenOverInsertedIndexes];
+        _takenOverRemovedIndexes = nil;
+        _takenOverInsertedIndexes = nil;
+    }
+}
+
+- (void)ft_recordInsertedIndexes:(NSIndexSet *)indexes
+{
+    if (_changeSet) {
+        [self ft_replayTakenOverChangeSet];
+        // The indexes refer to the array after the insertion. Inserting the
+        // ranges in ascending order shifts each range by the preceding ones.
+        [indexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+            [_insertedIndexes shiftIndexesStartingAtIndex:range.location by:range.length];
+            [_insertedIndexes addIndexesInRange:range];
+        }];
+    }
+}
+
+- (void)ft_recordRemovedIndexes:(NSIndexSet *)indexes
+{
+    if (_changeSet) {
+        [self ft_replayTakenOverChangeSet];
+        if ([_insertedIndexes count] == 0 && [_deletedIndexes count] == 0) {
+            [_deletedIndexes addIndexes:indexes];
+        } else {
+            // The indexes refer to the array before the removal. Removing the
+            // objects in descending order keeps the remaining indexes valid.
+            [indexes enumerateIndexesWithOptions:NSEnumerationReverse
+                                      usingBlock:^(NSUInteger index, BOOL *stop) {
+                                          if ([_insertedIndexes containsIndex:index]) {
+                                              [_insertedIndexes removeIndex:index];
+                                          } else {
+                                              [_deletedIndexes addIndex:[self ft_originalIndexOfIndex:index]];
+                                          }
+                                          [_insertedIndexes shiftIndexesStartingAtIndex:index + 1 by:-1];
+                                      }];
+        }
+    }
+}
+
+- (void)ft_recordReplacedIndexes:(NSIndexSet *)indexes
+{
+    if (_changeSet) {
+        [self ft_replayTakenOverChangeSet];
+        if ([_insertedIndexes count] == 0 && [_deletedIndexes count] == 0) {
+            [_changedIndexes addIndexes:indexes];
+        } else {
+            [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+                if (![_insertedIndexes containsIndex:index]) {
+                    [_changedIndexes addIndex:[self ft_originalIndexOfIndex:index]];
+                }
+            }];
+        }
+    }
+}
+
+- (NSUInteger)ft_originalIndexOfIndex:(NSUInteger)index
+{
+    // Skip the objects inserted in front of the index, then skip the
+    // objects, which have been deleted in front of the original index.
+
+    __block NSUInteger originalIndex = index - [_insertedIndexes countOfIndexesInRange:NSMakeRange(0, index)];
+    [_deletedIndexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+        if (range.location <= originalIndex) {
+            originalIndex += range.length;
+        } else {
+            *stop = YES;
+        }
+    }];
+    return originalIndex;
+}
+
+- (NSArray *)ft_indexPathsWithIndexes:(NSIndexSet *)indexes
+{
+    NSMutableArray *indexPaths = [[NSMutableArray alloc] initWithCapacity:[indexes count]];
+    NSIndexPath *sectionIndexPath = [NSIndexPath indexPathWithIndex:0];
+    [indexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        [indexPaths addObject:[sectionIndexPath indexPathByAddingIndex:index]];
+    }];
+    return indexPaths;
+}
+
+#pragma mark Diff
+
+- (FTChangeSet *)ft_changeSetFromObjects:(NSArray *)objects toObjects:(NSArray *)newObjects
+{
+    return [FTChangeSet changeSetFromSections:@[ objects ]
+                                 sectionItems:@[ [NSNull null] ]
+                                   toSections:@[ newObjects ]
+                                 sectionItems:@[ [NSNull null] ]
+                                 changedItems:nil];
 }
 
 #pragma mark FTDataSource
@@ -294,17 +577,17 @@
 
 - (NSArray *)observers
 {
-    return [_observers allObjects];
+    return [_observers observers];
 }
 
 - (void)addObserver:(id<FTDataSourceObserver>)observer
 {
-    [_observers addObject:observer];
+    [_observers addObserver:observer];
 }
 
 - (void)removeObserver:(id<FTDataSourceObserver>)observer
 {
-    [_observers removeObject:observer];
+    [_observers removeObserver:observer];
 }
 
 #pragma mark FTReverseDataSource
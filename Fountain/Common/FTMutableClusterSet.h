@@ -32,6 +32,12 @@
 #pragma mark Life-cycle
 - (instancetype)initSortDescriptors:(NSArray *)sortDescriptors comperator:(FTClusterComperator *)comperator;
 
+/*! Initializes the set with objects, which are already sorted by the sort descriptors.
+    The clusters are built in a single pass, comparing each object with its predecessor.
+    The order is only verified, if assertions are enabled.
+ */
+- (instancetype)initWithSortedObjects:(NSArray *)objects sortDescriptors:(NSArray *)sortDescriptors comperator:(FTClusterComperator *)comperator;
+
 #pragma mark Sort Descriptors & Clustering
 @property (nonatomic, readonly) NSArray *sortDescriptors;
 @property (nonatomic, readonly) FTClusterComperator *comperator;
@@ -42,6 +48,8 @@
  
  You can use this method in cases where you want to make multiple changes to the set and want to treat them as a single change. Use the blocked passed in the updates parameter to specify all of the operations you want to perform. The observer methods <code>dataSourceWillChange:</code> and <code>dataSourceDidChange:</code> are only called once for all operations performed in the batch update.
  
+ The changes are reported to the observers as inserted, deleted and moved sections and items. If at least 100 objects and more than half of the objects (before or after the update, whichever is larger) have been changed, the observers are notified with <code>dataSourceWillReset:</code> and <code>dataSourceDidReset:</code> instead. Objects inserted into an empty set are always reported as inserted sections.
+ 
  @note This method may safely be called reentrantly.
  
  @param updates The block that performs the relevant insert, delete, and replace operations.
@@ -6,12 +6,25 @@
 //  Copyright © 2015 Tobias Kräntzer. All rights reserved.
 //
 
+#import "FTChangeSet.h"
 #import "FTDataSourceObserver.h"
+#import "FTInstrumentation.h"
+#import "FTObserverRegistry.h"
+#import "FTPrefixSums.h"
+#import "FTSortKeyCache.h"
+#import "NSArray+Fountain.h"
+#import "NSSortDescriptor+Fountain.h"
 
 #import "FTMutableClusterSet.h"
 
+// A batch update is reported as a reset, if it changes at least the minimum
+// number of objects and more than the fraction of the larger of the number of
+// objects before and after the update.
+static const NSUInteger FTMutableClusterSetMinimumNumberOfChangesForReset = 100;
+static const double FTMutableClusterSetFractionOfChangesForReset = 0.5;
+
 @interface FTMutableClusterSet () {
-    NSHashTable *_observers;
+    FTObserverRegistry *_observers;
 
     NSUInteger _batchUpdateCallCount;
 
@@ -20,9 +33,21 @@
     NSMutableArray *_backingStore;
     NSMutableArray *_sections;
 
+    // The map from the objects to their sections and the number of items per
+    // section are used to translate between objects, positions in the backing
+    // store and index paths. The indexes of the sections are rebuilt on demand.
+    NSMapTable *_sectionsOfObjects;
+    NSMapTable *_indexesOfSections;
+    FTPrefixSums *_numbersOfItems;
+    NSComparator _objectComperator;
+
     NSMutableSet *_insertedObjects;
     NSMutableSet *_updatedObjects;
     NSMutableSet *_deletedObjects;
+
+    NSMapTable *_sectionSnapshots;
+
+    FTInstrumentationSpan *_instrumentationSpan;
 }
 
 @end
@@ -36,6 +61,17 @@
     return [self initWithBackingStore:[[NSMutableArray alloc] init] sortDescriptors:sortDescriptors comperator:comperator];
 }
 
+- (instancetype)initWithSortedObjects:(NSArray *)objects sortDescriptors:(NSArray *)sortDescriptors comperator:(FTClusterComperator *)comperator
+{
+    self = [self initWithBackingStore:[[NSMutableArray alloc] init] sortDescriptors:sortDescriptors comperator:comperator];
+    if (self) {
+        // The order of the objects is only verified, if assertions are enabled.
+        NSAssert([objects ft_isSortedUsingComparator:_objectComperator], @"Objects must be sorted by the sort descriptors.");
+        [self ft_loadSortedObjects:objects];
+    }
+    return self;
+}
+
 - (nonnull instancetype)initWithBackingStore:(NSMutableArray *)backingStore
                              sortDescriptors:(NSArray *)sortDescriptors
                                   comperator:(FTClusterComperator *)comperator
@@ -43,14 +79,15 @@
     self = [super init];
     if (self) {
         _backingStore = backingStore;
-        _observers = [[NSHashTable alloc] init];
+        _observers = [[FTObserverRegistry alloc] init];
         _batchUpdateCallCount = 0;
         _sortDescriptors = [sortDescriptors count] > 0 ? [sortDescriptors copy] : nil;
         _comperator = comperator;
 
-        [_backingStore sortUsingDescriptors:self.sortDescriptors];
+        _objectComperator = [NSSortDescriptor ft_comperatorUsingSortDescriptors:self.sortDescriptors];
 
-        _sections = [[NSMutableArray alloc] init];
+        [backingStore sortUsingDescriptors:self.sortDescriptors];
+        [self ft_loadSortedObjects:backingStore];
     }
     return self;
 }
@@ -64,8 +101,13 @@
 
 - (id)member:(id)object
 {
-    NSUInteger index = [_backingStore indexOfObject:object];
-    return index != NSNotFound ? [_backingStore objectAtIndex:index] : nil;
+    NSArray *section = [_sectionsOfObjects objectForKey:object];
+    if (section) {
+        NSUInteger itemIndex = [self ft_indexOfObject:object inSection:section];
+        return itemIndex != NSNotFound ? [section objectAtIndex:itemIndex] : nil;
+    } else {
+        return nil;
+    }
 }
 
 - (NSEnumerator *)objectEnumerator
@@ -78,7 +120,7 @@
 - (void)addObject:(nonnull id)anObject
 {
     [self performBatchUpdate:^{
-        if ([_backingStore containsObject:anObject]) {
+        if ([_sectionsOfObjects objectForKey:anObject] != nil) {
             [_updatedObjects addObject:anObject];
         } else {
             [_insertedObjects addObject:anObject];
@@ -87,6 +129,65 @@
     }];
 }
 
+- (void)addObjectsFromArray:(NSArray *)array
+{
+    if (_batchUpdateCallCount == 0 && [_backingStore count] == 0 && [array count] > 0) {
+
+        // Load the objects into the empty set by sorting them once and
+        // building the clusters in a single pass over the sorted objects.
+
+        _instrumentationSpan = [FTInstrumentationSpan spanWithName:@"FTMutableClusterSet.load"];
+        _observers.instrumentationSpan = _instrumentationSpan;
+        [_instrumentationSpan addCount:[array count] forKey:@"inserted"];
+        [_instrumentationSpan beginPhase:@"sort"];
+
+        FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:self.sortDescriptors];
+        NSArray *sortedObjects = [sortKeyCache sortedArrayFromObjects:array];
+
+        [_instrumentationSpan beginPhase:@"notify"];
+
+        [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+            if (methods & FTDataSourceObserverMethodWillChange) {
+                [observer dataSourceWillChange:self];
+            }
+        }];
+
+        [_instrumentationSpan beginPhase:@"insert"];
+
+        [self ft_loadSortedObjects:sortedObjects];
+
+        [_instrumentationSpan beginPhase:@"notify"];
+
+        // All sections of the previously empty set have been inserted.
+
+        FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+        [changeSet insertSections:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [_sections count])]];
+
+        [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+            if (methods & FTDataSourceObserverMethodDidApplyChangeSet) {
+                [(id<FTDataSourceChangeSetObserver>)observer dataSource:self didApplyChangeSet:changeSet];
+            } else {
+                [changeSet notifyObserver:observer implementingMethods:methods ofChangesInDataSource:self];
+            }
+        }];
+
+        [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+            if (methods & FTDataSourceObserverMethodDidChange) {
+                [observer dataSourceDidChange:self];
+            }
+        }];
+
+        [self ft_finishInstrumentationSpan];
+
+    } else {
+        [self performBatchUpdate:^{
+            for (id object in array) {
+                [self addObject:object];
+            }
+        }];
+    }
+}
+
 - (void)removeObject:(id)object
 {
     [self performBatchUpdate:^{
@@ -132,8 +233,11 @@
         _backingStore = [aDecoder decodeObjectOfClass:[NSMutableArray class] forKey:@"_backingStore"];
         _sortDescriptors = [aDecoder decodeObjectOfClass:[NSArray class] forKey:@"_sortDescriptors"];
         _comperator = [aDecoder decodeObjectOfClass:[FTClusterComperator class] forKey:@"_comperator"];
-        _observers = [[NSHashTable alloc] init];
+        _observers = [[FTObserverRegistry alloc] init];
         _batchUpdateCallCount = 0;
+        _objectComperator = [NSSortDescriptor ft_comperatorUsingSortDescriptors:self.sortDescriptors];
+
+        [self ft_loadSortedObjects:_backingStore];
     }
     return self;
 }
@@ -156,24 +260,6 @@
     }
 }
 
-+ (NSComparator)comperatorUsingSortDescriptors:(NSArray *)sortDescriptors
-{
-    return ^(id firstObject, id secondObject) {
-        for (NSSortDescriptor *sortDescriptor in sortDescriptors) {
-            NSComparisonResult result = [sortDescriptor compareObject:firstObject toObject:secondObject];
-            switch (result) {
-            case NSOrderedAscending:
-                return sortDescriptor.ascending ? NSOrderedAscending : NSOrderedDescending;
-            case NSOrderedDescending:
-                return sortDescriptor.ascending ? NSOrderedDescending : NSOrderedAscending;
-            default:
-                break;
-            }
-        }
-        return NSOrderedSame;
-    };
-}
-
 + (NSSortDescriptor *)defaultSortDescriptor
 {
     return [NSSortDescriptor sortDescriptorWithKey:@"self"
@@ -195,12 +281,8 @@
 {
     if (updates) {
         if (_batchUpdateCallCount == 0) {
-
-            for (id<FTDataSourceObserver> observer in self.observers) {
-                if ([observer respondsToSelector:@selector(dataSourceWillReset:)]) {
-                    [observer dataSourceWillReset:self];
-                }
-            }
+            _instrumentationSpan = [FTInstrumentationSpan spanWithName:@"FTMutableClusterSet.batch"];
+            _observers.instrumentationSpan = _instrumentationSpan;
 
             _insertedObjects = [[NSMutableSet alloc] init];
             _updatedObjects = [[NSMutableSet alloc] init];
@@ -215,203 +297,575 @@
 
         if (_batchUpdateCallCount == 0) {
 
-            [self ft_applyDeletion];
-            [self ft_applyInsertion];
+            // The changes are applied after all updates have been collected. If a
+            // large part of the set has been changed, the observers are notified
+            // with a reset. Otherwise the individual changes of the sections and
+            // items are reported.
 
-            for (id<FTDataSourceObserver> observer in self.observers) {
-                if ([observer respondsToSelector:@selector(dataSourceDidReset:)]) {
-                    [observer dataSourceDidReset:self];
-                }
+            [_instrumentationSpan addCount:[_insertedObjects count] forKey:@"inserted"];
+            [_instrumentationSpan addCount:[_updatedObjects count] forKey:@"updated"];
+            [_instrumentationSpan addCount:[_deletedObjects count] forKey:@"deleted"];
+
+            if ([self ft_shouldResetForChanges]) {
+                [self ft_applyChangesWithReset];
+            } else {
+                [self ft_applyChanges];
             }
 
             _insertedObjects = nil;
             _updatedObjects = nil;
             _deletedObjects = nil;
+
+            [self ft_finishInstrumentationSpan];
         }
     }
 }
 
-#pragma mark Apply Changes
+- (BOOL)ft_shouldResetForChanges
+{
+    // Objects inserted into an empty set are always reported as inserted sections.
 
-- (void)ft_applyDeletion
+    NSUInteger count = [_backingStore count];
+    if (count == 0) {
+        return NO;
+    }
+
+    NSUInteger numberOfChanges = [_insertedObjects count] + [_updatedObjects count] + [_deletedObjects count];
+    NSUInteger largerCount = MAX(count, count + [_insertedObjects count] - MIN(count, [_deletedObjects count]));
+
+    return numberOfChanges >= FTMutableClusterSetMinimumNumberOfChangesForReset &&
+           numberOfChanges > largerCount * FTMutableClusterSetFractionOfChangesForReset;
+}
+
+- (void)ft_applyChangesWithReset
+{
+    [_instrumentationSpan beginPhase:@"notify"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodWillReset) {
+            [observer dataSourceWillReset:self];
+        }
+    }];
+
+    [_instrumentationSpan beginPhase:@"delete"];
+    [self ft_applyDeletion];
+    [_instrumentationSpan beginPhase:@"insert"];
+    [self ft_applyInsertion];
+    [_instrumentationSpan beginPhase:@"notify"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidReset) {
+            [observer dataSourceDidReset:self];
+        }
+    }];
+}
+
+- (void)ft_applyChanges
 {
-    if ([_deletedObjects count] > 0 || [_updatedObjects count] > 0) {
+    [_instrumentationSpan beginPhase:@"notify"];
 
-        NSComparator comperator = [[self class] comperatorUsingSortDescriptors:self.sortDescriptors];
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodWillChange) {
+            [observer dataSourceWillChange:self];
+        }
+    }];
 
-        NSMutableArray *objects = [NSMutableArray array];
-        [objects addObjectsFromArray:[_deletedObjects allObjects]];
-        [objects addObjectsFromArray:[_updatedObjects allObjects]];
-        NSArray *sortedObjects = [objects sortedArrayUsingDescriptors:self.sortDescriptors];
+    NSArray *originalSections = nil;
+    if (_observers.implementedMethods != 0) {
+        originalSections = [_sections copy];
+        _sectionSnapshots = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                  valueOptions:NSPointerFunctionsStrongMemory];
+    }
 
-        NSUInteger offset = 0;
+    [_instrumentationSpan beginPhase:@"delete"];
+    [self ft_applyDeletion];
+    [_instrumentationSpan beginPhase:@"insert"];
+    [self ft_applyInsertion];
+    [_instrumentationSpan beginPhase:@"notify"];
 
-        for (id object in sortedObjects) {
+    if (originalSections) {
+        FTChangeSet *changeSet = [self ft_changeSetWithOriginalSections:originalSections];
+        _sectionSnapshots = nil;
 
-            NSUInteger index = [_backingStore indexOfObject:object
-                                              inSortedRange:NSMakeRange(offset, [_backingStore count] - offset)
-                                                    options:NSBinarySearchingInsertionIndex
-                                            usingComparator:comperator];
-
-            [_backingStore insertObject:object atIndex:index];
-
-            NSUInteger sectionIndex = [_sections indexOfObject:object
-                                                 inSortedRange:NSMakeRange(0, [_sections count])
-                                                       options:NSBinarySearchingFirstEqual
-                                               usingComparator:^NSComparisonResult(NSMutableArray *section, id object) {
-
-                                                   NSUInteger itemIndex = [section indexOfObject:object
-                                                                                   inSortedRange:NSMakeRange(0, [section count])
-                                                                                         options:NSBinarySearchingInsertionIndex
-                                                                                 usingComparator:comperator];
-
-                                                   if (itemIndex == 0) {
-                                                       if ([_comperator compareObject:object toObject:[section firstObject]]) {
-                                                           return NSOrderedSame;
-                                                       } else {
-                                                           return NSOrderedDescending;
-                                                       }
-                                                   } else if (itemIndex == [section count]) {
-                                                       if ([_comperator compareObject:[section lastObject] toObject:object]) {
-                                                           return NSOrderedSame;
-                                                       } else {
-                                                           return NSOrderedAscending;
-                                                       }
-                                                   } else {
-                                                       return NSOrderedSame;
-                                                   }
-                                               }];
-
-            if (sectionIndex != NSNotFound) {
-                NSMutableArray *section = [_sections objectAtIndex:sectionIndex];
-
-                NSUInteger itemIndex = [section indexOfObject:object
-                                                inSortedRange:NSMakeRange(0, [section count])
-                                                      options:NSBinarySearchingInsertionIndex
-                                              usingComparator:comperator];
-
-                if (itemIndex != NSNotFound) {
-
-                    if ([section count] == 1) {
-                        [_sections removeObject:section];
-                    } else {
-                        [section removeObject:object];
-
-                        if (itemIndex < [section count] && itemIndex > 0) {
-                            id previousObject = [section objectAtIndex:itemIndex - 1];
-                            id nextObject = [section objectAtIndex:itemIndex];
-
-                            if (![_comperator compareObject:previousObject toObject:nextObject]) {
-
-                                // Section needs to be split into two sections
-
-                                NSMutableArray *newSection = [[section subarrayWithRange:NSMakeRange(itemIndex, [section count] - itemIndex)] mutableCopy];
-                                [section removeObjectsInRange:NSMakeRange(itemIndex, [section count] - itemIndex)];
-                                [_sections insertObject:newSection atIndex:sectionIndex + 1];
-                            }
-                        }
-                    }
-                }
+        [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+            if (methods & FTDataSourceObserverMethodDidApplyChangeSet) {
+                [(id<FTDataSourceChangeSetObserver>)observer dataSource:self didApplyChangeSet:changeSet];
+            } else {
+                [changeSet notifyObserver:observer implementingMethods:methods ofChangesInDataSource:self];
             }
+        }];
+    }
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidChange) {
+            [observer dataSourceDidChange:self];
         }
+    }];
+}
+
+#pragma mark Instrumentation
+
+- (void)ft_finishInstrumentationSpan
+{
+    if (_instrumentationSpan) {
+        FTInstrumentationSpan *span = _instrumentationSpan;
+        _instrumentationSpan = nil;
+        _observers.instrumentationSpan = nil;
+
+        [span addCount:[_backingStore count] forKey:@"items"];
+        [span addCount:[_sections count] forKey:@"sections"];
+        [span finish];
     }
 }
 
+#pragma mark Apply Changes
+
+- (void)ft_loadSortedObjects:(NSArray *)objects
+{
+    // Replaces the content of the set with the sorted objects. Each object is
+    // only compared with its predecessor to decide, whether it starts a new cluster.
+
+    _backingStore = [[NSMutableArray alloc] initWithCapacity:[objects count]];
+    _sections = [[NSMutableArray alloc] init];
+    _sectionsOfObjects = [NSMapTable strongToStrongObjectsMapTable];
+    _indexesOfSections = nil;
+
+    NSMutableArray *section = nil;
+    for (id object in objects) {
+        if ([_sectionsOfObjects objectForKey:object] != nil) {
+            continue;
+        }
+
+        if (section == nil || ![_comperator compareObject:[section lastObject] toObject:object]) {
+            section = [[NSMutableArray alloc] init];
+            [_sections addObject:section];
+        }
+
+        [section addObject:object];
+        [_backingStore addObject:object];
+        [_sectionsOfObjects setObject:section forKey:object];
+    }
+
+    NSUInteger numberOfSections = [_sections count];
+    NSMutableData *numbersOfItems = [[NSMutableData alloc] initWithLength:numberOfSections * sizeof(NSUInteger)];
+    NSUInteger *values = [numbersOfItems mutableBytes];
+    for (NSUInteger sectionIndex = 0; sectionIndex < numberOfSections; sectionIndex++) {
+        values[sectionIndex] = [[_sections objectAtIndex:sectionIndex] count];
+    }
+    _numbersOfItems = [[FTPrefixSums alloc] initWithValues:values count:numberOfSections];
+}
+
+- (void)ft_applyDeletion
+{
+    // Updated objects are removed and inserted again. Their sort keys may have
+    // changed, which is why they are looked up in their section, without
+    // relying on the order of the objects.
+    //
+    // The positions of all objects are looked up before the first removal,
+    // such that the indexes of the sections are only built once per batch.
+    // Removing the objects in descending order of their positions does not
+    // change the positions of the objects, which are removed afterwards.
+
+    NSMutableIndexSet *positions = [NSMutableIndexSet indexSet];
+
+    for (id object in _updatedObjects) {
+        NSUInteger position = [self ft_positionOfObject:object];
+        if (position != NSNotFound) {
+            [positions addIndex:position];
+        }
+    }
+
+    for (id object in _deletedObjects) {
+        NSUInteger position = [self ft_positionOfObject:object];
+        if (position != NSNotFound) {
+            [positions addIndex:position];
+        }
+    }
+
+    [positions enumerateIndexesWithOptions:NSEnumerationReverse
+                                usingBlock:^(NSUInteger position, BOOL *stop) {
+                                    [self ft_removeObjectAtPosition:position];
+                                }];
+}
+
 - (void)ft_applyInsertion
 {
     if ([_insertedObjects count] > 0 || [_updatedObjects count] > 0) {
 
-        NSComparator comperator = [[self class] comperatorUsingSortDescriptors:self.sortDescriptors];
+        FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:self.sortDescriptors];
+        NSComparator comperator = [sortKeyCache comperator];
+        if (_instrumentationSpan) {
+            comperator = [_instrumentationSpan countingComparator:comperator];
+        }
 
         NSMutableArray *objects = [NSMutableArray array];
         [objects addObjectsFromArray:[_insertedObjects allObjects]];
         [objects addObjectsFromArray:[_updatedObjects allObjects]];
-        NSArray *sortedObjects = [objects sortedArrayUsingDescriptors:self.sortDescriptors];
+        NSArray *sortedObjects = [sortKeyCache sortedArrayFromObjects:objects];
+
+        // The objects are inserted in ascending order. Each object can
+        // therefore only be inserted after the previously inserted object.
 
         NSUInteger offset = 0;
 
         for (id object in sortedObjects) {
 
-            NSUInteger index = [_backingStore indexOfObject:object
-                                              inSortedRange:NSMakeRange(offset, [_backingStore count] - offset)
-                                                    options:NSBinarySearchingInsertionIndex
-                                            usingComparator:comperator];
-
-            [_backingStore insertObject:object atIndex:index];
-
-            NSUInteger sectionIndex = [_sections indexOfObject:object
-                                                 inSortedRange:NSMakeRange(0, [_sections count])
-                                                       options:NSBinarySearchingFirstEqual
-                                               usingComparator:^NSComparisonResult(NSMutableArray *section, id object) {
-
-                                                   NSUInteger itemIndex = [section indexOfObject:object
-                                                                                   inSortedRange:NSMakeRange(0, [section count])
-                                                                                         options:NSBinarySearchingInsertionIndex
-                                                                                 usingComparator:comperator];
-
-                                                   if (itemIndex == 0) {
-                                                       if ([_comperator compareObject:object toObject:[section firstObject]]) {
-                                                           return NSOrderedSame;
-                                                       } else {
-                                                           return NSOrderedDescending;
-                                                       }
-                                                   } else if (itemIndex == [section count]) {
-                                                       if ([_comperator compareObject:[section lastObject] toObject:object]) {
-                                                           return NSOrderedSame;
-                                                       } else {
-                                                           return NSOrderedAscending;
-                                                       }
-                                                   } else {
-                                                       return NSOrderedSame;
-                                                   }
-                                               }];
-
-            if (sectionIndex == NSNotFound) {
-
-                // Create new section
-
-                NSMutableArray *newSection = [[NSMutableArray alloc] init];
-                [newSection addObject:object];
-
-                sectionIndex = [_sections indexOfObject:newSection
-                                          inSortedRange:NSMakeRange(0, [_sections count])
-                                                options:NSBinarySearchingInsertionIndex
-                                        usingComparator:^NSComparisonResult(NSArray *section1, NSArray *section2) {
-                                            return comperator([section1 firstObject], [section2 firstObject]);
-                                        }];
+            NSUInteger position = [_backingStore indexOfObject:object
+                                                 inSortedRange:NSMakeRange(offset, [_backingStore count] - offset)
+                                                       options:NSBinarySearchingInsertionIndex | NSBinarySearchingLastEqual
+                                               usingComparator:comperator];
 
-                [_sections insertObject:newSection atIndex:sectionIndex];
+            [self ft_insertObject:object atPosition:position];
 
-            } else {
+            offset = position + 1;
+        }
+    }
+}
+
+// Objects belong to the same cluster as their predecessor in the sorted
+// backing store, if the cluster comperator returns YES for both objects.
+// The following methods keep the sections in sync with the backing store
+// and split or merge the clusters affected by an insertion or removal.
+
+- (void)ft_insertObject:(id)object atPosition:(NSUInteger)position
+{
+    id previousObject = position > 0 ? [_backingStore objectAtIndex:position - 1] : nil;
+    id nextObject = position < [_backingStore count] ? [_backingStore objectAtIndex:position] : nil;
+
+    BOOL joinsPreviousObject = previousObject != nil && [_comperator compareObject:previousObject toObject:object];
+    BOOL joinsNextObject = nextObject != nil && [_comperator compareObject:object toObject:nextObject];
+
+    NSUInteger sectionIndex = 0;
+    NSUInteger itemIndex = 0;
+    [self ft_getSection:&sectionIndex item:&itemIndex ofPosition:position];
+
+    [_backingStore insertObject:object atIndex:position];
+
+    if (nextObject != nil && itemIndex > 0) {
+
+        // Insert into an existing cluster
+
+        NSMutableArray *section = [_sections objectAtIndex:sectionIndex];
+        [self ft_willChangeSection:section];
+        [section insertObject:object atIndex:itemIndex];
+        [self ft_didAddObject:object toSectionAtIndex:sectionIndex];
+
+        if (!joinsNextObject) {
+            [self ft_splitSectionAtIndex:sectionIndex item:itemIndex + 1];
+        }
+
+        if (!joinsPreviousObject) {
+            [self ft_splitSectionAtIndex:sectionIndex item:itemIndex];
+        }
+
+    } else if (joinsPreviousObject) {
+
+        // Append to the previous cluster and merge it with the next cluster
+
+        NSMutableArray *previousSection = [_sections objectAtIndex:sectionIndex - 1];
+        [self ft_willChangeSection:previousSection];
+        [previousSection addObject:object];
+        [self ft_didAddObject:object toSectionAtIndex:sectionIndex - 1];
+
+        if (joinsNextObject) {
+            [self ft_mergeSectionAtIndex:sectionIndex - 1];
+        }
+
+    } else if (joinsNextObject) {
+
+        // Prepend to the next cluster
+
+        NSMutableArray *section = [_sections objectAtIndex:sectionIndex];
+        [self ft_willChangeSection:section];
+        [section insertObject:object atIndex:0];
+        [self ft_didAddObject:object toSectionAtIndex:sectionIndex];
+
+    } else {
+
+        // Create new cluster
+
+        NSMutableArray *newSection = [[NSMutableArray alloc] initWithObjects:object, nil];
+        [self ft_insertSection:newSection atIndex:sectionIndex];
+    }
+}
+
+- (void)ft_removeObjectAtPosition:(NSUInteger)position
+{
+    NSUInteger sectionIndex = 0;
+    NSUInteger itemIndex = 0;
+    [self ft_getSection:&sectionIndex item:&itemIndex ofPosition:position];
+
+    NSMutableArray *section = [_sections objectAtIndex:sectionIndex];
+    id object = [section objectAtIndex:itemIndex];
+
+    [_backingStore removeObjectAtIndex:position];
+
+    [self ft_willChangeSection:section];
+    [section removeObjectAtIndex:itemIndex];
+    [_sectionsOfObjects removeObjectForKey:object];
+    [_numbersOfItems addValue:-1 toValueAtIndex:sectionIndex];
+
+    if ([section count] == 0) {
+
+        // Remove the cluster, the previous and the next cluster are now adjacent
+
+        [self ft_removeSectionAtIndex:sectionIndex];
+        if (sectionIndex > 0) {
+            [self ft_mergeSectionAtIndex:sectionIndex - 1];
+        }
+
+    } else if (itemIndex == 0) {
+        if (sectionIndex > 0) {
+            [self ft_mergeSectionAtIndex:sectionIndex - 1];
+        }
+    } else if (itemIndex == [section count]) {
+        [self ft_mergeSectionAtIndex:sectionIndex];
+    } else if (![_comperator compareObject:[section objectAtIndex:itemIndex - 1] toObject:[section objectAtIndex:itemIndex]]) {
+        [self ft_splitSectionAtIndex:sectionIndex item:itemIndex];
+    }
+}
+
+- (void)ft_splitSectionAtIndex:(NSUInteger)sectionIndex item:(NSUInteger)itemIndex
+{
+    NSMutableArray *section = [_sections objectAtIndex:sectionIndex];
+    [self ft_willChangeSection:section];
+
+    NSRange range = NSMakeRange(itemIndex, [section count] - itemIndex);
+    NSMutableArray *newSection = [[section subarrayWithRange:range] mutableCopy];
+    [section removeObjectsInRange:range];
+    [_numbersOfItems addValue:-(NSInteger)range.length toValueAtIndex:sectionIndex];
+    [self ft_insertSection:newSection atIndex:sectionIndex + 1];
+}
+
+- (void)ft_mergeSectionAtIndex:(NSUInteger)sectionIndex
+{
+    if (sectionIndex + 1 < [_sections count]) {
+        NSMutableArray *section = [_sections objectAtIndex:sectionIndex];
+        NSMutableArray *nextSection = [_sections objectAtIndex:sectionIndex + 1];
+
+        if ([_comperator compareObject:[section lastObject] toObject:[nextSection firstObject]]) {
+            [self ft_willChangeSection:section];
+            [section addObjectsFromArray:nextSection];
+            [_numbersOfItems addValue:[nextSection count] toValueAtIndex:sectionIndex];
+            for (id object in nextSection) {
+                [_sectionsOfObjects setObject:section forKey:object];
+            }
+            [self ft_removeSectionAtIndex:sectionIndex + 1];
+        }
+    }
+}
+
+- (void)ft_insertSection:(NSMutableArray *)section atIndex:(NSUInteger)sectionIndex
+{
+    [_sections insertObject:section atIndex:sectionIndex];
+    [_numbersOfItems insertValue:[section count] atIndex:sectionIndex];
+    for (id object in section) {
+        [_sectionsOfObjects setObject:section forKey:object];
+    }
+    _indexesOfSections = nil;
+}
+
+- (void)ft_removeSectionAtIndex:(NSUInteger)sectionIndex
+{
+    [_sections removeObjectAtIndex:sectionIndex];
+    [_numbersOfItems removeValueAtIndex:sectionIndex];
+    _indexesOfSections = nil;
+}
+
+- (void)ft_didAddObject:(id)object toSectionAtIndex:(NSUInteger)sectionIndex
+{
+    [_sectionsOfObjects setObject:[_sections objectAtIndex:sectionIndex] forKey:object];
+    [_numbersOfItems addValue:1 toValueAtIndex:sectionIndex];
+}
 
-                // Use exsiting section
+- (void)ft_getSection:(NSUInteger *)sectionIndex item:(NSUInteger *)itemIndex ofPosition:(NSUInteger)position
+{
+    // A position behind the last object results in a section index
+    // equal to the number of sections and an item index of 0.
+
+    *sectionIndex = [_numbersOfItems indexOfPosition:position offset:itemIndex];
+}
+
+- (NSUInteger)ft_positionOfObject:(id)object
+{
+    NSArray *section = [_sectionsOfObjects objectForKey:object];
+    if (section == nil) {
+        return NSNotFound;
+    }
+
+    NSUInteger sectionIndex = [self ft_indexOfSection:section];
+    NSUInteger itemIndex = [self ft_indexOfObject:object inSection:section];
+    if (sectionIndex == NSNotFound || itemIndex == NSNotFound) {
+        return NSNotFound;
+    }
+
+    return [_numbersOfItems sumOfValuesBeforeIndex:sectionIndex] + itemIndex;
+}
+
+- (NSUInteger)ft_indexOfSection:(NSArray *)section
+{
+    if (_indexesOfSections == nil) {
+        _indexesOfSections = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                   valueOptions:NSPointerFunctionsStrongMemory];
+        [_sections enumerateObjectsUsingBlock:^(NSArray *section, NSUInteger sectionIndex, BOOL *stop) {
+            [_indexesOfSections setObject:@(sectionIndex) forKey:section];
+        }];
+    }
+
+    NSNumber *sectionIndex = [_indexesOfSections objectForKey:section];
+    return sectionIndex ? [sectionIndex unsignedIntegerValue] : NSNotFound;
+}
 
-                NSMutableArray *section = [_sections objectAtIndex:sectionIndex];
+- (NSUInteger)ft_indexOfObject:(id)object inSection:(NSArray *)section
+{
+    NSComparator comperator = _objectComperator;
+    if (_instrumentationSpan) {
+        comperator = [_instrumentationSpan countingComparator:comperator];
+    }
 
-                NSUInteger itemIndex = [section indexOfObject:object
-                                                inSortedRange:NSMakeRange(0, [section count])
-                                                      options:NSBinarySearchingInsertionIndex
-                                              usingComparator:comperator];
+    NSUInteger count = [section count];
+    NSUInteger itemIndex = [section indexOfObject:object
+                                    inSortedRange:NSMakeRange(0, count)
+                                          options:NSBinarySearchingFirstEqual
+                                  usingComparator:comperator];
+    if (itemIndex != NSNotFound) {
+        for (; itemIndex < count; itemIndex++) {
+            id candidate = [section objectAtIndex:itemIndex];
+            if ([candidate isEqual:object]) {
+                return itemIndex;
+            } else if (comperator(candidate, object) != NSOrderedSame) {
+                break;
+            }
+        }
+    }
 
-                [section insertObject:object atIndex:itemIndex];
+    // The sort key of an updated object may have changed
+    itemIndex = [section indexOfObject:object];
+    [_instrumentationSpan addCount:itemIndex == NSNotFound ? count : itemIndex + 1 forKey:@"scanned"];
+    return itemIndex;
+}
 
-                if (itemIndex == [section count] - 1 && sectionIndex < [_sections count] - 1) {
+#pragma mark Change Set
 
-                    NSMutableArray *nextSection = [_sections objectAtIndex:sectionIndex + 1];
+- (void)ft_willChangeSection:(NSMutableArray *)section
+{
+    if (_sectionSnapshots && [_sectionSnapshots objectForKey:section] == nil) {
+        [_sectionSnapshots setObject:[section copy] forKey:section];
+    }
+}
+
+- (FTChangeSet *)ft_changeSetWithOriginalSections:(NSArray *)originalSections
+{
+    // Sections are identified by their arrays. Splitting a cluster moves the tail
+    // into a new array and merging two clusters keeps the array of the first
+    // cluster. Therefore the order of the remaining sections does not change and
+    // only the items of the changed sections have to be compared.
+
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+
+    NSMapTable *sectionIndexes = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                       valueOptions:NSPointerFunctionsStrongMemory];
+    [_sections enumerateObjectsUsingBlock:^(NSArray *section, NSUInteger sectionIndex, BOOL *stop) {
+        [sectionIndexes setObject:@(sectionIndex) forKey:section];
+    }];
 
-                    if ([_comperator compareObject:[section lastObject] toObject:[nextSection firstObject]]) {
+    NSMutableIndexSet *insertedSections = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [_sections count])];
+    NSMutableIndexSet *deletedSections = [[NSMutableIndexSet alloc] init];
 
-                        // Merge with next cluster
+    NSMapTable *originalIndexPaths = [NSMapTable strongToStrongObjectsMapTable];
+    NSMapTable *indexPaths = [NSMapTable strongToStrongObjectsMapTable];
 
-                        [section addObjectsFromArray:nextSection];
-                        [_sections removeObject:nextSection];
-                    }
+    NSMapTable *originalSnapshots = [NSMapTable strongToStrongObjectsMapTable];
+
+    [originalSections enumerateObjectsUsingBlock:^(NSArray *section, NSUInteger originalSectionIndex, BOOL *stop) {
+        NSNumber *sectionIndex = [sectionIndexes objectForKey:section];
+        if (sectionIndex == nil) {
+            [deletedSections addIndex:originalSectionIndex];
+        } else {
+            [insertedSections removeIndex:[sectionIndex unsignedIntegerValue]];
+
+            NSArray *snapshot = [_sectionSnapshots objectForKey:section];
+            if (snapshot) {
+                [originalSnapshots setObject:snapshot forKey:@(originalSectionIndex)];
+                [snapshot enumerateObjectsUsingBlock:^(id object, NSUInteger itemIndex, BOOL *stop) {
+                    NSUInteger indexes[] = {originalSectionIndex, itemIndex};
+                    [originalIndexPaths setObject:[NSIndexPath indexPathWithIndexes:indexes length:2] forKey:object];
+                }];
+                [section enumerateObjectsUsingBlock:^(id object, NSUInteger itemIndex, BOOL *stop) {
+                    NSUInteger indexes[] = {[sectionIndex unsignedIntegerValue], itemIndex};
+                    [indexPaths setObject:[NSIndexPath indexPathWithIndexes:indexes length:2] forKey:object];
+                }];
+            }
+        }
+    }];
+
+    [changeSet deleteSections:deletedSections];
+    [changeSet insertSections:insertedSections];
+
+    // Items, which are moved from or to a deleted or inserted section, are reported
+    // as deleted or inserted items. Updated items are reported as changed, if they
+    // are still behind the same unchanged item, otherwise they are reported as moved.
+
+    NSMutableArray *deletedItems = [[NSMutableArray alloc] init];
+    NSMutableArray *insertedItems = [[NSMutableArray alloc] init];
+    NSMutableArray *changedItems = [[NSMutableArray alloc] init];
+
+    for (id object in originalIndexPaths) {
+        NSIndexPath *originalIndexPath = [originalIndexPaths objectForKey:object];
+        NSIndexPath *indexPath = [indexPaths objectForKey:object];
+
+        if (indexPath == nil) {
+            [deletedItems addObject:originalIndexPath];
+        } else {
+            NSUInteger originalSectionIndex = [originalIndexPath indexAtPosition:0];
+            NSUInteger sectionIndex = [[sectionIndexes objectForKey:[originalSections objectAtIndex:originalSectionIndex]] unsignedIntegerValue];
+
+            BOOL inPlace = sectionIndex == [indexPath indexAtPosition:0];
+            if (inPlace && [_updatedObjects containsObject:object]) {
+                NSArray *snapshot = [originalSnapshots objectForKey:@(originalSectionIndex)];
+                NSArray *section = [_sections objectAtIndex:sectionIndex];
+
+                id originalPreviousObject = [self ft_objectBeforeItem:[originalIndexPath indexAtPosition:1] inObjects:snapshot skippingObjects:_deletedObjects];
+                id previousObject = [self ft_objectBeforeItem:[indexPath indexAtPosition:1] inObjects:section skippingObjects:_insertedObjects];
+                inPlace = originalPreviousObject == previousObject;
+
+                if (inPlace) {
+                    [changedItems addObject:originalIndexPath];
                 }
             }
+
+            if (!inPlace) {
+                [changeSet moveItemAtIndexPath:originalIndexPath toIndexPath:indexPath];
+            }
+        }
+    }
+
+    for (id object in indexPaths) {
+        if ([originalIndexPaths objectForKey:object] == nil) {
+            [insertedItems addObject:[indexPaths objectForKey:object]];
         }
+    }
+
+    [changeSet deleteItemsAtIndexPaths:deletedItems];
+    [changeSet insertItemsAtIndexPaths:insertedItems];
+    [changeSet changeItemsAtIndexPaths:changedItems];
+
+    return [changeSet copy];
+}
+
+- (id)ft_objectBeforeItem:(NSUInteger)itemIndex inObjects:(NSArray *)objects skippingObjects:(NSSet *)skippedObjects
+{
+    // Returns the closest object in front of the item, which has
+    // neither been updated nor been skipped.
 
-        [_insertedObjects removeAllObjects];
+    while (itemIndex > 0) {
+        itemIndex--;
+        id object = [objects objectAtIndex:itemIndex];
+        if (![_updatedObjects containsObject:object] && ![skippedObjects containsObject:object]) {
+            return object;
+        }
     }
+    return nil;
 }
 
 #pragma mark FTDataSource
@@ -463,17 +917,17 @@
 
 - (NSArray *)observers
 {
-    return [_observers allObjects];
+    return [_observers observers];
 }
 
 - (void)addObserver:(id<FTDataSourceObserver>)observer
 {
-    [_observers addObject:observer];
+    [_observers addObserver:observer];
 }
 
 - (void)removeObserver:(id<FTDataSourceObserver>)observer
 {
-    [_observers removeObject:observer];
+    [_observers removeObserver:observer];
 }
 
 #pragma mark FTReverseDataSource
@@ -491,48 +945,15 @@
 {
     NSParameterAssert(object);
 
-    if ([_backingStore containsObject:object]) {
-
-        NSComparator comperator = [[self class] comperatorUsingSortDescriptors:self.sortDescriptors];
-
-        NSUInteger sectionIndex = [_sections indexOfObject:object
-                                             inSortedRange:NSMakeRange(0, [_sections count])
-                                                   options:NSBinarySearchingFirstEqual
-                                           usingComparator:^NSComparisonResult(NSMutableArray *section, id object) {
-
-                                               NSUInteger itemIndex = [section indexOfObject:object
-                                                                               inSortedRange:NSMakeRange(0, [section count])
-                                                                                     options:NSBinarySearchingInsertionIndex
-                                                                             usingComparator:comperator];
-
-                                               if (itemIndex == 0) {
-                                                   if ([_comperator compareObject:object toObject:[section firstObject]]) {
-                                                       return NSOrderedSame;
-                                                   } else {
-                                                       return NSOrderedDescending;
-                                                   }
-                                               } else if (itemIndex == [section count]) {
-                                                   if ([_comperator compareObject:[section lastObject] toObject:object]) {
-                                                       return NSOrderedSame;
-                                                   } else {
-                                                       return NSOrderedAscending;
-                                                   }
-                                               } else {
-                                                   return NSOrderedSame;
-                                               }
-                                           }];
-
-        if (sectionIndex != NSNotFound) {
-
-            NSMutableArray *section = [_sections objectAtIndex:sectionIndex];
-            NSUInteger itemIndex = [section indexOfObject:object];
-
-            if (itemIndex != NSNotFound) {
-
-                NSUInteger indexes[] = {sectionIndex, itemIndex};
-                NSIndexPath *indexPath = [NSIndexPath indexPathWithIndexes:indexes length:2];
-                return @[ indexPath ];
-            }
+    NSArray *section = [_sectionsOfObjects objectForKey:object];
+    if (section) {
+        NSUInteger sectionIndex = [self ft_indexOfSection:section];
+        NSUInteger itemIndex = [self ft_indexOfObject:object inSection:section];
+
+        if (sectionIndex != NSNotFound && itemIndex != NSNotFound) {
+            NSUInteger indexes[] = {sectionIndex, itemIndex};
+            NSIndexPath *indexPath = [NSIndexPath indexPathWithIndexes:indexes length:2];
+            return @[ indexPath ];
         }
     }
 
@@ -6,7 +6,10 @@
 //  Copyright © 2015 Tobias Kräntzer. All rights reserved.
 //
 
+#if __APPLE__
 #import <Availability.h>
+#endif
+
 #import "FTDataSource.h"
 
 #if TARGET_OS_IOS
@@ -11,6 +11,23 @@
 #import "FTDataSource.h"
 #import "FTReverseDataSource.h"
 
+/*! The storage engine used by <code>FTMutableSet</code> to keep the sorted items.
+ 
+    <code>FTMutableSetStorageArray</code> keeps the items in an array. Accessing an item is
+    done in constant time, but inserting or removing an item needs to move all following items.
+    Removing items scans the array once per batch update up to the position of the last removed
+    item, and looking up the index of an item scans the array up to its position. Removing items
+    in many separate batches is therefore quadratic. Use <code>FTMutableSetStorageTree</code> for
+    large sets with frequent removals or reverse lookups.
+ 
+    <code>FTMutableSetStorageTree</code> keeps the items in an order statistic tree. Accessing,
+    inserting and removing an item as well as looking up the index of an item is done in O(log n).
+ */
+typedef NS_ENUM(NSUInteger, FTMutableSetStorage) {
+    FTMutableSetStorageArray,
+    FTMutableSetStorageTree
+};
+
 /*! <code>FTMutableSet</code> is a subclass of <code>NSMutableSet</code> that conforms
     to the <code>FTDataSource</code> and the <code>FTReverseDataSource</code> protocols.
  
@@ -26,6 +43,15 @@
 - (instancetype)initSortDescriptors:(NSArray *)sortDescriptors NS_SWIFT_UNAVAILABLE("deprecated")DEPRECATED_ATTRIBUTE;
 - (instancetype)initWithSortDescriptors:(NSArray *)sortDescriptors;
 - (instancetype)initWithSortDescriptors:(NSArray *)sortDescriptors includeEmptySections:(BOOL)includeEmptySections;
+- (instancetype)initWithSortDescriptors:(NSArray *)sortDescriptors includeEmptySections:(BOOL)includeEmptySections storage:(FTMutableSetStorage)storage;
+
+/*! Initializes the set with objects, which are already sorted by the sort descriptors and
+    do not contain duplicates (e.g., the result of a fetch request with the same sort descriptors).
+    The objects are adopted in O(n) without sorting them again. Their order is only verified,
+    if assertions are enabled.
+ */
+- (instancetype)initWithSortedObjects:(NSArray *)objects sortDescriptors:(NSArray *)sortDescriptors;
+- (instancetype)initWithSortedObjects:(NSArray *)objects sortDescriptors:(NSArray *)sortDescriptors includeEmptySections:(BOOL)includeEmptySections storage:(FTMutableSetStorage)storage;
 
 #pragma mark Sort Descriptors
 @property (nonatomic, readonly) NSArray *sortDescriptors;
@@ -33,6 +59,9 @@
 #pragma mark Include Empty Sections
 @property (nonatomic, readonly) BOOL includeEmptySections;
 
+#pragma mark Storage
+@property (nonatomic, readonly) FTMutableSetStorage storage;
+
 #pragma mark Batch Updates
 
 /** Combines multiple insert, delete, and replace operations to one change.
@@ -6,7 +6,12 @@
 //  Copyright © 2015 Tobias Kräntzer. All rights reserved.
 //
 
+#import "FTChangeSet.h"
 #import "FTDataSourceObserver.h"
+#import "FTInstrumentation.h"
+#import "FTObserverRegistry.h"
+#import "FTOrderStatisticTree.h"
+#import "FTSortKeyCache.h"
 #import "NSArray+Fountain.h"
 #import "NSSortDescriptor+Fountain.h"
 
@@ -14,10 +19,11 @@
 
 @implementation FTMutableSet {
 
-    NSHashTable *_observers;
+    FTObserverRegistry *_observers;
     NSUInteger _batchUpdateCallCount;
 
     NSMutableArray *_backingStore;
+    NSMutableSet *_members;
     NSArray *_sortDescriptors;
 
     NSMutableSet *_insertedObjects;
@@ -25,6 +31,16 @@
     NSMutableSet *_deletedObjects;
 
     BOOL _includeEmptySections;
+    FTMutableSetStorage _storage;
+
+    FTMutableChangeSet *_changeSet;
+    NSMutableIndexSet *_movedIndexes;
+    NSMutableIndexSet *_reinsertedIndexes;
+    NSMutableDictionary *_newIndexesOfMovedObjects;
+    NSIndexSet *_deletedIndexes;
+    NSMutableIndexSet *_insertedIndexes;
+
+    FTInstrumentationSpan *_instrumentationSpan;
 }
 
 #pragma mark Life-cycle
@@ -37,9 +53,11 @@
 - (instancetype)initWithObjects:(const id __unsafe_unretained *)objects count:(NSUInteger)cnt
 {
     NSMutableArray *backingStore = [[NSMutableArray alloc] init];
+    NSMutableSet *members = [[NSMutableSet alloc] initWithCapacity:cnt];
     for (NSUInteger i = 0; i < cnt; i++) {
         id obj = objects[i];
-        if (![backingStore containsObject:obj]) {
+        if (![members containsObject:obj]) {
+            [members addObject:obj];
             [backingStore addObject:obj];
         }
     }
@@ -67,23 +85,87 @@
                  includeEmptySections:includeEmptySections];
 }
 
+- (instancetype)initWithSortDescriptors:(NSArray *)sortDescriptors includeEmptySections:(BOOL)includeEmptySections storage:(FTMutableSetStorage)storage
+{
+    return [self initWithBackingStore:[[self class] ft_backingStoreWithStorage:storage]
+                      sortDescriptors:sortDescriptors
+                 includeEmptySections:includeEmptySections];
+}
+
+- (instancetype)initWithSortedObjects:(NSArray *)objects sortDescriptors:(NSArray *)sortDescriptors
+{
+    return [self initWithSortedObjects:objects
+                       sortDescriptors:sortDescriptors
+                  includeEmptySections:YES
+                               storage:FTMutableSetStorageArray];
+}
+
+- (instancetype)initWithSortedObjects:(NSArray *)objects sortDescriptors:(NSArray *)sortDescriptors includeEmptySections:(BOOL)includeEmptySections storage:(FTMutableSetStorage)storage
+{
+    NSMutableArray *backingStore = nil;
+    switch (storage) {
+    case FTMutableSetStorageTree:
+        backingStore = [[FTOrderStatisticTree alloc] initWithArray:objects];
+        break;
+    case FTMutableSetStorageArray:
+    default:
+        backingStore = [objects mutableCopy];
+        break;
+    }
+
+    self = [self initWithSortedBackingStore:backingStore
+                            sortDescriptors:sortDescriptors
+                       includeEmptySections:includeEmptySections];
+    if (self) {
+        // The objects are adopted as they are. Their order and uniqueness
+        // is only verified, if assertions are enabled.
+        NSAssert([_members count] == [_backingStore count], @"Objects of a set must be unique.");
+        NSAssert([_backingStore ft_isSortedUsingComparator:[NSSortDescriptor ft_comperatorUsingSortDescriptors:self.sortDescriptors]], @"Objects must be sorted by the sort descriptors.");
+    }
+    return self;
+}
+
 - (nonnull instancetype)initWithBackingStore:(NSMutableArray *)backingStore
                              sortDescriptors:(NSArray *)sortDescriptors
                         includeEmptySections:(BOOL)includeEmptySections
+{
+    self = [self initWithSortedBackingStore:backingStore
+                            sortDescriptors:sortDescriptors
+                       includeEmptySections:includeEmptySections];
+    if (self) {
+        [_backingStore sortUsingDescriptors:self.sortDescriptors];
+    }
+    return self;
+}
+
+- (nonnull instancetype)initWithSortedBackingStore:(NSMutableArray *)backingStore
+                                   sortDescriptors:(NSArray *)sortDescriptors
+                              includeEmptySections:(BOOL)includeEmptySections
 {
     self = [super init];
     if (self) {
         _backingStore = backingStore;
-        _observers = [[NSHashTable alloc] init];
+        _members = [[NSMutableSet alloc] initWithArray:backingStore];
+        _observers = [[FTObserverRegistry alloc] init];
         _batchUpdateCallCount = 0;
         _sortDescriptors = [sortDescriptors count] > 0 ? [sortDescriptors copy] : nil;
         _includeEmptySections = includeEmptySections;
-
-        [_backingStore sortUsingDescriptors:self.sortDescriptors];
+        _storage = [backingStore isKindOfClass:[FTOrderStatisticTree class]] ? FTMutableSetStorageTree : FTMutableSetStorageArray;
     }
     return self;
 }
 
++ (NSMutableArray *)ft_backingStoreWithStorage:(FTMutableSetStorage)storage
+{
+    switch (storage) {
+    case FTMutableSetStorageTree:
+        return [[FTOrderStatisticTree alloc] init];
+    case FTMutableSetStorageArray:
+    default:
+        return [[NSMutableArray alloc] init];
+    }
+}
+
 #pragma mark NSSet
 
 - (NSUInteger)count
@@ -93,8 +175,7 @@
 
 - (id)member:(id)object
 {
-    NSUInteger index = [_backingStore indexOfObject:object];
-    return index != NSNotFound ? [_backingStore objectAtIndex:index] : nil;
+    return [_members member:object];
 }
 
 - (NSEnumerator *)objectEnumerator
@@ -102,12 +183,18 @@
     return [_backingStore objectEnumerator];
 }
 
+- (NSArray *)allObjects
+{
+    // Copies the objects in sort order with one pass over the backing store.
+    return [NSArray arrayWithArray:_backingStore];
+}
+
 #pragma mark NSMutableSet
 
 - (void)addObject:(nonnull id)anObject
 {
     [self performBatchUpdate:^{
-        if ([_backingStore containsObject:anObject]) {
+        if ([_members containsObject:anObject]) {
             [_updatedObjects addObject:anObject];
         } else {
             [_insertedObjects addObject:anObject];
@@ -129,14 +216,15 @@
 
 - (id)copyWithZone:(nullable NSZone *)zone
 {
-    return [[[self class] alloc] initWithBackingStore:[_backingStore mutableCopy] sortDescriptors:[_sortDescriptors copy] includeEmptySections:_includeEmptySections];
+    // The mutable copy of the backing store keeps the storage and the order of the objects.
+    return [[[self class] alloc] initWithSortedBackingStore:[_backingStore mutableCopy] sortDescriptors:[_sortDescriptors copy] includeEmptySections:_includeEmptySections];
 }
 
 #pragma mark NSMutableCopying
 
 - (id)mutableCopyWithZone:(NSZone *)zone
 {
-    return [[[self class] alloc] initWithBackingStore:[_backingStore mutableCopy] sortDescriptors:[_sortDescriptors copy] includeEmptySections:_includeEmptySections];
+    return [[[self class] alloc] initWithSortedBackingStore:[_backingStore mutableCopy] sortDescriptors:[_sortDescriptors copy] includeEmptySections:_includeEmptySections];
 }
 
 #pragma mark NSCoding
@@ -151,15 +239,22 @@
     [super encodeWithCoder:aCoder];
     [aCoder encodeObject:_backingStore forKey:@"_backingStore"];
     [aCoder encodeObject:_sortDescriptors forKey:@"_sortDescriptors"];
+    [aCoder encodeInteger:_storage forKey:@"_storage"];
+    [aCoder encodeBool:_includeEmptySections forKey:@"_includeEmptySections"];
 }
 
 - (nullable instancetype)initWithCoder:(NSCoder *)aDecoder
 {
     self = [super initWithCoder:aDecoder];
     if (self) {
-        _backingStore = [aDecoder decodeObjectOfClass:[NSMutableArray class] forKey:@"_backingStore"];
+        _storage = [aDecoder decodeIntegerForKey:@"_storage"];
+        _backingStore = [[self class] ft_backingStoreWithStorage:_storage];
+        [_backingStore addObjectsFromArray:[aDecoder decodeObjectOfClass:[NSMutableArray class] forKey:@"_backingStore"]];
+        _members = [[NSMutableSet alloc] initWithArray:_backingStore];
         _sortDescriptors = [aDecoder decodeObjectOfClass:[NSArray class] forKey:@"_sortDescriptors"];
-        _observers = [[NSHashTable alloc] init];
+        // Archives without the flag have been created with the default of the initializers.
+        _includeEmptySections = [aDecoder containsValueForKey:@"_includeEmptySections"] ? [aDecoder decodeBoolForKey:@"_includeEmptySections"] : YES;
+        _observers = [[FTObserverRegistry alloc] init];
         _batchUpdateCallCount = 0;
     }
     return self;
@@ -205,6 +300,13 @@
     return _includeEmptySections;
 }
 
+#pragma mark Storage
+
+- (FTMutableSetStorage)storage
+{
+    return _storage;
+}
+
 #pragma mark Batch Updates
 
 - (void)performBatchUpdate:(void (^)(void))updates
@@ -212,15 +314,23 @@
     if (updates) {
         if (_batchUpdateCallCount == 0) {
 
-            for (id<FTDataSourceObserver> observer in self.observers) {
-                if ([observer respondsToSelector:@selector(dataSourceWillChange:)]) {
+            _instrumentationSpan = [FTInstrumentationSpan spanWithName:@"FTMutableSet.batch"];
+            _observers.instrumentationSpan = _instrumentationSpan;
+            [_instrumentationSpan beginPhase:@"notify"];
+
+            [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+                if (methods & FTDataSourceObserverMethodWillChange) {
                     [observer dataSourceWillChange:self];
                 }
-            }
+            }];
+
+            [_instrumentationSpan endPhase];
 
             _insertedObjects = [[NSMutableSet alloc] init];
             _updatedObjects = [[NSMutableSet alloc] init];
             _deletedObjects = [[NSMutableSet alloc] init];
+
+            [self ft_beginChangeSet];
         }
 
         _batchUpdateCallCount++;
@@ -242,60 +352,211 @@
                         insertSection = YES;
                     }
                 } else {
-                    NSSet *exsitingObjects = [NSSet setWithArray:_backingStore];
-                    if ([exsitingObjects isEqual:_deletedObjects]) {
+                    if ([_members isEqualToSet:_deletedObjects]) {
                         callObserver = NO;
                         removeSection = YES;
                     }
                 }
             }
 
+            [_instrumentationSpan addCount:[_updatedObjects count] forKey:@"updated"];
+            [_instrumentationSpan addCount:[_insertedObjects count] forKey:@"inserted"];
+
+            [_instrumentationSpan beginPhase:@"update"];
             [self ft_applyUpdateAndCallObserver:callObserver];
+            [_instrumentationSpan beginPhase:@"delete"];
             [self ft_applyDeletionAndCallObserver:callObserver];
+            [_instrumentationSpan beginPhase:@"insert"];
             [self ft_applyInsertionAndCallObserver:callObserver];
+            [_instrumentationSpan beginPhase:@"notify"];
 
-            for (id<FTDataSourceObserver> observer in self.observers) {
+            [self ft_endChangeSetWithInsertedSection:insertSection removedSection:removeSection];
 
-                if (insertSection) {
-                    if ([observer respondsToSelector:@selector(dataSource:didInsertSections:)]) {
-                        [observer dataSource:self didInsertSections:[NSIndexSet indexSetWithIndex:0]];
+            [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+
+                if (!(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
+                    if (insertSection) {
+                        if (methods & FTDataSourceObserverMethodDidInsertSections) {
+                            [observer dataSource:self didInsertSections:[NSIndexSet indexSetWithIndex:0]];
+                        }
                     }
-                }
 
-                if (removeSection) {
-                    if ([observer respondsToSelector:@selector(dataSource:didDeleteSections:)]) {
-                        [observer dataSource:self didDeleteSections:[NSIndexSet indexSetWithIndex:0]];
+                    if (removeSection) {
+                        if (methods & FTDataSourceObserverMethodDidDeleteSections) {
+                            [observer dataSource:self didDeleteSections:[NSIndexSet indexSetWithIndex:0]];
+                        }
                     }
                 }
 
-                if ([observer respondsToSelector:@selector(dataSourceDidChange:)]) {
+                if (methods & FTDataSourceObserverMethodDidChange) {
                     [observer dataSourceDidChange:self];
                 }
-            }
+            }];
 
             _insertedObjects = nil;
             _updatedObjects = nil;
             _deletedObjects = nil;
+
+            [self ft_finishInstrumentationSpan];
         }
     }
 }
 
+#pragma mark Instrumentation
+
+- (void)ft_finishInstrumentationSpan
+{
+    if (_instrumentationSpan) {
+        FTInstrumentationSpan *span = _instrumentationSpan;
+        _instrumentationSpan = nil;
+        _observers.instrumentationSpan = nil;
+
+        [span addCount:[_backingStore count] forKey:@"items"];
+        [span finish];
+    }
+}
+
+#pragma mark Change Set
+
+- (void)ft_beginChangeSet
+{
+    if (_observers.implementedMethods & FTDataSourceObserverMethodDidApplyChangeSet) {
+        _changeSet = [[FTMutableChangeSet alloc] init];
+        _movedIndexes = [[NSMutableIndexSet alloc] init];
+        _reinsertedIndexes = [[NSMutableIndexSet alloc] init];
+        _newIndexesOfMovedObjects = [[NSMutableDictionary alloc] init];
+        _deletedIndexes = [NSIndexSet indexSet];
+        _insertedIndexes = [[NSMutableIndexSet alloc] init];
+    }
+}
+
+- (void)ft_endChangeSetWithInsertedSection:(BOOL)insertSection removedSection:(BOOL)removeSection
+{
+    if (_changeSet == nil) {
+        return;
+    }
+
+    if (insertSection) {
+        [_changeSet insertSections:[NSIndexSet indexSetWithIndex:0]];
+    }
+
+    if (removeSection) {
+        [_changeSet deleteSections:[NSIndexSet indexSetWithIndex:0]];
+    }
+
+    // The changes are applied in three steps (update, deletion and insertion),
+    // each reporting indexes relative to the state after the previous step. The
+    // change set reports deletions relative to the state before the batch update.
+
+    if ([_movedIndexes count] == 0) {
+        [_changeSet deleteItemsAtIndexes:_deletedIndexes inSection:0];
+    } else {
+        NSMutableIndexSet *deletedIndexes = [[NSMutableIndexSet alloc] init];
+        [_deletedIndexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+            __block NSUInteger index = idx - [_reinsertedIndexes countOfIndexesInRange:NSMakeRange(0, idx)];
+            [_movedIndexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+                if (range.location <= index) {
+                    index += range.length;
+                } else {
+                    *stop = YES;
+                }
+            }];
+            [deletedIndexes addIndex:index];
+        }];
+        [_changeSet deleteItemsAtIndexes:deletedIndexes inSection:0];
+    }
+
+    [_changeSet insertItemsAtIndexes:_insertedIndexes inSection:0];
+
+    NSIndexPath *sectionIndexPath = [NSIndexPath indexPathWithIndex:0];
+    [_newIndexesOfMovedObjects enumerateKeysAndObjectsUsingBlock:^(NSNumber *index, NSNumber *indexAfterUpdate, BOOL *stop) {
+        NSUInteger newIndex = [indexAfterUpdate unsignedIntegerValue];
+        newIndex -= [_deletedIndexes countOfIndexesInRange:NSMakeRange(0, newIndex)];
+
+        NSUInteger insertedIndex = [_insertedIndexes firstIndex];
+        while (insertedIndex != NSNotFound && insertedIndex <= newIndex) {
+            newIndex++;
+            insertedIndex = [_insertedIndexes indexGreaterThanIndex:insertedIndex];
+        }
+
+        [_changeSet moveItemAtIndexPath:[sectionIndexPath indexPathByAddingIndex:[index unsignedIntegerValue]]
+                            toIndexPath:[sectionIndexPath indexPathByAddingIndex:newIndex]];
+    }];
+
+    FTChangeSet *changeSet = [_changeSet copy];
+
+    _changeSet = nil;
+    _movedIndexes = nil;
+    _reinsertedIndexes = nil;
+    _newIndexesOfMovedObjects = nil;
+    _deletedIndexes = nil;
+    _insertedIndexes = nil;
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidApplyChangeSet) {
+            [(id<FTDataSourceChangeSetObserver>)observer dataSource:self didApplyChangeSet:changeSet];
+        }
+    }];
+}
+
+#pragma mark Positions
+
+- (NSMapTable *)ft_positionsOfObjects:(NSSet *)objects
+{
+    if (_storage == FTMutableSetStorageTree) {
+        NSMapTable *positions = [NSMapTable strongToStrongObjectsMapTable];
+        for (id object in objects) {
+            NSUInteger index = [_backingStore indexOfObject:object];
+            if (index != NSNotFound) {
+                [positions setObject:@(index) forKey:object];
+            }
+        }
+        return positions;
+    } else {
+        return [NSArray ft_positionsOfObjects:objects inArray:_backingStore];
+    }
+}
+
 #pragma mark Apply Changes
 
 - (void)ft_applyDeletionAndCallObserver:(BOOL)callObserver
 {
     if ([_deletedObjects count] > 0) {
 
+        // Only objects, that are actually in the set can be removed. This allows
+        // to stop the scan of the backing store as soon as all objects are found.
+
+        [_deletedObjects intersectSet:_members];
+
+        NSUInteger numberOfDeletedObjects = [_deletedObjects count];
         NSMutableIndexSet *indexes = [[NSMutableIndexSet alloc] init];
 
-        for (id obj in _deletedObjects) {
-            NSUInteger index = [_backingStore indexOfObject:obj];
-            if (index != NSNotFound) {
-                [indexes addIndex:index];
+        [_instrumentationSpan addCount:numberOfDeletedObjects forKey:@"deleted"];
+
+        if (numberOfDeletedObjects > 0) {
+            if (_storage == FTMutableSetStorageTree) {
+                for (id obj in _deletedObjects) {
+                    [indexes addIndex:[_backingStore indexOfObject:obj]];
+                }
+            } else {
+                [_backingStore enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+                    if ([_deletedObjects containsObject:obj]) {
+                        [indexes addIndex:idx];
+                        *stop = [indexes count] == numberOfDeletedObjects;
+                    }
+                }];
+                [_instrumentationSpan addCount:[indexes lastIndex] + 1 forKey:@"scanned"];
             }
         }
 
-        if ([indexes count] > 0) {
+        BOOL notifiesObservers = callObserver && [_observers hasObserversImplementingMethods:FTDataSourceObserverMethodDidDeleteItems
+                                                                             excludingMethods:FTDataSourceObserverMethodDidApplyChangeSet];
+
+        if (callObserver == YES && _changeSet) {
+            _deletedIndexes = [indexes copy];
+        }
+
+        if ([indexes count] > 0 && notifiesObservers) {
 
             NSIndexPath *sectionIndexPath = [NSIndexPath indexPathWithIndex:0];
 
@@ -304,16 +565,16 @@
                 [indexPathsOfDeletedItems addObject:[sectionIndexPath indexPathByAddingIndex:idx]];
             }];
 
-            if (callObserver == YES) {
-                for (id<FTDataSourceObserver> observer in self.observers) {
-                    if ([observer respondsToSelector:@selector(dataSource:didDeleteItemsAtIndexPaths:)]) {
-                        [observer dataSource:self didDeleteItemsAtIndexPaths:indexPathsOfDeletedItems];
-                    }
+            [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+                if ((methods & FTDataSourceObserverMethodDidDeleteItems) &&
+                    !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
+                    [observer dataSource:self didDeleteItemsAtIndexPaths:indexPathsOfDeletedItems];
                 }
-            }
+            }];
         }
 
         [_backingStore removeObjectsAtIndexes:indexes];
+        [_members minusSet:_deletedObjects];
         [_deletedObjects removeAllObjects];
     }
 }
@@ -322,9 +583,15 @@
 {
     if ([_insertedObjects count] > 0) {
 
-        NSComparator comperator = [NSSortDescriptor ft_comperatorUsingSortDescriptors:self.sortDescriptors];
-        NSArray *insertedObjects = [_insertedObjects sortedArrayUsingDescriptors:self.sortDescriptors];
+        FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:self.sortDescriptors];
+        NSComparator comperator = [sortKeyCache comperator];
+        if (_instrumentationSpan) {
+            comperator = [_instrumentationSpan countingComparator:comperator];
+        }
+        NSArray *insertedObjects = [sortKeyCache sortedArrayFromObjects:_insertedObjects];
 
+        BOOL notifiesObservers = callObserver && [_observers hasObserversImplementingMethods:FTDataSourceObserverMethodDidInsertItems
+                                                                             excludingMethods:FTDataSourceObserverMethodDidApplyChangeSet];
         NSMutableArray *indexPathsOfInsertedItems = [[NSMutableArray alloc] init];
 
         NSUInteger offset = 0;
@@ -337,19 +604,27 @@
                                             usingComparator:comperator];
 
             [_backingStore insertObject:object atIndex:index];
+            [_members addObject:object];
+
+            if (notifiesObservers) {
+                NSUInteger indexes[] = {0, index};
+                [indexPathsOfInsertedItems addObject:[NSIndexPath indexPathWithIndexes:indexes length:2]];
+            }
 
-            NSUInteger indexes[] = {0, index};
-            [indexPathsOfInsertedItems addObject:[NSIndexPath indexPathWithIndexes:indexes length:2]];
+            if (callObserver == YES && _changeSet) {
+                [_insertedIndexes addIndex:index];
+            }
 
             offset = index + 1;
         }
 
-        if (callObserver == YES && [indexPathsOfInsertedItems count] > 0) {
-            for (id<FTDataSourceObserver> observer in self.observers) {
-                if ([observer respondsToSelector:@selector(dataSource:didInsertItemsAtIndexPaths:)]) {
+        if (notifiesObservers) {
+            [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+                if ((methods & FTDataSourceObserverMethodDidInsertItems) &&
+                    !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
                     [observer dataSource:self didInsertItemsAtIndexPaths:indexPathsOfInsertedItems];
                 }
-            }
+            }];
         }
 
         [_insertedObjects removeAllObjects];
@@ -360,59 +635,167 @@
 {
     if ([_updatedObjects count] > 0) {
 
-        NSComparator comperator = [NSSortDescriptor ft_comperatorUsingSortDescriptors:self.sortDescriptors];
-        NSArray *updatedObjects = [NSArray ft_arrayBySortingObjects:_updatedObjects
-                                               usingSortDescriptors:self.sortDescriptors
-                                orderAmbiguousObjectsByOrderInArray:_backingStore];
+        FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:self.sortDescriptors];
+        NSComparator comperator = [sortKeyCache comperator];
+        if (_instrumentationSpan) {
+            comperator = [_instrumentationSpan countingComparator:comperator];
+        }
+
+        // The positions of the updated objects are looked up once and used to order
+        // objects with an ambiguous sort order as well as to report the old index.
+
+        NSMapTable *indexesByObjects = [self ft_positionsOfObjects:_updatedObjects];
+        NSArray *updatedObjects = [NSArray ft_arrayBySortingObjects:_updatedObjects byPositions:indexesByObjects];
+        updatedObjects = [updatedObjects sortedArrayWithOptions:NSSortStable usingComparator:comperator];
 
         NSMutableIndexSet *indexes = [NSMutableIndexSet indexSet];
-        NSMapTable *indexesByObjects = [NSMapTable strongToStrongObjectsMapTable];
 
         for (id object in updatedObjects) {
-            NSUInteger index = [_backingStore indexOfObject:object];
+            NSUInteger index = [[indexesByObjects objectForKey:object] unsignedIntegerValue];
             [indexes addIndex:index];
 
             // Replace the object in the set with the updated object. The object might
             // be a different object, because the update is based on equality and not
             // on identity.
             [_backingStore replaceObjectAtIndex:index withObject:object];
+            [_members removeObject:object];
+            [_members addObject:object];
+        }
+
+        // Only the updated objects, which are out of order with respect to their
+        // neighbours, are removed and reinserted. Removing an object can bring two
+        // other objects next to each other, therefore the check is repeated until
+        // all remaining objects are in order.
+
+        NSMutableIndexSet *movedIndexes = [self ft_indexesOfObjectsOutOfOrderAtIndexes:indexes usingComparator:comperator];
+        NSMutableIndexSet *insertedIndexes = [NSMutableIndexSet indexSet];
+        NSMapTable *newIndexesByObjects = [NSMapTable strongToStrongObjectsMapTable];
 
-            [indexesByObjects setObject:@(index) forKey:object];
+        if ([movedIndexes count] > 0) {
+
+            [_backingStore removeObjectsAtIndexes:movedIndexes];
+
+            // The moved objects are inserted in ascending order. Therefore an
+            // insertion never changes the index of a previously inserted object.
+
+            for (id object in updatedObjects) {
+                NSUInteger index = [[indexesByObjects objectForKey:object] unsignedIntegerValue];
+                if ([movedIndexes containsIndex:index]) {
+                    NSUInteger newIndex = [_backingStore indexOfObject:object
+                                                         inSortedRange:NSMakeRange(0, [_backingStore count])
+                                                               options:NSBinarySearchingInsertionIndex | NSBinarySearchingLastEqual
+                                                       usingComparator:comperator];
+                    [_backingStore insertObject:object atIndex:newIndex];
+                    [insertedIndexes addIndex:newIndex];
+                    [newIndexesByObjects setObject:@(newIndex) forKey:object];
+                }
+            }
         }
 
-        [_backingStore sortUsingComparator:comperator];
+        if (callObserver && _changeSet) {
+            [_movedIndexes addIndexes:movedIndexes];
+            [_reinsertedIndexes addIndexes:insertedIndexes];
+        }
 
         if (callObserver) {
             NSIndexPath *sectionIndex = [NSIndexPath indexPathWithIndex:0];
 
             for (id object in updatedObjects) {
                 NSUInteger index = [[indexesByObjects objectForKey:object] unsignedIntegerValue];
-                NSUInteger newIndex = [_backingStore indexOfObject:object];
+                NSUInteger newIndex = index;
+
+                if ([movedIndexes containsIndex:index]) {
+                    newIndex = [[newIndexesByObjects objectForKey:object] unsignedIntegerValue];
+                } else if ([movedIndexes count] > 0) {
+
+                    // The index of an object, that stayed in place, is shifted by the
+                    // removed objects in front of it and by the objects inserted before it.
+
+                    newIndex = index - [movedIndexes countOfIndexesInRange:NSMakeRange(0, index)];
+
+                    NSUInteger insertedIndex = [insertedIndexes firstIndex];
+                    while (insertedIndex != NSNotFound && insertedIndex <= newIndex) {
+                        newIndex++;
+                        insertedIndex = [insertedIndexes indexGreaterThanIndex:insertedIndex];
+                    }
+                }
 
                 if (index == newIndex) {
 
+                    [_changeSet changeItemsAtIndexes:[NSIndexSet indexSetWithIndex:index] inSection:0];
+
                     NSIndexPath *indexPath = [sectionIndex indexPathByAddingIndex:index];
 
-                    for (id<FTDataSourceObserver> observer in self.observers) {
-                        if ([observer respondsToSelector:@selector(dataSource:didChangeItemsAtIndexPaths:)]) {
+                    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+                        if ((methods & FTDataSourceObserverMethodDidChangeItems) &&
+                            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
                             [observer dataSource:self didChangeItemsAtIndexPaths:@[ indexPath ]];
                         }
-                    }
+                    }];
 
                 } else {
 
-                    for (id<FTDataSourceObserver> observer in self.observers) {
-                        if ([observer respondsToSelector:@selector(dataSource:didMoveItemAtIndexPath:toIndexPath:)]) {
+                    [_newIndexesOfMovedObjects setObject:@(newIndex) forKey:@(index)];
+
+                    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+                        if ((methods & FTDataSourceObserverMethodDidMoveItem) &&
+                            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
 
                             [observer dataSource:self
                                 didMoveItemAtIndexPath:[sectionIndex indexPathByAddingIndex:index]
                                            toIndexPath:[sectionIndex indexPathByAddingIndex:newIndex]];
                         }
-                    }
+                    }];
+                }
+            }
+        }
+    }
+}
+
+- (NSMutableIndexSet *)ft_indexesOfObjectsOutOfOrderAtIndexes:(NSIndexSet *)indexes usingComparator:(NSComparator)comperator
+{
+    NSMutableIndexSet *outOfOrderIndexes = [NSMutableIndexSet indexSet];
+    NSUInteger count = [_backingStore count];
+
+    BOOL changed = YES;
+    while (changed) {
+        changed = NO;
+
+        NSUInteger index = [indexes firstIndex];
+        while (index != NSNotFound) {
+            if (![outOfOrderIndexes containsIndex:index]) {
+
+                id object = [_backingStore objectAtIndex:index];
+
+                // Find the nearest neighbours, which have not been removed.
+
+                NSUInteger previousIndex = index;
+                do {
+                    previousIndex = previousIndex > 0 ? previousIndex - 1 : NSNotFound;
+                } while (previousIndex != NSNotFound && [outOfOrderIndexes containsIndex:previousIndex]);
+
+                NSUInteger nextIndex = index;
+                do {
+                    nextIndex = nextIndex + 1 < count ? nextIndex + 1 : NSNotFound;
+                } while (nextIndex != NSNotFound && [outOfOrderIndexes containsIndex:nextIndex]);
+
+                BOOL outOfOrder = NO;
+                if (previousIndex != NSNotFound && comperator([_backingStore objectAtIndex:previousIndex], object) == NSOrderedDescending) {
+                    outOfOrder = YES;
+                } else if (nextIndex != NSNotFound && comperator(object, [_backingStore objectAtIndex:nextIndex]) == NSOrderedDescending) {
+                    outOfOrder = YES;
+                }
+
+                if (outOfOrder) {
+                    [outOfOrderIndexes addIndex:index];
+                    changed = YES;
                 }
             }
+            index = [indexes indexGreaterThanIndex:index];
         }
     }
+
+    return outOfOrderIndexes;
 }
 
 #pragma mark FTDataSource
@@ -468,17 +851,17 @@
 
 - (NSArray *)observers
 {
-    return [_observers allObjects];
+    return [_observers observers];
 }
 
 - (void)addObserver:(id<FTDataSourceObserver>)observer
 {
-    [_observers addObject:observer];
+    [_observers addObserver:observer];
 }
 
 - (void)removeObserver:(id<FTDataSourceObserver>)observer
 {
-    [_observers removeObject:observer];
+    [_observers removeObserver:observer];
 }
 
 #pragma mark FTReverseDataSource
@@ -490,17 +873,21 @@
 
 - (NSArray *)indexPathsOfItem:(id)item
 {
-    NSMutableArray *indexPaths = [[NSMutableArray alloc] init];
+    if (![_members containsObject:item]) {
+        return @[];
+    }
 
-    NSIndexPath *sectionIndexPath = [NSIndexPath indexPathWithIndex:0];
+    // The objects in the backing store are unique, therefore there is only
+    // one index path for the item. The lookup is linear with the array storage
+    // and logarithmic with the tree storage.
 
-    [_backingStore enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-        if ([obj isEqual:item]) {
-            [indexPaths addObject:[sectionIndexPath indexPathByAddingIndex:idx]];
-        }
-    }];
+    NSUInteger index = [_backingStore indexOfObject:item];
+    if (index == NSNotFound) {
+        return @[];
+    }
 
-    return [indexPaths copy];
+    NSUInteger indexes[] = {0, index};
+    return @[ [NSIndexPath indexPathWithIndexes:indexes length:2] ];
 }
 
 @end
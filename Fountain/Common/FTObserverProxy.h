@@ -15,7 +15,7 @@
     a backing sotre in another data source and the delegate calls for the data source
     changes should be forwarded to the observer of the data source.
  */
-@interface FTObserverProxy : NSObject <FTDataSourceObserver>
+@interface FTObserverProxy : NSObject <FTDataSourceChangeSetObserver>
 
 #pragma mark Object
 @property (nonatomic, weak) id object;
@@ -6,10 +6,17 @@
 //  Copyright © 2016 Tobias Kräntzer. All rights reserved.
 //
 
+#import "FTChangeSet.h"
+#import "FTInstrumentation.h"
+#import "FTObserverRegistry.h"
+
 #import "FTObserverProxy.h"
 
 @interface FTObserverProxy () {
-    NSHashTable *_observers;
+    FTObserverRegistry *_observers;
+    FTMutableChangeSet *_changeSet;
+    NSUInteger _changeCallCount;
+    FTInstrumentationSpan *_instrumentationSpan;
 }
 
 @end
@@ -22,7 +29,8 @@
 {
     self = [super init];
     if (self) {
-        _observers = [NSHashTable weakObjectsHashTable];
+        _observers = [[FTObserverRegistry alloc] init];
+        _changeSet = [[FTMutableChangeSet alloc] init];
     }
     return self;
 }
@@ -31,17 +39,25 @@
 
 - (NSArray *)observers;
 {
-    return [_observers allObjects];
+    return [_observers observers];
 }
 
 - (void)addObserver:(id<FTDataSourceObserver>)observer
 {
-    [_observers addObject:observer];
+    [_observers addObserver:observer];
 }
 
 - (void)removeObserver:(id<FTDataSourceObserver>)observer
 {
-    [_observers removeObject:observer];
+    [_observers removeObserver:observer];
+}
+
+#pragma mark Change Set
+
+- (BOOL)ft_recordsChangeSet
+{
+    // The individual changes are only needed for observers supporting change sets.
+    return (_observers.implementedMethods & FTDataSourceObserverMethodDidApplyChangeSet) != 0;
 }
 
 #pragma mark -
@@ -49,39 +65,73 @@
 
 - (void)dataSourceWillReset:(id<FTDataSource>)dataSource
 {
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSourceWillReset:)]) {
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodWillReset) {
             [observer dataSourceWillReset:self.object ?: self];
         }
-    }
+    }];
 }
 
 - (void)dataSourceDidReset:(id<FTDataSource>)dataSource
 {
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSourceDidReset:)]) {
+    // Individual changes recorded before the reset are replaced by the reset.
+    [_changeSet removeAllChanges];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidReset) {
             [observer dataSourceDidReset:self.object ?: self];
         }
-    }
+    }];
 }
 
 #pragma mark Begin End Updates
 
 - (void)dataSourceWillChange:(id<FTDataSource>)dataSource
 {
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSourceWillChange:)]) {
+    if (_changeCallCount == 0) {
+        _instrumentationSpan = [FTInstrumentationSpan spanWithName:@"FTObserverProxy.batch"];
+        _observers.instrumentationSpan = _instrumentationSpan;
+    }
+    _changeCallCount++;
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodWillChange) {
             [observer dataSourceWillChange:self.object ?: self];
         }
-    }
+    }];
 }
 
 - (void)dataSourceDidChange:(id<FTDataSource>)dataSource
 {
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSourceDidChange:)]) {
+    // Observers, which support change sets, receive the individual changes
+    // as one change set, if the object does not provide a change set itself.
+    // Nested updates are part of the change set of the outermost update.
+
+    if (_changeCallCount <= 1 && [_changeSet isEmpty] == NO) {
+        FTChangeSet *changeSet = [_changeSet copy];
+        [_changeSet removeAllChanges];
+
+        [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+            if (methods & FTDataSourceObserverMethodDidApplyChangeSet) {
+                [(id<FTDataSourceChangeSetObserver>)observer dataSource:self.object ?: self didApplyChangeSet:changeSet];
+            }
+        }];
+    }
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidChange) {
             [observer dataSourceDidChange:self.object ?: self];
         }
+    }];
+
+    if (_changeCallCount > 0) {
+        _changeCallCount--;
+        if (_changeCallCount == 0) {
+            FTInstrumentationSpan *span = _instrumentationSpan;
+            _instrumentationSpan = nil;
+            _observers.instrumentationSpan = nil;
+            [span finish];
+        }
     }
 }
 
@@ -89,76 +139,139 @@
 
 - (void)dataSource:(id<FTDataSource>)dataSource didInsertSections:(NSIndexSet *)sections
 {
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didInsertSections:)]) {
+    if ([self ft_recordsChangeSet]) {
+        [_changeSet insertSections:sections];
+    }
+    [_instrumentationSpan addCount:[sections count] forKey:@"sections"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidInsertSections) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self.object ?: self didInsertSections:sections];
         }
-    }
+    }];
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didDeleteSections:(NSIndexSet *)sections
 {
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didDeleteSections:)]) {
+    if ([self ft_recordsChangeSet]) {
+        [_changeSet deleteSections:sections];
+    }
+    [_instrumentationSpan addCount:[sections count] forKey:@"sections"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidDeleteSections) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self.object ?: self didDeleteSections:sections];
         }
-    }
+    }];
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didChangeSections:(NSIndexSet *)sections
 {
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didChangeSections:)]) {
+    if ([self ft_recordsChangeSet]) {
+        [_changeSet changeSections:sections];
+    }
+    [_instrumentationSpan addCount:[sections count] forKey:@"sections"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidChangeSections) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self.object ?: self didChangeSections:sections];
         }
-    }
+    }];
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didMoveSection:(NSInteger)section toSection:(NSInteger)newSection
 {
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didMoveSection:toSection:)]) {
+    if ([self ft_recordsChangeSet]) {
+        [_changeSet moveSection:section toSection:newSection];
+    }
+    [_instrumentationSpan addCount:1 forKey:@"sections"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidMoveSection) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self.object ?: self didMoveSection:section toSection:newSection];
         }
-    }
+    }];
 }
 
 #pragma mark Manage Items
 
 - (void)dataSource:(id<FTDataSource>)dataSource didInsertItemsAtIndexPaths:(NSArray *)indexPaths
 {
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didInsertItemsAtIndexPaths:)]) {
+    if ([self ft_recordsChangeSet]) {
+        [_changeSet insertItemsAtIndexPaths:indexPaths];
+    }
+    [_instrumentationSpan addCount:[indexPaths count] forKey:@"items"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidInsertItems) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self.object ?: self didInsertItemsAtIndexPaths:indexPaths];
         }
-    }
+    }];
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didDeleteItemsAtIndexPaths:(NSArray *)indexPaths
 {
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didDeleteItemsAtIndexPaths:)]) {
+    if ([self ft_recordsChangeSet]) {
+        [_changeSet deleteItemsAtIndexPaths:indexPaths];
+    }
+    [_instrumentationSpan addCount:[indexPaths count] forKey:@"items"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidDeleteItems) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self.object ?: self didDeleteItemsAtIndexPaths:indexPaths];
         }
-    }
+    }];
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didChangeItemsAtIndexPaths:(NSArray *)indexPaths
 {
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didChangeItemsAtIndexPaths:)]) {
+    if ([self ft_recordsChangeSet]) {
+        [_changeSet changeItemsAtIndexPaths:indexPaths];
+    }
+    [_instrumentationSpan addCount:[indexPaths count] forKey:@"items"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidChangeItems) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self.object ?: self didChangeItemsAtIndexPaths:indexPaths];
         }
-    }
+    }];
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didMoveItemAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath
 {
-    for (id<FTDataSourceObserver> observer in self.observers) {
-        if ([observer respondsToSelector:@selector(dataSource:didMoveItemAtIndexPath:toIndexPath:)]) {
+    if ([self ft_recordsChangeSet]) {
+        [_changeSet moveItemAtIndexPath:indexPath toIndexPath:newIndexPath];
+    }
+    [_instrumentationSpan addCount:1 forKey:@"items"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if ((methods & FTDataSourceObserverMethodDidMoveItem) &&
+            !(methods & FTDataSourceObserverMethodDidApplyChangeSet)) {
             [observer dataSource:self.object ?: self didMoveItemAtIndexPath:indexPath toIndexPath:newIndexPath];
         }
-    }
+    }];
+}
+
+#pragma mark Change Sets
+
+- (void)dataSource:(id<FTDataSource>)dataSource didApplyChangeSet:(FTChangeSet *)changeSet
+{
+    [_instrumentationSpan addCount:1 forKey:@"changeSets"];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidApplyChangeSet) {
+            [(id<FTDataSourceChangeSetObserver>)observer dataSource:self.object ?: self didApplyChangeSet:changeSet];
+        } else {
+            [changeSet notifyObserver:observer implementingMethods:methods ofChangesInDataSource:self.object ?: self];
+        }
+    }];
 }
 
 @end
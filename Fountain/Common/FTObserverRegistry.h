@@ -0,0 +1,66 @@
+//
+//  FTObserverRegistry.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 28.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FTDataSourceObserver.h"
+
+@class FTInstrumentationSpan;
+
+typedef NS_OPTIONS(NSUInteger, FTDataSourceObserverMethods) {
+    FTDataSourceObserverMethodWillReset = 1 << 0,
+    FTDataSourceObserverMethodDidReset = 1 << 1,
+    FTDataSourceObserverMethodWillChange = 1 << 2,
+    FTDataSourceObserverMethodDidChange = 1 << 3,
+    FTDataSourceObserverMethodDidInsertSections = 1 << 4,
+    FTDataSourceObserverMethodDidDeleteSections = 1 << 5,
+    FTDataSourceObserverMethodDidChangeSections = 1 << 6,
+    FTDataSourceObserverMethodDidMoveSection = 1 << 7,
+    FTDataSourceObserverMethodDidInsertItems = 1 << 8,
+    FTDataSourceObserverMethodDidDeleteItems = 1 << 9,
+    FTDataSourceObserverMethodDidChangeItems = 1 << 10,
+    FTDataSourceObserverMethodDidMoveItem = 1 << 11,
+    FTDataSourceObserverMethodDidApplyChangeSet = 1 << 12
+};
+
+/*! <code>FTObserverRegistry</code> holds the observers of a data source weakly.
+
+    The methods an observer implements are determined once, if the observer is added.
+    The observers are kept in an immutable snapshot, which is replaced if an observer
+    is added or removed. Enumerating the observers does therefore neither allocate
+    nor ask the observers, if they respond to a selector.
+
+    While an instrumentation span is set, the time spent in each observer during an
+    enumeration is added to the span.
+ */
+@interface FTObserverRegistry : NSObject
+
+#pragma mark Observers
+@property (nonatomic, readonly) NSArray *observers;
+- (void)addObserver:(id<FTDataSourceObserver>)observer;
+- (void)removeObserver:(id<FTDataSourceObserver>)observer;
+
+// The union of the methods implemented by the observers.
+@property (nonatomic, readonly) FTDataSourceObserverMethods implementedMethods;
+
+// Returns YES, if at least one observer implements all of the methods and none of the excluded methods.
+- (BOOL)hasObserversImplementingMethods:(FTDataSourceObserverMethods)methods excludingMethods:(FTDataSourceObserverMethods)excludedMethods;
+
+#pragma mark Enumerating Observers
+
+// The block is called with the observers in the order they have been added. Observers
+// added or removed while enumerating do not affect the current enumeration.
+- (void)enumerateObserversUsingBlock:(void (^)(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods))block;
+
+#pragma mark Instrumentation
+@property (nonatomic, strong) FTInstrumentationSpan *instrumentationSpan;
+
+#pragma mark Implemented Methods
++ (FTDataSourceObserverMethods)methodsImplementedByObserver:(id<FTDataSourceObserver>)observer;
+
+@end
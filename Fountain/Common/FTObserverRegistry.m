@@ -0,0 +1,192 @@
+//
+//  FTObserverRegistry.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 28.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTInstrumentation.h"
+
+#import "FTObserverRegistry.h"
+
+@interface FTObserverRegistryEntry : NSObject
+@property (nonatomic, readonly, weak) id<FTDataSourceObserver> observer;
+@property (nonatomic, readonly) FTDataSourceObserverMethods methods;
+- (instancetype)initWithObserver:(id<FTDataSourceObserver>)observer methods:(FTDataSourceObserverMethods)methods;
+@end
+
+@interface FTObserverRegistry () {
+    NSArray *_entries;
+}
+
+@end
+
+@implementation FTObserverRegistry
+
+#pragma mark Life-cycle
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _entries = @[];
+        _implementedMethods = 0;
+    }
+    return self;
+}
+
+#pragma mark Observers
+
+- (NSArray *)observers
+{
+    NSMutableArray *observers = [[NSMutableArray alloc] initWithCapacity:[_entries count]];
+    for (FTObserverRegistryEntry *entry in _entries) {
+        id<FTDataSourceObserver> observer = entry.observer;
+        if (observer) {
+            [observers addObject:observer];
+        }
+    }
+    return observers;
+}
+
+- (void)addObserver:(id<FTDataSourceObserver>)observer
+{
+    if (observer == nil) {
+        return;
+    }
+
+    NSMutableArray *entries = [self ft_entriesWithoutObserver:observer];
+    FTDataSourceObserverMethods methods = [[self class] methodsImplementedByObserver:observer];
+    [entries addObject:[[FTObserverRegistryEntry alloc] initWithObserver:observer methods:methods]];
+    [self ft_setEntries:entries];
+}
+
+- (void)removeObserver:(id<FTDataSourceObserver>)observer
+{
+    [self ft_setEntries:[self ft_entriesWithoutObserver:observer]];
+}
+
+- (NSMutableArray *)ft_entriesWithoutObserver:(id<FTDataSourceObserver>)observer
+{
+    // Entries of observers, which have been deallocated, are dropped as well.
+
+    NSMutableArray *entries = [[NSMutableArray alloc] initWithCapacity:[_entries count] + 1];
+    for (FTObserverRegistryEntry *entry in _entries) {
+        id<FTDataSourceObserver> entryObserver = entry.observer;
+        if (entryObserver != nil && entryObserver != observer) {
+            [entries addObject:entry];
+        }
+    }
+    return entries;
+}
+
+- (void)ft_setEntries:(NSMutableArray *)entries
+{
+    FTDataSourceObserverMethods implementedMethods = 0;
+    for (FTObserverRegistryEntry *entry in entries) {
+        implementedMethods |= entry.methods;
+    }
+
+    _entries = [entries copy];
+    _implementedMethods = implementedMethods;
+}
+
+- (BOOL)hasObserversImplementingMethods:(FTDataSourceObserverMethods)methods excludingMethods:(FTDataSourceObserverMethods)excludedMethods
+{
+    for (FTObserverRegistryEntry *entry in _entries) {
+        if ((entry.methods & methods) == methods && (entry.methods & excludedMethods) == 0 && entry.observer != nil) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+#pragma mark Enumerating Observers
+
+- (void)enumerateObserversUsingBlock:(void (^)(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods))block
+{
+    // The entries are never mutated. Holding on to the current snapshot keeps the
+    // enumeration stable, even if the block adds or removes observers.
+
+    NSArray *entries = _entries;
+    FTInstrumentationSpan *span = _instrumentationSpan;
+    for (FTObserverRegistryEntry *entry in entries) {
+        id<FTDataSourceObserver> observer = entry.observer;
+        if (observer) {
+            if (span) {
+                [span measureDeliveryToObserver:observer
+                                     usingBlock:^{
+                                         block(observer, entry.methods);
+                                     }];
+            } else {
+                block(observer, entry.methods);
+            }
+        }
+    }
+}
+
+#pragma mark Implemented Methods
+
++ (FTDataSourceObserverMethods)methodsImplementedByObserver:(id<FTDataSourceObserver>)observer
+{
+    FTDataSourceObserverMethods methods = 0;
+
+    if ([observer respondsToSelector:@selector(dataSourceWillReset:)]) {
+        methods |= FTDataSourceObserverMethodWillReset;
+    }
+    if ([observer respondsToSelector:@selector(dataSourceDidReset:)]) {
+        methods |= FTDataSourceObserverMethodDidReset;
+    }
+    if ([observer respondsToSelector:@selector(dataSourceWillChange:)]) {
+        methods |= FTDataSourceObserverMethodWillChange;
+    }
+    if ([observer respondsToSelector:@selector(dataSourceDidChange:)]) {
+        methods |= FTDataSourceObserverMethodDidChange;
+    }
+    if ([observer respondsToSelector:@selector(dataSource:didInsertSections:)]) {
+        methods |= FTDataSourceObserverMethodDidInsertSections;
+    }
+    if ([observer respondsToSelector:@selector(dataSource:didDeleteSections:)]) {
+        methods |= FTDataSourceObserverMethodDidDeleteSections;
+    }
+    if ([observer respondsToSelector:@selector(dataSource:didChangeSections:)]) {
+        methods |= FTDataSourceObserverMethodDidChangeSections;
+    }
+    if ([observer respondsToSelector:@selector(dataSource:didMoveSection:toSection:)]) {
+        methods |= FTDataSourceObserverMethodDidMoveSection;
+    }
+    if ([observer respondsToSelector:@selector(dataSource:didInsertItemsAtIndexPaths:)]) {
+        methods |= FTDataSourceObserverMethodDidInsertItems;
+    }
+    if ([observer respondsToSelector:@selector(dataSource:didDeleteItemsAtIndexPaths:)]) {
+        methods |= FTDataSourceObserverMethodDidDeleteItems;
+    }
+    if ([observer respondsToSelector:@selector(dataSource:didChangeItemsAtIndexPaths:)]) {
+        methods |= FTDataSourceObserverMethodDidChangeItems;
+    }
+    if ([observer respondsToSelector:@selector(dataSource:didMoveItemAtIndexPath:toIndexPath:)]) {
+        methods |= FTDataSourceObserverMethodDidMoveItem;
+    }
+    if ([observer respondsToSelector:@selector(dataSource:didApplyChangeSet:)]) {
+        methods |= FTDataSourceObserverMethodDidApplyChangeSet;
+    }
+
+    return methods;
+}
+
+@end
+
+@implementation FTObserverRegistryEntry
+
+- (instancetype)initWithObserver:(id<FTDataSourceObserver>)observer methods:(FTDataSourceObserverMethods)methods
+{
+    self = [super init];
+    if (self) {
+        _observer = observer;
+        _methods = methods;
+    }
+    return self;
+}
+
+@end
@@ -0,0 +1,22 @@
+//
+//  FTOrderStatisticTree.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 12.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/*! <code>FTOrderStatisticTree</code> is a subclass of <code>NSMutableArray</code> which
+    stores its objects in a balanced tree, where each node knows the size of its subtree.
+
+    Accessing, inserting and removing an object at a given index as well as a binary search
+    in a sorted tree is done in O(log n). Looking up the index of an object (rank) is done
+    in O(log n) by using a map from the objects to the nodes of the tree.
+
+    @warning The objects in the tree must be unique (based on <code>isEqual:</code>).
+ */
+@interface FTOrderStatisticTree : NSMutableArray
+
+@end
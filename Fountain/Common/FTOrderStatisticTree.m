@@ -0,0 +1,531 @@
+//
+//  FTOrderStatisticTree.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 12.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTOrderStatisticTree.h"
+
+#include <stdlib.h>
+
+@interface FTOrderStatisticTreeNode : NSObject {
+  @public
+    id _object;
+    FTOrderStatisticTreeNode *_left;
+    FTOrderStatisticTreeNode *_right;
+    __unsafe_unretained FTOrderStatisticTreeNode *_parent;
+    uint64_t _priority;
+    NSUInteger _size;
+}
+@end
+
+@implementation FTOrderStatisticTreeNode
+@end
+
+typedef FTOrderStatisticTreeNode FTNode;
+
+static FTNode *FTNodeSuccessor(FTNode *node);
+
+@interface FTOrderStatisticTreeEnumerator : NSEnumerator {
+    FTNode *_node;
+}
+- (instancetype)initWithNode:(FTNode *)node;
+@end
+
+@implementation FTOrderStatisticTreeEnumerator
+
+- (instancetype)initWithNode:(FTNode *)node
+{
+    self = [super init];
+    if (self) {
+        _node = node;
+    }
+    return self;
+}
+
+- (id)nextObject
+{
+    FTNode *node = _node;
+    if (node == nil) {
+        return nil;
+    }
+    _node = FTNodeSuccessor(node);
+    return node->_object;
+}
+
+@end
+
+#pragma mark Node Helper
+
+static inline NSUInteger FTNodeSize(FTNode *node)
+{
+    return node ? node->_size : 0;
+}
+
+static inline void FTNodeUpdate(FTNode *node)
+{
+    node->_size = 1 + FTNodeSize(node->_left) + FTNodeSize(node->_right);
+    if (node->_left) {
+        node->_left->_parent = node;
+    }
+    if (node->_right) {
+        node->_right->_parent = node;
+    }
+}
+
+static inline uint64_t FTNodeRandomPriority(void)
+{
+    return ((uint64_t)arc4random() << 32) | arc4random();
+}
+
+static inline uint64_t FTNodePriorityForDepth(NSUInteger depth)
+{
+    // Nodes created by a bulk load get a priority depending on their depth in
+    // the (perfectly balanced) tree. This keeps the heap property of the treap
+    // without the need of sorting random priorities.
+    return ((uint64_t)(0xFFFFFF - MIN(depth, 0xFFFFFF)) << 40) | arc4random();
+}
+
+static FTNode *FTNodeMerge(FTNode *left, FTNode *right)
+{
+    if (left == nil) {
+        return right;
+    } else if (right == nil) {
+        return left;
+    } else if (left->_priority > right->_priority) {
+        left->_right = FTNodeMerge(left->_right, right);
+        FTNodeUpdate(left);
+        return left;
+    } else {
+        right->_left = FTNodeMerge(left, right->_left);
+        FTNodeUpdate(right);
+        return right;
+    }
+}
+
+static void FTNodeSplit(FTNode *node, NSUInteger index, FTNode *__strong *left, FTNode *__strong *right)
+{
+    if (node == nil) {
+        *left = nil;
+        *right = nil;
+        return;
+    }
+
+    FTNode *l = nil;
+    FTNode *r = nil;
+
+    NSUInteger leftSize = FTNodeSize(node->_left);
+    if (leftSize < index) {
+        FTNodeSplit(node->_right, index - leftSize - 1, &l, &r);
+        node->_right = l;
+        FTNodeUpdate(node);
+        *left = node;
+        *right = r;
+    } else {
+        FTNodeSplit(node->_left, index, &l, &r);
+        node->_left = r;
+        FTNodeUpdate(node);
+        *left = l;
+        *right = node;
+    }
+}
+
+static FTNode *FTNodeBuild(const id __unsafe_unretained *objects, NSUInteger count, NSUInteger depth, NSMapTable *nodes)
+{
+    if (count == 0) {
+        return nil;
+    }
+
+    NSUInteger mid = count / 2;
+
+    FTNode *node = [[FTNode alloc] init];
+    node->_object = objects[mid];
+    node->_priority = FTNodePriorityForDepth(depth);
+    node->_left = FTNodeBuild(objects, mid, depth + 1, nodes);
+    node->_right = FTNodeBuild(objects + mid + 1, count - mid - 1, depth + 1, nodes);
+    FTNodeUpdate(node);
+
+    [nodes setObject:node forKey:node->_object];
+
+    return node;
+}
+
+static FTNode *FTNodeAtIndex(FTNode *node, NSUInteger index)
+{
+    while (node) {
+        NSUInteger leftSize = FTNodeSize(node->_left);
+        if (index < leftSize) {
+            node = node->_left;
+        } else if (index == leftSize) {
+            return node;
+        } else {
+            index -= leftSize + 1;
+            node = node->_right;
+        }
+    }
+    return nil;
+}
+
+static NSUInteger FTNodeRank(FTNode *node)
+{
+    NSUInteger rank = FTNodeSize(node->_left);
+    while (node->_parent) {
+        FTNode *parent = node->_parent;
+        if (parent->_right == node) {
+            rank += FTNodeSize(parent->_left) + 1;
+        }
+        node = parent;
+    }
+    return rank;
+}
+
+static FTNode *FTNodeSuccessor(FTNode *node)
+{
+    if (node->_right) {
+        node = node->_right;
+        while (node->_left) {
+            node = node->_left;
+        }
+        return node;
+    } else {
+        while (node->_parent && node->_parent->_right == node) {
+            node = node->_parent;
+        }
+        return node->_parent;
+    }
+}
+
+@implementation FTOrderStatisticTree {
+    FTNode *_root;
+    NSMapTable *_nodes;
+    unsigned long _mutations;
+}
+
+#pragma mark Life-cycle
+
+- (instancetype)init
+{
+    return [self initWithObjects:NULL count:0];
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)numItems
+{
+    return [self initWithObjects:NULL count:0];
+}
+
+- (instancetype)initWithObjects:(const id __unsafe_unretained *)objects count:(NSUInteger)cnt
+{
+    self = [super init];
+    if (self) {
+        _nodes = [NSMapTable strongToStrongObjectsMapTable];
+        _root = FTNodeBuild(objects, cnt, 0, _nodes);
+        _mutations = 0;
+    }
+    return self;
+}
+
+#pragma mark NSArray
+
+- (NSUInteger)count
+{
+    return FTNodeSize(_root);
+}
+
+- (id)objectAtIndex:(NSUInteger)index
+{
+    FTNode *node = FTNodeAtIndex(_root, index);
+    if (node == nil) {
+        [NSException raise:NSRangeException format:@"*** %s: index %lu beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, (unsigned long)index, (unsigned long)FTNodeSize(_root)];
+    }
+    return node->_object;
+}
+
+- (void)getObjects:(id __unsafe_unretained[])objects range:(NSRange)range
+{
+    if (NSMaxRange(range) > FTNodeSize(_root)) {
+        [NSException raise:NSRangeException format:@"*** %s: range %@ beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, NSStringFromRange(range), (unsigned long)FTNodeSize(_root)];
+    }
+
+    FTNode *node = range.length > 0 ? FTNodeAtIndex(_root, range.location) : nil;
+    for (NSUInteger i = 0; i < range.length; i++) {
+        objects[i] = node->_object;
+        node = FTNodeSuccessor(node);
+    }
+}
+
+- (BOOL)containsObject:(id)anObject
+{
+    return [_nodes objectForKey:anObject] != nil;
+}
+
+- (NSUInteger)indexOfObject:(id)anObject
+{
+    FTNode *node = [_nodes objectForKey:anObject];
+    return node ? FTNodeRank(node) : NSNotFound;
+}
+
+- (NSUInteger)indexOfObject:(id)obj
+              inSortedRange:(NSRange)range
+                    options:(NSBinarySearchingOptions)opts
+            usingComparator:(NSComparator)cmp
+{
+    if (NSMaxRange(range) > FTNodeSize(_root)) {
+        [NSException raise:NSRangeException format:@"*** %s: range %@ beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, NSStringFromRange(range), (unsigned long)FTNodeSize(_root)];
+    }
+
+    if ((opts & NSBinarySearchingFirstEqual) && (opts & NSBinarySearchingLastEqual)) {
+        [NSException raise:NSInvalidArgumentException format:@"*** %s: both NSBinarySearchingFirstEqual and NSBinarySearchingLastEqual options cannot be specified.", __PRETTY_FUNCTION__];
+    }
+
+    BOOL lastEqual = (opts & NSBinarySearchingLastEqual) != 0;
+
+    // Find the number of objects ordered before the object (lower bound) or the
+    // number of objects not ordered after the object (upper bound).
+
+    NSUInteger bound = 0;
+    FTNode *node = _root;
+    while (node) {
+        NSComparisonResult result = cmp(node->_object, obj);
+        BOOL descendRight = lastEqual ? result != NSOrderedDescending : result == NSOrderedAscending;
+        if (descendRight) {
+            bound += FTNodeSize(node->_left) + 1;
+            node = node->_right;
+        } else {
+            node = node->_left;
+        }
+    }
+
+    bound = MIN(MAX(bound, range.location), NSMaxRange(range));
+
+    if (opts & NSBinarySearchingInsertionIndex) {
+        return bound;
+    }
+
+    NSUInteger index = lastEqual ? bound - 1 : bound;
+    if ((lastEqual && bound == range.location) || (!lastEqual && bound == NSMaxRange(range))) {
+        return NSNotFound;
+    }
+
+    return cmp(FTNodeAtIndex(_root, index)->_object, obj) == NSOrderedSame ? index : NSNotFound;
+}
+
+- (void)enumerateObjectsUsingBlock:(void (^)(id obj, NSUInteger idx, BOOL *stop))block
+{
+    BOOL stop = NO;
+    NSUInteger index = 0;
+    FTNode *node = FTNodeAtIndex(_root, 0);
+    while (node && !stop) {
+        block(node->_object, index, &stop);
+        node = FTNodeSuccessor(node);
+        index++;
+    }
+}
+
+- (NSEnumerator *)objectEnumerator
+{
+    return [[FTOrderStatisticTreeEnumerator alloc] initWithNode:FTNodeAtIndex(_root, 0)];
+}
+
+#pragma mark NSFastEnumeration
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
+                                  objects:(id __unsafe_unretained[])buffer
+                                    count:(NSUInteger)len
+{
+    // The next node is kept in the state between the calls. The nodes are
+    // not changed during the enumeration, because mutating the tree raises
+    // an exception (see mutationsPtr).
+
+    FTNode *node = nil;
+    if (state->state == 0) {
+        node = FTNodeAtIndex(_root, 0);
+        state->mutationsPtr = &_mutations;
+    } else {
+        node = (__bridge FTNode *)(void *)state->extra[0];
+    }
+
+    NSUInteger length = 0;
+    while (node && length < len) {
+        buffer[length++] = node->_object;
+        node = FTNodeSuccessor(node);
+    }
+
+    state->state += length;
+    state->extra[0] = (unsigned long)(__bridge void *)node;
+    state->itemsPtr = buffer;
+
+    return length;
+}
+
+#pragma mark NSMutableArray
+
+- (void)insertObject:(id)anObject atIndex:(NSUInteger)index
+{
+    if (index > FTNodeSize(_root)) {
+        [NSException raise:NSRangeException format:@"*** %s: index %lu beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, (unsigned long)index, (unsigned long)FTNodeSize(_root)];
+    }
+
+    NSAssert([_nodes objectForKey:anObject] == nil, @"Objects in an order statistic tree must be unique.");
+
+    FTNode *node = [[FTNode alloc] init];
+    node->_object = anObject;
+    node->_priority = FTNodeRandomPriority();
+    node->_size = 1;
+
+    FTNode *left = nil;
+    FTNode *right = nil;
+    FTNodeSplit(_root, index, &left, &right);
+
+    _root = FTNodeMerge(FTNodeMerge(left, node), right);
+    _root->_parent = nil;
+
+    [_nodes setObject:node forKey:anObject];
+    _mutations++;
+}
+
+- (void)removeObjectAtIndex:(NSUInteger)index
+{
+    FTNode *node = FTNodeAtIndex(_root, index);
+    if (node == nil) {
+        [NSException raise:NSRangeException format:@"*** %s: index %lu beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, (unsigned long)index, (unsigned long)FTNodeSize(_root)];
+    }
+
+    FTNode *parent = node->_parent;
+    FTNode *child = FTNodeMerge(node->_left, node->_right);
+
+    if (child) {
+        child->_parent = parent;
+    }
+
+    if (parent == nil) {
+        _root = child;
+    } else if (parent->_left == node) {
+        parent->_left = child;
+    } else {
+        parent->_right = child;
+    }
+
+    for (FTNode *ancestor = parent; ancestor; ancestor = ancestor->_parent) {
+        ancestor->_size--;
+    }
+
+    if ([_nodes objectForKey:node->_object] == node) {
+        [_nodes removeObjectForKey:node->_object];
+    }
+
+    node->_left = nil;
+    node->_right = nil;
+    node->_parent = nil;
+
+    _mutations++;
+}
+
+- (void)addObject:(id)anObject
+{
+    [self insertObject:anObject atIndex:FTNodeSize(_root)];
+}
+
+- (void)removeLastObject
+{
+    if (_root) {
+        [self removeObjectAtIndex:FTNodeSize(_root) - 1];
+    }
+}
+
+- (void)replaceObjectAtIndex:(NSUInteger)index withObject:(id)anObject
+{
+    FTNode *node = FTNodeAtIndex(_root, index);
+    if (node == nil) {
+        [NSException raise:NSRangeException format:@"*** %s: index %lu beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, (unsigned long)index, (unsigned long)FTNodeSize(_root)];
+    }
+
+    if ([_nodes objectForKey:node->_object] == node) {
+        [_nodes removeObjectForKey:node->_object];
+    }
+
+    node->_object = anObject;
+    [_nodes setObject:node forKey:anObject];
+
+    _mutations++;
+}
+
+- (void)removeAllObjects
+{
+    _root = nil;
+    [_nodes removeAllObjects];
+    _mutations++;
+}
+
+- (void)setArray:(NSArray *)otherArray
+{
+    [self ft_rebuildWithArray:otherArray];
+}
+
+#pragma mark Sorting
+
+// The default implementations of the sort methods are replacing the objects
+// one by one, which would temporarily break the uniqueness of the objects.
+// Instead, the sorted objects are used to rebuild the tree in O(n).
+
+- (void)sortUsingComparator:(NSComparator)cmptr
+{
+    [self ft_rebuildWithArray:[[NSArray arrayWithArray:self] sortedArrayUsingComparator:cmptr]];
+}
+
+- (void)sortWithOptions:(NSSortOptions)opts usingComparator:(NSComparator)cmptr
+{
+    [self ft_rebuildWithArray:[[NSArray arrayWithArray:self] sortedArrayWithOptions:opts usingComparator:cmptr]];
+}
+
+- (void)sortUsingDescriptors:(NSArray *)sortDescriptors
+{
+    [self ft_rebuildWithArray:[[NSArray arrayWithArray:self] sortedArrayUsingDescriptors:sortDescriptors]];
+}
+
+- (void)sortUsingFunction:(NSInteger (*)(id, id, void *))compare context:(void *)context
+{
+    [self ft_rebuildWithArray:[[NSArray arrayWithArray:self] sortedArrayUsingFunction:compare context:context]];
+}
+
+- (void)sortUsingSelector:(SEL)comparator
+{
+    [self ft_rebuildWithArray:[[NSArray arrayWithArray:self] sortedArrayUsingSelector:comparator]];
+}
+
+- (void)ft_rebuildWithArray:(NSArray *)array
+{
+    NSUInteger count = [array count];
+    id __unsafe_unretained *objects = (id __unsafe_unretained *)calloc(MAX(count, 1), sizeof(id));
+    [array getObjects:objects range:NSMakeRange(0, count)];
+
+    [_nodes removeAllObjects];
+    _root = FTNodeBuild(objects, count, 0, _nodes);
+    _mutations++;
+
+    free(objects);
+}
+
+#pragma mark NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    return [[NSArray alloc] initWithArray:self];
+}
+
+#pragma mark NSMutableCopying
+
+- (id)mutableCopyWithZone:(NSZone *)zone
+{
+    return [[FTOrderStatisticTree alloc] initWithArray:self];
+}
+
+#pragma mark NSCoding
+
+- (Class)classForCoder
+{
+    return [NSMutableArray class];
+}
+
+@end
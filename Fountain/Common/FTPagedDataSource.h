@@ -0,0 +1,64 @@
+//
+//  FTPagedDataSource.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 03.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FTPagingDataSource.h"
+#import "FTPrefetchingDataSource.h"
+#import "FTReverseDataSource.h"
+
+// The completion handler of a page loader can be called on any thread. An empty page marks the end of the pages.
+typedef void (^FTPagedDataSourceCompletionHandler)(NSArray *items, NSError *error);
+typedef void (^FTPagedDataSourcePageLoader)(NSInteger page, FTPagedDataSourceCompletionHandler completionHandler);
+
+/*! <code>FTPagedDataSource</code> is a data source with one section, which contains the items
+    of consecutive pages loaded with a page loader block.
+
+    Pages are loaded, if an item within the <code>prefetchDistance</code> of the first or last
+    item is displayed or prefetched. Multiple pages can be loaded at the same time, but each
+    page is only requested once while it is loading. Loaded pages are spliced in as soon as they
+    are adjacent to the pages already in the data source, each as one batch inserting the range
+    of the items of the page.
+
+    At most <code>maximumNumberOfPages</code> pages are kept. If more pages are loaded, the pages
+    behind the last displayed item in the scrolling direction are removed and can be loaded again.
+
+    The data source and the observers are used on the main queue.
+ */
+@interface FTPagedDataSource : NSObject <FTPagingDataSource, FTPrefetchingDataSource, FTReverseDataSource>
+
+#pragma mark Life-cycle
+- (instancetype)initWithPageLoader:(FTPagedDataSourcePageLoader)pageLoader;
+- (instancetype)initWithPageLoader:(FTPagedDataSourcePageLoader)pageLoader firstPage:(NSInteger)firstPage;
+
+#pragma mark Page Loader
+@property (nonatomic, readonly) FTPagedDataSourcePageLoader pageLoader;
+@property (nonatomic, readonly) NSInteger firstPage;
+
+#pragma mark Prefetch Distance
+
+// Number of items before the first or after the last item, at which loading the next page starts. Defaults to 20.
+@property (nonatomic, readwrite) NSUInteger prefetchDistance;
+
+#pragma mark Page Cache
+
+// Defaults to 10. At least two pages are kept.
+@property (nonatomic, readwrite) NSUInteger maximumNumberOfPages;
+
+// The pages, which are currently in the data source.
+@property (nonatomic, readonly) NSInteger firstLoadedPage;
+@property (nonatomic, readonly) NSUInteger numberOfLoadedPages;
+
+- (BOOL)isLoadingPage:(NSInteger)page;
+
+#pragma mark Loading Pages
+
+// Loads the first page, if no page has been loaded yet.
+- (void)loadFirstPageWithCompletionHandler:(void (^)(BOOL success, NSError *error))completionHandler;
+
+@end
@@ -0,0 +1,458 @@
+//
+//  FTPagedDataSource.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 03.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTChangeSet.h"
+#import "FTDataSourceObserver.h"
+#import "FTObserverRegistry.h"
+
+#import "FTPagedDataSource.h"
+
+@interface FTPagedDataSource () {
+    FTObserverRegistry *_observers;
+
+    // The items of the loaded pages. The pages are consecutive, starting
+    // with the page at _firstLoadedPage.
+    NSMutableArray *_pages;
+    NSUInteger _numberOfItems;
+
+    // Pages, which have been loaded, but are not yet adjacent to the loaded pages
+    NSMutableDictionary *_completedPages;
+
+    // The completion handlers of the pages, which are currently loading
+    NSMutableDictionary *_completionHandlers;
+
+    // The first page, which is known to be empty (NSIntegerMax until the end is known)
+    NSInteger _endPage;
+
+    NSUInteger _lastDisplayedIndex;
+    BOOL _scrollingBackward;
+}
+
+@end
+
+@implementation FTPagedDataSource
+
+#pragma mark Life-cycle
+
+- (instancetype)initWithPageLoader:(FTPagedDataSourcePageLoader)pageLoader
+{
+    return [self initWithPageLoader:pageLoader firstPage:0];
+}
+
+- (instancetype)initWithPageLoader:(FTPagedDataSourcePageLoader)pageLoader firstPage:(NSInteger)firstPage
+{
+    self = [super init];
+    if (self) {
+        _pageLoader = [pageLoader copy];
+        _firstPage = firstPage;
+        _firstLoadedPage = firstPage;
+        _prefetchDistance = 20;
+        _maximumNumberOfPages = 10;
+
+        _observers = [[FTObserverRegistry alloc] init];
+        _pages = [[NSMutableArray alloc] init];
+        _completedPages = [[NSMutableDictionary alloc] init];
+        _completionHandlers = [[NSMutableDictionary alloc] init];
+        _endPage = NSIntegerMax;
+    }
+    return self;
+}
+
+#pragma mark Page Cache
+
+- (void)setMaximumNumberOfPages:(NSUInteger)maximumNumberOfPages
+{
+    _maximumNumberOfPages = MAX(maximumNumberOfPages, 2);
+    [self ft_removePagesBeyondLimit];
+}
+
+- (NSUInteger)numberOfLoadedPages
+{
+    return [_pages count];
+}
+
+- (BOOL)isLoadingPage:(NSInteger)page
+{
+    return _completionHandlers[@(page)] != nil;
+}
+
+#pragma mark Loading Pages
+
+- (void)loadFirstPageWithCompletionHandler:(void (^)(BOOL success, NSError *error))completionHandler
+{
+    [self ft_loadPage:_firstPage completionHandler:completionHandler];
+}
+
+- (BOOL)ft_isLoadedPage:(NSInteger)page
+{
+    if (_completedPages[@(page)] != nil) {
+        return YES;
+    }
+    return [_pages count] > 0 && page >= _firstLoadedPage && page < _firstLoadedPage + (NSInteger)[_pages count];
+}
+
+- (void)ft_loadPage:(NSInteger)page completionHandler:(void (^)(BOOL success, NSError *error))completionHandler
+{
+    if (page < _firstPage || page >= _endPage || [self ft_isLoadedPage:page]) {
+        if (completionHandler) {
+            completionHandler(YES, nil);
+        }
+        return;
+    }
+
+    // Requests for a page, which is already loading, only wait for the
+    // pending request.
+
+    NSMutableArray *completionHandlers = _completionHandlers[@(page)];
+    BOOL loading = completionHandlers != nil;
+    if (completionHandlers == nil) {
+        completionHandlers = [[NSMutableArray alloc] init];
+        _completionHandlers[@(page)] = completionHandlers;
+    }
+
+    if (completionHandler) {
+        [completionHandlers addObject:[completionHandler copy]];
+    }
+
+    if (loading == NO) {
+        __weak FTPagedDataSource *weakSelf = self;
+        _pageLoader(page, ^(NSArray *items, NSError *error) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [weakSelf ft_didLoadItems:items ofPage:page error:error];
+            });
+        });
+    }
+}
+
+- (void)ft_didLoadItems:(NSArray *)items ofPage:(NSInteger)page error:(NSError *)error
+{
+    NSArray *completionHandlers = _completionHandlers[@(page)];
+    [_completionHandlers removeObjectForKey:@(page)];
+
+    if (error == nil) {
+        if ([items count] == 0) {
+            _endPage = MIN(_endPage, page);
+        } else {
+            _completedPages[@(page)] = [items copy];
+            [self ft_spliceCompletedPages];
+            [self ft_removePagesBeyondLimit];
+        }
+    }
+
+    for (void (^completionHandler)(BOOL success, NSError *error) in completionHandlers) {
+        completionHandler(error == nil, error);
+    }
+}
+
+#pragma mark Prefetching Pages
+
+- (void)ft_prefetchPagesAroundIndex:(NSUInteger)index
+{
+    if (index != _lastDisplayedIndex) {
+        _scrollingBackward = index < _lastDisplayedIndex;
+    }
+    _lastDisplayedIndex = index;
+
+    if ([_pages count] == 0) {
+        return;
+    }
+
+    // The number of pages needed to cover the prefetch distance is estimated
+    // based on the average size of the loaded pages.
+
+    NSUInteger averagePageSize = MAX(_numberOfItems / [_pages count], 1);
+    NSInteger maximumNumberOfPages = _maximumNumberOfPages - 1;
+
+    if (index + _prefetchDistance >= _numberOfItems) {
+        NSUInteger missingItems = index + _prefetchDistance + 1 - _numberOfItems;
+        NSInteger numberOfPages = MIN((missingItems + averagePageSize - 1) / averagePageSize, maximumNumberOfPages);
+        NSInteger nextPage = _firstLoadedPage + [_pages count];
+        for (NSInteger page = nextPage; page < nextPage + numberOfPages; page++) {
+            [self ft_loadPage:page completionHandler:nil];
+        }
+    }
+
+    if (index < _prefetchDistance) {
+        NSUInteger missingItems = _prefetchDistance - index;
+        NSInteger numberOfPages = MIN((missingItems + averagePageSize - 1) / averagePageSize, maximumNumberOfPages);
+        for (NSInteger page = _firstLoadedPage - 1; page >= _firstLoadedPage - numberOfPages; page--) {
+            [self ft_loadPage:page completionHandler:nil];
+        }
+    }
+}
+
+#pragma mark Splicing Pages
+
+- (void)ft_spliceCompletedPages
+{
+    if ([_pages count] == 0) {
+        NSNumber *page = [[[_completedPages allKeys] sortedArrayUsingSelector:@selector(compare:)] firstObject];
+        if (page == nil) {
+            return;
+        }
+        [self ft_insertItems:_completedPages[page] ofPage:[page integerValue]];
+        [_completedPages removeObjectForKey:page];
+    }
+
+    NSArray *items = nil;
+    while ((items = _completedPages[@(_firstLoadedPage - 1)])) {
+        [_completedPages removeObjectForKey:@(_firstLoadedPage - 1)];
+        [self ft_insertItems:items ofPage:_firstLoadedPage - 1];
+    }
+
+    while ((items = _completedPages[@(_firstLoadedPage + (NSInteger)[_pages count])])) {
+        [_completedPages removeObjectForKey:@(_firstLoadedPage + (NSInteger)[_pages count])];
+        [self ft_insertItems:items ofPage:_firstLoadedPage + [_pages count]];
+    }
+}
+
+- (void)ft_insertItems:(NSArray *)items ofPage:(NSInteger)page
+{
+    BOOL prepend = [_pages count] > 0 && page < _firstLoadedPage;
+    NSRange range = NSMakeRange(prepend ? 0 : _numberOfItems, [items count]);
+
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+    [changeSet insertItemsAtIndexes:[NSIndexSet indexSetWithIndexesInRange:range] inSection:0];
+
+    [self ft_applyChangeSet:changeSet
+                 usingBlock:^{
+                     if (prepend) {
+                         [_pages insertObject:items atIndex:0];
+                         _lastDisplayedIndex += [items count];
+                     } else {
+                         [_pages addObject:items];
+                     }
+                     if (prepend || [_pages count] == 1) {
+                         _firstLoadedPage = page;
+                     }
+                     _numberOfItems += [items count];
+                 }];
+}
+
+- (void)ft_removePagesBeyondLimit
+{
+    while ([_pages count] > _maximumNumberOfPages) {
+
+        // Remove the page behind the last displayed item in the scrolling
+        // direction, unless it contains the last displayed item.
+
+        NSUInteger lastDisplayedIndex = MIN(_lastDisplayedIndex, _numberOfItems - 1);
+        BOOL removeFirst = NO;
+        if (_scrollingBackward) {
+            removeFirst = lastDisplayedIndex >= _numberOfItems - [[_pages lastObject] count];
+        } else {
+            removeFirst = lastDisplayedIndex >= [[_pages firstObject] count];
+        }
+
+        NSArray *items = removeFirst ? [_pages firstObject] : [_pages lastObject];
+        NSRange range = NSMakeRange(removeFirst ? 0 : _numberOfItems - [items count], [items count]);
+
+        FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+        [changeSet deleteItemsAtIndexes:[NSIndexSet indexSetWithIndexesInRange:range] inSection:0];
+
+        [self ft_applyChangeSet:changeSet
+                     usingBlock:^{
+                         if (removeFirst) {
+                             [_pages removeObjectAtIndex:0];
+                             _firstLoadedPage++;
+                             _lastDisplayedIndex -= MIN([items count], _lastDisplayedIndex);
+                         } else {
+                             [_pages removeLastObject];
+                         }
+                         _numberOfItems -= [items count];
+                     }];
+    }
+
+    // Pages, which have been loaded ahead, are dropped, if they are too far
+    // away from the loaded pages.
+
+    NSInteger lowestPage = _firstLoadedPage - (NSInteger)_maximumNumberOfPages;
+    NSInteger highestPage = _firstLoadedPage + (NSInteger)[_pages count] + (NSInteger)_maximumNumberOfPages;
+    for (NSNumber *page in [_completedPages allKeys]) {
+        if ([page integerValue] < lowestPage || [page integerValue] > highestPage) {
+            [_completedPages removeObjectForKey:page];
+        }
+    }
+}
+
+- (void)ft_applyChangeSet:(FTChangeSet *)changeSet usingBlock:(void (^)(void))block
+{
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodWillChange) {
+            [observer dataSourceWillChange:self];
+        }
+    }];
+
+    block();
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidApplyChangeSet) {
+            [(id<FTDataSourceChangeSetObserver>)observer dataSource:self didApplyChangeSet:changeSet];
+        } else {
+            [changeSet notifyObserver:observer implementingMethods:methods ofChangesInDataSource:self];
+        }
+    }];
+
+    [_observers enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        if (methods & FTDataSourceObserverMethodDidChange) {
+            [observer dataSourceDidChange:self];
+        }
+    }];
+}
+
+#pragma mark FTPagingDataSource
+
+- (BOOL)hasItemsBeforeFirstItem
+{
+    return [_pages count] > 0 && _firstLoadedPage > _firstPage;
+}
+
+- (void)loadMoreItemsBeforeFirstItemCompletionHandler:(void (^)(BOOL success, NSError *error))completionHandler
+{
+    _lastDisplayedIndex = 0;
+    _scrollingBackward = YES;
+    if ([_pages count] == 0) {
+        [self ft_loadPage:_firstPage completionHandler:completionHandler];
+    } else {
+        [self ft_loadPage:_firstLoadedPage - 1 completionHandler:completionHandler];
+    }
+}
+
+- (BOOL)hasItemsAfterLastItem
+{
+    if ([_pages count] == 0) {
+        return _firstPage < _endPage;
+    } else {
+        return _firstLoadedPage + (NSInteger)[_pages count] < _endPage;
+    }
+}
+
+- (void)loadMoreItemsAfterLastItemCompletionHandler:(void (^)(BOOL success, NSError *error))completionHandler
+{
+    _lastDisplayedIndex = _numberOfItems > 0 ? _numberOfItems - 1 : 0;
+    _scrollingBackward = NO;
+    if ([_pages count] == 0) {
+        [self ft_loadPage:_firstPage completionHandler:completionHandler];
+    } else {
+        [self ft_loadPage:_firstLoadedPage + [_pages count] completionHandler:completionHandler];
+    }
+}
+
+#pragma mark FTPrefetchingDataSource
+
+- (void)prefetchItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    for (NSIndexPath *indexPath in indexPaths) {
+        if ([indexPath length] == 2 && [indexPath indexAtPosition:0] == 0) {
+            [self ft_prefetchPagesAroundIndex:[indexPath indexAtPosition:1]];
+        }
+    }
+}
+
+- (void)cancelPrefetchingForItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    // Pages, which are loading, are kept for later use.
+}
+
+#pragma mark FTDataSource
+
+#pragma mark Getting Item and Section Metrics
+
+- (NSUInteger)numberOfSections
+{
+    return 1;
+}
+
+- (NSUInteger)numberOfItemsInSection:(NSUInteger)section
+{
+    if (section != 0) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. 1].", __PRETTY_FUNCTION__, (long)section];
+    }
+
+    return _numberOfItems;
+}
+
+#pragma mark Getting Items and Sections
+
+- (id)sectionItemForSection:(NSUInteger)section
+{
+    if (section != 0) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. 1].", __PRETTY_FUNCTION__, (long)section];
+    }
+
+    return nil;
+}
+
+- (id)itemAtIndexPath:(NSIndexPath *)indexPath
+{
+    if ([indexPath length] != 2) {
+        [NSException raise:NSInvalidArgumentException format:@"*** %s: length of index path must be 2, got an index path with length %lu.", __PRETTY_FUNCTION__, (unsigned long)[indexPath length]];
+    }
+
+    NSUInteger section = [indexPath indexAtPosition:0];
+    NSUInteger item = [indexPath indexAtPosition:1];
+
+    if (section != 0) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. 1].", __PRETTY_FUNCTION__, (long)section];
+    }
+
+    if (item >= _numberOfItems) {
+        [NSException raise:NSRangeException format:@"*** %s: index %ld beyond bounds [0 .. %ld].", __PRETTY_FUNCTION__, (long)item, (long)_numberOfItems];
+    }
+
+    for (NSArray *items in _pages) {
+        if (item < [items count]) {
+            return items[item];
+        }
+        item -= [items count];
+    }
+
+    return nil;
+}
+
+#pragma mark Observer
+
+- (NSArray *)observers
+{
+    return [_observers observers];
+}
+
+- (void)addObserver:(id<FTDataSourceObserver>)observer
+{
+    [_observers addObserver:observer];
+}
+
+- (void)removeObserver:(id<FTDataSourceObserver>)observer
+{
+    [_observers removeObserver:observer];
+}
+
+#pragma mark FTReverseDataSource
+
+- (NSIndexSet *)sectionsOfSectionItem:(id)sectionItem
+{
+    return [NSIndexSet indexSet];
+}
+
+- (NSArray *)indexPathsOfItem:(id)item
+{
+    NSMutableArray *indexPaths = [[NSMutableArray alloc] init];
+    NSUInteger offset = 0;
+    for (NSArray *items in _pages) {
+        [items enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+            if ([obj isEqual:item]) {
+                NSUInteger indexes[] = {0, offset + idx};
+                [indexPaths addObject:[NSIndexPath indexPathWithIndexes:indexes length:2]];
+            }
+        }];
+        offset += [items count];
+    }
+    return indexPaths;
+}
+
+@end
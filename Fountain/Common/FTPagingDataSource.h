@@ -16,4 +16,10 @@
 - (BOOL)hasItemsAfterLastItem;
 - (void)loadMoreItemsAfterLastItemCompletionHandler:(void (^)(BOOL success, NSError *error))completionHandler;
 
+@optional
+
+// Number of items before the first or after the last item, at which the adapters
+// start loading more items. Without it, loading starts at the first or last item.
+- (NSUInteger)prefetchDistance;
+
 @end
@@ -0,0 +1,27 @@
+//
+//  FTPrefetchingDataSource.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 02.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTDataSource.h"
+
+/*! A data source conforming to <code>FTPrefetchingDataSource</code> can load items ahead of
+    their use. The index paths are only hints: prefetching an item does not change the data
+    source and items are always available via <code>itemAtIndexPath:</code>, regardless of
+    whether they have been prefetched.
+ */
+@protocol FTPrefetchingDataSource <FTDataSource>
+
+#pragma mark Prefetching Items
+
+// Starts loading the items at the index paths, which are likely to be accessed soon.
+// Index paths beyond the bounds of the data source are ignored.
+- (void)prefetchItemsAtIndexPaths:(NSArray *)indexPaths;
+
+// Cancels the prefetching of the items at the index paths, which are no longer needed.
+- (void)cancelPrefetchingForItemsAtIndexPaths:(NSArray *)indexPaths;
+
+@end
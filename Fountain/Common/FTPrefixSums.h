@@ -0,0 +1,43 @@
+//
+//  FTPrefixSums.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 26.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/*! <code>FTPrefixSums</code> stores a sequence of values in a binary indexed (Fenwick) tree.
+
+    Changing a value, getting the sum of the values in front of an index and finding the
+    index, which covers a position in the accumulated values, is done in O(log n).
+    Inserting or removing a value rebuilds the tree in O(n).
+ */
+@interface FTPrefixSums : NSObject <NSCopying>
+
+#pragma mark Life-cycle
+- (instancetype)initWithValues:(const NSUInteger *)values count:(NSUInteger)count;
+
+#pragma mark Values
+@property (nonatomic, readonly) NSUInteger count;
+- (NSUInteger)valueAtIndex:(NSUInteger)index;
+- (void)setValue:(NSUInteger)value atIndex:(NSUInteger)index;
+- (void)addValue:(NSInteger)value toValueAtIndex:(NSUInteger)index;
+
+#pragma mark Inserting and Removing Values
+- (void)insertValue:(NSUInteger)value atIndex:(NSUInteger)index;
+- (void)removeValueAtIndex:(NSUInteger)index;
+- (void)removeAllValues;
+
+#pragma mark Prefix Sums
+@property (nonatomic, readonly) NSUInteger totalSum;
+- (NSUInteger)sumOfValuesBeforeIndex:(NSUInteger)index;
+
+// Returns the index of the value, which covers the position, if the values are
+// laid out one after the other. The offset is set to the position relative to
+// the start of that value. Values of 0 never cover a position. For positions
+// beyond the total sum, the count is returned.
+- (NSUInteger)indexOfPosition:(NSUInteger)position offset:(NSUInteger *)offset;
+
+@end
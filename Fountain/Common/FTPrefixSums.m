@@ -0,0 +1,179 @@
+//
+//  FTPrefixSums.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 26.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTPrefixSums.h"
+
+@implementation FTPrefixSums {
+    NSMutableData *_values;
+    NSMutableData *_tree;
+    NSUInteger _count;
+    NSUInteger _totalSum;
+}
+
+#pragma mark Life-cycle
+
+- (instancetype)init
+{
+    return [self initWithValues:NULL count:0];
+}
+
+- (instancetype)initWithValues:(const NSUInteger *)values count:(NSUInteger)count
+{
+    self = [super init];
+    if (self) {
+        _values = values ? [[NSMutableData alloc] initWithBytes:values length:count * sizeof(NSUInteger)]
+                         : [[NSMutableData alloc] initWithLength:count * sizeof(NSUInteger)];
+        _count = count;
+        [self ft_rebuildTree];
+    }
+    return self;
+}
+
+#pragma mark Values
+
+- (NSUInteger)valueAtIndex:(NSUInteger)index
+{
+    if (index >= _count) {
+        [NSException raise:NSRangeException format:@"*** %s: index %lu beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, (unsigned long)index, (unsigned long)_count];
+    }
+
+    const NSUInteger *values = [_values bytes];
+    return values[index];
+}
+
+- (void)setValue:(NSUInteger)value atIndex:(NSUInteger)index
+{
+    NSUInteger currentValue = [self valueAtIndex:index];
+    [self addValue:(NSInteger)(value - currentValue) toValueAtIndex:index];
+}
+
+- (void)addValue:(NSInteger)value toValueAtIndex:(NSUInteger)index
+{
+    if (index >= _count) {
+        [NSException raise:NSRangeException format:@"*** %s: index %lu beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, (unsigned long)index, (unsigned long)_count];
+    }
+
+    NSUInteger *values = [_values mutableBytes];
+    values[index] += value;
+    _totalSum += value;
+
+    NSUInteger *tree = [_tree mutableBytes];
+    for (NSUInteger i = index + 1; i <= _count; i += i & (~i + 1)) {
+        tree[i] += value;
+    }
+}
+
+#pragma mark Inserting and Removing Values
+
+- (void)insertValue:(NSUInteger)value atIndex:(NSUInteger)index
+{
+    if (index > _count) {
+        [NSException raise:NSRangeException format:@"*** %s: index %lu beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, (unsigned long)index, (unsigned long)_count];
+    }
+
+    [_values replaceBytesInRange:NSMakeRange(index * sizeof(NSUInteger), 0) withBytes:&value length:sizeof(NSUInteger)];
+    _count++;
+    [self ft_rebuildTree];
+}
+
+- (void)removeValueAtIndex:(NSUInteger)index
+{
+    if (index >= _count) {
+        [NSException raise:NSRangeException format:@"*** %s: index %lu beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, (unsigned long)index, (unsigned long)_count];
+    }
+
+    [_values replaceBytesInRange:NSMakeRange(index * sizeof(NSUInteger), sizeof(NSUInteger)) withBytes:NULL length:0];
+    _count--;
+    [self ft_rebuildTree];
+}
+
+- (void)removeAllValues
+{
+    [_values setLength:0];
+    _count = 0;
+    [self ft_rebuildTree];
+}
+
+#pragma mark Prefix Sums
+
+- (NSUInteger)sumOfValuesBeforeIndex:(NSUInteger)index
+{
+    if (index > _count) {
+        [NSException raise:NSRangeException format:@"*** %s: index %lu beyond bounds [0 .. %lu].", __PRETTY_FUNCTION__, (unsigned long)index, (unsigned long)_count];
+    }
+
+    const NSUInteger *tree = [_tree bytes];
+
+    NSUInteger sum = 0;
+    for (NSUInteger i = index; i > 0; i -= i & (~i + 1)) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+- (NSUInteger)indexOfPosition:(NSUInteger)position offset:(NSUInteger *)offset
+{
+    const NSUInteger *tree = [_tree bytes];
+
+    // Descend the implicit tree, starting with the largest power of two
+    // not greater than the count. After the loop, index is the number of
+    // values, which end in front of or at the position.
+
+    NSUInteger mask = 1;
+    while (mask <= _count / 2) {
+        mask <<= 1;
+    }
+
+    NSUInteger index = 0;
+    for (; mask > 0 && _count > 0; mask >>= 1) {
+        NSUInteger next = index + mask;
+        if (next <= _count && tree[next] <= position) {
+            index = next;
+            position -= tree[next];
+        }
+    }
+
+    if (offset) {
+        *offset = position;
+    }
+
+    return index;
+}
+
+#pragma mark Tree
+
+- (void)ft_rebuildTree
+{
+    // The tree is 1-based. Each node i contains the sum of
+    // the values in the range (i - lowbit(i), i].
+
+    _tree = [[NSMutableData alloc] initWithLength:(_count + 1) * sizeof(NSUInteger)];
+
+    const NSUInteger *values = [_values bytes];
+    NSUInteger *tree = [_tree mutableBytes];
+
+    _totalSum = 0;
+    for (NSUInteger i = 1; i <= _count; i++) {
+        tree[i] += values[i - 1];
+        _totalSum += values[i - 1];
+
+        NSUInteger parent = i + (i & (~i + 1));
+        if (parent <= _count) {
+            tree[parent] += tree[i];
+        }
+    }
+}
+
+#pragma mark NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    return [[FTPrefixSums alloc] initWithValues:[_values bytes] count:_count];
+}
+
+@end
@@ -0,0 +1,59 @@
+//
+//  FTPrepareHandlerRegistry.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 04.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class FTCompiledPredicate;
+
+@interface FTPrepareHandler : NSObject
+
+#pragma mark Life-cycle
+- (instancetype)initWithPredicate:(NSPredicate *)predicate
+                  reuseIdentifier:(NSString *)reuseIdentifier
+                            block:(id)block;
+
+#pragma mark Properties
+@property (nonatomic, readonly) NSString *reuseIdentifier;
+@property (nonatomic, readonly) NSPredicate *predicate;
+@property (nonatomic, readonly) FTCompiledPredicate *compiledPredicate;
+@property (nonatomic, readonly) id block;
+@property (nonatomic, strong) id prototype;
+
+#pragma mark Matching Items
+
+// The substitution variables are only requested, if the predicate uses them.
+- (BOOL)matchesItem:(id)item substitutionVariables:(NSDictionary * (^)(void))substitutionVariables;
+
+@end
+
+/*! <code>FTPrepareHandlerRegistry</code> resolves the first handler in the order of
+    registration, whose predicate matches an item.
+
+    The result of the handlers, whose predicates don't use substitution variables (like
+    <code>$SECTION</code> or <code>$ITEM</code>), are memoized. If these predicates only
+    check the class of the item, the result is memoized per class, otherwise per item
+    identity. Handlers using substitution variables are evaluated on each lookup. The
+    memoized results must be invalidated, if the items could have changed.
+ */
+@interface FTPrepareHandlerRegistry : NSObject
+
+#pragma mark Handlers
+@property (nonatomic, readonly) NSArray *handlers;
+- (void)addHandler:(FTPrepareHandler *)handler;
+
+#pragma mark Resolving Handlers
+- (FTPrepareHandler *)handlerForItem:(id)item substitutionVariables:(NSDictionary * (^)(void))substitutionVariables;
+
+#pragma mark Memoized Results
+
+// Number of items, for which the results are memoized, before all memoized results of items are discarded. Defaults to 1000.
+@property (nonatomic, readwrite) NSUInteger cacheLimit;
+
+- (void)invalidateCache;
+
+@end
@@ -0,0 +1,226 @@
+//
+//  FTPrepareHandlerRegistry.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 04.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <objc/runtime.h>
+
+#import "FTCompiledPredicate.h"
+
+#import "FTPrepareHandlerRegistry.h"
+
+static BOOL FTPrepareHandlerRegistryPredicateChecksClassOnly(NSPredicate *predicate);
+
+@implementation FTPrepareHandler
+
+#pragma mark Life-cycle
+
+- (instancetype)initWithPredicate:(NSPredicate *)predicate
+                  reuseIdentifier:(NSString *)reuseIdentifier
+                            block:(id)block
+{
+    self = [super init];
+    if (self) {
+        _predicate = predicate;
+        _compiledPredicate = [[FTCompiledPredicate alloc] initWithPredicate:predicate];
+        _reuseIdentifier = reuseIdentifier;
+        _block = block;
+    }
+    return self;
+}
+
+#pragma mark Matching Items
+
+- (BOOL)matchesItem:(id)item substitutionVariables:(NSDictionary * (^)(void))substitutionVariables
+{
+    NSDictionary *variables = _compiledPredicate.usesSubstitutionVariables ? substitutionVariables() : nil;
+    return [_compiledPredicate evaluateWithObject:item substitutionVariables:variables];
+}
+
+@end
+
+#pragma mark -
+
+@interface FTPrepareHandlerRegistry () {
+    NSMutableArray *_handlers;
+
+    // Index of the first handler without substitution variables, which does not
+    // only check the class of the item (or the number of handlers, if there is none).
+    NSUInteger _indexOfFirstItemHandler;
+
+    // The index of the first matching handler without substitution variables. The
+    // results per class only consider the handlers before _indexOfFirstItemHandler,
+    // if none of these handlers match, _indexOfFirstItemHandler is stored.
+    NSMapTable *_handlerIndexByClass;
+    NSMapTable *_handlerIndexByItem;
+}
+
+@end
+
+@implementation FTPrepareHandlerRegistry
+
+#pragma mark Life-cycle
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _handlers = [[NSMutableArray alloc] init];
+        _indexOfFirstItemHandler = 0;
+        _cacheLimit = 1000;
+        _handlerIndexByClass = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                         valueOptions:NSPointerFunctionsStrongMemory
+                                                             capacity:0];
+        _handlerIndexByItem = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                                        valueOptions:NSPointerFunctionsStrongMemory
+                                                            capacity:0];
+    }
+    return self;
+}
+
+#pragma mark Handlers
+
+- (NSArray *)handlers
+{
+    return [_handlers copy];
+}
+
+- (void)addHandler:(FTPrepareHandler *)handler
+{
+    if (_indexOfFirstItemHandler == [_handlers count]) {
+        if (handler.compiledPredicate.usesSubstitutionVariables ||
+            FTPrepareHandlerRegistryPredicateChecksClassOnly(handler.predicate)) {
+            _indexOfFirstItemHandler++;
+        }
+    }
+
+    [_handlers addObject:handler];
+
+    [_handlerIndexByClass removeAllObjects];
+    [_handlerIndexByItem removeAllObjects];
+}
+
+#pragma mark Resolving Handlers
+
+- (FTPrepareHandler *)handlerForItem:(id)item substitutionVariables:(NSDictionary * (^)(void))substitutionVariables
+{
+    NSUInteger numberOfHandlers = [_handlers count];
+    NSUInteger index = [self ft_indexOfFirstHandlerMatchingItem:item];
+
+    // Handlers using substitution variables can not be memoized and are
+    // evaluated, if they are before the memoized handler.
+
+    for (NSUInteger idx = 0; idx < MIN(index, numberOfHandlers); idx++) {
+        FTPrepareHandler *handler = _handlers[idx];
+        if (handler.compiledPredicate.usesSubstitutionVariables &&
+            [handler matchesItem:item substitutionVariables:substitutionVariables]) {
+            return handler;
+        }
+    }
+
+    return index < numberOfHandlers ? _handlers[index] : nil;
+}
+
+- (NSUInteger)ft_indexOfFirstHandlerMatchingItem:(id)item
+{
+    NSUInteger numberOfHandlers = [_handlers count];
+
+    if (item == nil) {
+        return [self ft_indexOfFirstHandlerMatchingItem:item inRange:NSMakeRange(0, numberOfHandlers)];
+    }
+
+    Class itemClass = object_getClass(item);
+    NSNumber *index = [_handlerIndexByClass objectForKey:itemClass];
+    if (index == nil) {
+        NSUInteger idx = [self ft_indexOfFirstHandlerMatchingItem:item inRange:NSMakeRange(0, _indexOfFirstItemHandler)];
+        index = @(idx == NSNotFound ? _indexOfFirstItemHandler : idx);
+        [_handlerIndexByClass setObject:index forKey:itemClass];
+    }
+
+    if ([index unsignedIntegerValue] < _indexOfFirstItemHandler) {
+        return [index unsignedIntegerValue];
+    } else if (_indexOfFirstItemHandler == numberOfHandlers) {
+        return NSNotFound;
+    }
+
+    index = [_handlerIndexByItem objectForKey:item];
+    if (index == nil) {
+        NSRange range = NSMakeRange(_indexOfFirstItemHandler, numberOfHandlers - _indexOfFirstItemHandler);
+        index = @([self ft_indexOfFirstHandlerMatchingItem:item inRange:range]);
+        if ([_handlerIndexByItem count] >= _cacheLimit) {
+            [_handlerIndexByItem removeAllObjects];
+        }
+        [_handlerIndexByItem setObject:index forKey:item];
+    }
+
+    return [index unsignedIntegerValue];
+}
+
+- (NSUInteger)ft_indexOfFirstHandlerMatchingItem:(id)item inRange:(NSRange)range
+{
+    for (NSUInteger idx = range.location; idx < NSMaxRange(range); idx++) {
+        FTPrepareHandler *handler = _handlers[idx];
+        if (handler.compiledPredicate.usesSubstitutionVariables == NO &&
+            [handler.compiledPredicate evaluateWithObject:item]) {
+            return idx;
+        }
+    }
+    return NSNotFound;
+}
+
+#pragma mark Memoized Results
+
+- (void)setCacheLimit:(NSUInteger)cacheLimit
+{
+    _cacheLimit = cacheLimit;
+    if ([_handlerIndexByItem count] > _cacheLimit) {
+        [_handlerIndexByItem removeAllObjects];
+    }
+}
+
+- (void)invalidateCache
+{
+    // The class of an item does not change, therefore only the results per item are discarded.
+    [_handlerIndexByItem removeAllObjects];
+}
+
+@end
+
+#pragma mark - Class Checks
+
+static BOOL FTPrepareHandlerRegistryPredicateChecksClassOnly(NSPredicate *predicate)
+{
+    if ([predicate isKindOfClass:[NSCompoundPredicate class]]) {
+        for (NSPredicate *subpredicate in [(NSCompoundPredicate *)predicate subpredicates]) {
+            if (FTPrepareHandlerRegistryPredicateChecksClassOnly(subpredicate) == NO) {
+                return NO;
+            }
+        }
+        return YES;
+    } else if ([predicate isKindOfClass:[NSComparisonPredicate class]]) {
+        NSComparisonPredicate *comparisonPredicate = (NSComparisonPredicate *)predicate;
+        NSExpression *lhs = comparisonPredicate.leftExpression;
+        NSExpression *rhs = comparisonPredicate.rightExpression;
+
+        if (rhs.expressionType != NSConstantValueExpressionType) {
+            return NO;
+        }
+
+        if (comparisonPredicate.predicateOperatorType == NSCustomSelectorPredicateOperatorType) {
+            SEL selector = comparisonPredicate.customSelector;
+            return lhs.expressionType == NSEvaluatedObjectExpressionType &&
+                   (selector == @selector(isKindOfClass:) || selector == @selector(isMemberOfClass:));
+        } else {
+            return lhs.expressionType == NSKeyPathExpressionType &&
+                   lhs.operand.expressionType == NSEvaluatedObjectExpressionType &&
+                   [lhs.keyPath isEqualToString:@"class"];
+        }
+    } else {
+        return predicate == nil ||
+               [predicate isEqual:[NSPredicate predicateWithValue:YES]] ||
+               [predicate isEqual:[NSPredicate predicateWithValue:NO]];
+    }
+}
@@ -0,0 +1,76 @@
+//
+//  FTSnapshotDataSource.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 09.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "FTDataSource.h"
+#import "FTReverseDataSource.h"
+
+@class FTChangeSet;
+
+typedef NSData * (^FTSnapshotItemEncoder)(id item);
+typedef id (^FTSnapshotItemDecoder)(NSData *data);
+
+/*! <code>FTSnapshotDataSource</code> is an immutable data source backed by a snapshot file of
+    another data source (e.g., <code>FTMutableSet</code>, <code>FTMutableArray</code> or
+    <code>FTMutableClusterSet</code>). It can be used to show the last state of a data source
+    on start, until the data source has been loaded again (e.g., by a fetch from the store).
+
+    The snapshot contains the number of items per section and one record per item and section
+    item in the order of the data source. The file is memory mapped, and the number of sections
+    and items are read directly from the file. Opening a snapshot does not depend on the number
+    of items. An item is decoded when it is accessed for the first time and kept afterwards, such
+    that the data source returns the same object for the same index path. An item, which can't be
+    decoded (e.g., a corrupt record or an object of an unexpected class), is returned as
+    <code>NSNull</code>, and a section item, which can't be decoded, as nil.
+
+    The reverse lookup of items and section items decodes all items on the first call and
+    keeps an index of them afterwards.
+
+    By default, the items are encoded with <code>NSKeyedArchiver</code> and must conform to
+    <code>NSSecureCoding</code>. They are decoded with secure coding and only objects of the
+    expected item classes are accepted (property list classes, <code>NSNull</code>, <code>NSURL</code>
+    and <code>NSUUID</code>, unless other classes are given). Items, which can't be archived (e.g.,
+    managed objects), can be written with an encoder block (e.g., writing the URI of the object ID)
+    and read with the matching decoder block.
+
+    Writing a snapshot fails with an error, if an item or section item can't be encoded.
+
+    The snapshot is written in the byte order of the device and can't be read on a device with a
+    different byte order.
+ */
+@interface FTSnapshotDataSource : NSObject <FTDataSource, FTReverseDataSource>
+
+#pragma mark Writing Snapshots
++ (BOOL)writeSnapshotOfDataSource:(id<FTDataSource>)dataSource toURL:(NSURL *)url error:(NSError **)error;
++ (BOOL)writeSnapshotOfDataSource:(id<FTDataSource>)dataSource toURL:(NSURL *)url itemEncoder:(FTSnapshotItemEncoder)itemEncoder error:(NSError **)error;
+
+#pragma mark Life-cycle
+
+// Returns nil, if the file can't be read or is not a valid snapshot.
+- (instancetype)initWithContentsOfURL:(NSURL *)url error:(NSError **)error;
+- (instancetype)initWithContentsOfURL:(NSURL *)url itemClasses:(NSSet *)itemClasses error:(NSError **)error;
+- (instancetype)initWithContentsOfURL:(NSURL *)url itemDecoder:(FTSnapshotItemDecoder)itemDecoder error:(NSError **)error;
+
+#pragma mark Snapshot
+@property (nonatomic, readonly) NSURL *URL;
+@property (nonatomic, readonly) NSUInteger numberOfItems;
+
+// Decodes all items, which have not been accessed yet, and returns them in the order of the snapshot.
+- (NSArray *)allItems;
+
+#pragma mark Changes
+
+// Returns the changes from the snapshot to the current state of the data source (e.g., the data
+// source the snapshot has been written of, after it has been loaded again). This can be used to
+// animate the replacement of the snapshot instead of reloading the view. The items and section
+// items are matched by equality, therefore the decoded items must be equal to the items of the
+// data source. Matched items are reported as changed, if they are not identical.
+- (FTChangeSet *)changeSetToDataSource:(id<FTDataSource>)dataSource;
+
+@end
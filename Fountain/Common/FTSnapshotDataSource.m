@@ -0,0 +1,522 @@
+//
+//  FTSnapshotDataSource.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 09.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTChangeSet.h"
+#import "FTObserverRegistry.h"
+
+#import "FTSnapshotDataSource.h"
+
+// Layout of a snapshot file (all integers in the byte order of the device):
+//
+//   header      FTSnapshotHeader
+//   sections    FTSnapshotSection[numberOfSections]
+//   items       FTSnapshotRecord[numberOfItems]
+//   data        the encoded items and section items
+//
+// The offsets of the records are relative to the start of the file. A record
+// with the length 0 stands for nil (only allowed for section items).
+
+static const uint32_t FTSnapshotMagic = 0x4E535446; // "FTSN"
+static const uint32_t FTSnapshotVersion = 1;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t numberOfSections;
+    uint64_t numberOfItems;
+} FTSnapshotHeader;
+
+typedef struct {
+    uint64_t offset;
+    uint64_t length;
+} FTSnapshotRecord;
+
+typedef struct {
+    uint64_t firstItem;
+    uint64_t numberOfItems;
+    FTSnapshotRecord sectionItem;
+} FTSnapshotSection;
+
+static NSData *FTSnapshotArchiveItem(id item);
+static id FTSnapshotUnarchiveItem(NSData *data, NSSet *itemClasses);
+static BOOL FTSnapshotRecordIsValid(FTSnapshotRecord record, NSUInteger length);
+static NSError *FTSnapshotCorruptFileError(NSURL *url);
+static NSError *FTSnapshotEncodingError(NSURL *url, NSString *description);
+static NSArray *FTSnapshotSectionsOfDataSource(id<FTDataSource> dataSource, NSArray **sectionItems);
+
+@interface FTSnapshotDataSource () {
+    NSData *_data;
+    FTSnapshotItemDecoder _itemDecoder;
+    FTObserverRegistry *_observers;
+
+    const FTSnapshotSection *_sections;
+    const FTSnapshotRecord *_items;
+    NSUInteger _numberOfSections;
+
+    NSMutableDictionary *_decodedItems;
+    NSMutableDictionary *_decodedSectionItems;
+
+    // Created by the first reverse lookup.
+    NSMapTable *_indexPathsOfItems;
+    NSMapTable *_sectionsOfSectionItems;
+}
+
+@end
+
+@implementation FTSnapshotDataSource
+
+#pragma mark Writing Snapshots
+
++ (BOOL)writeSnapshotOfDataSource:(id<FTDataSource>)dataSource toURL:(NSURL *)url error:(NSError **)error
+{
+    return [self writeSnapshotOfDataSource:dataSource toURL:url itemEncoder:nil error:error];
+}
+
++ (BOOL)writeSnapshotOfDataSource:(id<FTDataSource>)dataSource toURL:(NSURL *)url itemEncoder:(FTSnapshotItemEncoder)itemEncoder error:(NSError **)error
+{
+    if (itemEncoder == nil) {
+        itemEncoder = ^(id item) {
+            return FTSnapshotArchiveItem(item);
+        };
+    }
+
+    NSUInteger numberOfSections = [dataSource numberOfSections];
+    NSUInteger numberOfItems = 0;
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        numberOfItems += [dataSource numberOfItemsInSection:section];
+    }
+
+    // The tables are written first and filled in, while the encoded items
+    // are appended to the data.
+
+    NSUInteger sectionTableOffset = sizeof(FTSnapshotHeader);
+    NSUInteger itemTableOffset = sectionTableOffset + numberOfSections * sizeof(FTSnapshotSection);
+    NSUInteger dataOffset = itemTableOffset + numberOfItems * sizeof(FTSnapshotRecord);
+
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:dataOffset];
+
+    FTSnapshotHeader *header = [data mutableBytes];
+    header->magic = FTSnapshotMagic;
+    header->version = FTSnapshotVersion;
+    header->numberOfSections = numberOfSections;
+    header->numberOfItems = numberOfItems;
+
+    NSUInteger item = 0;
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+
+        FTSnapshotSection sectionRecord;
+        sectionRecord.firstItem = item;
+        sectionRecord.numberOfItems = [dataSource numberOfItemsInSection:section];
+        sectionRecord.sectionItem.offset = 0;
+        sectionRecord.sectionItem.length = 0;
+
+        id sectionItem = [dataSource sectionItemForSection:section];
+        if (sectionItem) {
+            NSData *encodedSectionItem = itemEncoder(sectionItem);
+            if ([encodedSectionItem length] == 0) {
+                if (error) {
+                    *error = FTSnapshotEncodingError(url, [NSString stringWithFormat:@"The section item of section %ld could not be encoded.", (long)section]);
+                }
+                return NO;
+            }
+            sectionRecord.sectionItem.offset = [data length];
+            sectionRecord.sectionItem.length = [encodedSectionItem length];
+            [data appendData:encodedSectionItem];
+        }
+
+        for (NSUInteger itemInSection = 0; itemInSection < sectionRecord.numberOfItems; itemInSection++, item++) {
+            NSUInteger indexes[] = {section, itemInSection};
+            NSIndexPath *indexPath = [NSIndexPath indexPathWithIndexes:indexes length:2];
+
+            NSData *encodedItem = itemEncoder([dataSource itemAtIndexPath:indexPath]);
+            if ([encodedItem length] == 0) {
+                if (error) {
+                    *error = FTSnapshotEncodingError(url, [NSString stringWithFormat:@"The item at index path %@ could not be encoded.", indexPath]);
+                }
+                return NO;
+            }
+
+            FTSnapshotRecord itemRecord;
+            itemRecord.offset = [data length];
+            itemRecord.length = [encodedItem length];
+            [data appendData:encodedItem];
+
+            // The pointer to the bytes can change, if the data is appended.
+            FTSnapshotRecord *items = (FTSnapshotRecord *)((uint8_t *)[data mutableBytes] + itemTableOffset);
+            items[item] = itemRecord;
+        }
+
+        FTSnapshotSection *sections = (FTSnapshotSection *)((uint8_t *)[data mutableBytes] + sectionTableOffset);
+        sections[section] = sectionRecord;
+    }
+
+    return [data writeToURL:url options:NSDataWritingAtomic error:error];
+}
+
+#pragma mark Life-cycle
+
+- (instancetype)initWithContentsOfURL:(NSURL *)url error:(NSError **)error
+{
+    return [self initWithContentsOfURL:url itemClasses:nil error:error];
+}
+
+- (instancetype)initWithContentsOfURL:(NSURL *)url itemClasses:(NSSet *)itemClasses error:(NSError **)error
+{
+    if (itemClasses == nil) {
+        itemClasses = [FTSnapshotDataSource defaultItemClasses];
+    }
+
+    return [self initWithContentsOfURL:url
+                           itemDecoder:^(NSData *data) {
+                               return FTSnapshotUnarchiveItem(data, itemClasses);
+                           }
+                                 error:error];
+}
+
+- (instancetype)initWithContentsOfURL:(NSURL *)url itemDecoder:(FTSnapshotItemDecoder)itemDecoder error:(NSError **)error
+{
+    self = [super init];
+    if (self) {
+        _URL = [url copy];
+        _itemDecoder = [itemDecoder copy] ?: ^(NSData *data) {
+            return FTSnapshotUnarchiveItem(data, [FTSnapshotDataSource defaultItemClasses]);
+        };
+        _observers = [[FTObserverRegistry alloc] init];
+        _decodedItems = [[NSMutableDictionary alloc] init];
+        _decodedSectionItems = [[NSMutableDictionary alloc] init];
+
+        _data = [[NSData alloc] initWithContentsOfURL:url options:NSDataReadingMappedAlways error:error];
+        if (_data == nil) {
+            return nil;
+        }
+
+        if (![self ft_validateSnapshot]) {
+            if (error) {
+                *error = FTSnapshotCorruptFileError(url);
+            }
+            return nil;
+        }
+    }
+    return self;
+}
+
++ (NSSet *)defaultItemClasses
+{
+    return [NSSet setWithObjects:[NSArray class], [NSData class], [NSDate class], [NSDictionary class], [NSNull class],
+                                 [NSNumber class], [NSSet class], [NSString class], [NSURL class], [NSUUID class], nil];
+}
+
+- (BOOL)ft_validateSnapshot
+{
+    NSUInteger length = [_data length];
+    if (length < sizeof(FTSnapshotHeader)) {
+        return NO;
+    }
+
+    const FTSnapshotHeader *header = [_data bytes];
+    if (header->magic != FTSnapshotMagic || header->version != FTSnapshotVersion) {
+        return NO;
+    }
+
+    // The sizes of the tables are checked before they are multiplied to
+    // prevent an overflow with a corrupt header.
+
+    NSUInteger available = length - sizeof(FTSnapshotHeader);
+    if (header->numberOfSections > available / sizeof(FTSnapshotSection)) {
+        return NO;
+    }
+    available -= header->numberOfSections * sizeof(FTSnapshotSection);
+    if (header->numberOfItems > available / sizeof(FTSnapshotRecord)) {
+        return NO;
+    }
+
+    _numberOfSections = header->numberOfSections;
+    _numberOfItems = header->numberOfItems;
+    _sections = (const FTSnapshotSection *)((const uint8_t *)[_data bytes] + sizeof(FTSnapshotHeader));
+    _items = (const FTSnapshotRecord *)(_sections + _numberOfSections);
+
+    // The records of the items are only checked when they are decoded.
+
+    NSUInteger firstItem = 0;
+    for (NSUInteger section = 0; section < _numberOfSections; section++) {
+        FTSnapshotSection sectionRecord = _sections[section];
+        if (sectionRecord.firstItem != firstItem ||
+            sectionRecord.numberOfItems > _numberOfItems - firstItem) {
+            return NO;
+        }
+        if (sectionRecord.sectionItem.length > 0 && !FTSnapshotRecordIsValid(sectionRecord.sectionItem, length)) {
+            return NO;
+        }
+        firstItem += sectionRecord.numberOfItems;
+    }
+
+    return firstItem == _numberOfItems;
+}
+
+#pragma mark Snapshot
+
+- (NSArray *)allItems
+{
+    NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:_numberOfItems];
+    for (NSUInteger item = 0; item < _numberOfItems; item++) {
+        [items addObject:[self ft_itemAtIndex:item]];
+    }
+    return items;
+}
+
+- (id)ft_itemAtIndex:(NSUInteger)index
+{
+    id item = _decodedItems[@(index)];
+    if (item == nil) {
+        // The records of the items are not validated when the snapshot is
+        // opened. An item, which can't be decoded, is replaced by NSNull.
+
+        FTSnapshotRecord record = _items[index];
+        item = [self ft_decodeRecord:record] ?: [NSNull null];
+        _decodedItems[@(index)] = item;
+    }
+    return item;
+}
+
+- (id)ft_decodeRecord:(FTSnapshotRecord)record
+{
+    if (record.length == 0 || !FTSnapshotRecordIsValid(record, [_data length])) {
+        return nil;
+    }
+
+    // The data of the record points into the mapped file.
+    NSData *data = [_data subdataWithRange:NSMakeRange(record.offset, record.length)];
+    return _itemDecoder(data);
+}
+
+#pragma mark Changes
+
+- (FTChangeSet *)changeSetToDataSource:(id<FTDataSource>)dataSource
+{
+    NSArray *sectionItems = nil;
+    NSArray *sections = FTSnapshotSectionsOfDataSource(self, &sectionItems);
+
+    NSArray *newSectionItems = nil;
+    NSArray *newSections = FTSnapshotSectionsOfDataSource(dataSource, &newSectionItems);
+
+    return [FTChangeSet changeSetFromSections:sections
+                                 sectionItems:sectionItems
+                                   toSections:newSections
+                                 sectionItems:newSectionItems
+                                 changedItems:nil];
+}
+
+#pragma mark FTDataSource
+
+#pragma mark Getting Item and Section Metrics
+
+- (NSUInteger)numberOfSections
+{
+    return _numberOfSections;
+}
+
+- (NSUInteger)numberOfItemsInSection:(NSUInteger)section
+{
+    if (section >= _numberOfSections) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. %ld].", __PRETTY_FUNCTION__, (long)section, (long)_numberOfSections];
+    }
+
+    return _sections[section].numberOfItems;
+}
+
+#pragma mark Getting Items and Sections
+
+- (id)sectionItemForSection:(NSUInteger)section
+{
+    if (section >= _numberOfSections) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. %ld].", __PRETTY_FUNCTION__, (long)section, (long)_numberOfSections];
+    }
+
+    FTSnapshotRecord record = _sections[section].sectionItem;
+    if (record.length == 0) {
+        return nil;
+    }
+
+    id sectionItem = _decodedSectionItems[@(section)];
+    if (sectionItem == nil) {
+        sectionItem = [self ft_decodeRecord:record];
+        if (sectionItem) {
+            _decodedSectionItems[@(section)] = sectionItem;
+        }
+    }
+    return sectionItem;
+}
+
+- (id)itemAtIndexPath:(NSIndexPath *)indexPath
+{
+    NSUInteger section = [indexPath indexAtPosition:0];
+    NSUInteger item = [indexPath indexAtPosition:1];
+
+    if (section >= _numberOfSections) {
+        [NSException raise:NSRangeException format:@"*** %s: section index %ld beyond bounds [0 .. %ld].", __PRETTY_FUNCTION__, (long)section, (long)_numberOfSections];
+    }
+
+    FTSnapshotSection sectionRecord = _sections[section];
+    if (item >= sectionRecord.numberOfItems) {
+        [NSException raise:NSRangeException format:@"*** %s: item index %ld beyond bounds [0 .. %ld].", __PRETTY_FUNCTION__, (long)item, (long)sectionRecord.numberOfItems];
+    }
+
+    return [self ft_itemAtIndex:sectionRecord.firstItem + item];
+}
+
+#pragma mark Observer
+
+- (NSArray *)observers
+{
+    return [_observers observers];
+}
+
+- (void)addObserver:(id<FTDataSourceObserver>)observer
+{
+    [_observers addObserver:observer];
+}
+
+- (void)removeObserver:(id<FTDataSourceObserver>)observer
+{
+    [_observers removeObserver:observer];
+}
+
+#pragma mark FTReverseDataSource
+
+- (NSIndexSet *)sectionsOfSectionItem:(id)sectionItem
+{
+    [self ft_indexItems];
+    return [[_sectionsOfSectionItems objectForKey:sectionItem] copy] ?: [NSIndexSet indexSet];
+}
+
+- (NSArray *)indexPathsOfItem:(id)item
+{
+    [self ft_indexItems];
+    return [[_indexPathsOfItems objectForKey:item] copy] ?: @[];
+}
+
+- (void)ft_indexItems
+{
+    if (_indexPathsOfItems) {
+        return;
+    }
+
+    _indexPathsOfItems = [NSMapTable strongToStrongObjectsMapTable];
+    _sectionsOfSectionItems = [NSMapTable strongToStrongObjectsMapTable];
+
+    for (NSUInteger section = 0; section < _numberOfSections; section++) {
+        id sectionItem = [self sectionItemForSection:section];
+        if (sectionItem) {
+            NSMutableIndexSet *sections = [_sectionsOfSectionItems objectForKey:sectionItem];
+            if (sections == nil) {
+                sections = [[NSMutableIndexSet alloc] init];
+                [_sectionsOfSectionItems setObject:sections forKey:sectionItem];
+            }
+            [sections addIndex:section];
+        }
+
+        // Items, which could not be decoded, are not indexed.
+
+        FTSnapshotSection sectionRecord = _sections[section];
+        for (NSUInteger item = 0; item < sectionRecord.numberOfItems; item++) {
+            id object = [self ft_itemAtIndex:sectionRecord.firstItem + item];
+            if (object == [NSNull null]) {
+                continue;
+            }
+            NSMutableArray *indexPaths = [_indexPathsOfItems objectForKey:object];
+            if (indexPaths == nil) {
+                indexPaths = [[NSMutableArray alloc] init];
+                [_indexPathsOfItems setObject:indexPaths forKey:object];
+            }
+            NSUInteger indexes[] = {section, item};
+            [indexPaths addObject:[NSIndexPath indexPathWithIndexes:indexes length:2]];
+        }
+    }
+}
+
+@end
+
+#pragma mark - Sections
+
+static NSArray *FTSnapshotSectionsOfDataSource(id<FTDataSource> dataSource, NSArray **sectionItems)
+{
+    NSUInteger numberOfSections = [dataSource numberOfSections];
+    NSMutableArray *sections = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+    NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        [items addObject:[dataSource sectionItemForSection:section] ?: [NSNull null]];
+
+        NSUInteger numberOfItems = [dataSource numberOfItemsInSection:section];
+        NSMutableArray *itemsInSection = [[NSMutableArray alloc] initWithCapacity:numberOfItems];
+        for (NSUInteger item = 0; item < numberOfItems; item++) {
+            NSUInteger indexes[] = {section, item};
+            [itemsInSection addObject:[dataSource itemAtIndexPath:[NSIndexPath indexPathWithIndexes:indexes length:2]]];
+        }
+        [sections addObject:itemsInSection];
+    }
+
+    *sectionItems = items;
+    return sections;
+}
+
+#pragma mark - Archiving
+
+static NSData *FTSnapshotArchiveItem(id item)
+{
+    // Only items supporting secure coding are archived, such that they can
+    // be unarchived with the expected classes.
+
+    if (![[item class] conformsToProtocol:@protocol(NSSecureCoding)] || ![[item class] supportsSecureCoding]) {
+        return nil;
+    }
+
+    NSMutableData *data = [[NSMutableData alloc] init];
+    NSKeyedArchiver *archiver = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+    archiver.requiresSecureCoding = YES;
+    [archiver encodeObject:item forKey:NSKeyedArchiveRootObjectKey];
+    [archiver finishEncoding];
+    return data;
+}
+
+static id FTSnapshotUnarchiveItem(NSData *data, NSSet *itemClasses)
+{
+    // Objects of other than the given classes are not decoded and the
+    // item is nil.
+
+    NSKeyedUnarchiver *unarchiver = [[NSKeyedUnarchiver alloc] initForReadingWithData:data];
+    unarchiver.requiresSecureCoding = YES;
+    unarchiver.decodingFailurePolicy = NSDecodingFailurePolicySetErrorAndReturn;
+    id item = [unarchiver decodeObjectOfClasses:itemClasses forKey:NSKeyedArchiveRootObjectKey];
+    [unarchiver finishDecoding];
+    return unarchiver.error ? nil : item;
+}
+
+#pragma mark - Records
+
+static BOOL FTSnapshotRecordIsValid(FTSnapshotRecord record, NSUInteger length)
+{
+    return record.offset <= length && record.length <= length - record.offset;
+}
+
+#pragma mark - Errors
+
+static NSError *FTSnapshotCorruptFileError(NSURL *url)
+{
+    return [NSError errorWithDomain:NSCocoaErrorDomain
+                               code:NSFileReadCorruptFileError
+                           userInfo:@{NSURLErrorKey : url}];
+}
+
+static NSError *FTSnapshotEncodingError(NSURL *url, NSString *description)
+{
+    return [NSError errorWithDomain:NSCocoaErrorDomain
+                               code:NSCoderInvalidValueError
+                           userInfo:@{NSURLErrorKey : url,
+                                      NSDebugDescriptionErrorKey : description}];
+}
@@ -0,0 +1,39 @@
+//
+//  FTSortKeyCache.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 19.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/*! <code>FTSortKeyCache</code> extracts the values for the key paths of the sort descriptors
+    once per object and compares the objects based on these cached values.
+
+    Numbers, dates and strings compared with <code>compare:</code> are compared without
+    sending the comparison selector via the sort descriptor. All other values are compared
+    with the comparator or selector of the sort descriptor.
+
+    @note The cached values are not updated, if an object changes. Therefore a cache should
+    only be used for the duration of one batch update.
+ */
+@interface FTSortKeyCache : NSObject
+
+#pragma mark Life-cycle
+- (instancetype)initWithSortDescriptors:(NSArray *)sortDescriptors;
+
+#pragma mark Sort Descriptors
+@property (nonatomic, readonly) NSArray *sortDescriptors;
+
+#pragma mark Comparing Objects
+
+// Returns a comparator, which compares two objects based on the cached values.
+// Values of objects, which are not in the cache, are extracted on first use.
+- (NSComparator)comperator;
+
+// Returns a sorted array with the objects. The values used to sort the objects
+// are extracted once per object and stay in the cache.
+- (NSArray *)sortedArrayFromObjects:(id<NSFastEnumeration>)objects;
+
+@end
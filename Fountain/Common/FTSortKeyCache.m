@@ -0,0 +1,284 @@
+//
+//  FTSortKeyCache.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 19.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <objc/message.h>
+
+#import "FTSortKeyCache.h"
+
+typedef NS_ENUM(NSUInteger, FTSortDescriptorMode) {
+    FTSortDescriptorModeComparator,
+    FTSortDescriptorModeCompare,
+    FTSortDescriptorModeSelector
+};
+
+typedef NS_ENUM(NSUInteger, FTSortKeyKind) {
+    FTSortKeyKindObject,
+    FTSortKeyKindInteger,
+    FTSortKeyKindDouble,
+    FTSortKeyKindDate,
+    FTSortKeyKindString
+};
+
+typedef struct {
+    FTSortKeyKind kind;
+    long long integerValue;
+    double doubleValue;
+    const void *value;
+} FTSortKey;
+
+static const CFDictionaryKeyCallBacks FTSortKeyCacheIdentityKeyCallBacks = {0, kCFTypeDictionaryKeyCallBacks.retain, kCFTypeDictionaryKeyCallBacks.release, NULL, NULL, NULL};
+
+@implementation FTSortKeyCache {
+    NSUInteger _numberOfSortDescriptors;
+    NSString *__unsafe_unretained *_keyPaths;
+    FTSortDescriptorMode *_modes;
+    SEL *_selectors;
+    BOOL *_ascending;
+    NSArray *_keyPathsStore;
+    NSArray *_comparators;
+
+    FTSortKey *_keys;
+    NSUInteger _count;
+    NSUInteger _capacity;
+    CFMutableDictionaryRef _indexes;
+}
+
+#pragma mark Life-cycle
+
+- (instancetype)initWithSortDescriptors:(NSArray *)sortDescriptors
+{
+    self = [super init];
+    if (self) {
+        _sortDescriptors = [sortDescriptors copy];
+        _numberOfSortDescriptors = [_sortDescriptors count];
+
+        _keyPaths = (NSString *__unsafe_unretained *)calloc(MAX(_numberOfSortDescriptors, 1), sizeof(NSString *));
+        _modes = calloc(MAX(_numberOfSortDescriptors, 1), sizeof(FTSortDescriptorMode));
+        _selectors = calloc(MAX(_numberOfSortDescriptors, 1), sizeof(SEL));
+        _ascending = calloc(MAX(_numberOfSortDescriptors, 1), sizeof(BOOL));
+
+        NSMutableArray *keyPaths = [[NSMutableArray alloc] init];
+        NSMutableArray *comparators = [[NSMutableArray alloc] init];
+
+        [_sortDescriptors enumerateObjectsUsingBlock:^(NSSortDescriptor *sortDescriptor, NSUInteger idx, BOOL *stop) {
+            [keyPaths addObject:sortDescriptor.key ?: @"self"];
+            [comparators addObject:sortDescriptor.comparator ?: (id)[NSNull null]];
+
+            _selectors[idx] = sortDescriptor.selector;
+            _ascending[idx] = sortDescriptor.ascending;
+
+            if (sortDescriptor.comparator) {
+                _modes[idx] = FTSortDescriptorModeComparator;
+            } else if (sortDescriptor.selector == @selector(compare:)) {
+                _modes[idx] = FTSortDescriptorModeCompare;
+            } else {
+                _modes[idx] = FTSortDescriptorModeSelector;
+            }
+        }];
+
+        _keyPathsStore = [keyPaths copy];
+        _comparators = [comparators copy];
+
+        for (NSUInteger idx = 0; idx < _numberOfSortDescriptors; idx++) {
+            _keyPaths[idx] = [_keyPathsStore objectAtIndex:idx];
+        }
+
+        _keys = NULL;
+        _count = 0;
+        _capacity = 0;
+        _indexes = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &FTSortKeyCacheIdentityKeyCallBacks, NULL);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    for (NSUInteger i = 0; i < _count * _numberOfSortDescriptors; i++) {
+        if (_keys[i].value) {
+            CFRelease(_keys[i].value);
+        }
+    }
+
+    free(_keys);
+    free(_keyPaths);
+    free(_modes);
+    free(_selectors);
+    free(_ascending);
+
+    CFRelease(_indexes);
+}
+
+#pragma mark Extracting Keys
+
+static void FTSortKeyMake(FTSortKey *key, id value, FTSortDescriptorMode mode)
+{
+    key->kind = FTSortKeyKindObject;
+    key->value = value ? CFBridgingRetain(value) : NULL;
+
+    if (mode != FTSortDescriptorModeCompare || value == nil) {
+        return;
+    }
+
+    if ([value isKindOfClass:[NSString class]]) {
+        key->kind = FTSortKeyKindString;
+    } else if ([value isKindOfClass:[NSDate class]]) {
+        key->kind = FTSortKeyKindDate;
+        key->doubleValue = [(NSDate *)value timeIntervalSinceReferenceDate];
+    } else if ([value isKindOfClass:[NSNumber class]] && ![value isKindOfClass:[NSDecimalNumber class]]) {
+        const char *type = [(NSNumber *)value objCType];
+        switch (type[0]) {
+        case 'c':
+        case 'C':
+        case 's':
+        case 'S':
+        case 'i':
+        case 'I':
+        case 'l':
+        case 'q':
+        case 'B':
+            key->kind = FTSortKeyKindInteger;
+            key->integerValue = [(NSNumber *)value longLongValue];
+            break;
+
+        case 'L':
+        case 'Q':
+            if ([(NSNumber *)value unsignedLongLongValue] <= LLONG_MAX) {
+                key->kind = FTSortKeyKindInteger;
+                key->integerValue = [(NSNumber *)value longLongValue];
+            }
+            break;
+
+        case 'f':
+        case 'd':
+            key->kind = FTSortKeyKindDouble;
+            key->doubleValue = [(NSNumber *)value doubleValue];
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+static NSUInteger FTSortKeyCacheIndexOfObject(FTSortKeyCache *cache, id object)
+{
+    const void *index = NULL;
+    if (CFDictionaryGetValueIfPresent(cache->_indexes, (__bridge const void *)object, &index)) {
+        return (NSUInteger)index - 1;
+    }
+
+    if (cache->_count == cache->_capacity) {
+        cache->_capacity = MAX(cache->_capacity * 2, 16);
+        cache->_keys = realloc(cache->_keys, cache->_capacity * MAX(cache->_numberOfSortDescriptors, 1) * sizeof(FTSortKey));
+    }
+
+    NSUInteger newIndex = cache->_count;
+    FTSortKey *keys = cache->_keys + newIndex * cache->_numberOfSortDescriptors;
+
+    for (NSUInteger idx = 0; idx < cache->_numberOfSortDescriptors; idx++) {
+        FTSortKeyMake(&keys[idx], [object valueForKeyPath:cache->_keyPaths[idx]], cache->_modes[idx]);
+    }
+
+    cache->_count++;
+    CFDictionarySetValue(cache->_indexes, (__bridge const void *)object, (const void *)(newIndex + 1));
+
+    return newIndex;
+}
+
+#pragma mark Comparing Objects
+
+static inline NSComparisonResult FTCompareScalar(double a, double b)
+{
+    if (a < b) {
+        return NSOrderedAscending;
+    } else if (a > b) {
+        return NSOrderedDescending;
+    } else {
+        return NSOrderedSame;
+    }
+}
+
+static NSComparisonResult FTSortKeyCacheCompare(FTSortKeyCache *cache, id firstObject, id secondObject)
+{
+    if (firstObject == secondObject) {
+        return NSOrderedSame;
+    }
+
+    NSUInteger firstIndex = FTSortKeyCacheIndexOfObject(cache, firstObject);
+    NSUInteger secondIndex = FTSortKeyCacheIndexOfObject(cache, secondObject);
+
+    FTSortKey *firstKeys = cache->_keys + firstIndex * cache->_numberOfSortDescriptors;
+    FTSortKey *secondKeys = cache->_keys + secondIndex * cache->_numberOfSortDescriptors;
+
+    for (NSUInteger idx = 0; idx < cache->_numberOfSortDescriptors; idx++) {
+
+        FTSortKey *a = &firstKeys[idx];
+        FTSortKey *b = &secondKeys[idx];
+
+        id firstValue = (__bridge id)a->value;
+        id secondValue = (__bridge id)b->value;
+
+        NSComparisonResult result = NSOrderedSame;
+
+        if (firstValue == nil || secondValue == nil) {
+
+            // Let the sort descriptor decide how to handle missing values. The
+            // result of the sort descriptor already respects the sort direction.
+
+            NSSortDescriptor *sortDescriptor = [cache->_sortDescriptors objectAtIndex:idx];
+            result = [sortDescriptor compareObject:firstObject toObject:secondObject];
+            if (result != NSOrderedSame) {
+                return result;
+            } else {
+                continue;
+            }
+
+        } else if (cache->_modes[idx] == FTSortDescriptorModeComparator) {
+            NSComparator comparator = [cache->_comparators objectAtIndex:idx];
+            result = comparator(firstValue, secondValue);
+        } else if (a->kind == b->kind && a->kind == FTSortKeyKindInteger) {
+            result = a->integerValue < b->integerValue ? NSOrderedAscending : (a->integerValue > b->integerValue ? NSOrderedDescending : NSOrderedSame);
+        } else if (a->kind == b->kind && (a->kind == FTSortKeyKindDouble || a->kind == FTSortKeyKindDate)) {
+            result = FTCompareScalar(a->doubleValue, b->doubleValue);
+        } else if (a->kind == b->kind && a->kind == FTSortKeyKindString) {
+            result = [(NSString *)firstValue compare:secondValue];
+        } else {
+            SEL selector = cache->_selectors[idx];
+            result = ((NSComparisonResult(*)(id, SEL, id))objc_msgSend)(firstValue, selector, secondValue);
+        }
+
+        if (result != NSOrderedSame) {
+            if (cache->_ascending[idx]) {
+                return result;
+            } else {
+                return result == NSOrderedAscending ? NSOrderedDescending : NSOrderedAscending;
+            }
+        }
+    }
+
+    return NSOrderedSame;
+}
+
+- (NSComparator)comperator
+{
+    return ^(id firstObject, id secondObject) {
+        return FTSortKeyCacheCompare(self, firstObject, secondObject);
+    };
+}
+
+- (NSArray *)sortedArrayFromObjects:(id<NSFastEnumeration>)objects
+{
+    NSMutableArray *array = [[NSMutableArray alloc] init];
+    for (id object in objects) {
+        FTSortKeyCacheIndexOfObject(self, object);
+        [array addObject:object];
+    }
+    return [array sortedArrayWithOptions:NSSortStable usingComparator:[self comperator]];
+}
+
+@end
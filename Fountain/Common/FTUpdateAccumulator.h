@@ -0,0 +1,65 @@
+//
+//  FTUpdateAccumulator.h
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 05.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class FTChangeSet;
+
+/*! <code>FTUpdateAccumulator</code> collects the changes of a data source, which are reported
+    in one or more consecutive or nested batches, and combines them into a single change set
+    relative to the state before the first batch.
+
+    The changes of each batch are relative to the state after the previous batch, following the
+    conventions of <code>FTChangeSet</code>. If there is more than one batch, the batches are
+    replayed on placeholders of the items. This cancels items, which are inserted and deleted
+    again, collapses repeated changes and combines consecutive moves of an item into one move.
+    The items of the resulting change set are merged into ranges per section.
+
+    If the number of changes exceeds <code>maximumNumberOfChanges</code> or if the changes
+    don't match the number of items, <code>requiresReload</code> is YES and the view should be
+    reloaded instead of applying the change set.
+ */
+@interface FTUpdateAccumulator : NSObject
+
+#pragma mark Life-cycle
+
+// The number of items per section (as NSNumber) before the first batch.
+- (instancetype)initWithNumberOfItemsInSections:(NSArray *)numberOfItemsInSections;
+
+#pragma mark Batches
+@property (nonatomic, readonly) NSUInteger numberOfOpenBatches;
+- (void)beginBatch;
+- (void)endBatch;
+
+#pragma mark Recording Changes
+- (void)insertSections:(NSIndexSet *)sections;
+- (void)deleteSections:(NSIndexSet *)sections;
+- (void)changeSections:(NSIndexSet *)sections;
+- (void)moveSection:(NSUInteger)section toSection:(NSUInteger)newSection;
+
+- (void)insertItemsAtIndexPaths:(NSArray *)indexPaths;
+- (void)deleteItemsAtIndexPaths:(NSArray *)indexPaths;
+- (void)changeItemsAtIndexPaths:(NSArray *)indexPaths;
+- (void)moveItemAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath;
+
+#pragma mark Cost Model
+
+// Each inserted, deleted, changed or moved section and item counts as one change. Defaults to 500.
+@property (nonatomic, readwrite) NSUInteger maximumNumberOfChanges;
+@property (nonatomic, readonly) NSUInteger numberOfChanges;
+@property (nonatomic, readonly) BOOL requiresReload;
+
+#pragma mark Accumulated Changes
+@property (nonatomic, readonly) FTChangeSet *changeSet;
+
+// Items, which have been moved and changed. A view can not move and reload an item at the same
+// time, therefore these items are not contained in the changed items of the change set. The index
+// paths refer to the state after the changes.
+@property (nonatomic, readonly) NSArray *movedItemsToReload;
+
+@end
@@ -0,0 +1,346 @@
+//
+//  FTUpdateAccumulator.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 05.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTChangeSet.h"
+
+#import "FTUpdateAccumulator.h"
+
+static NSIndexPath *FTUpdateAccumulatorIndexPath(NSUInteger section, NSUInteger item);
+static BOOL FTUpdateAccumulatorMovesChangedItems(FTChangeSet *changeSet);
+static NSUInteger FTUpdateAccumulatorNumberOfChanges(FTChangeSet *changeSet);
+
+@interface FTUpdateAccumulator () {
+    NSArray *_numberOfItemsInSections;
+
+    // The changes of the current batch
+    FTMutableChangeSet *_batch;
+
+    // The first batch, as long as it is the only batch
+    FTChangeSet *_firstBatch;
+
+    // Placeholders of the sections and items before the first batch and after
+    // the batches replayed so far. The placeholders are only created, if more
+    // than one batch has to be combined.
+    NSArray *_initialSections;
+    NSArray *_initialSectionPlaceholders;
+    NSMutableArray *_sections;
+    NSMutableArray *_sectionPlaceholders;
+    NSMutableSet *_changedPlaceholders;
+
+    BOOL _inconsistent;
+    BOOL _needsUpdate;
+
+    FTChangeSet *_changeSet;
+    NSArray *_movedItemsToReload;
+    NSUInteger _numberOfChanges;
+}
+
+@end
+
+@implementation FTUpdateAccumulator
+
+#pragma mark Life-cycle
+
+- (instancetype)initWithNumberOfItemsInSections:(NSArray *)numberOfItemsInSections
+{
+    self = [super init];
+    if (self) {
+        _numberOfItemsInSections = [numberOfItemsInSections copy];
+        _batch = [[FTMutableChangeSet alloc] init];
+        _maximumNumberOfChanges = 500;
+        _needsUpdate = YES;
+    }
+    return self;
+}
+
+#pragma mark Batches
+
+- (void)beginBatch
+{
+    [self ft_commitBatch];
+    _numberOfOpenBatches++;
+}
+
+- (void)endBatch
+{
+    [self ft_commitBatch];
+    if (_numberOfOpenBatches > 0) {
+        _numberOfOpenBatches--;
+    }
+}
+
+#pragma mark Recording Changes
+
+- (void)insertSections:(NSIndexSet *)sections
+{
+    [_batch insertSections:sections];
+}
+
+- (void)deleteSections:(NSIndexSet *)sections
+{
+    [_batch deleteSections:sections];
+}
+
+- (void)changeSections:(NSIndexSet *)sections
+{
+    [_batch changeSections:sections];
+}
+
+- (void)moveSection:(NSUInteger)section toSection:(NSUInteger)newSection
+{
+    [_batch moveSection:section toSection:newSection];
+}
+
+- (void)insertItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    [_batch insertItemsAtIndexPaths:indexPaths];
+}
+
+- (void)deleteItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    [_batch deleteItemsAtIndexPaths:indexPaths];
+}
+
+- (void)changeItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    [_batch changeItemsAtIndexPaths:indexPaths];
+}
+
+- (void)moveItemAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath
+{
+    [_batch moveItemAtIndexPath:indexPath toIndexPath:newIndexPath];
+}
+
+#pragma mark Cost Model
+
+- (NSUInteger)numberOfChanges
+{
+    [self ft_update];
+    return _numberOfChanges;
+}
+
+- (BOOL)requiresReload
+{
+    [self ft_update];
+    return _inconsistent || _numberOfChanges > _maximumNumberOfChanges;
+}
+
+#pragma mark Accumulated Changes
+
+- (FTChangeSet *)changeSet
+{
+    [self ft_update];
+    return _changeSet;
+}
+
+- (NSArray *)movedItemsToReload
+{
+    [self ft_update];
+    return _movedItemsToReload;
+}
+
+#pragma mark Combining Batches
+
+- (void)ft_commitBatch
+{
+    if ([_batch isEmpty]) {
+        return;
+    }
+
+    FTChangeSet *batch = [_batch copy];
+    [_batch removeAllChanges];
+
+    if (_firstBatch == nil && _sections == nil) {
+        _firstBatch = batch;
+    } else {
+        [self ft_replayBatch:batch];
+    }
+
+    _needsUpdate = YES;
+}
+
+- (void)ft_update
+{
+    [self ft_commitBatch];
+
+    if (_needsUpdate == NO) {
+        return;
+    }
+
+    _needsUpdate = NO;
+
+    if (_sections == nil && (_firstBatch == nil || FTUpdateAccumulatorMovesChangedItems(_firstBatch) == NO)) {
+
+        // A single batch can be used as it is.
+
+        _changeSet = _firstBatch ?: [[FTMutableChangeSet alloc] init];
+        _movedItemsToReload = @[];
+        if (_firstBatch && [_firstBatch isValidForNumberOfItemsInSections:_numberOfItemsInSections] == NO) {
+            _inconsistent = YES;
+        }
+
+    } else {
+
+        [self ft_replayBatch:nil];
+
+        if (_inconsistent) {
+            _changeSet = [[FTMutableChangeSet alloc] init];
+            _movedItemsToReload = @[];
+        } else {
+            FTMutableChangeSet *changeSet = [[FTChangeSet changeSetFromSections:_initialSections
+                                                                   sectionItems:_initialSectionPlaceholders
+                                                                     toSections:_sections
+                                                                   sectionItems:_sectionPlaceholders
+                                                                   changedItems:_changedPlaceholders] mutableCopy];
+
+            // The changed items, which are moved, are reloaded after the changes.
+
+            NSMutableArray *movedChangedItems = [[NSMutableArray alloc] init];
+            NSMutableArray *movedItemsToReload = [[NSMutableArray alloc] init];
+            [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+                id placeholder = _initialSections[[indexPath indexAtPosition:0]][[indexPath indexAtPosition:1]];
+                if ([_changedPlaceholders containsObject:placeholder]) {
+                    [movedChangedItems addObject:indexPath];
+                    [movedItemsToReload addObject:newIndexPath];
+                }
+            }];
+            [changeSet removeChangedItemsAtIndexPaths:movedChangedItems];
+
+            _changeSet = changeSet;
+            _movedItemsToReload = movedItemsToReload;
+        }
+    }
+
+    _numberOfChanges = FTUpdateAccumulatorNumberOfChanges(_changeSet);
+}
+
+#pragma mark Replaying Batches
+
+- (void)ft_preparePlaceholders
+{
+    NSUInteger numberOfSections = [_numberOfItemsInSections count];
+
+    NSMutableArray *sections = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+    NSMutableArray *sectionPlaceholders = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+
+    _sections = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+    _sectionPlaceholders = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+    _changedPlaceholders = [[NSMutableSet alloc] init];
+
+    for (NSUInteger section = 0; section < numberOfSections; section++) {
+        NSUInteger numberOfItems = [_numberOfItemsInSections[section] unsignedIntegerValue];
+        NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:numberOfItems];
+        for (NSUInteger item = 0; item < numberOfItems; item++) {
+            [items addObject:FTUpdateAccumulatorIndexPath(section, item)];
+        }
+        [sections addObject:items];
+        [sectionPlaceholders addObject:@(section)];
+
+        [_sections addObject:[items mutableCopy]];
+        [_sectionPlaceholders addObject:@(section)];
+    }
+
+    _initialSections = sections;
+    _initialSectionPlaceholders = sectionPlaceholders;
+}
+
+// Replays the batch on the placeholders. The first batch is replayed, if
+// the placeholders are created, which is also done for a nil batch.
+- (void)ft_replayBatch:(FTChangeSet *)batch
+{
+    if (_sections == nil) {
+        [self ft_preparePlaceholders];
+        if (_firstBatch) {
+            [self ft_applyBatch:_firstBatch];
+            _firstBatch = nil;
+        }
+    }
+
+    if (batch) {
+        [self ft_applyBatch:batch];
+    }
+}
+
+- (void)ft_applyBatch:(FTChangeSet *)batch
+{
+    if (_inconsistent) {
+        return;
+    }
+
+    // Changes are attached to the placeholders, changes of inserted items are dropped with
+    // the item. Changes, which don't match the state, are ignored, because applying the
+    // batch fails in that case.
+
+    [batch.changedSections enumerateIndexesUsingBlock:^(NSUInteger section, BOOL *stop) {
+        if (section < [_sectionPlaceholders count]) {
+            [_changedPlaceholders addObject:_sectionPlaceholders[section]];
+        }
+    }];
+
+    [batch enumerateChangedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        if (section < [_sections count] && [items lastIndex] < [_sections[section] count]) {
+            [_changedPlaceholders addObjectsFromArray:[_sections[section] objectsAtIndexes:items]];
+        }
+    }];
+
+    BOOL consistent = [batch applyToSections:_sections
+                                sectionItems:_sectionPlaceholders
+                           insertedItemBlock:^id(NSIndexPath *indexPath) {
+                               return [[NSObject alloc] init];
+                           }
+                    insertedSectionItemBlock:^id(NSUInteger section) {
+                        return [[NSObject alloc] init];
+                    }];
+
+    if (consistent == NO) {
+        _inconsistent = YES;
+    }
+}
+
+@end
+
+#pragma mark - Change Sets
+
+static NSIndexPath *FTUpdateAccumulatorIndexPath(NSUInteger section, NSUInteger item)
+{
+    NSUInteger indexes[] = {section, item};
+    return [NSIndexPath indexPathWithIndexes:indexes length:2];
+}
+
+static BOOL FTUpdateAccumulatorMovesChangedItems(FTChangeSet *changeSet)
+{
+    __block BOOL movesChangedItems = NO;
+    [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        if ([[changeSet changedItemsInSection:[indexPath indexAtPosition:0]] containsIndex:[indexPath indexAtPosition:1]]) {
+            movesChangedItems = YES;
+            *stop = YES;
+        }
+    }];
+    return movesChangedItems;
+}
+
+static NSUInteger FTUpdateAccumulatorNumberOfChanges(FTChangeSet *changeSet)
+{
+    __block NSUInteger numberOfChanges = [changeSet.insertedSections count] + [changeSet.deletedSections count] + [changeSet.changedSections count];
+
+    void (^countItems)(NSUInteger, NSIndexSet *, BOOL *) = ^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        numberOfChanges += [items count];
+    };
+
+    [changeSet enumerateSectionMovesUsingBlock:^(NSUInteger section, NSUInteger newSection, BOOL *stop) {
+        numberOfChanges++;
+    }];
+    [changeSet enumerateInsertedItemsUsingBlock:countItems];
+    [changeSet enumerateDeletedItemsUsingBlock:countItems];
+    [changeSet enumerateChangedItemsUsingBlock:countItems];
+    [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        numberOfChanges++;
+    }];
+
+    return numberOfChanges;
+}
@@ -18,19 +18,32 @@ FOUNDATION_EXPORT const unsigned char FountainVersionString[];
 
 // In this header, you should import all the public headers of your framework using statements like #import <Fountain/PublicHeader.h>
 
+#import <Fountain/FTAggregatingInstrumentationSink.h>
+#import <Fountain/FTChangeSet.h>
+#import <Fountain/FTCoalescingDataSource.h>
 #import <Fountain/FTCombinedDataSource.h>
+#import <Fountain/FTCompiledPredicate.h>
+#import <Fountain/FTConcurrentSet.h>
 #import <Fountain/FTDataSource.h>
 #import <Fountain/FTDataSourceObserver.h>
 #import <Fountain/FTFetchedDataSource.h>
 #import <Fountain/FTFutureItemsDataSource.h>
+#import <Fountain/FTInstrumentation.h>
+#import <Fountain/FTItemMetricsCache.h>
 #import <Fountain/FTMovableItemsDataSource.h>
 #import <Fountain/FTMutableArray.h>
 #import <Fountain/FTMutableClusterSet.h>
 #import <Fountain/FTMutableDataSource.h>
 #import <Fountain/FTMutableSet.h>
 #import <Fountain/FTObserverProxy.h>
+#import <Fountain/FTObserverRegistry.h>
+#import <Fountain/FTPagedDataSource.h>
 #import <Fountain/FTPagingDataSource.h>
+#import <Fountain/FTPrepareHandlerRegistry.h>
+#import <Fountain/FTPrefetchingDataSource.h>
 #import <Fountain/FTReverseDataSource.h>
+#import <Fountain/FTSnapshotDataSource.h>
+#import <Fountain/FTUpdateAccumulator.h>
 
 #if TARGET_OS_IOS
 #import <Fountain/FountainiOS.h>
@@ -19,4 +19,21 @@
 + (NSArray *)ft_arrayBySortingObjects:(NSSet *)objects
                        byOrderInArray:(NSArray *)referenceArray;
 
+// Same as above, but the order in the reference array is given as a map from the objects
+// to their positions (NSNumber). Objects without a position are ordered after all other objects.
++ (NSArray *)ft_arrayBySortingObjects:(NSSet *)objects
+                 usingSortDescriptors:(NSArray *)sortDescriptors
+     orderAmbiguousObjectsByPositions:(NSMapTable *)positions;
+
++ (NSArray *)ft_arrayBySortingObjects:(NSSet *)objects
+                          byPositions:(NSMapTable *)positions;
+
+// Returns a map from the objects of the given set to their positions (NSNumber) in the reference
+// array. The reference array is scanned once and the scan stops, if all objects have been found.
++ (NSMapTable *)ft_positionsOfObjects:(NSSet *)objects inArray:(NSArray *)referenceArray;
+
+// Returns YES, if no object is ordered before its predecessor by the comparator. Each object
+// is only compared with its predecessor.
+- (BOOL)ft_isSortedUsingComparator:(NSComparator)comparator;
+
 @end
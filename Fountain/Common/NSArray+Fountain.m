@@ -6,6 +6,8 @@
 //  Copyright © 2016 Tobias Kräntzer. All rights reserved.
 //
 
+#import "FTSortKeyCache.h"
+
 #import "NSArray+Fountain.h"
 
 @implementation NSArray (Fountain)
@@ -14,48 +16,38 @@
                    usingSortDescriptors:(NSArray *)sortDescriptors
     orderAmbiguousObjectsByOrderInArray:(NSArray *)referenceArray
 {
-    return [[objects allObjects] sortedArrayUsingComparator:^(id firstObject, id secondObject) {
-
-        // Early return, if the first object is the second object
-
-        if (firstObject == secondObject) {
-            return NSOrderedSame;
-        }
+    return [self ft_arrayBySortingObjects:objects
+                     usingSortDescriptors:sortDescriptors
+         orderAmbiguousObjectsByPositions:[self ft_positionsOfObjects:objects inArray:referenceArray]];
+}
 
-        // Sort objects by the sort descriptors
++ (NSArray *)ft_arrayBySortingObjects:(NSSet *)objects
+                       byOrderInArray:(NSArray *)referenceArray
+{
+    return [self ft_arrayBySortingObjects:objects
+                              byPositions:[self ft_positionsOfObjects:objects inArray:referenceArray]];
+}
 
-        for (NSSortDescriptor *sortDescriptor in sortDescriptors) {
-            NSComparisonResult result = [sortDescriptor compareObject:firstObject toObject:secondObject];
-            switch (result) {
-            case NSOrderedAscending:
-            case NSOrderedDescending:
-                return result;
-            default:
-                break;
-            }
-        }
++ (NSArray *)ft_arrayBySortingObjects:(NSSet *)objects
+                 usingSortDescriptors:(NSArray *)sortDescriptors
+     orderAmbiguousObjectsByPositions:(NSMapTable *)positions
+{
+    FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:sortDescriptors];
+    NSComparator comperator = [sortKeyCache comperator];
 
-        // If the sort order is ambiguous (based on the sort descriptors),
-        // order the objects by the order in the backing store.
+    // Sort the objects by their position first. Because the sort is stable, objects
+    // with an ambiguous sort order (based on the sort descriptors) keep this order.
 
-        NSInteger firstIndex = [referenceArray indexOfObject:firstObject];
-        NSInteger secondIndex = [referenceArray indexOfObject:secondObject];
+    NSArray *objectsByPosition = [self ft_arrayBySortingObjects:objects byPositions:positions];
 
-        if (firstIndex == secondIndex) {
-            return NSOrderedSame; // should never happen
-        } else if (firstIndex < secondIndex) {
-            return NSOrderedAscending;
-        } else {
-            return NSOrderedDescending;
-        }
-
-    }];
+    return [objectsByPosition sortedArrayWithOptions:NSSortStable
+                                     usingComparator:comperator];
 }
 
 + (NSArray *)ft_arrayBySortingObjects:(NSSet *)objects
-                       byOrderInArray:(NSArray *)referenceArray
+                          byPositions:(NSMapTable *)positions
 {
-    return [[objects allObjects] sortedArrayUsingComparator:^(id firstObject, id secondObject) {
+    return [[objects allObjects] sortedArrayWithOptions:NSSortStable usingComparator:^(id firstObject, id secondObject) {
 
         // Early return, if the first object is the second object
 
@@ -63,13 +55,16 @@
             return NSOrderedSame;
         }
 
-        // Order the objects by the order in the backing store.
+        // Order the objects by the position in the reference array.
 
-        NSInteger firstIndex = [referenceArray indexOfObject:firstObject];
-        NSInteger secondIndex = [referenceArray indexOfObject:secondObject];
+        NSNumber *firstPosition = [positions objectForKey:firstObject];
+        NSNumber *secondPosition = [positions objectForKey:secondObject];
+
+        NSUInteger firstIndex = firstPosition ? [firstPosition unsignedIntegerValue] : NSNotFound;
+        NSUInteger secondIndex = secondPosition ? [secondPosition unsignedIntegerValue] : NSNotFound;
 
         if (firstIndex == secondIndex) {
-            return NSOrderedSame; // should never happen
+            return NSOrderedSame; // should only happen for objects without a position
         } else if (firstIndex < secondIndex) {
             return NSOrderedAscending;
         } else {
@@ -78,4 +73,33 @@
     }];
 }
 
++ (NSMapTable *)ft_positionsOfObjects:(NSSet *)objects inArray:(NSArray *)referenceArray
+{
+    NSMapTable *positions = [NSMapTable strongToStrongObjectsMapTable];
+
+    NSUInteger numberOfObjects = [objects count];
+    if (numberOfObjects > 0) {
+        [referenceArray enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+            if ([objects containsObject:obj] && [positions objectForKey:obj] == nil) {
+                [positions setObject:@(idx) forKey:obj];
+                *stop = [positions count] == numberOfObjects;
+            }
+        }];
+    }
+
+    return positions;
+}
+
+- (BOOL)ft_isSortedUsingComparator:(NSComparator)comparator
+{
+    id previousObject = nil;
+    for (id object in self) {
+        if (previousObject && comparator(previousObject, object) == NSOrderedDescending) {
+            return NO;
+        }
+        previousObject = object;
+    }
+    return YES;
+}
+
 @end
@@ -0,0 +1,270 @@
+//
+//  FTChangeSetTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 22.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#define HC_SHORTHAND
+#define MOCKITO_SHORTHAND
+
+#import <Fountain/Fountain.h>
+#import <OCHamcrest/OCHamcrest.h>
+#import <OCMockito/OCMockito.h>
+#import <XCTest/XCTest.h>
+
+#define IDX(item, section) [[NSIndexPath indexPathWithIndex:section] indexPathByAddingIndex:item]
+
+@interface FTChangeSetTests : XCTestCase
+
+@end
+
+@implementation FTChangeSetTests
+
+#pragma mark Test Life-cycle
+
+- (void)testInit
+{
+    FTChangeSet *changeSet = [[FTChangeSet alloc] init];
+
+    XCTAssertTrue([changeSet isEmpty]);
+    XCTAssertEqual([[changeSet insertedSections] count], 0);
+    XCTAssertEqual([[changeSet insertedItemsInSection:0] count], 0);
+}
+
+#pragma mark Test Recording Changes
+
+- (void)testRecordChanges
+{
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+
+    [changeSet insertSections:[NSIndexSet indexSetWithIndex:3]];
+    [changeSet deleteSections:[NSIndexSet indexSetWithIndex:1]];
+    [changeSet insertItemsAtIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 100)] inSection:0];
+    [changeSet insertItemsAtIndexPaths:@[ IDX(200, 0), IDX(5, 2) ]];
+    [changeSet changeItemsAtIndexes:[NSIndexSet indexSetWithIndex:7] inSection:2];
+    [changeSet moveItemAtIndexPath:IDX(1, 2) toIndexPath:IDX(4, 2)];
+
+    FTChangeSet *copy = [changeSet copy];
+
+    XCTAssertFalse([copy isEmpty]);
+    XCTAssertFalse([copy isKindOfClass:[FTMutableChangeSet class]]);
+
+    XCTAssertEqualObjects([copy insertedSections], [NSIndexSet indexSetWithIndex:3]);
+    XCTAssertEqualObjects([copy deletedSections], [NSIndexSet indexSetWithIndex:1]);
+
+    NSMutableIndexSet *expectedItems = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 100)];
+    [expectedItems addIndex:200];
+    XCTAssertEqualObjects([copy insertedItemsInSection:0], expectedItems);
+    XCTAssertEqualObjects([copy insertedItemsInSection:2], [NSIndexSet indexSetWithIndex:5]);
+    XCTAssertEqualObjects([copy changedItemsInSection:2], [NSIndexSet indexSetWithIndex:7]);
+
+    NSMutableArray *sections = [[NSMutableArray alloc] init];
+    [copy enumerateInsertedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [sections addObject:@(section)];
+    }];
+    XCTAssertEqualObjects(sections, (@[ @(0), @(2) ]));
+
+    __block NSUInteger numberOfMoves = 0;
+    [copy enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        XCTAssertEqualObjects(indexPath, IDX(1, 2));
+        XCTAssertEqualObjects(newIndexPath, IDX(4, 2));
+        numberOfMoves++;
+    }];
+    XCTAssertEqual(numberOfMoves, 1);
+
+    // Changes after copying do not affect the copy
+
+    [changeSet removeAllChanges];
+
+    XCTAssertTrue([changeSet isEmpty]);
+    XCTAssertFalse([copy isEmpty]);
+}
+
+- (void)testAddChangesWithSectionOffset
+{
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+    [changeSet insertSections:[NSIndexSet indexSetWithIndex:0]];
+    [changeSet deleteItemsAtIndexes:[NSIndexSet indexSetWithIndex:2] inSection:1];
+    [changeSet moveSection:0 toSection:1];
+    [changeSet moveItemAtIndexPath:IDX(0, 1) toIndexPath:IDX(3, 1)];
+
+    FTMutableChangeSet *combinedChangeSet = [[FTMutableChangeSet alloc] init];
+    [combinedChangeSet addChangesFromChangeSet:changeSet sectionOffset:5];
+
+    XCTAssertEqualObjects([combinedChangeSet insertedSections], [NSIndexSet indexSetWithIndex:5]);
+    XCTAssertEqualObjects([combinedChangeSet deletedItemsInSection:6], [NSIndexSet indexSetWithIndex:2]);
+    XCTAssertEqual([[combinedChangeSet deletedItemsInSection:1] count], 0);
+
+    [combinedChangeSet enumerateSectionMovesUsingBlock:^(NSUInteger section, NSUInteger newSection, BOOL *stop) {
+        XCTAssertEqual(section, 5);
+        XCTAssertEqual(newSection, 6);
+    }];
+
+    [combinedChangeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        XCTAssertEqualObjects(indexPath, IDX(0, 6));
+        XCTAssertEqualObjects(newIndexPath, IDX(3, 6));
+    }];
+}
+
+#pragma mark Test Computing Change Sets
+
+- (void)testChangeSetFromSections
+{
+    NSArray *sections = @[ @[ @"a", @"b", @"c" ], @[ @"d", @"e" ], @[ @"f" ] ];
+    NSArray *sectionItems = @[ @"x", @"y", @"z" ];
+
+    // Section "y" is removed, section "w" is inserted, "c" moves into
+    // section "z", "b" moves in front of "a", which is changed, and "f"
+    // keeps its position.
+
+    NSArray *newSections = @[ @[ @"b", @"a" ], @[ @"f", @"c" ], @[ @"g" ] ];
+    NSArray *newSectionItems = @[ @"x", @"z", @"w" ];
+
+    FTChangeSet *changeSet = [FTChangeSet changeSetFromSections:sections
+                                                   sectionItems:sectionItems
+                                                     toSections:newSections
+                                                   sectionItems:newSectionItems
+                                                   changedItems:[NSSet setWithObject:@"a"]];
+
+    XCTAssertEqualObjects([changeSet deletedSections], [NSIndexSet indexSetWithIndex:1]);
+    XCTAssertEqualObjects([changeSet insertedSections], [NSIndexSet indexSetWithIndex:2]);
+    XCTAssertEqual([[changeSet changedSections] count], 0);
+
+    XCTAssertEqual([[changeSet deletedItemsInSection:0] count], 0);
+    XCTAssertEqual([[changeSet insertedItemsInSection:1] count], 0);
+    XCTAssertEqualObjects([changeSet changedItemsInSection:0], [NSIndexSet indexSetWithIndex:0]);
+
+    NSMutableArray *moves = [[NSMutableArray alloc] init];
+    [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        [moves addObject:@[ indexPath, newIndexPath ]];
+    }];
+    assertThat(moves, containsInAnyOrder(@[ IDX(1, 0), IDX(0, 0) ], @[ IDX(2, 0), IDX(1, 1) ], nil));
+}
+
+- (void)testChangeSetFromSectionsWithMovedChangedItems
+{
+    NSNull *null = [NSNull null];
+
+    // "c" moves in front of "a" and "d" moves into the first section. Both
+    // are changed and reported as moved and as changed at their old index.
+
+    FTChangeSet *changeSet = [FTChangeSet changeSetFromSections:@[ @[ @"a", @"b", @"c" ], @[ @"d", @"e" ] ]
+                                                   sectionItems:@[ null, null ]
+                                                     toSections:@[ @[ @"c", @"a", @"b", @"d" ], @[ @"e" ] ]
+                                                   sectionItems:@[ null, null ]
+                                                   changedItems:[NSSet setWithObjects:@"c", @"d", nil]];
+
+    XCTAssertEqualObjects([changeSet changedItemsInSection:0], [NSIndexSet indexSetWithIndex:2]);
+    XCTAssertEqualObjects([changeSet changedItemsInSection:1], [NSIndexSet indexSetWithIndex:0]);
+
+    NSMutableArray *moves = [[NSMutableArray alloc] init];
+    [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        [moves addObject:@[ indexPath, newIndexPath ]];
+    }];
+    assertThat(moves, containsInAnyOrder(@[ IDX(2, 0), IDX(0, 0) ], @[ IDX(0, 1), IDX(3, 0) ], nil));
+
+    assertThat([changeSet description], containsSubstring(@"moved item: (0, 2) -> (0, 0)"));
+}
+
+- (void)testChangeSetFromSectionsWithoutSectionItems
+{
+    NSNull *null = [NSNull null];
+
+    FTChangeSet *changeSet = [FTChangeSet changeSetFromSections:@[ @[ @"a" ], @[ @"b" ] ]
+                                                   sectionItems:@[ null, null ]
+                                                     toSections:@[ @[ @"a", @"c" ] ]
+                                                   sectionItems:@[ null ]
+                                                   changedItems:nil];
+
+    XCTAssertEqualObjects([changeSet deletedSections], [NSIndexSet indexSetWithIndex:1]);
+    XCTAssertEqualObjects([changeSet insertedItemsInSection:0], [NSIndexSet indexSetWithIndex:1]);
+    XCTAssertEqual([[changeSet changedItemsInSection:0] count], 0);
+}
+
+#pragma mark Test Applying Changes
+
+- (void)testApplyToSections
+{
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+    [changeSet insertSections:[NSIndexSet indexSetWithIndex:0]];
+    [changeSet deleteItemsAtIndexes:[NSIndexSet indexSetWithIndex:0] inSection:0];
+    [changeSet insertItemsAtIndexes:[NSIndexSet indexSetWithIndex:0] inSection:2];
+    [changeSet moveItemAtIndexPath:IDX(1, 0) toIndexPath:IDX(1, 2)];
+
+    NSMutableArray *sections = [@[ [@[ @"a", @"b", @"c" ] mutableCopy], [@[ @"d" ] mutableCopy] ] mutableCopy];
+    NSMutableArray *sectionItems = [@[ @"A", @"B" ] mutableCopy];
+
+    XCTAssertTrue([changeSet isValidForNumberOfItemsInSections:@[ @(3), @(1) ]]);
+
+    BOOL success = [changeSet applyToSections:sections
+                                 sectionItems:sectionItems
+                            insertedItemBlock:^id(NSIndexPath *indexPath) {
+                                return @"x";
+                            }
+                     insertedSectionItemBlock:^id(NSUInteger section) {
+                         return @"X";
+                     }];
+
+    XCTAssertTrue(success);
+    XCTAssertEqualObjects(sectionItems, (@[ @"X", @"A", @"B" ]));
+    XCTAssertEqualObjects(sections, (@[ @[], @[ @"c" ], @[ @"x", @"b", @"d" ] ]));
+}
+
+- (void)testIndexPathAfterChanges
+{
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+    [changeSet insertSections:[NSIndexSet indexSetWithIndex:0]];
+    [changeSet deleteSections:[NSIndexSet indexSetWithIndex:1]];
+    [changeSet deleteItemsAtIndexes:[NSIndexSet indexSetWithIndex:0] inSection:0];
+    [changeSet insertItemsAtIndexes:[NSIndexSet indexSetWithIndex:0] inSection:1];
+    [changeSet moveItemAtIndexPath:IDX(1, 0) toIndexPath:IDX(0, 2)];
+
+    assertThatUnsignedInteger([changeSet sectionAfterChangesOfSection:0], equalToUnsignedInteger(1));
+    assertThatUnsignedInteger([changeSet sectionAfterChangesOfSection:1], equalToUnsignedInteger(NSNotFound));
+    assertThatUnsignedInteger([changeSet sectionAfterChangesOfSection:2], equalToUnsignedInteger(2));
+
+    assertThat([changeSet indexPathAfterChangesOfItemAtIndexPath:IDX(0, 0)], nilValue());
+    assertThat([changeSet indexPathAfterChangesOfItemAtIndexPath:IDX(0, 1)], nilValue());
+    assertThat([changeSet indexPathAfterChangesOfItemAtIndexPath:IDX(1, 0)], equalTo(IDX(0, 2)));
+    assertThat([changeSet indexPathAfterChangesOfItemAtIndexPath:IDX(2, 0)], equalTo(IDX(1, 1)));
+    assertThat([changeSet indexPathAfterChangesOfItemAtIndexPath:IDX(0, 2)], equalTo(IDX(1, 2)));
+}
+
+- (void)testApplyInvalidChanges
+{
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+    [changeSet deleteItemsAtIndexes:[NSIndexSet indexSetWithIndex:3] inSection:0];
+
+    XCTAssertFalse([changeSet isValidForNumberOfItemsInSections:@[ @(3) ]]);
+
+    NSMutableArray *sections = [@[ [@[ @"a", @"b", @"c" ] mutableCopy] ] mutableCopy];
+    XCTAssertFalse([changeSet applyToSections:sections sectionItems:[@[ @"A" ] mutableCopy] insertedItemBlock:nil insertedSectionItemBlock:nil]);
+}
+
+#pragma mark Test Notifying Observers
+
+- (void)testNotifyObserver
+{
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+    [changeSet insertSections:[NSIndexSet indexSetWithIndex:1]];
+    [changeSet insertItemsAtIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)] inSection:0];
+    [changeSet deleteItemsAtIndexes:[NSIndexSet indexSetWithIndex:4] inSection:0];
+    [changeSet changeItemsAtIndexes:[NSIndexSet indexSetWithIndex:3] inSection:0];
+    [changeSet moveItemAtIndexPath:IDX(5, 0) toIndexPath:IDX(6, 0)];
+
+    FTMutableArray *dataSource = [FTMutableArray array];
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+
+    [changeSet notifyObserver:observer ofChangesInDataSource:dataSource];
+
+    [verifyCount(observer, times(1)) dataSource:dataSource didInsertSections:[NSIndexSet indexSetWithIndex:1]];
+    [verifyCount(observer, times(1)) dataSource:dataSource didInsertItemsAtIndexPaths:@[ IDX(0, 0), IDX(1, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:dataSource didDeleteItemsAtIndexPaths:@[ IDX(4, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:dataSource didChangeItemsAtIndexPaths:@[ IDX(3, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:dataSource didMoveItemAtIndexPath:IDX(5, 0) toIndexPath:IDX(6, 0)];
+    [verifyCount(observer, never()) dataSource:dataSource didDeleteSections:anything()];
+}
+
+@end
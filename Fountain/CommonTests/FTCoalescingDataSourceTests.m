@@ -0,0 +1,308 @@
+//
+//  FTCoalescingDataSourceTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 30.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#define HC_SHORTHAND
+#define MOCKITO_SHORTHAND
+
+#import <Fountain/Fountain.h>
+#import <OCHamcrest/OCHamcrest.h>
+#import <OCMockito/OCMockito.h>
+#import <XCTest/XCTest.h>
+
+#import "FTTestItem.h"
+
+#define IDX(item, section) [[NSIndexPath indexPathWithIndex:section] indexPathByAddingIndex:item]
+
+@interface FTCoalescingDataSourceTestsObserver : NSObject <FTDataSourceChangeSetObserver>
+@property (nonatomic, readonly) NSUInteger numberOfCallbacks;
+@end
+
+@implementation FTCoalescingDataSourceTestsObserver
+- (void)dataSourceWillChange:(id<FTDataSource>)dataSource { _numberOfCallbacks++; }
+- (void)dataSource:(id<FTDataSource>)dataSource didApplyChangeSet:(FTChangeSet *)changeSet { _numberOfCallbacks++; }
+- (void)dataSourceDidChange:(id<FTDataSource>)dataSource { _numberOfCallbacks++; }
+@end
+
+// Counts the items read from the wrapped array.
+@interface FTCoalescingDataSourceTestsCountingDataSource : NSObject <FTDataSource>
+- (instancetype)initWithArray:(FTMutableArray *)array;
+@property (nonatomic, readonly) NSUInteger numberOfReadItems;
+@end
+
+@implementation FTCoalescingDataSourceTestsCountingDataSource {
+    FTMutableArray *_array;
+}
+- (instancetype)initWithArray:(FTMutableArray *)array
+{
+    self = [super init];
+    if (self) {
+        _array = array;
+    }
+    return self;
+}
+- (NSUInteger)numberOfSections { return [_array numberOfSections]; }
+- (NSUInteger)numberOfItemsInSection:(NSUInteger)section { return [_array numberOfItemsInSection:section]; }
+- (id)sectionItemForSection:(NSUInteger)section { return [_array sectionItemForSection:section]; }
+- (id)itemAtIndexPath:(NSIndexPath *)indexPath
+{
+    _numberOfReadItems++;
+    return [_array itemAtIndexPath:indexPath];
+}
+- (NSArray *)observers { return [_array observers]; }
+- (void)addObserver:(id<FTDataSourceObserver>)observer { [_array addObserver:observer]; }
+- (void)removeObserver:(id<FTDataSourceObserver>)observer { [_array removeObserver:observer]; }
+@end
+
+@interface FTCoalescingDataSourceTests : XCTestCase
+
+@end
+
+@implementation FTCoalescingDataSourceTests
+
+#pragma mark Test Coalescing Changes
+
+- (void)testCoalesceBatches
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @"a" ]];
+    FTCoalescingDataSource *dataSource = [[FTCoalescingDataSource alloc] initWithDataSource:array];
+
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [dataSource addObserver:observer];
+
+    [array addObject:@"b"];
+    [array addObject:@"c"];
+    [array removeObjectAtIndex:0];
+
+    // Nothing is published before the changes are flushed
+
+    XCTAssertTrue([dataSource hasPendingChanges]);
+    assertThat([dataSource itemAtIndexPath:IDX(0, 0)], equalTo(@"a"));
+    [verifyCount(observer, never()) dataSourceWillChange:dataSource];
+
+    [dataSource flush];
+
+    XCTAssertFalse([dataSource hasPendingChanges]);
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(2));
+    assertThat([dataSource indexPathsOfItem:@"c"], contains(IDX(1, 0), nil));
+
+    HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(1)) dataSourceWillChange:dataSource];
+    [verifyCount(observer, times(1)) dataSource:dataSource didApplyChangeSet:(id)changeSetCaptor];
+    [verifyCount(observer, times(1)) dataSourceDidChange:dataSource];
+
+    FTChangeSet *changeSet = [changeSetCaptor value];
+    assertThat([changeSet deletedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndex:0]));
+    assertThat([changeSet insertedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]));
+}
+
+- (void)testInsertAndDeleteCancelOut
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @"a" ]];
+    FTCoalescingDataSource *dataSource = [[FTCoalescingDataSource alloc] initWithDataSource:array];
+
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [dataSource addObserver:observer];
+
+    [array addObject:@"b"];
+    [array removeObject:@"b"];
+    [dataSource flush];
+
+    XCTAssertFalse([dataSource hasPendingChanges]);
+    [verifyCount(observer, never()) dataSourceWillChange:dataSource];
+    [verifyCount(observer, never()) dataSourceDidChange:dataSource];
+}
+
+- (void)testMergeChangesOfItem
+{
+    NSMutableString *a = [@"a" mutableCopy];
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ a, @"b" ]];
+    FTCoalescingDataSource *dataSource = [[FTCoalescingDataSource alloc] initWithDataSource:array];
+
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [dataSource addObserver:observer];
+
+    // The wrapped array reports a change of the identical object twice
+
+    [array replaceObjectAtIndex:0 withObject:a];
+    [array insertObject:@"c" atIndex:0];
+    [array replaceObjectAtIndex:1 withObject:a];
+    [dataSource flush];
+
+    [verifyCount(observer, times(1)) dataSourceWillChange:dataSource];
+    [verifyCount(observer, times(1)) dataSource:dataSource didInsertItemsAtIndexPaths:@[ IDX(0, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:dataSource didChangeItemsAtIndexPaths:@[ IDX(0, 0) ]];
+    [verifyCount(observer, never()) dataSource:dataSource didDeleteItemsAtIndexPaths:anything()];
+    [verifyCount(observer, times(1)) dataSourceDidChange:dataSource];
+}
+
+- (void)testReplaceItem
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @"a", @"b", @"c" ]];
+    FTCoalescingDataSource *dataSource = [[FTCoalescingDataSource alloc] initWithDataSource:array];
+
+    [array insertObject:@"x" atIndex:0];
+    [array replaceObjectAtIndex:2 withObject:@"y"];
+    [dataSource flush];
+
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(4));
+    assertThat([dataSource itemAtIndexPath:IDX(0, 0)], equalTo(@"x"));
+    assertThat([dataSource itemAtIndexPath:IDX(2, 0)], equalTo(@"y"));
+}
+
+- (void)testChangeAndInsertInOneBatch
+{
+    FTTestItem *item = ITEM(30);
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ]];
+    [set addObjectsFromArray:@[ ITEM(10), ITEM(20), item ]];
+
+    FTCoalescingDataSource *dataSource = [[FTCoalescingDataSource alloc] initWithDataSource:set];
+
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [dataSource addObserver:observer];
+
+    // The change of the item refers to the state before the insertion
+
+    [set performBatchUpdate:^{
+        [set addObject:ITEM(5)];
+        [set addObject:item];
+    }];
+    [dataSource flush];
+
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(4));
+    assertThat([dataSource itemAtIndexPath:IDX(3, 0)], sameInstance(item));
+
+    [verifyCount(observer, times(1)) dataSource:dataSource didInsertItemsAtIndexPaths:@[ IDX(0, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:dataSource didChangeItemsAtIndexPaths:@[ IDX(2, 0) ]];
+}
+
+- (void)testReadOnlyChangedItems
+{
+    NSMutableArray *items = [[NSMutableArray alloc] init];
+    for (NSUInteger i = 0; i < 1000; i++) {
+        [items addObject:@(i)];
+    }
+
+    FTMutableArray *array = [FTMutableArray arrayWithArray:items];
+    FTCoalescingDataSourceTestsCountingDataSource *countingDataSource = [[FTCoalescingDataSourceTestsCountingDataSource alloc] initWithArray:array];
+    FTCoalescingDataSource *dataSource = [[FTCoalescingDataSource alloc] initWithDataSource:countingDataSource];
+
+    XCTAssertEqual(countingDataSource.numberOfReadItems, 1000);
+
+    // Only the inserted items are read, not the whole data source per batch.
+
+    for (NSUInteger i = 0; i < 10; i++) {
+        [array insertObject:@(1000 + i) atIndex:i * 10];
+        [array removeObjectAtIndex:500];
+    }
+    [dataSource flush];
+
+    XCTAssertEqual(countingDataSource.numberOfReadItems, 1010);
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(1000));
+    assertThat([dataSource itemAtIndexPath:IDX(90, 0)], equalTo(@1009));
+}
+
+- (void)testResetOfDataSource
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @"a", @"b", @"c" ]];
+    FTCoalescingDataSource *dataSource = [[FTCoalescingDataSource alloc] initWithDataSource:array];
+
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [dataSource addObserver:observer];
+
+    // Simulate a reset of the wrapped data source, which does not report
+    // the individual changes. The reset is published as the difference to
+    // the published state.
+
+    [array removeObserver:(id<FTDataSourceObserver>)dataSource];
+    [array removeObject:@"b"];
+    [(id<FTDataSourceObserver>)dataSource dataSourceDidReset:array];
+    [dataSource flush];
+
+    [verifyCount(observer, never()) dataSourceWillReset:dataSource];
+    [verifyCount(observer, times(1)) dataSource:dataSource didDeleteItemsAtIndexPaths:@[ IDX(1, 0) ]];
+}
+
+#pragma mark Test Publishing Changes
+
+- (void)testPublishAtEndOfRunLoopTurn
+{
+    FTMutableArray *array = [FTMutableArray array];
+    FTCoalescingDataSource *dataSource = [[FTCoalescingDataSource alloc] initWithDataSource:array];
+
+    FTCoalescingDataSourceTestsObserver *observer = [[FTCoalescingDataSourceTestsObserver alloc] init];
+    [dataSource addObserver:observer];
+
+    [array addObject:@"a"];
+    [array addObject:@"b"];
+
+    XCTAssertTrue([dataSource hasPendingChanges]);
+
+    [self expectationForPredicate:[NSPredicate predicateWithFormat:@"hasPendingChanges == NO"] evaluatedWithObject:dataSource handler:nil];
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+
+    XCTAssertEqual([observer numberOfCallbacks], 3);
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(2));
+}
+
+- (void)testPublishAfterInterval
+{
+    FTMutableArray *array = [FTMutableArray array];
+    FTCoalescingDataSource *dataSource = [[FTCoalescingDataSource alloc] initWithDataSource:array interval:0.05];
+
+    [array addObject:@"a"];
+
+    [self expectationForPredicate:[NSPredicate predicateWithFormat:@"hasPendingChanges == NO"] evaluatedWithObject:dataSource handler:nil];
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(1));
+}
+
+#pragma mark Test Number of Callbacks
+
+- (void)testNumberOfCallbacks
+{
+    FTMutableArray *array = [FTMutableArray array];
+    FTCoalescingDataSource *dataSource = [[FTCoalescingDataSource alloc] initWithDataSource:array];
+
+    FTCoalescingDataSourceTestsObserver *directObserver = [[FTCoalescingDataSourceTestsObserver alloc] init];
+    FTCoalescingDataSourceTestsObserver *coalescedObserver = [[FTCoalescingDataSourceTestsObserver alloc] init];
+    [array addObserver:directObserver];
+    [dataSource addObserver:coalescedObserver];
+
+    for (NSUInteger i = 0; i < 100; i++) {
+        [array addObject:@(i)];
+    }
+    for (NSUInteger i = 0; i < 50; i++) {
+        [array removeObjectAtIndex:0];
+    }
+    [dataSource flush];
+
+    // Each of the 150 batches of the array results in three callbacks
+    // (will change, change set, did change), the wrapper publishes one.
+
+    XCTAssertEqual([directObserver numberOfCallbacks], 450);
+    XCTAssertEqual([coalescedObserver numberOfCallbacks], 3);
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(50));
+}
+
+- (void)testPerformanceOfCoalescingBurst
+{
+    [self measureBlock:^{
+        FTMutableArray *array = [FTMutableArray array];
+        FTCoalescingDataSource *dataSource = [[FTCoalescingDataSource alloc] initWithDataSource:array];
+        FTCoalescingDataSourceTestsObserver *observer = [[FTCoalescingDataSourceTestsObserver alloc] init];
+        [dataSource addObserver:observer];
+
+        for (NSUInteger i = 0; i < 500; i++) {
+            [array addObject:@(i)];
+        }
+        [dataSource flush];
+    }];
+}
+
+@end
@@ -16,6 +16,113 @@
 
 #define IDX(item, section) [[NSIndexPath indexPathWithIndex:section] indexPathByAddingIndex:item]
 
+// A data source with several sections, which reports the changes given with the new sections.
+@interface FTCombinedDataSourceTestsDataSource : NSObject <FTReverseDataSource>
+- (instancetype)initWithSections:(NSArray *)sections;
+- (void)setSections:(NSArray *)sections changeSet:(FTChangeSet *)changeSet;
+@property (nonatomic, readonly) NSUInteger numberOfItemRequests;
+@property (nonatomic, readonly) NSUInteger numberOfReverseLookups;
+@end
+
+@interface FTCombinedDataSourceTestsPrefetchingDataSource : FTCombinedDataSourceTestsDataSource <FTPrefetchingDataSource>
+@end
+
+@implementation FTCombinedDataSourceTestsDataSource {
+    NSArray *_sections;
+    NSHashTable *_observers;
+}
+
+- (instancetype)initWithSections:(NSArray *)sections
+{
+    self = [super init];
+    if (self) {
+        _sections = [sections copy];
+        _observers = [NSHashTable weakObjectsHashTable];
+    }
+    return self;
+}
+
+- (void)setSections:(NSArray *)sections changeSet:(FTChangeSet *)changeSet
+{
+    for (id<FTDataSourceObserver> observer in [_observers allObjects]) {
+        [observer dataSourceWillChange:self];
+    }
+    _sections = [sections copy];
+    for (id<FTDataSourceObserver> observer in [_observers allObjects]) {
+        [(id<FTDataSourceChangeSetObserver>)observer dataSource:self didApplyChangeSet:changeSet];
+        [observer dataSourceDidChange:self];
+    }
+}
+
+- (NSUInteger)numberOfSections
+{
+    return [_sections count];
+}
+
+- (NSUInteger)numberOfItemsInSection:(NSUInteger)section
+{
+    return [_sections[section] count];
+}
+
+- (id)sectionItemForSection:(NSUInteger)section
+{
+    return nil;
+}
+
+- (id)itemAtIndexPath:(NSIndexPath *)indexPath
+{
+    _numberOfItemRequests++;
+    return _sections[[indexPath indexAtPosition:0]][[indexPath indexAtPosition:1]];
+}
+
+- (NSIndexSet *)sectionsOfSectionItem:(id)sectionItem
+{
+    return [NSIndexSet indexSet];
+}
+
+- (NSArray *)indexPathsOfItem:(id)item
+{
+    _numberOfReverseLookups++;
+    NSMutableArray *indexPaths = [[NSMutableArray alloc] init];
+    [_sections enumerateObjectsUsingBlock:^(NSArray *items, NSUInteger section, BOOL *stop) {
+        [items enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+            if ([obj isEqual:item]) {
+                [indexPaths addObject:IDX(idx, section)];
+            }
+        }];
+    }];
+    return indexPaths;
+}
+
+- (NSArray *)observers
+{
+    return [_observers allObjects];
+}
+
+- (void)addObserver:(id<FTDataSourceObserver>)observer
+{
+    [_observers addObject:observer];
+}
+
+- (void)removeObserver:(id<FTDataSourceObserver>)observer
+{
+    [_observers removeObject:observer];
+}
+
+@end
+
+@implementation FTCombinedDataSourceTestsPrefetchingDataSource
+
+- (void)prefetchItemsAtIndexPaths:(NSArray *)indexPaths
+{
+}
+
+- (void)cancelPrefetchingForItemsAtIndexPaths:(NSArray *)indexPaths
+{
+}
+
+@end
+
 @interface FTCombinedDataSourceTests : XCTestCase
 
 @end
@@ -41,4 +148,245 @@
     assertThat([dataSource itemAtIndexPath:IDX(2, 2)], equalTo(@"z"));
 }
 
+#pragma mark Test Section Mapping
+
+- (void)testSectionMapping
+{
+    FTMutableArray *dataSourceA = [FTMutableArray arrayWithObjects:@"a", @"b", nil];
+    FTMutableSet *dataSourceB = [[FTMutableSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ]
+                                                         includeEmptySections:NO];
+    FTMutableArray *dataSourceC = [FTMutableArray arrayWithObjects:@"x", @"y", @"z", nil];
+
+    FTCombinedDataSource *dataSource = [[FTCombinedDataSource alloc] initWithDataSources:@[ dataSourceA, dataSourceB, dataSourceC ]];
+
+    assertThatInteger([dataSource numberOfSections], equalToInteger(2));
+    assertThat([dataSource dataSourceOfIndexPath:IDX(0, 1)], sameInstance(dataSourceC));
+    assertThat([dataSource dataSourceOfIndexPath:IDX(0, 2)], nilValue());
+    assertThatInteger([dataSource convertSection:1 toDataSource:dataSourceC], equalToInteger(0));
+
+    [dataSourceB addObject:@"1"];
+
+    assertThatInteger([dataSource numberOfSections], equalToInteger(3));
+    assertThat([dataSource dataSourceOfIndexPath:IDX(0, 1)], sameInstance(dataSourceB));
+    assertThat([dataSource dataSourceOfIndexPath:IDX(0, 2)], sameInstance(dataSourceC));
+    assertThatInteger([dataSource convertSection:2 toDataSource:dataSourceC], equalToInteger(0));
+    assertThatInteger([dataSource convertSection:0 fromDataSource:dataSourceC], equalToInteger(2));
+    assertThat([dataSource itemAtIndexPath:IDX(0, 1)], equalTo(@"1"));
+    assertThat([dataSource itemAtIndexPath:IDX(2, 2)], equalTo(@"z"));
+
+    [dataSourceB removeObject:@"1"];
+
+    assertThatInteger([dataSource numberOfSections], equalToInteger(2));
+    assertThat([dataSource dataSourceOfIndexPath:IDX(0, 1)], sameInstance(dataSourceC));
+}
+
+#pragma mark Test Item Index
+
+- (void)testIndexPathsOfItem
+{
+    FTMutableArray *dataSourceA = [FTMutableArray arrayWithObjects:@"a", @"b", @"c", nil];
+    FTMutableArray *dataSourceB = [FTMutableArray arrayWithObjects:@"1", @"b", nil];
+
+    for (NSNumber *indexesItems in @[ @NO, @YES ]) {
+        FTCombinedDataSource *dataSource = [[FTCombinedDataSource alloc] initWithDataSources:@[ dataSourceA, dataSourceB ]];
+        dataSource.indexesItems = [indexesItems boolValue];
+
+        assertThat([dataSource indexPathsOfItem:@"b"], contains(IDX(1, 0), IDX(1, 1), nil));
+        assertThat([dataSource indexPathsOfItem:@"1"], contains(IDX(0, 1), nil));
+        assertThat([dataSource indexPathsOfItem:@"x"], hasCountOf(0));
+    }
+}
+
+- (void)testUpdateItemIndex
+{
+    FTMutableArray *dataSourceA = [FTMutableArray arrayWithObjects:@"a", @"b", @"c", nil];
+    FTMutableArray *dataSourceB = [FTMutableArray arrayWithObjects:@"1", @"2", nil];
+
+    FTCombinedDataSource *dataSource = [[FTCombinedDataSource alloc] initWithDataSources:@[ dataSourceA, dataSourceB ]];
+    dataSource.indexesItems = YES;
+
+    assertThat([dataSource indexPathsOfItem:@"x"], hasCountOf(0));
+
+    // Insertions are added to the index
+
+    [dataSourceB addObject:@"x"];
+    assertThat([dataSource indexPathsOfItem:@"x"], contains(IDX(2, 1), nil));
+
+    [dataSourceA insertObject:@"x" atIndex:0];
+    assertThat([dataSource indexPathsOfItem:@"x"], contains(IDX(0, 0), IDX(2, 1), nil));
+
+    // Moves keep the index
+
+    [dataSourceA moveObjectAtIndex:0 toIndex:3];
+    assertThat([dataSource indexPathsOfItem:@"x"], contains(IDX(3, 0), IDX(2, 1), nil));
+
+    // Deletions and replacements are removed from the index
+
+    [dataSourceB removeObject:@"x"];
+    assertThat([dataSource indexPathsOfItem:@"x"], contains(IDX(3, 0), nil));
+
+    [dataSourceA replaceObjectAtIndex:3 withObject:@"y"];
+    assertThat([dataSource indexPathsOfItem:@"x"], hasCountOf(0));
+    assertThat([dataSource indexPathsOfItem:@"y"], contains(IDX(3, 0), nil));
+
+    // An item contained more than once stays in the index until the last one is removed
+
+    [dataSourceA addObject:@"b"];
+    [dataSourceA removeObjectAtIndex:1];
+    assertThat([dataSource indexPathsOfItem:@"b"], contains(IDX(3, 0), nil));
+
+    [dataSourceA removeObject:@"b"];
+    assertThat([dataSource indexPathsOfItem:@"b"], hasCountOf(0));
+    assertThat([dataSource indexPathsOfItem:@"c"], contains(IDX(1, 0), nil));
+}
+
+- (void)testUpdateItemIndexWithMovesOfChangedSections
+{
+    FTMutableArray *dataSourceA = [FTMutableArray arrayWithObjects:@"1", nil];
+    FTCombinedDataSourceTestsDataSource *dataSourceB = [[FTCombinedDataSourceTestsDataSource alloc] initWithSections:@[ @[ @"a", @"b", @"c" ], @[ @"x", @"y" ] ]];
+
+    FTCombinedDataSource *dataSource = [[FTCombinedDataSource alloc] initWithDataSources:@[ dataSourceA, dataSourceB ]];
+    dataSource.indexesItems = YES;
+    assertThat([dataSource indexPathsOfItem:@"b"], contains(IDX(1, 1), nil));
+
+    // An item moved out of a changed section stays in the index
+
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+    [changeSet changeSections:[NSIndexSet indexSetWithIndex:0]];
+    [changeSet moveItemAtIndexPath:IDX(1, 0) toIndexPath:IDX(0, 1)];
+    [dataSourceB setSections:@[ @[ @"a", @"c" ], @[ @"b", @"x", @"y" ] ] changeSet:changeSet];
+
+    assertThat([dataSource indexPathsOfItem:@"b"], contains(IDX(0, 2), nil));
+    assertThat([dataSource indexPathsOfItem:@"c"], contains(IDX(1, 1), nil));
+
+    // An item moved into a changed section is indexed once
+
+    changeSet = [[FTMutableChangeSet alloc] init];
+    [changeSet changeSections:[NSIndexSet indexSetWithIndex:0]];
+    [changeSet moveItemAtIndexPath:IDX(2, 1) toIndexPath:IDX(0, 0)];
+    [dataSourceB setSections:@[ @[ @"y", @"a", @"c" ], @[ @"b", @"x" ] ] changeSet:changeSet];
+
+    assertThat([dataSource indexPathsOfItem:@"y"], contains(IDX(0, 1), nil));
+
+    changeSet = [[FTMutableChangeSet alloc] init];
+    [changeSet deleteItemsAtIndexPaths:@[ IDX(0, 0) ]];
+    [dataSourceB setSections:@[ @[ @"a", @"c" ], @[ @"b", @"x" ] ] changeSet:changeSet];
+
+    NSUInteger numberOfReverseLookups = dataSourceB.numberOfReverseLookups;
+    assertThat([dataSource indexPathsOfItem:@"y"], hasCountOf(0));
+    assertThatUnsignedInteger(dataSourceB.numberOfReverseLookups, equalToUnsignedInteger(numberOfReverseLookups));
+
+    // An item moved out of a deleted section stays in the index
+
+    changeSet = [[FTMutableChangeSet alloc] init];
+    [changeSet deleteSections:[NSIndexSet indexSetWithIndex:0]];
+    [changeSet moveItemAtIndexPath:IDX(1, 0) toIndexPath:IDX(0, 0)];
+    [dataSourceB setSections:@[ @[ @"c", @"b", @"x" ] ] changeSet:changeSet];
+
+    assertThat([dataSource indexPathsOfItem:@"c"], contains(IDX(0, 1), nil));
+    assertThat([dataSource indexPathsOfItem:@"a"], hasCountOf(0));
+}
+
+- (void)testItemIndexWithPrefetchingDataSource
+{
+    FTMutableArray *dataSourceA = [FTMutableArray arrayWithObjects:@"a", nil];
+    FTCombinedDataSourceTestsPrefetchingDataSource *dataSourceB = [[FTCombinedDataSourceTestsPrefetchingDataSource alloc] initWithSections:@[ @[ @"x", @"y" ] ]];
+
+    FTCombinedDataSource *dataSource = [[FTCombinedDataSource alloc] initWithDataSources:@[ dataSourceA, dataSourceB ]];
+    dataSource.indexesItems = YES;
+
+    // Data sources loading their items on demand are asked directly and not read for the index
+
+    assertThat([dataSource indexPathsOfItem:@"y"], contains(IDX(1, 1), nil));
+    assertThat([dataSource indexPathsOfItem:@"a"], contains(IDX(0, 0), nil));
+    assertThatUnsignedInteger(dataSourceB.numberOfItemRequests, equalToUnsignedInteger(0));
+
+    FTMutableChangeSet *changeSet = [[FTMutableChangeSet alloc] init];
+    [changeSet insertItemsAtIndexPaths:@[ IDX(0, 0) ]];
+    [dataSourceB setSections:@[ @[ @"z", @"x", @"y" ] ] changeSet:changeSet];
+
+    assertThat([dataSource indexPathsOfItem:@"z"], contains(IDX(0, 1), nil));
+    assertThatUnsignedInteger(dataSourceB.numberOfItemRequests, equalToUnsignedInteger(0));
+}
+
+#pragma mark Test Change Sets
+
+- (void)testForwardChangeSet
+{
+    FTMutableArray *dataSourceA = [FTMutableArray arrayWithObjects:@"a", @"b", @"c", @"d", nil];
+    FTMutableArray *dataSourceB = [FTMutableArray arrayWithObjects:@"1", @"2", @"3", @"4", @"5", nil];
+
+    FTCombinedDataSource *dataSource = [[FTCombinedDataSource alloc] initWithDataSources:@[ dataSourceA, dataSourceB ]];
+
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [dataSource addObserver:observer];
+
+    id<FTDataSourceObserver> legacyObserver = mockProtocol(@protocol(FTDataSourceObserver));
+    [dataSource addObserver:legacyObserver];
+
+    [dataSourceB addObjectsFromArray:@[ @"6", @"7" ]];
+
+    HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(1)) dataSource:dataSource didApplyChangeSet:(id)changeSetCaptor];
+
+    FTChangeSet *changeSet = [changeSetCaptor value];
+    assertThat([changeSet insertedItemsInSection:1], equalTo([NSIndexSet indexSetWithIndexesInRange:NSMakeRange(5, 2)]));
+    assertThat([changeSet insertedItemsInSection:0], hasCountOf(0));
+
+    [verifyCount(observer, never()) dataSource:dataSource didInsertItemsAtIndexPaths:anything()];
+    [verifyCount(legacyObserver, times(1)) dataSource:dataSource didInsertItemsAtIndexPaths:@[ IDX(5, 1), IDX(6, 1) ]];
+    [verifyCount(legacyObserver, times(1)) dataSourceDidChange:dataSource];
+}
+
+#pragma mark Test Performance
+
+- (void)testPerformanceOfLookingUpItems
+{
+    FTCombinedDataSource *dataSource = [self ft_dataSourceForPerformanceTests];
+    NSArray *items = [self ft_itemsForPerformanceTests];
+
+    [self measureBlock:^{
+        for (id item in items) {
+            [dataSource indexPathsOfItem:item];
+        }
+    }];
+}
+
+- (void)testPerformanceOfLookingUpItemsWithItemIndex
+{
+    FTCombinedDataSource *dataSource = [self ft_dataSourceForPerformanceTests];
+    dataSource.indexesItems = YES;
+    NSArray *items = [self ft_itemsForPerformanceTests];
+
+    [self measureBlock:^{
+        for (id item in items) {
+            [dataSource indexPathsOfItem:item];
+        }
+    }];
+}
+
+- (FTCombinedDataSource *)ft_dataSourceForPerformanceTests
+{
+    NSMutableArray *dataSources = [[NSMutableArray alloc] init];
+    for (NSUInteger i = 0; i < 200; i++) {
+        FTMutableArray *dataSource = [[FTMutableArray alloc] init];
+        for (NSUInteger j = 0; j < 100; j++) {
+            [dataSource addObject:@(i * 100 + j)];
+        }
+        [dataSources addObject:dataSource];
+    }
+    return [[FTCombinedDataSource alloc] initWithDataSources:dataSources];
+}
+
+- (NSArray *)ft_itemsForPerformanceTests
+{
+    // Only every tenth item is contained in one of the data sources
+
+    NSMutableArray *items = [[NSMutableArray alloc] init];
+    for (NSUInteger i = 0; i < 1000; i++) {
+        [items addObject:@(arc4random_uniform(200 * 100 * 10))];
+    }
+    return items;
+}
+
 @end
@@ -0,0 +1,211 @@
+//
+//  FTCompiledPredicateTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 01.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#define HC_SHORTHAND
+#define MOCKITO_SHORTHAND
+
+#import <Fountain/Fountain.h>
+#import <OCHamcrest/OCHamcrest.h>
+#import <OCMockito/OCMockito.h>
+#import <XCTest/XCTest.h>
+
+@interface FTCompiledPredicateTestsPerson : NSObject
+@property (nonatomic, copy) NSString *name;
+@property (nonatomic, strong) NSNumber *age;
+@property (nonatomic, assign) NSInteger rank;
+@property (nonatomic, strong) FTCompiledPredicateTestsPerson *parent;
+@property (nonatomic, copy) NSArray *tags;
+@end
+
+@implementation FTCompiledPredicateTestsPerson
+@end
+
+@interface FTCompiledPredicateTests : XCTestCase
+@property (nonatomic, strong) NSArray *objects;
+@end
+
+@implementation FTCompiledPredicateTests
+
+- (void)setUp
+{
+    [super setUp];
+
+    FTCompiledPredicateTestsPerson *anna = [[FTCompiledPredicateTestsPerson alloc] init];
+    anna.name = @"Anna";
+    anna.age = @(42);
+    anna.rank = 1;
+    anna.tags = @[ @"a", @"b" ];
+
+    FTCompiledPredicateTestsPerson *bert = [[FTCompiledPredicateTestsPerson alloc] init];
+    bert.name = @"Bért";
+    bert.age = @(12);
+    bert.rank = 2;
+    bert.parent = anna;
+    bert.tags = @[];
+
+    FTCompiledPredicateTestsPerson *carl = [[FTCompiledPredicateTestsPerson alloc] init];
+    carl.name = @"carl";
+    carl.rank = 3;
+    carl.parent = bert;
+
+    self.objects = @[ anna, bert, carl ];
+}
+
+#pragma mark Tests
+
+- (void)testCompiledPredicatesMatchNSPredicate
+{
+    NSArray *formats = @[ @"TRUEPREDICATE",
+                          @"FALSEPREDICATE",
+                          @"age == 42",
+                          @"age != 42",
+                          @"age < 20",
+                          @"age >= 12",
+                          @"age == nil",
+                          @"rank > 1",
+                          @"rank IN {1, 3}",
+                          @"name IN {'Anna', 'carl'}",
+                          @"name IN[c] {'anna', 'CARL'}",
+                          @"name BEGINSWITH 'A'",
+                          @"name BEGINSWITH[c] 'c'",
+                          @"name ENDSWITH 'rt'",
+                          @"name ENDSWITH[d] 'ert'",
+                          @"name CONTAINS[cd] 'ER'",
+                          @"tags CONTAINS 'b'",
+                          @"parent.name == 'Anna'",
+                          @"parent.parent.age == 42",
+                          @"age > 10 AND rank < 3",
+                          @"age > 20 OR rank == 3",
+                          @"NOT (name == 'Anna')",
+                          @"tags.@count > 0" ];
+
+    for (NSString *format in formats) {
+        NSPredicate *predicate = [NSPredicate predicateWithFormat:format];
+        FTCompiledPredicate *compiledPredicate = [FTCompiledPredicate compiledPredicateWithPredicate:predicate];
+        XCTAssertTrue([compiledPredicate isCompiled], @"%@", format);
+        XCTAssertFalse([compiledPredicate usesSubstitutionVariables], @"%@", format);
+
+        for (id object in self.objects) {
+            XCTAssertEqual([compiledPredicate evaluateWithObject:object], [predicate evaluateWithObject:object], @"%@", format);
+        }
+    }
+}
+
+- (void)testDictionaryItems
+{
+    // A dictionary returns the object for the key and not the result of
+    // the getter with the same name.
+
+    NSArray *dictionaries = @[ @{ @"description" : @"x", @"count" : @(5) },
+                               @{ @"description" : @"y" } ];
+    NSArray *formats = @[ @"description == 'x'",
+                          @"count == 5",
+                          @"count == 1" ];
+
+    for (NSString *format in formats) {
+        NSPredicate *predicate = [NSPredicate predicateWithFormat:format];
+        FTCompiledPredicate *compiledPredicate = [FTCompiledPredicate compiledPredicateWithPredicate:predicate];
+        XCTAssertTrue([compiledPredicate isCompiled], @"%@", format);
+
+        // The persons (without a count) are evaluated after the dictionaries,
+        // which changes the class of the getter resolved by the compiled key.
+
+        NSArray *objects = [format hasPrefix:@"count"] ? dictionaries : [dictionaries arrayByAddingObjectsFromArray:self.objects];
+        for (id object in objects) {
+            XCTAssertEqual([compiledPredicate evaluateWithObject:object], [predicate evaluateWithObject:object], @"%@ %@", format, object);
+        }
+    }
+
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"description == 'x'"];
+    FTCompiledPredicate *compiledPredicate = [FTCompiledPredicate compiledPredicateWithPredicate:predicate];
+    XCTAssertTrue([compiledPredicate evaluateWithObject:dictionaries[0]]);
+    XCTAssertFalse([compiledPredicate evaluateWithObject:dictionaries[1]]);
+}
+
+- (void)testClassCheck
+{
+    NSPredicate *predicate = [NSComparisonPredicate predicateWithLeftExpression:[NSExpression expressionForEvaluatedObject]
+                                                                rightExpression:[NSExpression expressionForConstantValue:[NSString class]]
+                                                                 customSelector:@selector(isKindOfClass:)];
+    FTCompiledPredicate *compiledPredicate = [FTCompiledPredicate compiledPredicateWithPredicate:predicate];
+
+    XCTAssertTrue([compiledPredicate isCompiled]);
+    XCTAssertTrue([compiledPredicate evaluateWithObject:@"a"]);
+    XCTAssertFalse([compiledPredicate evaluateWithObject:@(1)]);
+
+    predicate = [NSPredicate predicateWithFormat:@"SELF.class == %@", [FTCompiledPredicateTestsPerson class]];
+    compiledPredicate = [FTCompiledPredicate compiledPredicateWithPredicate:predicate];
+
+    XCTAssertTrue([compiledPredicate isCompiled]);
+    XCTAssertTrue([compiledPredicate evaluateWithObject:self.objects[0]]);
+    XCTAssertFalse([compiledPredicate evaluateWithObject:@"a"]);
+}
+
+- (void)testSubstitutionVariables
+{
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"$SECTION == 1 AND $ITEM < 10"];
+    FTCompiledPredicate *compiledPredicate = [FTCompiledPredicate compiledPredicateWithPredicate:predicate];
+
+    XCTAssertTrue([compiledPredicate isCompiled]);
+    XCTAssertTrue([compiledPredicate usesSubstitutionVariables]);
+    XCTAssertTrue([compiledPredicate evaluateWithObject:nil substitutionVariables:@{ @"SECTION" : @(1), @"ITEM" : @(2) }]);
+    XCTAssertFalse([compiledPredicate evaluateWithObject:nil substitutionVariables:@{ @"SECTION" : @(0), @"ITEM" : @(2) }]);
+}
+
+- (void)testFallback
+{
+    // MATCHES is not compiled and evaluated by the predicate itself
+
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"rank > 1 AND name MATCHES '[a-z]+'"];
+    FTCompiledPredicate *compiledPredicate = [FTCompiledPredicate compiledPredicateWithPredicate:predicate];
+
+    XCTAssertFalse([compiledPredicate isCompiled]);
+    XCTAssertTrue([compiledPredicate usesSubstitutionVariables]);
+
+    for (id object in self.objects) {
+        XCTAssertEqual([compiledPredicate evaluateWithObject:object], [predicate evaluateWithObject:object]);
+    }
+}
+
+- (void)testNilPredicate
+{
+    FTCompiledPredicate *compiledPredicate = [FTCompiledPredicate compiledPredicateWithPredicate:nil];
+    XCTAssertTrue([compiledPredicate isCompiled]);
+    XCTAssertTrue([compiledPredicate evaluateWithObject:nil]);
+}
+
+#pragma mark Benchmark
+
+- (void)testPerformanceOfNSPredicate
+{
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"parent.name BEGINSWITH[c] 'a' AND rank IN {1, 2, 3} AND $SECTION == 0"];
+    NSDictionary *variables = @{ @"SECTION" : @(0) };
+    NSArray *objects = self.objects;
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10000; i++) {
+            [predicate evaluateWithObject:objects[i % 3] substitutionVariables:variables];
+        }
+    }];
+}
+
+- (void)testPerformanceOfCompiledPredicate
+{
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"parent.name BEGINSWITH[c] 'a' AND rank IN {1, 2, 3} AND $SECTION == 0"];
+    FTCompiledPredicate *compiledPredicate = [FTCompiledPredicate compiledPredicateWithPredicate:predicate];
+    NSDictionary *variables = @{ @"SECTION" : @(0) };
+    NSArray *objects = self.objects;
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10000; i++) {
+            [compiledPredicate evaluateWithObject:objects[i % 3] substitutionVariables:variables];
+        }
+    }];
+}
+
+@end
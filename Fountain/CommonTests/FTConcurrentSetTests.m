@@ -0,0 +1,153 @@
+//
+//  FTConcurrentSetTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 29.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#define HC_SHORTHAND
+#define MOCKITO_SHORTHAND
+
+#import <Fountain/Fountain.h>
+#import <OCHamcrest/OCHamcrest.h>
+#import <OCMockito/OCMockito.h>
+#import <XCTest/XCTest.h>
+
+#import "FTTestItem.h"
+
+#define IDX(item, section) [[NSIndexPath indexPathWithIndex:section] indexPathByAddingIndex:item]
+
+@interface FTConcurrentSetTests : XCTestCase
+
+@end
+
+@implementation FTConcurrentSetTests
+
+#pragma mark Tests
+
+- (void)testAddObjects
+{
+    FTConcurrentSet *set = [[FTConcurrentSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ]];
+
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [set addObserver:observer];
+
+    [set addObjectsFromArray:@[ @(3), @(1), @(2) ]];
+
+    // Nothing is published before the observer queue got the chance to run
+
+    assertThatInteger([set numberOfItemsInSection:0], equalToInteger(0));
+
+    [self ft_waitForSet:set];
+
+    assertThatInteger([set numberOfItemsInSection:0], equalToInteger(3));
+    assertThat([set itemAtIndexPath:IDX(0, 0)], equalTo(@(1)));
+    assertThat([set itemAtIndexPath:IDX(2, 0)], equalTo(@(3)));
+    assertThat([set indexPathsOfItem:@(2)], contains(IDX(1, 0), nil));
+    assertThat([set indexPathsOfItem:@(4)], hasCountOf(0));
+
+    HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(1)) dataSourceWillChange:set];
+    [verifyCount(observer, times(1)) dataSource:set didApplyChangeSet:(id)changeSetCaptor];
+    [verifyCount(observer, times(1)) dataSourceDidChange:set];
+
+    FTChangeSet *changeSet = [changeSetCaptor value];
+    assertThat([changeSet insertedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 3)]));
+}
+
+- (void)testBatchUpdate
+{
+    FTConcurrentSet *set = [[FTConcurrentSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ]
+                                                        includeEmptySections:NO];
+    [set addObjectsFromArray:@[ @(1), @(2), @(3) ]];
+    [self ft_waitForSet:set];
+
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [set addObserver:observer];
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Expect Published Changes"];
+    [set performBatchUpdate:^(NSMutableSet *workingSet) {
+        XCTAssertFalse([NSThread isMainThread]);
+        [workingSet removeObject:@(2)];
+        [workingSet addObject:@(4)];
+    }
+                 completion:^{
+                     XCTAssertTrue([NSThread isMainThread]);
+                     [expectation fulfill];
+                 }];
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+
+    assertThat([set allObjects], contains(@(1), @(3), @(4), nil));
+
+    [verifyCount(observer, times(1)) dataSourceWillChange:set];
+    [verifyCount(observer, times(1)) dataSource:set didDeleteItemsAtIndexPaths:@[ IDX(1, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:set didInsertItemsAtIndexPaths:@[ IDX(2, 0) ]];
+    [verifyCount(observer, times(1)) dataSourceDidChange:set];
+
+    // Removing all objects removes the section
+
+    [set removeAllObjects];
+    [self ft_waitForSet:set];
+
+    assertThatInteger([set numberOfSections], equalToInteger(0));
+    [verifyCount(observer, times(1)) dataSource:set didDeleteSections:[NSIndexSet indexSetWithIndex:0]];
+}
+
+- (void)testIndexPathsOfItemWithChangedSortKey
+{
+    FTConcurrentSet *set = [[FTConcurrentSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ]];
+
+    FTTestItem *item1 = ITEM(1);
+    FTTestItem *item2 = ITEM(2);
+    FTTestItem *item3 = ITEM(3);
+
+    [set addObjectsFromArray:@[ item3, item1, item2 ]];
+    [self ft_waitForSet:set];
+
+    assertThat([set indexPathsOfItem:item2], contains(IDX(1, 0), nil));
+
+    // The item keeps its position in the published snapshot until the
+    // set is updated, but must still be found by a reverse lookup.
+
+    item2.value = 10;
+
+    assertThat([set indexPathsOfItem:item1], contains(IDX(0, 0), nil));
+    assertThat([set indexPathsOfItem:item2], contains(IDX(1, 0), nil));
+    assertThat([set indexPathsOfItem:item3], contains(IDX(2, 0), nil));
+
+    [set addObject:item2];
+    [self ft_waitForSet:set];
+
+    assertThat([set indexPathsOfItem:item2], contains(IDX(2, 0), nil));
+    assertThat([set indexPathsOfItem:item3], contains(IDX(1, 0), nil));
+    assertThat([set indexPathsOfItem:ITEM(2)], hasCountOf(0));
+}
+
+- (void)testMutateFromSeveralThreads
+{
+    FTConcurrentSet *set = [[FTConcurrentSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ]];
+
+    dispatch_apply(100, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        [set addObject:@(i)];
+    });
+
+    [self ft_waitForSet:set];
+
+    assertThatInteger([set count], equalToInteger(100));
+    assertThat([set itemAtIndexPath:IDX(99, 0)], equalTo(@(99)));
+}
+
+#pragma mark Helper
+
+- (void)ft_waitForSet:(FTConcurrentSet *)set
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Expect Published Changes"];
+    [set performBatchUpdate:nil
+                 completion:^{
+                     [expectation fulfill];
+                 }];
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+}
+
+@end
@@ -16,6 +16,7 @@ NS_ASSUME_NONNULL_BEGIN
 @interface FTEntity (CoreDataProperties)
 
 @property (nullable, nonatomic, retain) NSNumber *flag;
+@property (nullable, nonatomic, retain) NSString *name;
 @property (nullable, nonatomic, retain) NSNumber *value;
 
 @end
@@ -136,6 +136,67 @@
     assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(90));
 }
 
+- (void)testFetchSortedObjects
+{
+    // Insert the objects in an order, which differs from the sort order
+    NSMutableIndexSet *indexes = [[NSMutableIndexSet alloc] init];
+    for (NSUInteger i = 0; i < 100; i++) {
+        [indexes addIndex:(i * 37) % 100];
+    }
+    [self seedContextWithIndexes:indexes];
+
+    NSEntityDescription *entity = [NSEntityDescription entityForName:@"Entity" inManagedObjectContext:self.context];
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"flag" ascending:YES],
+                                  [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:NO] ];
+
+    FTFetchedDataSource *dataSource = [[FTFetchedDataSource alloc] initWithManagedObjectContext:self.context
+                                                                                         entity:entity
+                                                                                sortDescriptors:sortDescriptors
+                                                                                      predicate:nil];
+
+    NSError *error = nil;
+    BOOL success = [dataSource fetchObjects:&error];
+    assertThatBool(success, isTrue());
+
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(100));
+
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(0, 0)] value], equalTo(@(99)));
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(9, 0)] value], equalTo(@(90)));
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(10, 0)] value], equalTo(@(89)));
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(99, 0)] value], equalTo(@(0)));
+}
+
+- (void)testFetchObjectsWithComparator
+{
+    [self seedContext];
+
+    // Sort descriptors with a comparator can not be used by the store and
+    // the fetched objects are sorted in memory.
+
+    NSEntityDescription *entity = [NSEntityDescription entityForName:@"Entity" inManagedObjectContext:self.context];
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value"
+                                                                ascending:YES
+                                                               comparator:^NSComparisonResult(NSNumber *first, NSNumber *second) {
+                                                                   return [@([first integerValue] % 10) compare:@([second integerValue] % 10)] ?: [first compare:second];
+                                                               }] ];
+
+    FTFetchedDataSource *dataSource = [[FTFetchedDataSource alloc] initWithManagedObjectContext:self.context
+                                                                                         entity:entity
+                                                                                sortDescriptors:sortDescriptors
+                                                                                      predicate:nil];
+
+    NSError *error = nil;
+    BOOL success = [dataSource fetchObjects:&error];
+    assertThatBool(success, isTrue());
+
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(100));
+
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(0, 0)] value], equalTo(@(0)));
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(1, 0)] value], equalTo(@(10)));
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(10, 0)] value], equalTo(@(1)));
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(99, 0)] value], equalTo(@(99)));
+}
+
 - (void)testDeleteObject
 {
     [self seedContext];
@@ -484,6 +545,276 @@
     [verifyCount(observer, times(1)) dataSourceDidReset:dataSource];
 }
 
+#pragma mark Test Faulting
+
+- (void)testFaultObjects
+{
+    [self seedContext];
+
+    // The data source uses a separate context to count the objects, which are
+    // kept in memory by the data source.
+
+    NSManagedObjectContext *context = [[NSManagedObjectContext alloc] initWithConcurrencyType:NSMainQueueConcurrencyType];
+    context.persistentStoreCoordinator = self.coordinator;
+
+    NSEntityDescription *entity = [NSEntityDescription entityForName:@"Entity" inManagedObjectContext:context];
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"flag == YES"];
+
+    FTFetchedDataSource *dataSource = [[FTFetchedDataSource alloc] initWithManagedObjectContext:context
+                                                                                         entity:entity
+                                                                                sortDescriptors:sortDescriptors
+                                                                                      predicate:predicate];
+    dataSource.fetchBatchSize = 10;
+    dataSource.residentObjectLimit = 20;
+
+    NSError *error = nil;
+    BOOL success = [dataSource fetchObjects:&error];
+    assertThatBool(success, isTrue());
+
+    assertThatInteger([dataSource numberOfSections], equalToInteger(1));
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(90));
+    assertThatInteger([self numberOfResidentObjectsInContext:context], equalToInteger(0));
+
+    @autoreleasepool {
+        FTEntity *object = [dataSource itemAtIndexPath:IDX(45, 0)];
+        assertThat(object.value, equalTo(@(45)));
+        assertThat([dataSource indexPathsOfItem:object], contains(IDX(45, 0), nil));
+    }
+
+    // Accessing an item fetches the batch of the item
+
+    assertThatInteger([self numberOfResidentObjectsInContext:context], equalToInteger(10));
+
+    @autoreleasepool {
+        for (NSUInteger i = 0; i < 90; i++) {
+            FTEntity *object = [dataSource itemAtIndexPath:IDX(i, 0)];
+            assertThat(object.value, equalTo(@(i)));
+        }
+    }
+
+    // Only the most recently used objects are kept
+
+    assertThatInteger([self numberOfResidentObjectsInContext:context], lessThanOrEqualTo(@(20)));
+}
+
+- (void)testFaultObjectsSortedByString
+{
+    [self seedContext];
+
+    NSEntityDescription *entity = [NSEntityDescription entityForName:@"Entity" inManagedObjectContext:self.context];
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"name" ascending:YES selector:@selector(localizedStandardCompare:)] ];
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"flag == YES"];
+
+    FTFetchedDataSource *dataSource = [[FTFetchedDataSource alloc] initWithManagedObjectContext:self.context
+                                                                                         entity:entity
+                                                                                sortDescriptors:sortDescriptors
+                                                                                      predicate:predicate];
+    dataSource.fetchBatchSize = 10;
+
+    NSError *error = nil;
+    BOOL success = [dataSource fetchObjects:&error];
+    assertThatBool(success, isTrue());
+
+    // The store may order strings differently, therefore the order of the
+    // objects is verified before they are turned into faults ("Item 9" is
+    // ordered before "Item 10").
+
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(90));
+    for (NSUInteger i = 0; i < 90; i++) {
+        FTEntity *object = [dataSource itemAtIndexPath:IDX(i, 0)];
+        assertThat(object.value, equalTo(@(i)));
+        assertThat([dataSource indexPathsOfItem:object], contains(IDX(i, 0), nil));
+    }
+}
+
+- (void)testFaultObjectsWithChanges
+{
+    [self seedContext];
+
+    NSEntityDescription *entity = [NSEntityDescription entityForName:@"Entity" inManagedObjectContext:self.context];
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"flag == YES"];
+
+    FTFetchedDataSource *dataSource = [[FTFetchedDataSource alloc] initWithManagedObjectContext:self.context
+                                                                                         entity:entity
+                                                                                sortDescriptors:sortDescriptors
+                                                                                      predicate:predicate];
+    dataSource.fetchBatchSize = 10;
+
+    NSError *error = nil;
+    BOOL success = [dataSource fetchObjects:&error];
+    assertThatBool(success, isTrue());
+
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [dataSource addObserver:observer];
+
+    FTEntity *deletedObject = [dataSource itemAtIndexPath:IDX(10, 0)];
+    FTEntity *movedObject = [dataSource itemAtIndexPath:IDX(30, 0)];
+    FTEntity *changedObject = [dataSource itemAtIndexPath:IDX(89, 0)];
+
+    [self.context deleteObject:deletedObject];
+    movedObject.value = @200;
+    changedObject.value = @95;
+
+    FTEntity *insertedObject = [[FTEntity alloc] initWithEntity:entity insertIntoManagedObjectContext:self.context];
+    insertedObject.value = @150;
+    insertedObject.flag = @YES;
+
+    success = [self.context save:&error];
+    XCTAssertTrue(success, @"Failed to save context: %@", [error localizedDescription]);
+
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(90));
+
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(10, 0)] value], equalTo(@(11)));
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(29, 0)] value], equalTo(@(31)));
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(87, 0)] value], equalTo(@(95)));
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(88, 0)] value], equalTo(@(150)));
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(89, 0)] value], equalTo(@(200)));
+
+    assertThat([dataSource indexPathsOfItem:insertedObject], contains(IDX(88, 0), nil));
+    assertThat([dataSource indexPathsOfItem:deletedObject], isEmpty());
+
+    [verifyCount(observer, times(1)) dataSourceWillChange:dataSource];
+    [verifyCount(observer, times(1)) dataSource:dataSource didDeleteItemsAtIndexPaths:@[ IDX(10, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:dataSource didInsertItemsAtIndexPaths:@[ IDX(88, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:dataSource didChangeItemsAtIndexPaths:@[ IDX(89, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:dataSource didMoveItemAtIndexPath:IDX(30, 0) toIndexPath:IDX(89, 0)];
+    [verifyCount(observer, times(1)) dataSourceDidChange:dataSource];
+}
+
+- (void)testFaultObjectsWithPendingChanges
+{
+    [self seedContext];
+
+    NSEntityDescription *entity = [NSEntityDescription entityForName:@"Entity" inManagedObjectContext:self.context];
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"flag == YES"];
+
+    FTFetchedDataSource *dataSource = [[FTFetchedDataSource alloc] initWithManagedObjectContext:self.context
+                                                                                         entity:entity
+                                                                                sortDescriptors:sortDescriptors
+                                                                                      predicate:predicate];
+    dataSource.fetchBatchSize = 10;
+
+    NSError *error = nil;
+    BOOL success = [dataSource fetchObjects:&error];
+    assertThatBool(success, isTrue());
+
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [dataSource addObserver:observer];
+
+    FTEntity *deletedObject = [dataSource itemAtIndexPath:IDX(10, 0)];
+    [self.context deleteObject:deletedObject];
+
+    // Accessing the items of other batches while the deletion is pending does
+    // not notify the observers and does not change the data source.
+
+    for (NSUInteger i = 20; i < 90; i += 5) {
+        FTEntity *object = [dataSource itemAtIndexPath:IDX(i, 0)];
+        assertThat(object, notNilValue());
+        assertThat(object.value, equalTo(@(i)));
+    }
+
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(90));
+    [verifyCount(observer, never()) dataSourceWillChange:dataSource];
+
+    [self.context processPendingChanges];
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+    assertThatInteger([dataSource numberOfItemsInSection:0], equalToInteger(89));
+    assertThat([(FTEntity *)[dataSource itemAtIndexPath:IDX(10, 0)] value], equalTo(@(11)));
+
+    [verifyCount(observer, times(1)) dataSourceWillChange:dataSource];
+    [verifyCount(observer, times(1)) dataSource:dataSource didDeleteItemsAtIndexPaths:@[ IDX(10, 0) ]];
+    [verifyCount(observer, times(1)) dataSourceDidChange:dataSource];
+}
+
+- (void)testPrefetchObjects
+{
+    [self seedContext];
+
+    NSManagedObjectContext *context = [[NSManagedObjectContext alloc] initWithConcurrencyType:NSMainQueueConcurrencyType];
+    context.persistentStoreCoordinator = self.coordinator;
+
+    NSEntityDescription *entity = [NSEntityDescription entityForName:@"Entity" inManagedObjectContext:context];
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    FTFetchedDataSource *dataSource = [[FTFetchedDataSource alloc] initWithManagedObjectContext:context
+                                                                                         entity:entity
+                                                                                sortDescriptors:sortDescriptors
+                                                                                      predicate:nil];
+    dataSource.fetchBatchSize = 10;
+
+    NSError *error = nil;
+    BOOL success = [dataSource fetchObjects:&error];
+    assertThatBool(success, isTrue());
+
+    NSMutableArray *indexPaths = [[NSMutableArray alloc] init];
+    for (NSUInteger i = 50; i < 60; i++) {
+        [indexPaths addObject:IDX(i, 0)];
+    }
+
+    // The objects are fetched at the end of the run loop turn, unless the
+    // prefetching has been cancelled.
+
+    [dataSource prefetchItemsAtIndexPaths:indexPaths];
+    [dataSource cancelPrefetchingForItemsAtIndexPaths:[indexPaths subarrayWithRange:NSMakeRange(0, 4)]];
+    assertThatInteger([self numberOfResidentObjectsInContext:context], equalToInteger(0));
+
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+    assertThatInteger([self numberOfResidentObjectsInContext:context], equalToInteger(6));
+}
+
+#pragma mark Benchmark
+
+- (void)testPerformanceOfTimeToFirstItem
+{
+    [self seedContextWithIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 10000)]];
+    [self measureTimeToFirstItemWithFetchBatchSize:0];
+}
+
+- (void)testPerformanceOfTimeToFirstItemWithFaulting
+{
+    [self seedContextWithIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 10000)]];
+    [self measureTimeToFirstItemWithFetchBatchSize:50];
+}
+
+- (void)measureTimeToFirstItemWithFetchBatchSize:(NSUInteger)fetchBatchSize
+{
+    [self measureBlock:^{
+        NSManagedObjectContext *context = [[NSManagedObjectContext alloc] initWithConcurrencyType:NSMainQueueConcurrencyType];
+        context.persistentStoreCoordinator = self.coordinator;
+
+        NSEntityDescription *entity = [NSEntityDescription entityForName:@"Entity" inManagedObjectContext:context];
+        NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+        FTFetchedDataSource *dataSource = [[FTFetchedDataSource alloc] initWithManagedObjectContext:context
+                                                                                             entity:entity
+                                                                                    sortDescriptors:sortDescriptors
+                                                                                          predicate:nil];
+        dataSource.fetchBatchSize = fetchBatchSize;
+        [dataSource fetchObjects:nil];
+        [dataSource itemAtIndexPath:IDX(0, 0)];
+    }];
+}
+
+#pragma mark Resident Objects
+
+- (NSUInteger)numberOfResidentObjectsInContext:(NSManagedObjectContext *)context
+{
+    @autoreleasepool {
+        NSUInteger count = 0;
+        for (NSManagedObject *object in context.registeredObjects) {
+            if (![object isFault]) {
+                count++;
+            }
+        }
+        return count;
+    }
+}
+
 #pragma mark Seed Context
 
 - (NSArray *)seedContext
@@ -500,6 +831,7 @@
         FTEntity *object = [[FTEntity alloc] initWithEntity:entity insertIntoManagedObjectContext:self.context];
         object.value = @(idx);
         object.flag = @(idx < 90);
+        object.name = [NSString stringWithFormat:@"Item %lu", (unsigned long)idx];
 
         [objects addObject:object];
     }];
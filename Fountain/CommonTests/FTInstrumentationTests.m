@@ -0,0 +1,162 @@
+//
+//  FTInstrumentationTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 08.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#define HC_SHORTHAND
+#define MOCKITO_SHORTHAND
+
+#import <Fountain/Fountain.h>
+#import <OCHamcrest/OCHamcrest.h>
+#import <OCMockito/OCMockito.h>
+#import <XCTest/XCTest.h>
+
+#import "FTTestItem.h"
+
+@interface FTInstrumentationTestsObserver : NSObject <FTDataSourceObserver>
+@property (nonatomic, assign) NSUInteger numberOfChanges;
+@end
+
+@implementation FTInstrumentationTestsObserver
+
+- (void)dataSourceDidChange:(id<FTDataSource>)dataSource
+{
+    self.numberOfChanges++;
+}
+
+@end
+
+@interface FTInstrumentationTests : XCTestCase
+@property (nonatomic, strong) FTAggregatingInstrumentationSink *sink;
+@end
+
+@implementation FTInstrumentationTests
+
+#pragma mark Test Life-cycle
+
+- (void)setUp
+{
+    [super setUp];
+    self.sink = [[FTAggregatingInstrumentationSink alloc] init];
+    [FTInstrumentation setSink:self.sink];
+}
+
+- (void)tearDown
+{
+    [FTInstrumentation setSink:nil];
+    self.sink = nil;
+    [super tearDown];
+}
+
+#pragma mark Tests
+
+- (void)testDisabledInstrumentation
+{
+    [FTInstrumentation setSink:nil];
+
+    assertThat([FTInstrumentationSpan spanWithName:@"test"], nilValue());
+
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ]];
+    [set addObjectsFromArray:@[ ITEM(1), ITEM(2) ]];
+
+    assertThat(self.sink.spanNames, isEmpty());
+}
+
+- (void)testSpan
+{
+    FTInstrumentationSpan *span = [FTInstrumentationSpan spanWithName:@"test"];
+    assertThat(span, notNilValue());
+
+    [span beginPhase:@"a"];
+    [span beginPhase:@"b"];
+    [span beginPhase:@"a"];
+    [span addCount:2 forKey:@"items"];
+    [span addCount:3 forKey:@"items"];
+
+    NSComparator comperator = [span countingComparator:^NSComparisonResult(id obj1, id obj2) {
+        return [obj1 compare:obj2];
+    }];
+    XCTAssertEqual(comperator(@1, @2), NSOrderedAscending);
+    XCTAssertEqual(comperator(@2, @1), NSOrderedDescending);
+
+    [span finish];
+    [span finish];
+
+    XCTAssertTrue(span.finished);
+    assertThat([span.phaseDurations allKeys], containsInAnyOrder(@"a", @"b", nil));
+    assertThat(span.counts[@"items"], equalTo(@5));
+    assertThat(span.counts[@"comparisons"], equalTo(@2));
+
+    XCTAssertEqual([self.sink numberOfSpansWithName:@"test"], 1);
+}
+
+- (void)testMutableSetBatch
+{
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ]];
+    [set addObjectsFromArray:@[ ITEM(1), ITEM(3), ITEM(5), ITEM(7) ]];
+    [self.sink reset];
+
+    FTTestItem *item = [set itemAtIndexPath:[[NSIndexPath indexPathWithIndex:0] indexPathByAddingIndex:1]];
+
+    [set performBatchUpdate:^{
+        [set addObject:ITEM(4)];
+        [set addObject:ITEM(6)];
+        [set removeObject:item];
+    }];
+
+    XCTAssertEqual([self.sink numberOfSpansWithName:@"FTMutableSet.batch"], 1);
+
+    FTInstrumentationSpan *span = [[self.sink spansWithName:@"FTMutableSet.batch"] firstObject];
+    assertThat([span.phaseDurations allKeys], containsInAnyOrder(@"update", @"delete", @"insert", @"notify", nil));
+    assertThat(span.counts[@"inserted"], equalTo(@2));
+    assertThat(span.counts[@"deleted"], equalTo(@1));
+    assertThat(span.counts[@"items"], equalTo(@5));
+    XCTAssertGreaterThan([span.counts[@"comparisons"] unsignedIntegerValue], 0);
+}
+
+- (void)testObserverDelivery
+{
+    FTInstrumentationTestsObserver *observer = [[FTInstrumentationTestsObserver alloc] init];
+
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ ITEM(1), ITEM(2) ]];
+    [array addObserver:observer];
+
+    [array addObject:ITEM(3)];
+    [array removeObjectAtIndex:0];
+
+    XCTAssertEqual(observer.numberOfChanges, 2);
+    XCTAssertEqual([self.sink numberOfSpansWithName:@"FTMutableArray.batch"], 2);
+    XCTAssertEqual([self.sink totalCount:@"inserted" ofSpansWithName:@"FTMutableArray.batch"], 1);
+    XCTAssertEqual([self.sink totalCount:@"deleted" ofSpansWithName:@"FTMutableArray.batch"], 1);
+
+    NSDictionary *deliveryDurations = [self.sink observerDeliveryDurationsOfSpansWithName:@"FTMutableArray.batch"];
+    assertThat([deliveryDurations allKeys], contains(NSStringFromClass([FTInstrumentationTestsObserver class]), nil));
+}
+
+- (void)testPercentiles
+{
+    for (NSUInteger i = 0; i < 10; i++) {
+        FTInstrumentationSpan *span = [FTInstrumentationSpan spanWithName:@"test"];
+        [span beginPhase:@"phase"];
+        [span finish];
+    }
+
+    XCTAssertEqual([self.sink numberOfSpansWithName:@"test"], 10);
+
+    NSArray *durations = [[[self.sink spansWithName:@"test"] valueForKey:@"duration"] sortedArrayUsingSelector:@selector(compare:)];
+    XCTAssertEqual([self.sink percentile:0.5 ofDurationsOfSpansWithName:@"test"], [durations[4] doubleValue]);
+    XCTAssertEqual([self.sink percentile:0.9 ofDurationsOfSpansWithName:@"test"], [durations[8] doubleValue]);
+    XCTAssertEqual([self.sink percentile:1.0 ofDurationsOfSpansWithName:@"test"], [[durations lastObject] doubleValue]);
+    XCTAssertGreaterThanOrEqual([self.sink percentile:0.99 ofDurationsOfPhase:@"phase" ofSpansWithName:@"test"], 0);
+    XCTAssertEqual([self.sink percentile:0.5 ofDurationsOfSpansWithName:@"unknown"], 0);
+
+    assertThat([self.sink report], containsSubstring(@"test (10 spans)"));
+
+    [self.sink reset];
+    XCTAssertEqual([self.sink numberOfSpansWithName:@"test"], 0);
+}
+
+@end
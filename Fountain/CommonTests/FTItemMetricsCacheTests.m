@@ -0,0 +1,219 @@
+//
+//  FTItemMetricsCacheTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 06.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#define HC_SHORTHAND
+#define MOCKITO_SHORTHAND
+
+#import <Fountain/Fountain.h>
+#import <OCHamcrest/OCHamcrest.h>
+#import <OCMockito/OCMockito.h>
+#import <XCTest/XCTest.h>
+
+#import "FTTestItem.h"
+
+#define IDX(item, section) [[NSIndexPath indexPathWithIndex:section] indexPathByAddingIndex:item]
+
+@interface FTItemMetricsCacheTests : XCTestCase
+@property (nonatomic, assign) NSUInteger numberOfMeasurements;
+@end
+
+@implementation FTItemMetricsCacheTests
+
+#pragma mark Helper
+
+- (FTItemMetricsCache *)cacheWithDataSource:(id<FTDataSource>)dataSource
+{
+    __weak typeof(self) _self = self;
+    FTItemMetricsCache *cache = [[FTItemMetricsCache alloc] initWithMeasuringBlock:^double(FTTestItem *item, NSIndexPath *indexPath, id<FTDataSource> dataSource) {
+        _self.numberOfMeasurements++;
+        return item.value;
+    }];
+    cache.estimatedMetric = 5;
+    cache.dataSource = dataSource;
+    return cache;
+}
+
+- (void)measureAllItemsInCache:(FTItemMetricsCache *)cache
+{
+    for (NSUInteger item = 0; item < [cache.dataSource numberOfItemsInSection:0]; item++) {
+        [cache metricForItemAtIndexPath:IDX(item, 0)];
+    }
+}
+
+- (void)setUp
+{
+    [super setUp];
+    self.numberOfMeasurements = 0;
+}
+
+#pragma mark Tests
+
+- (void)testMeasureItemsOnce
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ ITEM(10), ITEM(20), ITEM(30) ]];
+    FTItemMetricsCache *cache = [self cacheWithDataSource:array];
+
+    XCTAssertFalse([cache hasMetricForItemAtIndexPath:IDX(1, 0)]);
+    XCTAssertEqual([cache estimatedMetricForItemAtIndexPath:IDX(1, 0)], 5);
+    XCTAssertEqual(self.numberOfMeasurements, 0);
+
+    XCTAssertEqual([cache metricForItemAtIndexPath:IDX(1, 0)], 20);
+    XCTAssertEqual([cache metricForItemAtIndexPath:IDX(1, 0)], 20);
+    XCTAssertEqual(self.numberOfMeasurements, 1);
+
+    XCTAssertTrue([cache hasMetricForItemAtIndexPath:IDX(1, 0)]);
+    XCTAssertEqual([cache estimatedMetricForItemAtIndexPath:IDX(1, 0)], 20);
+}
+
+- (void)testOffsets
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ ITEM(10), ITEM(20), ITEM(30), ITEM(40) ]];
+    FTItemMetricsCache *cache = [self cacheWithDataSource:array];
+
+    // Items, which have not been measured, use the estimated metric.
+
+    XCTAssertEqual([cache totalMetricOfSection:0], 20);
+    XCTAssertEqual([cache offsetOfItemAtIndexPath:IDX(2, 0)], 10);
+
+    [cache metricForItemAtIndexPath:IDX(0, 0)];
+    [cache metricForItemAtIndexPath:IDX(1, 0)];
+
+    XCTAssertEqual([cache offsetOfItemAtIndexPath:IDX(2, 0)], 30);
+    XCTAssertEqual([cache offsetOfItemAtIndexPath:IDX(3, 0)], 35);
+    XCTAssertEqual([cache totalMetricOfSection:0], 40);
+    XCTAssertEqual([cache offsetOfSection:1], 40);
+    XCTAssertEqual(cache.totalMetric, 40);
+
+    XCTAssertEqualObjects([cache indexPathOfItemAtOffset:0 inSection:0], IDX(0, 0));
+    XCTAssertEqualObjects([cache indexPathOfItemAtOffset:29.5 inSection:0], IDX(1, 0));
+    XCTAssertEqualObjects([cache indexPathOfItemAtOffset:30 inSection:0], IDX(2, 0));
+    XCTAssertNil([cache indexPathOfItemAtOffset:40 inSection:0]);
+
+    cache.estimatedMetric = 1;
+    XCTAssertEqual([cache totalMetricOfSection:0], 32);
+}
+
+- (void)testShiftMetricsOnInsertAndDelete
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ ITEM(10), ITEM(20), ITEM(30) ]];
+    FTItemMetricsCache *cache = [self cacheWithDataSource:array];
+    [self measureAllItemsInCache:cache];
+
+    [array insertObject:ITEM(40) atIndex:0];
+
+    XCTAssertFalse([cache hasMetricForItemAtIndexPath:IDX(0, 0)]);
+    XCTAssertTrue([cache hasMetricForItemAtIndexPath:IDX(1, 0)]);
+    XCTAssertEqual([cache offsetOfItemAtIndexPath:IDX(3, 0)], 35);
+
+    [array removeObjectAtIndex:2];
+
+    XCTAssertEqual([cache offsetOfItemAtIndexPath:IDX(2, 0)], 15);
+    XCTAssertEqual([cache totalMetricOfSection:0], 45);
+
+    [self measureAllItemsInCache:cache];
+
+    XCTAssertEqual(self.numberOfMeasurements, 4);
+    XCTAssertEqual([cache totalMetricOfSection:0], 80);
+}
+
+- (void)testMoveMetrics
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ ITEM(10), ITEM(20), ITEM(30) ]];
+    FTItemMetricsCache *cache = [self cacheWithDataSource:array];
+    [self measureAllItemsInCache:cache];
+
+    [array moveObjectAtIndex:2 toIndex:0];
+
+    XCTAssertEqual([cache offsetOfItemAtIndexPath:IDX(1, 0)], 30);
+    XCTAssertEqual([cache offsetOfItemAtIndexPath:IDX(2, 0)], 40);
+
+    [self measureAllItemsInCache:cache];
+    XCTAssertEqual(self.numberOfMeasurements, 3);
+}
+
+- (void)testInvalidateChangedItems
+{
+    FTTestItem *item = ITEM(20);
+
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ ITEM(10), item, ITEM(30) ]];
+    FTItemMetricsCache *cache = [self cacheWithDataSource:array];
+    [self measureAllItemsInCache:cache];
+
+    item.value = 50;
+    [array replaceObjectAtIndex:1 withObject:item];
+
+    XCTAssertFalse([cache hasMetricForItemAtIndexPath:IDX(1, 0)]);
+    XCTAssertTrue([cache hasMetricForItemAtIndexPath:IDX(2, 0)]);
+    XCTAssertEqual([cache offsetOfItemAtIndexPath:IDX(2, 0)], 15);
+
+    XCTAssertEqual([cache metricForItemAtIndexPath:IDX(1, 0)], 50);
+    XCTAssertEqual(self.numberOfMeasurements, 4);
+    XCTAssertEqual([cache offsetOfItemAtIndexPath:IDX(2, 0)], 60);
+}
+
+- (void)testReuseMetricsOfItems
+{
+    FTTestItem *item1 = ITEM(10);
+    FTTestItem *item2 = ITEM(20);
+    FTTestItem *item3 = ITEM(30);
+
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ item1, item2, item3 ]];
+    FTItemMetricsCache *cache = [self cacheWithDataSource:array];
+    [self measureAllItemsInCache:cache];
+
+    [array replaceAllObjectsWithObjects:@[ item3, ITEM(40), item1 ]];
+
+    [self measureAllItemsInCache:cache];
+    XCTAssertEqual(self.numberOfMeasurements, 4);
+
+    // The metrics are also reused for a different data source with the same items
+
+    cache.dataSource = [FTMutableArray arrayWithArray:@[ item2, item1 ]];
+
+    [self measureAllItemsInCache:cache];
+    XCTAssertEqual(self.numberOfMeasurements, 5);
+    XCTAssertEqual([cache totalMetricOfSection:0], 30);
+}
+
+- (void)testInvalidateAllMetrics
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ ITEM(10), ITEM(20) ]];
+    FTItemMetricsCache *cache = [self cacheWithDataSource:array];
+    [self measureAllItemsInCache:cache];
+
+    [cache invalidateAllMetrics];
+
+    XCTAssertEqual([cache totalMetricOfSection:0], 10);
+    [self measureAllItemsInCache:cache];
+    XCTAssertEqual(self.numberOfMeasurements, 4);
+}
+
+#pragma mark Benchmark
+
+- (void)testPerformanceOfOffsetsAfterUpdates
+{
+    NSMutableArray *items = [[NSMutableArray alloc] init];
+    for (NSInteger value = 0; value < 100000; value++) {
+        [items addObject:ITEM(value % 100)];
+    }
+
+    FTMutableArray *array = [FTMutableArray arrayWithArray:items];
+    FTItemMetricsCache *cache = [self cacheWithDataSource:array];
+    [self measureAllItemsInCache:cache];
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10; i++) {
+            [array insertObject:ITEM(10) atIndex:0];
+            for (NSUInteger item = 0; item < 100000; item += 1000) {
+                [cache offsetOfItemAtIndexPath:IDX(item, 0)];
+            }
+        }
+    }];
+}
+
+@end
@@ -146,9 +146,26 @@
 
     [verifyCount(observer, times(1)) dataSourceWillChange:array];
     [verifyCount(observer, times(1)) dataSourceDidChange:array];
-    [verifyCount(observer, times(1)) dataSource:array didInsertItemsAtIndexPaths:@[ IDX(0, 0) ]];
-    [verifyCount(observer, times(1)) dataSource:array didInsertItemsAtIndexPaths:@[ IDX(1, 0) ]];
-    [verifyCount(observer, times(1)) dataSource:array didInsertItemsAtIndexPaths:@[ IDX(2, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:array didInsertItemsAtIndexPaths:@[ IDX(0, 0), IDX(1, 0), IDX(2, 0) ]];
+}
+
+- (void)testInsertObjectsAtIndexes
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @(0), @(3) ]];
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [array addObserver:observer];
+
+    NSMutableIndexSet *indexes = [[NSMutableIndexSet alloc] init];
+    [indexes addIndexesInRange:NSMakeRange(1, 2)];
+    [indexes addIndex:4];
+
+    [array insertObjects:@[ @(1), @(2), @(4) ] atIndexes:indexes];
+
+    assertThat(array, contains(@(0), @(1), @(2), @(3), @(4), nil));
+
+    [verifyCount(observer, times(1)) dataSourceWillChange:array];
+    [verifyCount(observer, times(1)) dataSourceDidChange:array];
+    [verifyCount(observer, times(1)) dataSource:array didInsertItemsAtIndexPaths:@[ IDX(1, 0), IDX(2, 0), IDX(4, 0) ]];
 }
 
 #pragma mark Test Remove Objects
@@ -179,6 +196,40 @@
     [verifyCount(observer, times(1)) dataSource:array didDeleteItemsAtIndexPaths:@[ IDX(2, 0) ]];
 }
 
+- (void)testRemoveObjectsInRange
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @(0), @(1), @(2), @(3) ]];
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [array addObserver:observer];
+
+    [array removeObjectsInRange:NSMakeRange(1, 2)];
+
+    assertThat(array, contains(@(0), @(3), nil));
+
+    [verifyCount(observer, times(1)) dataSourceWillChange:array];
+    [verifyCount(observer, times(1)) dataSourceDidChange:array];
+    [verifyCount(observer, times(1)) dataSource:array didDeleteItemsAtIndexPaths:@[ IDX(1, 0), IDX(2, 0) ]];
+}
+
+#pragma mark Test Move Objects
+
+- (void)testMoveObject
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @(0), @(1), @(2), @(3) ]];
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [array addObserver:observer];
+
+    [array moveObjectAtIndex:0 toIndex:2];
+
+    assertThat(array, contains(@(1), @(2), @(0), @(3), nil));
+
+    [verifyCount(observer, times(1)) dataSourceWillChange:array];
+    [verifyCount(observer, times(1)) dataSourceDidChange:array];
+    [verifyCount(observer, times(1)) dataSource:array didMoveItemAtIndexPath:IDX(0, 0) toIndexPath:IDX(2, 0)];
+    [verifyCount(observer, never()) dataSource:array didDeleteItemsAtIndexPaths:anything()];
+    [verifyCount(observer, never()) dataSource:array didInsertItemsAtIndexPaths:anything()];
+}
+
 #pragma mark Test Replace Objects
 
 - (void)testReplaceObjectsAtIndexes
@@ -197,15 +248,256 @@
     [verifyCount(observer, times(1)) dataSourceWillChange:array];
     [verifyCount(observer, times(1)) dataSourceDidChange:array];
 
-    [verifyCount(observer, times(1)) dataSource:array didChangeItemsAtIndexPaths:@[ IDX(2, 0) ]];
-    [verifyCount(observer, times(1)) dataSource:array didChangeItemsAtIndexPaths:@[ IDX(4, 0) ]];
-    [verifyCount(observer, times(1)) dataSource:array didChangeItemsAtIndexPaths:@[ IDX(6, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:array didChangeItemsAtIndexPaths:@[ IDX(2, 0), IDX(4, 0), IDX(6, 0) ]];
 
     assertThat([array itemAtIndexPath:IDX(2, 0)], equalTo(@20));
     assertThat([array itemAtIndexPath:IDX(4, 0)], equalTo(@40));
     assertThat([array itemAtIndexPath:IDX(6, 0)], equalTo(@60));
 }
 
+- (void)testReplaceAllObjects
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @"a", @"b", @"c", @"d", @"e" ]];
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [array addObserver:observer];
+
+    [array replaceAllObjectsWithObjects:@[ @"a", @"d", @"b", @"c", @"x" ]];
+
+    assertThat(array, contains(@"a", @"d", @"b", @"c", @"x", nil));
+
+    [verifyCount(observer, times(1)) dataSourceWillChange:array];
+    [verifyCount(observer, times(1)) dataSourceDidChange:array];
+    [verifyCount(observer, times(1)) dataSource:array didDeleteItemsAtIndexPaths:@[ IDX(4, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:array didInsertItemsAtIndexPaths:@[ IDX(4, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:array didMoveItemAtIndexPath:IDX(3, 0) toIndexPath:IDX(1, 0)];
+    [verifyCount(observer, never()) dataSource:array didChangeItemsAtIndexPaths:anything()];
+}
+
+#pragma mark Test Change Sets
+
+- (void)testChangeSetOfAddedObjects
+{
+    FTMutableArray *array = [FTMutableArray array];
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [array addObserver:observer];
+
+    [array addObjectsFromArray:@[ @(0), @(2), @(3) ]];
+
+    HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(1)) dataSource:array didApplyChangeSet:(id)changeSetCaptor];
+
+    FTChangeSet *changeSet = [changeSetCaptor value];
+    assertThat([changeSet insertedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 3)]));
+    assertThat([changeSet deletedItemsInSection:0], hasCountOf(0));
+
+    // Observers receiving change sets do not get the individual changes
+    [verifyCount(observer, never()) dataSource:array didInsertItemsAtIndexPaths:anything()];
+    [verifyCount(observer, times(1)) dataSourceDidChange:array];
+}
+
+- (void)testChangeSetOfReplacedContents
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @0, @1, @2, @3, @4, @5, @1 ]];
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [array addObserver:observer];
+
+    [array replaceAllObjectsWithObjects:@[ @0, @1, @2, @3, @4, @5, @1 ]];
+    [array replaceAllObjectsWithObjects:@[ @0, @4, @2, @3, @1, @6, @1 ]];
+
+    HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(2)) dataSource:array didApplyChangeSet:(id)changeSetCaptor];
+
+    NSArray *changeSets = [changeSetCaptor allValues];
+
+    // Replacing the objects with the same objects does not change anything
+
+    FTChangeSet *changeSet = changeSets[0];
+    assertThatBool([changeSet isEmpty], isTrue());
+
+    // Only the differences are reported. Equal objects are matched in the
+    // order of their appearance.
+
+    changeSet = changeSets[1];
+    assertThat([changeSet deletedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndex:5]));
+    assertThat([changeSet insertedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndex:5]));
+    assertThat([changeSet changedItemsInSection:0], hasCountOf(0));
+
+    NSMutableArray *moves = [[NSMutableArray alloc] init];
+    [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        [moves addObject:@[ indexPath, newIndexPath ]];
+    }];
+    assertThat(moves, hasCountOf(2));
+    assertThat(moves, hasItem(@[ IDX(4, 0), IDX(1, 0) ]));
+    assertThat(moves, hasItem(@[ IDX(1, 0), IDX(4, 0) ]));
+}
+
+- (void)testChangeSetOfMovedObject
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @0, @1, @2, @3, @4, @5 ]];
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [array addObserver:observer];
+
+    [array moveObjectAtIndex:0 toIndex:3];
+
+    HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(1)) dataSource:array didApplyChangeSet:(id)changeSetCaptor];
+
+    FTChangeSet *changeSet = [changeSetCaptor value];
+    assertThat([changeSet deletedItemsInSection:0], hasCountOf(0));
+    assertThat([changeSet insertedItemsInSection:0], hasCountOf(0));
+
+    __block NSUInteger numberOfMoves = 0;
+    [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        assertThat(indexPath, equalTo(IDX(0, 0)));
+        assertThat(newIndexPath, equalTo(IDX(3, 0)));
+        numberOfMoves++;
+    }];
+    assertThatUnsignedInteger(numberOfMoves, equalToUnsignedInteger(1));
+}
+
+- (void)testChangeSetOfReplacedObjects
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @0, @1, @2, @3, @4, @5 ]];
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [array addObserver:observer];
+
+    NSMutableIndexSet *indexes = [[NSMutableIndexSet alloc] init];
+    [indexes addIndex:0];
+    [indexes addIndex:4];
+
+    [array replaceObjectsAtIndexes:indexes withObjects:@[ @20, @40 ]];
+
+    HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(1)) dataSource:array didApplyChangeSet:(id)changeSetCaptor];
+
+    FTChangeSet *changeSet = [changeSetCaptor value];
+    assertThat([changeSet changedItemsInSection:0], equalTo(indexes));
+    assertThat([changeSet insertedItemsInSection:0], hasCountOf(0));
+    assertThat([changeSet deletedItemsInSection:0], hasCountOf(0));
+}
+
+- (void)testReplaceObjectsInRange
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @0, @1, @2, @3, @4, @5 ]];
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [array addObserver:observer];
+
+    [array replaceObjectsInRange:NSMakeRange(1, 2) withObjectsFromArray:@[ @10, @20, @30 ]];
+
+    assertThat(array, contains(@0, @10, @20, @30, @3, @4, @5, nil));
+
+    [verifyCount(observer, times(1)) dataSourceWillChange:array];
+    [verifyCount(observer, times(1)) dataSourceDidChange:array];
+    [verifyCount(observer, times(1)) dataSource:array didChangeItemsAtIndexPaths:@[ IDX(1, 0), IDX(2, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:array didInsertItemsAtIndexPaths:@[ IDX(3, 0) ]];
+    [verifyCount(observer, never()) dataSource:array didDeleteItemsAtIndexPaths:anything()];
+
+    [array replaceObjectsInRange:NSMakeRange(0, 3) withObjectsFromArray:@[ @1 ]];
+
+    assertThat(array, contains(@1, @30, @3, @4, @5, nil));
+
+    [verifyCount(observer, times(1)) dataSource:array didChangeItemsAtIndexPaths:@[ IDX(0, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:array didDeleteItemsAtIndexPaths:@[ IDX(1, 0), IDX(2, 0) ]];
+}
+
+#pragma mark Test Batch Updates
+
+- (void)testBatchUpdate
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @"a", @"b", @"c", @"d" ]];
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [array addObserver:observer];
+
+    [array performBatchUpdate:^{
+        [array insertObject:@"x" atIndex:0];
+        [array replaceObjectAtIndex:2 withObject:@"B"];
+        [array removeObjectAtIndex:4];
+        [array addObject:@"y"];
+    }];
+
+    assertThat(array, contains(@"x", @"a", @"B", @"c", @"y", nil));
+
+    [verifyCount(observer, times(1)) dataSourceWillChange:array];
+    [verifyCount(observer, times(1)) dataSourceDidChange:array];
+
+    HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(1)) dataSource:array didApplyChangeSet:(id)changeSetCaptor];
+
+    FTChangeSet *changeSet = [changeSetCaptor value];
+    assertThat([changeSet deletedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndex:3]));
+    assertThat([changeSet changedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndex:1]));
+
+    NSMutableIndexSet *insertedItems = [NSMutableIndexSet indexSetWithIndex:0];
+    [insertedItems addIndex:4];
+    assertThat([changeSet insertedItemsInSection:0], equalTo(insertedItems));
+
+    [self assertChangeSet:changeSet transformsObjects:@[ @"a", @"b", @"c", @"d" ] toArray:array];
+}
+
+- (void)testBatchUpdateWithMoves
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @0, @1, @2, @3, @4, @5 ]];
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [array addObserver:observer];
+
+    // The move is taken over and replayed as deletion and insertion, when the array is changed afterwards
+
+    [array performBatchUpdate:^{
+        [array moveObjectAtIndex:0 toIndex:3];
+        [array removeObjectAtIndex:0];
+    }];
+
+    assertThat(array, contains(@2, @3, @0, @4, @5, nil));
+
+    HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(1)) dataSource:array didApplyChangeSet:(id)changeSetCaptor];
+
+    FTChangeSet *changeSet = [changeSetCaptor value];
+    assertThat([changeSet deletedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]));
+    assertThat([changeSet insertedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndex:2]));
+    [self assertChangeSet:changeSet transformsObjects:@[ @0, @1, @2, @3, @4, @5 ] toArray:array];
+
+    // Several moves and replacements of all objects in one batch update
+
+    NSArray *objects = [array copy];
+    [array performBatchUpdate:^{
+        [array moveObjectAtIndex:4 toIndex:0];
+        [array replaceAllObjectsWithObjects:@[ @3, @5, @2, @0, @6 ]];
+        [array moveObjectAtIndex:1 toIndex:2];
+        [array insertObject:@7 atIndex:1];
+    }];
+
+    assertThat(array, contains(@3, @7, @2, @5, @0, @6, nil));
+
+    changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(2)) dataSource:array didApplyChangeSet:(id)changeSetCaptor];
+
+    changeSet = [[changeSetCaptor allValues] lastObject];
+    [self assertChangeSet:changeSet transformsObjects:objects toArray:array];
+}
+
+#pragma mark Helper
+
+- (void)assertChangeSet:(FTChangeSet *)changeSet transformsObjects:(NSArray *)objects toArray:(NSArray *)array
+{
+    NSMutableArray *sections = [NSMutableArray arrayWithObject:[objects mutableCopy]];
+    NSMutableArray *sectionItems = [NSMutableArray arrayWithObject:[NSNull null]];
+
+    BOOL success = [changeSet applyToSections:sections
+        sectionItems:sectionItems
+        insertedItemBlock:^id(NSIndexPath *indexPath) {
+            return array[[indexPath indexAtPosition:1]];
+        }
+        insertedSectionItemBlock:nil];
+
+    assertThatBool(success, isTrue());
+    [[changeSet changedItemsInSection:0] enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        NSIndexPath *indexPath = [changeSet indexPathAfterChangesOfItemAtIndexPath:IDX(index, 0)];
+        sections[0][[indexPath indexAtPosition:1]] = array[[indexPath indexAtPosition:1]];
+    }];
+    assertThat(sections[0], equalTo(array));
+}
+
 #pragma mark Test Getting Metrics
 
 - (void)testGetMetrics
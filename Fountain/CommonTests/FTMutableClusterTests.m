@@ -73,8 +73,11 @@
     assertThatInteger([(FTTestItem *)[set itemAtIndexPath:IDX(0, 2)] value], equalToInteger(32));
     assertThatInteger([(FTTestItem *)[set itemAtIndexPath:IDX(1, 2)] value], equalToInteger(33));
 
-    [verifyCount(observer, times(1)) dataSourceWillReset:set];
-    [verifyCount(observer, times(1)) dataSourceDidReset:set];
+    // Items added to an empty set are reported as inserted sections
+
+    [verifyCount(observer, never()) dataSourceWillReset:set];
+    [verifyCount(observer, never()) dataSourceDidReset:set];
+    [verifyCount(observer, times(1)) dataSource:set didInsertSections:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 3)]];
 }
 
 - (void)testCombineClusterByAddingItems
@@ -111,8 +114,12 @@
     assertThatInteger([(FTTestItem *)[set itemAtIndexPath:IDX(1, 0)] value], equalToInteger(17));
     assertThatInteger([(FTTestItem *)[set itemAtIndexPath:IDX(2, 0)] value], equalToInteger(25));
 
-    [verifyCount(observer, times(1)) dataSourceWillReset:set];
-    [verifyCount(observer, times(1)) dataSourceDidReset:set];
+    [verifyCount(observer, times(1)) dataSourceWillChange:set];
+    [verifyCount(observer, times(1)) dataSourceDidChange:set];
+    [verifyCount(observer, never()) dataSourceWillReset:set];
+
+    [verifyCount(observer, times(1)) dataSource:set didDeleteSections:[NSIndexSet indexSetWithIndex:1]];
+    [verifyCount(observer, times(1)) dataSource:set didInsertItemsAtIndexPaths:@[ IDX(1, 0), IDX(2, 0) ]];
 }
 
 - (void)testDevideClusterByRemovingItem
@@ -149,8 +156,55 @@
     assertThatInteger([(FTTestItem *)[set itemAtIndexPath:IDX(0, 0)] value], equalToInteger(10));
     assertThatInteger([(FTTestItem *)[set itemAtIndexPath:IDX(0, 1)] value], equalToInteger(25));
 
-    [verifyCount(observer, times(1)) dataSourceWillReset:set];
-    [verifyCount(observer, times(1)) dataSourceDidReset:set];
+    [verifyCount(observer, times(1)) dataSourceWillChange:set];
+    [verifyCount(observer, times(1)) dataSourceDidChange:set];
+    [verifyCount(observer, never()) dataSourceWillReset:set];
+
+    [verifyCount(observer, times(1)) dataSource:set didDeleteItemsAtIndexPaths:@[ IDX(1, 0), IDX(2, 0) ]];
+    [verifyCount(observer, times(1)) dataSource:set didInsertSections:[NSIndexSet indexSetWithIndex:1]];
+}
+
+- (void)testRemoveItemsOfSeveralClustersInBatch
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initSortDescriptors:sortDescriptors
+                                                                     comperator:[[FTTestItemClusterComperator alloc] init]];
+
+    // All items are in one cluster. Removing every third item splits the
+    // cluster into many clusters within one batch.
+
+    NSMutableArray *items = [[NSMutableArray alloc] init];
+    for (NSInteger i = 0; i < 60; i++) {
+        [items addObject:ITEM(i * 8)];
+    }
+    [set addObjectsFromArray:items];
+
+    assertThatInteger([set numberOfSections], equalToInteger(1));
+
+    NSMutableArray *remainingItems = [[NSMutableArray alloc] init];
+    [set performBatchUpdate:^{
+        [items enumerateObjectsUsingBlock:^(FTTestItem *item, NSUInteger idx, BOOL *stop) {
+            if (idx % 3 == 1) {
+                [set removeObject:item];
+            } else {
+                [remainingItems addObject:item];
+            }
+        }];
+    }];
+
+    // The remaining items form the clusters 0, (16, 24), (40, 48), ..., (448, 456) and 472.
+
+    assertThatInteger([set numberOfSections], equalToInteger(21));
+    assertThatInteger([set numberOfItemsInSection:0], equalToInteger(1));
+    assertThatInteger([set numberOfItemsInSection:1], equalToInteger(2));
+    assertThatInteger([set numberOfItemsInSection:20], equalToInteger(1));
+
+    for (FTTestItem *item in remainingItems) {
+        NSArray *indexPaths = [set indexPathsOfItem:item];
+        assertThat(indexPaths, hasCountOf(1));
+        assertThat([set itemAtIndexPath:[indexPaths firstObject]], sameInstance(item));
+    }
 }
 
 - (void)testUpdateItem
@@ -221,8 +275,232 @@
     assertThatInteger([(FTTestItem *)[set itemAtIndexPath:IDX(4, 1)] value], equalToInteger(32));
     assertThatInteger([(FTTestItem *)[set itemAtIndexPath:IDX(5, 1)] value], equalToInteger(33));
 
+    [verifyCount(observer, times(1)) dataSourceWillChange:set];
+    [verifyCount(observer, times(1)) dataSourceDidChange:set];
+    [verifyCount(observer, never()) dataSourceWillReset:set];
+
+    [verifyCount(observer, times(1)) dataSource:set didDeleteSections:[NSIndexSet indexSetWithIndex:2]];
+    [verifyCount(observer, times(1)) dataSource:set didInsertItemsAtIndexPaths:@[ IDX(4, 1), IDX(5, 1) ]];
+    [verifyCount(observer, times(1)) dataSource:set didMoveItemAtIndexPath:IDX(2, 0) toIndexPath:IDX(3, 1)];
+}
+
+- (void)testUpdateItemInPlace
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initSortDescriptors:sortDescriptors
+                                                                     comperator:[[FTTestItemClusterComperator alloc] init]];
+
+    NSArray *items = @[ ITEM(1), ITEM(3), ITEM(5), ITEM(20) ];
+    [set addObjectsFromArray:items];
+
+    assertThatInteger([set numberOfSections], equalToInteger(2));
+
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [set addObserver:observer];
+
+    FTTestItem *item = items[1];
+    item.value = 4;
+
+    [set addObject:item];
+
+    assertThatInteger([(FTTestItem *)[set itemAtIndexPath:IDX(1, 0)] value], equalToInteger(4));
+
+    [verifyCount(observer, times(1)) dataSource:set didChangeItemsAtIndexPaths:@[ IDX(1, 0) ]];
+    [verifyCount(observer, never()) dataSource:set didMoveItemAtIndexPath:anything() toIndexPath:anything()];
+    [verifyCount(observer, never()) dataSource:set didInsertItemsAtIndexPaths:anything()];
+    [verifyCount(observer, never()) dataSource:set didDeleteItemsAtIndexPaths:anything()];
+}
+
+- (void)testChangeSet
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initSortDescriptors:sortDescriptors
+                                                                     comperator:[[FTTestItemClusterComperator alloc] init]];
+
+    [set addObjectsFromArray:@[ ITEM(1), ITEM(2), ITEM(20), ITEM(40) ]];
+
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [set addObserver:observer];
+
+    // Adding 3 extends the first cluster, 60 creates a new cluster
+
+    [set performBatchUpdate:^{
+        [set addObject:ITEM(3)];
+        [set addObject:ITEM(60)];
+    }];
+
+    HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(1)) dataSource:set didApplyChangeSet:(id)changeSetCaptor];
+
+    FTChangeSet *changeSet = [changeSetCaptor value];
+    assertThat([changeSet insertedSections], equalTo([NSIndexSet indexSetWithIndex:3]));
+    assertThat([changeSet deletedSections], hasCountOf(0));
+    assertThat([changeSet insertedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndex:2]));
+
+    [verifyCount(observer, never()) dataSource:set didInsertSections:anything()];
+    [verifyCount(observer, never()) dataSource:set didInsertItemsAtIndexPaths:anything()];
+}
+
+- (void)testIndexPathsOfItem
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initSortDescriptors:sortDescriptors
+                                                                     comperator:[[FTTestItemClusterComperator alloc] init]];
+
+    NSArray *items = @[ ITEM(1), ITEM(3), ITEM(20), ITEM(22), ITEM(24), ITEM(50) ];
+    [set addObjectsFromArray:items];
+
+    assertThat([set indexPathsOfItem:items[1]], equalTo(@[ IDX(1, 0) ]));
+    assertThat([set indexPathsOfItem:items[4]], equalTo(@[ IDX(2, 1) ]));
+    assertThat([set indexPathsOfItem:items[5]], equalTo(@[ IDX(0, 2) ]));
+    assertThat([set indexPathsOfItem:ITEM(3)], hasCountOf(0));
+
+    // Removing the first cluster shifts the sections of the other items
+
+    [set performBatchUpdate:^{
+        [set removeObject:items[0]];
+        [set removeObject:items[1]];
+    }];
+
+    assertThat([set indexPathsOfItem:items[4]], equalTo(@[ IDX(2, 0) ]));
+    assertThat([set indexPathsOfItem:items[5]], equalTo(@[ IDX(0, 1) ]));
+    assertThat([set indexPathsOfItem:items[0]], hasCountOf(0));
+    assertThatBool([set containsObject:items[2]], isTrue());
+}
+
+- (void)testInitWithSortedObjects
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    NSArray *items = @[ ITEM(1), ITEM(3), ITEM(20), ITEM(22), ITEM(24), ITEM(50) ];
+    FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initWithSortedObjects:items
+                                                                  sortDescriptors:sortDescriptors
+                                                                       comperator:[[FTTestItemClusterComperator alloc] init]];
+
+    assertThatInteger([set count], equalToInteger(6));
+    assertThatInteger([set numberOfSections], equalToInteger(3));
+    assertThatInteger([set numberOfItemsInSection:0], equalToInteger(2));
+    assertThatInteger([set numberOfItemsInSection:1], equalToInteger(3));
+    assertThatInteger([set numberOfItemsInSection:2], equalToInteger(1));
+
+    assertThat([set indexPathsOfItem:items[3]], equalTo(@[ IDX(1, 1) ]));
+
+    // Copies contain the same clusters
+
+    FTMutableClusterSet *copy = [set mutableCopy];
+    assertThatInteger([copy numberOfSections], equalToInteger(3));
+    assertThat([copy indexPathsOfItem:items[5]], equalTo(@[ IDX(0, 2) ]));
+}
+
+- (void)testLoadObjects
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initSortDescriptors:sortDescriptors
+                                                                     comperator:[[FTTestItemClusterComperator alloc] init]];
+
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [set addObserver:observer];
+
+    FTTestItem *item = ITEM(22);
+    [set addObjectsFromArray:@[ ITEM(50), item, ITEM(3), ITEM(20), item, ITEM(1) ]];
+
+    assertThatInteger([set count], equalToInteger(5));
+    assertThatInteger([set numberOfSections], equalToInteger(3));
+    assertThatInteger([(FTTestItem *)[set itemAtIndexPath:IDX(0, 0)] value], equalToInteger(1));
+    assertThatInteger([(FTTestItem *)[set itemAtIndexPath:IDX(1, 1)] value], equalToInteger(22));
+    assertThatInteger([(FTTestItem *)[set itemAtIndexPath:IDX(0, 2)] value], equalToInteger(50));
+
+    [verifyCount(observer, never()) dataSourceWillReset:set];
+    [verifyCount(observer, times(1)) dataSourceWillChange:set];
+    [verifyCount(observer, times(1)) dataSource:set didInsertSections:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 3)]];
+    [verifyCount(observer, times(1)) dataSourceDidChange:set];
+}
+
+- (void)testResetForLargeChanges
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initSortDescriptors:sortDescriptors
+                                                                     comperator:[[FTTestItemClusterComperator alloc] init]];
+
+    NSMutableArray *items = [[NSMutableArray alloc] init];
+    for (NSInteger value = 0; value < 300; value++) {
+        [items addObject:ITEM(value)];
+    }
+    [set addObjectsFromArray:items];
+
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [set addObserver:observer];
+
+    // Removing fewer than half of the items is reported as individual changes
+
+    [set performBatchUpdate:^{
+        for (NSUInteger i = 0; i < 120; i++) {
+            [set removeObject:items[i]];
+        }
+    }];
+
+    [verifyCount(observer, never()) dataSourceWillReset:set];
+    [verifyCount(observer, times(1)) dataSourceWillChange:set];
+
+    // Removing more than half of the remaining items resets the observers
+
+    [set performBatchUpdate:^{
+        for (NSUInteger i = 120; i < 220; i++) {
+            [set removeObject:items[i]];
+        }
+    }];
+
     [verifyCount(observer, times(1)) dataSourceWillReset:set];
     [verifyCount(observer, times(1)) dataSourceDidReset:set];
+    assertThatInteger([set count], equalToInteger(80));
+}
+
+#pragma mark Test Performance
+
+- (void)testPerformanceOfLoadingObjects
+{
+    NSArray *items = [self ft_itemsForPerformanceTests];
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    [self measureBlock:^{
+        FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initSortDescriptors:sortDescriptors
+                                                                         comperator:[[FTTestItemClusterComperator alloc] init]];
+        [set addObjectsFromArray:items];
+    }];
+}
+
+- (void)testPerformanceOfInsertingObjects
+{
+    NSArray *items = [self ft_itemsForPerformanceTests];
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    // Inserting the objects in a batch update applies each object separately
+
+    [self measureBlock:^{
+        FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initSortDescriptors:sortDescriptors
+                                                                         comperator:[[FTTestItemClusterComperator alloc] init]];
+        [set performBatchUpdate:^{
+            for (id item in items) {
+                [set addObject:item];
+            }
+        }];
+    }];
+}
+
+- (NSArray *)ft_itemsForPerformanceTests
+{
+    NSUInteger count = 20000;
+
+    NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [items addObject:ITEM(arc4random_uniform((uint32_t)count * 5))];
+    }
+    return items;
 }
 
 @end
@@ -70,6 +70,71 @@
     assertThat([set itemAtIndexPath:IDX(3, 0)], equalTo(@7));
 }
 
+- (void)testInitWithTreeStorage
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ];
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:sortDescriptors includeEmptySections:YES storage:FTMutableSetStorageTree];
+
+    [set addObjectsFromArray:@[ @(0), @(7), @(5), @(2) ]];
+
+    assertThatUnsignedInteger(set.storage, equalToUnsignedInteger(FTMutableSetStorageTree));
+
+    assertThat([set itemAtIndexPath:IDX(0, 0)], equalTo(@0));
+    assertThat([set itemAtIndexPath:IDX(1, 0)], equalTo(@2));
+    assertThat([set itemAtIndexPath:IDX(2, 0)], equalTo(@5));
+    assertThat([set itemAtIndexPath:IDX(3, 0)], equalTo(@7));
+
+    assertThat([set indexPathsOfItem:@5], contains(IDX(2, 0), nil));
+
+    [set removeObject:@2];
+
+    assertThat([set itemAtIndexPath:IDX(1, 0)], equalTo(@5));
+    assertThat([set indexPathsOfItem:@2], hasCountOf(0));
+
+    FTMutableSet *copiedSet = [set mutableCopy];
+    assertThatUnsignedInteger(copiedSet.storage, equalToUnsignedInteger(FTMutableSetStorageTree));
+    assertThat(copiedSet, hasCountOf(3));
+}
+
+- (void)testInitWithSortedObjects
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ];
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortedObjects:@[ @(0), @(2), @(5), @(7) ] sortDescriptors:sortDescriptors];
+
+    assertThat(set, hasCountOf(4));
+    assertThat([set itemAtIndexPath:IDX(1, 0)], equalTo(@2));
+    assertThat([set indexPathsOfItem:@5], contains(IDX(2, 0), nil));
+
+    [set addObject:@3];
+
+    assertThat([set itemAtIndexPath:IDX(2, 0)], equalTo(@3));
+    assertThat([set indexPathsOfItem:@7], contains(IDX(4, 0), nil));
+
+    // Unsorted objects are rejected, if assertions are enabled
+
+    XCTAssertThrows([[FTMutableSet alloc] initWithSortedObjects:@[ @(2), @(0) ] sortDescriptors:sortDescriptors]);
+}
+
+- (void)testInitWithSortedObjectsAndTreeStorage
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:NO] ];
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortedObjects:@[ @(7), @(5), @(2), @(0) ]
+                                                    sortDescriptors:sortDescriptors
+                                               includeEmptySections:NO
+                                                            storage:FTMutableSetStorageTree];
+
+    assertThatUnsignedInteger(set.storage, equalToUnsignedInteger(FTMutableSetStorageTree));
+    assertThatBool(set.includeEmptySections, isFalse());
+
+    assertThat([set itemAtIndexPath:IDX(0, 0)], equalTo(@7));
+    assertThat([set itemAtIndexPath:IDX(3, 0)], equalTo(@0));
+    assertThat([set indexPathsOfItem:@2], contains(IDX(2, 0), nil));
+
+    [set removeObject:@5];
+
+    assertThat([set itemAtIndexPath:IDX(1, 0)], equalTo(@2));
+}
+
 #pragma mark Test Secure Coding
 
 - (void)testCoding
@@ -93,6 +158,20 @@
     assertThat(unarchivedSet.observers, hasCountOf(0));
 }
 
+- (void)testCodingOfOptions
+{
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ]
+                                                 includeEmptySections:NO
+                                                              storage:FTMutableSetStorageTree];
+
+    NSData *archive = [NSKeyedArchiver archivedDataWithRootObject:set];
+    FTMutableSet *unarchivedSet = [NSKeyedUnarchiver unarchiveObjectWithData:archive];
+
+    assertThatBool(unarchivedSet.includeEmptySections, isFalse());
+    assertThatUnsignedInteger(unarchivedSet.storage, equalToUnsignedInteger(FTMutableSetStorageTree));
+    assertThatUnsignedInteger([unarchivedSet numberOfSections], equalToUnsignedInteger(0));
+}
+
 #pragma mark Test Copying
 
 - (void)testCopying
@@ -113,6 +192,20 @@
     assertThat(copiedSet.observers, hasCountOf(0));
 }
 
+- (void)testCopyingOfOptions
+{
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:NO] ]
+                                                 includeEmptySections:NO
+                                                              storage:FTMutableSetStorageTree];
+    [set addObjectsFromArray:@[ @0, @1, @2 ]];
+
+    FTMutableSet *copiedSet = [set copy];
+
+    assertThatBool(copiedSet.includeEmptySections, isFalse());
+    assertThatUnsignedInteger(copiedSet.storage, equalToUnsignedInteger(FTMutableSetStorageTree));
+    assertThat([copiedSet itemAtIndexPath:IDX(0, 0)], equalTo(@2));
+}
+
 #pragma mark Test Mutable Copying
 
 - (void)testMutableCopying
@@ -443,6 +536,124 @@
     [verifyCount(observer, times(0)) dataSource:set didMoveItemAtIndexPath:anything() toIndexPath:anything()];
 }
 
+- (void)testMoveMultipleItems
+{
+    for (NSNumber *storage in @[ @(FTMutableSetStorageArray), @(FTMutableSetStorageTree) ]) {
+        NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+        FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:sortDescriptors
+                                                     includeEmptySections:YES
+                                                                  storage:[storage unsignedIntegerValue]];
+
+        NSArray *items = @[ ITEM(10), ITEM(20), ITEM(30), ITEM(40), ITEM(50), ITEM(60) ];
+        [set addObjectsFromArray:items];
+
+        id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+        [set addObserver:observer];
+
+        [(FTTestItem *)items[1] setValue:55]; // 20 -> 55
+        [(FTTestItem *)items[2] setValue:35]; // 30 -> 35
+        [(FTTestItem *)items[4] setValue:5];  // 50 -> 5
+
+        [set performBatchUpdate:^{
+            [set addObject:items[1]];
+            [set addObject:items[2]];
+            [set addObject:items[4]];
+        }];
+
+        // Expected values:
+        // 5, 10, 35, 40, 55, 60
+
+        NSArray *expectedItems = @[ items[4], items[0], items[2], items[3], items[1], items[5] ];
+        [expectedItems enumerateObjectsUsingBlock:^(id item, NSUInteger idx, BOOL *stop) {
+            assertThat([set itemAtIndexPath:IDX(idx, 0)], sameInstance(item));
+        }];
+
+        [verifyCount(observer, times(1)) dataSourceWillChange:set];
+        [verifyCount(observer, times(1)) dataSourceDidChange:set];
+        [verifyCount(observer, times(1)) dataSource:set didChangeItemsAtIndexPaths:@[ IDX(2, 0) ]];
+        [verifyCount(observer, times(1)) dataSource:set didMoveItemAtIndexPath:IDX(1, 0) toIndexPath:IDX(4, 0)];
+        [verifyCount(observer, times(1)) dataSource:set didMoveItemAtIndexPath:IDX(4, 0) toIndexPath:IDX(0, 0)];
+    }
+}
+
+#pragma mark Test Change Sets
+
+- (void)testChangeSet
+{
+    for (NSNumber *storage in @[ @(FTMutableSetStorageArray), @(FTMutableSetStorageTree) ]) {
+        NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+        FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:sortDescriptors
+                                                     includeEmptySections:YES
+                                                                  storage:[storage unsignedIntegerValue]];
+
+        NSArray *items = @[ ITEM(10), ITEM(20), ITEM(30), ITEM(40), ITEM(50), ITEM(60) ];
+        [set addObjectsFromArray:items];
+
+        id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+        [set addObserver:observer];
+
+        FTTestItem *item = items[1];
+        item.value = 55;
+
+        [set performBatchUpdate:^{
+            [set addObject:item];       // 20 -> 55
+            [set removeObject:items[0]]; // 10
+            [set removeObject:items[3]]; // 40
+            [set addObject:ITEM(35)];
+        }];
+
+        // Expected values:
+        // 30, 35, 50, 55, 60
+
+        HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+        [verifyCount(observer, times(1)) dataSource:set didApplyChangeSet:(id)changeSetCaptor];
+
+        FTChangeSet *changeSet = [changeSetCaptor value];
+
+        NSMutableIndexSet *deletedItems = [[NSMutableIndexSet alloc] init];
+        [deletedItems addIndex:0];
+        [deletedItems addIndex:3];
+
+        assertThat([changeSet deletedItemsInSection:0], equalTo(deletedItems));
+        assertThat([changeSet insertedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndex:1]));
+        assertThat([changeSet changedItemsInSection:0], hasCountOf(0));
+
+        __block NSUInteger numberOfMoves = 0;
+        [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+            assertThat(indexPath, equalTo(IDX(1, 0)));
+            assertThat(newIndexPath, equalTo(IDX(3, 0)));
+            numberOfMoves++;
+        }];
+        assertThatInteger(numberOfMoves, equalToInteger(1));
+
+        assertThat([set itemAtIndexPath:IDX(3, 0)], sameInstance(item));
+
+        [verifyCount(observer, never()) dataSource:set didDeleteItemsAtIndexPaths:anything()];
+        [verifyCount(observer, never()) dataSource:set didMoveItemAtIndexPath:anything() toIndexPath:anything()];
+    }
+}
+
+- (void)testChangeSetOfEmptySection
+{
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ] includeEmptySections:NO];
+
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [set addObserver:observer];
+
+    [set performBatchUpdate:^{
+        [set addObjectsFromArray:@[ @(0), @(2), @(3) ]];
+    }];
+
+    HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(1)) dataSource:set didApplyChangeSet:(id)changeSetCaptor];
+
+    FTChangeSet *changeSet = [changeSetCaptor value];
+    assertThat([changeSet insertedSections], equalTo([NSIndexSet indexSetWithIndex:0]));
+    assertThat([changeSet insertedItemsInSection:0], hasCountOf(0));
+
+    [verifyCount(observer, never()) dataSource:set didInsertSections:anything()];
+}
+
 #pragma mark Test Getting Metrics
 
 - (void)testGetMetrics
@@ -472,4 +683,194 @@
     assertThat([set itemAtIndexPath:IDX(6, 0)], equalTo(@6));
 }
 
+#pragma mark Test Work
+
+- (void)testWorkOfBulkAddAndRemove
+{
+    // The work is counted by the instrumentation of the batch updates. With a
+    // tenfold number of objects, the comparisons of the insertion may grow by
+    // n log n (less than twentyfold), but not quadratically.
+    //
+    // With the array storage, the deletion scans the backing store in each
+    // batch. Removing objects in separate batches is therefore quadratic,
+    // and only the single batch of this test is bound to one pass.
+
+    FTAggregatingInstrumentationSink *sink = [[FTAggregatingInstrumentationSink alloc] init];
+    [FTInstrumentation setSink:sink];
+
+    NSDictionary *work1K = [self ft_workOfBulkAddAndRemoveOfObjects:1000 sink:sink];
+    NSDictionary *work10K = [self ft_workOfBulkAddAndRemoveOfObjects:10000 sink:sink];
+
+    [FTInstrumentation setSink:nil];
+
+    NSUInteger comparisons1K = [work1K[@"comparisons"] unsignedIntegerValue];
+    NSUInteger comparisons10K = [work10K[@"comparisons"] unsignedIntegerValue];
+    XCTAssertGreaterThan(comparisons1K, 0);
+    XCTAssertLessThanOrEqual(comparisons10K, comparisons1K * 20);
+
+    XCTAssertLessThanOrEqual([work1K[@"scanned"] unsignedIntegerValue], 1000);
+    XCTAssertLessThanOrEqual([work10K[@"scanned"] unsignedIntegerValue], 10000);
+}
+
+- (NSDictionary *)ft_workOfBulkAddAndRemoveOfObjects:(NSUInteger)count sink:(FTAggregatingInstrumentationSink *)sink
+{
+    NSMutableArray *objects = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [objects addObject:@(i)];
+    }
+
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ]];
+
+    [sink reset];
+
+    [set performBatchUpdate:^{
+        [set addObjectsFromArray:objects];
+    }];
+    [set performBatchUpdate:^{
+        for (id object in objects) {
+            [set removeObject:object];
+        }
+    }];
+
+    XCTAssertEqual([set count], 0);
+
+    return @{ @"comparisons" : @([sink totalCount:@"comparisons" ofSpansWithName:@"FTMutableSet.batch"]),
+              @"scanned" : @([sink totalCount:@"scanned" ofSpansWithName:@"FTMutableSet.batch"]) };
+}
+
+#pragma mark Test Performance
+
+- (void)testPerformanceOfBulkAddAndRemove1K
+{
+    [self ft_measureBulkAddAndRemoveOfObjects:1000];
+}
+
+- (void)testPerformanceOfBulkAddAndRemove10K
+{
+    [self ft_measureBulkAddAndRemoveOfObjects:10000];
+}
+
+- (void)testPerformanceOfBulkAddAndRemove100K
+{
+    [self ft_measureBulkAddAndRemoveOfObjects:100000];
+}
+
+- (void)testPerformanceOfBulkAddAndRemove1M
+{
+    [self ft_measureBulkAddAndRemoveOfObjects:1000000];
+}
+
+- (void)testPerformanceOfScatteredInsertsWithArrayStorage
+{
+    [self ft_measureScatteredInsertsWithStorage:FTMutableSetStorageArray];
+}
+
+- (void)testPerformanceOfScatteredInsertsWithTreeStorage
+{
+    [self ft_measureScatteredInsertsWithStorage:FTMutableSetStorageTree];
+}
+
+- (void)testPerformanceOfUpdatesWithArrayStorage
+{
+    [self ft_measureUpdatesWithStorage:FTMutableSetStorageArray];
+}
+
+- (void)testPerformanceOfUpdatesWithTreeStorage
+{
+    [self ft_measureUpdatesWithStorage:FTMutableSetStorageTree];
+}
+
+- (void)ft_measureUpdatesWithStorage:(FTMutableSetStorage)storage
+{
+    NSUInteger count = 200000;
+
+    NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [items addObject:ITEM(i * 2)];
+    }
+
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    [self measureMetrics:[[self class] defaultPerformanceMetrics]
+        automaticallyStartMeasuring:NO
+                           forBlock:^{
+                               FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:sortDescriptors includeEmptySections:YES storage:storage];
+                               [set performBatchUpdate:^{
+                                   [set addObjectsFromArray:items];
+                               }];
+
+                               [self startMeasuring];
+
+                               for (NSUInteger i = 0; i < 100; i++) {
+                                   [set performBatchUpdate:^{
+                                       for (NSUInteger j = 0; j < 10; j++) {
+                                           FTTestItem *item = items[arc4random_uniform((uint32_t)count)];
+                                           item.value = arc4random_uniform((uint32_t)count * 2);
+                                           [set addObject:item];
+                                       }
+                                   }];
+                               }
+
+                               [self stopMeasuring];
+                           }];
+}
+
+- (void)ft_measureScatteredInsertsWithStorage:(FTMutableSetStorage)storage
+{
+    NSUInteger count = 500000;
+
+    NSMutableArray *objects = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [objects addObject:@(i * 2)];
+    }
+
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ];
+
+    [self measureMetrics:[[self class] defaultPerformanceMetrics]
+        automaticallyStartMeasuring:NO
+                           forBlock:^{
+                               FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:sortDescriptors includeEmptySections:YES storage:storage];
+                               [set addObjectsFromArray:objects];
+
+                               [self startMeasuring];
+
+                               for (NSUInteger i = 0; i < 1000; i++) {
+                                   [set addObject:@(arc4random_uniform((uint32_t)count) * 2 + 1)];
+                               }
+
+                               [self stopMeasuring];
+                           }];
+}
+
+- (void)ft_measureBulkAddAndRemoveOfObjects:(NSUInteger)count
+{
+    NSMutableArray *objects = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [objects addObject:@(i)];
+    }
+
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ];
+
+    [self measureMetrics:[[self class] defaultPerformanceMetrics]
+        automaticallyStartMeasuring:NO
+                           forBlock:^{
+                               FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:sortDescriptors];
+
+                               [self startMeasuring];
+
+                               [set performBatchUpdate:^{
+                                   [set addObjectsFromArray:objects];
+                               }];
+                               [set performBatchUpdate:^{
+                                   for (id object in objects) {
+                                       [set removeObject:object];
+                                   }
+                               }];
+
+                               [self stopMeasuring];
+
+                               XCTAssertEqual([set count], 0);
+                           }];
+}
+
 @end
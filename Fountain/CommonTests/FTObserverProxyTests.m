@@ -0,0 +1,107 @@
+//
+//  FTObserverProxyTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 18.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#define HC_SHORTHAND
+#define MOCKITO_SHORTHAND
+
+#import <Fountain/Fountain.h>
+#import <OCHamcrest/OCHamcrest.h>
+#import <OCMockito/OCMockito.h>
+#import <XCTest/XCTest.h>
+
+#define IDX(item, section) [[NSIndexPath indexPathWithIndex:section] indexPathByAddingIndex:item]
+
+@interface FTObserverProxyTestsObserver : NSObject <FTDataSourceObserver>
+@end
+
+@implementation FTObserverProxyTestsObserver
+- (void)dataSource:(id<FTDataSource>)dataSource didInsertItemsAtIndexPaths:(NSArray *)indexPaths {}
+@end
+
+@interface FTObserverProxyTests : XCTestCase
+@property (nonatomic, strong) FTMutableArray *object;
+@property (nonatomic, strong) FTObserverProxy *proxy;
+@end
+
+@implementation FTObserverProxyTests
+
+#pragma mark Test Life-cycle
+
+- (void)setUp
+{
+    [super setUp];
+    self.object = [[FTMutableArray alloc] init];
+    self.proxy = [[FTObserverProxy alloc] init];
+    self.proxy.object = self.object;
+}
+
+- (void)tearDown
+{
+    self.proxy = nil;
+    self.object = nil;
+    [super tearDown];
+}
+
+#pragma mark Tests
+
+- (void)testCombineChangesOfNestedUpdates
+{
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [self.proxy addObserver:observer];
+
+    [self.proxy dataSourceWillChange:self.object];
+    [self.proxy dataSource:self.object didInsertItemsAtIndexPaths:@[ IDX(0, 0) ]];
+    [self.proxy dataSourceWillChange:self.object];
+    [self.proxy dataSource:self.object didInsertItemsAtIndexPaths:@[ IDX(1, 0) ]];
+    [self.proxy dataSourceDidChange:self.object];
+
+    [verifyCount(observer, never()) dataSource:anything() didApplyChangeSet:anything()];
+
+    [self.proxy dataSourceDidChange:self.object];
+
+    HCArgumentCaptor *changeSetCaptor = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(1)) dataSource:self.object didApplyChangeSet:(id)changeSetCaptor];
+
+    FTChangeSet *changeSet = [changeSetCaptor value];
+    assertThat([changeSet insertedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]));
+}
+
+- (void)testResetDiscardsChanges
+{
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [self.proxy addObserver:observer];
+
+    [self.proxy dataSourceWillChange:self.object];
+    [self.proxy dataSource:self.object didInsertItemsAtIndexPaths:@[ IDX(0, 0) ]];
+    [self.proxy dataSourceDidReset:self.object];
+    [self.proxy dataSourceDidChange:self.object];
+
+    [verifyCount(observer, times(1)) dataSourceDidReset:self.object];
+    [verifyCount(observer, never()) dataSource:anything() didApplyChangeSet:anything()];
+}
+
+- (void)testChangesAreOnlyRecordedForChangeSetObservers
+{
+    FTObserverProxyTestsObserver *legacyObserver = [[FTObserverProxyTestsObserver alloc] init];
+    [self.proxy addObserver:legacyObserver];
+
+    [self.proxy dataSourceWillChange:self.object];
+    [self.proxy dataSource:self.object didInsertItemsAtIndexPaths:@[ IDX(0, 0) ]];
+
+    // An observer added within the update does not receive the changes made before
+
+    id<FTDataSourceChangeSetObserver> observer = mockProtocol(@protocol(FTDataSourceChangeSetObserver));
+    [self.proxy addObserver:observer];
+
+    [self.proxy dataSourceDidChange:self.object];
+
+    [verifyCount(observer, never()) dataSource:anything() didApplyChangeSet:anything()];
+    [verifyCount(observer, times(1)) dataSourceDidChange:self.object];
+}
+
+@end
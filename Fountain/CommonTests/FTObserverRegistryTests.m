@@ -0,0 +1,131 @@
+//
+//  FTObserverRegistryTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 28.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#define HC_SHORTHAND
+#define MOCKITO_SHORTHAND
+
+#import <Fountain/Fountain.h>
+#import <OCHamcrest/OCHamcrest.h>
+#import <OCMockito/OCMockito.h>
+#import <XCTest/XCTest.h>
+
+@interface FTObserverRegistryTestsObserver : NSObject <FTDataSourceChangeSetObserver>
+@end
+
+@implementation FTObserverRegistryTestsObserver
+- (void)dataSourceWillChange:(id<FTDataSource>)dataSource {}
+- (void)dataSource:(id<FTDataSource>)dataSource didApplyChangeSet:(FTChangeSet *)changeSet {}
+@end
+
+@interface FTObserverRegistryTests : XCTestCase
+
+@end
+
+@implementation FTObserverRegistryTests
+
+#pragma mark Test Observers
+
+- (void)testAddObserver
+{
+    FTObserverRegistry *registry = [[FTObserverRegistry alloc] init];
+    FTObserverRegistryTestsObserver *observerA = [[FTObserverRegistryTestsObserver alloc] init];
+    FTObserverRegistryTestsObserver *observerB = [[FTObserverRegistryTestsObserver alloc] init];
+
+    [registry addObserver:observerA];
+    [registry addObserver:observerB];
+    [registry addObserver:observerA];
+
+    assertThat([registry observers], contains(observerB, observerA, nil));
+
+    [registry removeObserver:observerA];
+
+    assertThat([registry observers], contains(observerB, nil));
+}
+
+- (void)testObserversAreHeldWeakly
+{
+    FTObserverRegistry *registry = [[FTObserverRegistry alloc] init];
+
+    @autoreleasepool {
+        FTObserverRegistryTestsObserver *observer = [[FTObserverRegistryTestsObserver alloc] init];
+        [registry addObserver:observer];
+        assertThat([registry observers], hasCountOf(1));
+    }
+
+    assertThat([registry observers], hasCountOf(0));
+
+    __block NSUInteger numberOfObservers = 0;
+    [registry enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        numberOfObservers++;
+    }];
+    XCTAssertEqual(numberOfObservers, 0);
+}
+
+#pragma mark Test Implemented Methods
+
+- (void)testImplementedMethods
+{
+    FTObserverRegistry *registry = [[FTObserverRegistry alloc] init];
+    FTObserverRegistryTestsObserver *observer = [[FTObserverRegistryTestsObserver alloc] init];
+
+    XCTAssertEqual([registry implementedMethods], 0);
+
+    [registry addObserver:observer];
+
+    FTDataSourceObserverMethods expectedMethods = FTDataSourceObserverMethodWillChange | FTDataSourceObserverMethodDidApplyChangeSet;
+    XCTAssertEqual([registry implementedMethods], expectedMethods);
+
+    [registry enumerateObserversUsingBlock:^(id<FTDataSourceObserver> o, FTDataSourceObserverMethods methods) {
+        XCTAssertEqual(o, observer);
+        XCTAssertEqual(methods, expectedMethods);
+    }];
+
+    XCTAssertTrue([registry hasObserversImplementingMethods:FTDataSourceObserverMethodWillChange excludingMethods:0]);
+    XCTAssertFalse([registry hasObserversImplementingMethods:FTDataSourceObserverMethodWillChange
+                                             excludingMethods:FTDataSourceObserverMethodDidApplyChangeSet]);
+    XCTAssertFalse([registry hasObserversImplementingMethods:FTDataSourceObserverMethodDidChange excludingMethods:0]);
+}
+
+#pragma mark Test Enumerating Observers
+
+- (void)testMutateWhileEnumerating
+{
+    FTObserverRegistry *registry = [[FTObserverRegistry alloc] init];
+    FTObserverRegistryTestsObserver *observerA = [[FTObserverRegistryTestsObserver alloc] init];
+    FTObserverRegistryTestsObserver *observerB = [[FTObserverRegistryTestsObserver alloc] init];
+
+    [registry addObserver:observerA];
+
+    __block NSUInteger numberOfObservers = 0;
+    [registry enumerateObserversUsingBlock:^(id<FTDataSourceObserver> observer, FTDataSourceObserverMethods methods) {
+        [registry removeObserver:observerA];
+        [registry addObserver:observerB];
+        numberOfObservers++;
+    }];
+
+    XCTAssertEqual(numberOfObservers, 1);
+    assertThat([registry observers], contains(observerB, nil));
+}
+
+#pragma mark Test Data Sources
+
+- (void)testDataSourceHoldsObserversWeakly
+{
+    FTMutableArray *array = [[FTMutableArray alloc] init];
+
+    @autoreleasepool {
+        FTObserverRegistryTestsObserver *observer = [[FTObserverRegistryTestsObserver alloc] init];
+        [array addObserver:observer];
+        assertThat([array observers], hasCountOf(1));
+    }
+
+    assertThat([array observers], hasCountOf(0));
+    [array addObject:@"a"];
+}
+
+@end
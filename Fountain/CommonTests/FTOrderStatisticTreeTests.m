@@ -0,0 +1,125 @@
+//
+//  FTOrderStatisticTreeTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 12.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTOrderStatisticTree.h"
+#import <XCTest/XCTest.h>
+
+@interface FTOrderStatisticTreeTests : XCTestCase
+
+@end
+
+@implementation FTOrderStatisticTreeTests
+
+- (void)testInitWithObjects
+{
+    NSArray *objects = @[ @(1), @(2), @(3), @(4), @(5), @(6), @(7), @(8) ];
+
+    FTOrderStatisticTree *tree = [[FTOrderStatisticTree alloc] initWithArray:objects];
+
+    XCTAssertEqual([tree count], [objects count]);
+    XCTAssertEqualObjects([NSArray arrayWithArray:tree], objects);
+}
+
+- (void)testInsertAndRemove
+{
+    FTOrderStatisticTree *tree = [[FTOrderStatisticTree alloc] init];
+    NSMutableArray *array = [[NSMutableArray alloc] init];
+
+    for (NSUInteger i = 0; i < 1000; i++) {
+        NSUInteger index = arc4random_uniform((uint32_t)[array count] + 1);
+        [tree insertObject:@(i) atIndex:index];
+        [array insertObject:@(i) atIndex:index];
+    }
+
+    XCTAssertEqualObjects([NSArray arrayWithArray:tree], array);
+
+    for (NSUInteger i = 0; i < 500; i++) {
+        NSUInteger index = arc4random_uniform((uint32_t)[array count]);
+        [tree removeObjectAtIndex:index];
+        [array removeObjectAtIndex:index];
+    }
+
+    XCTAssertEqualObjects([NSArray arrayWithArray:tree], array);
+
+    [array enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+        XCTAssertEqualObjects([tree objectAtIndex:idx], obj);
+        XCTAssertEqual([tree indexOfObject:obj], idx);
+    }];
+}
+
+- (void)testReplaceObject
+{
+    FTOrderStatisticTree *tree = [[FTOrderStatisticTree alloc] initWithArray:@[ @(1), @(2), @(3) ]];
+
+    [tree replaceObjectAtIndex:1 withObject:@(5)];
+
+    XCTAssertEqualObjects([NSArray arrayWithArray:tree], (@[ @(1), @(5), @(3) ]));
+    XCTAssertEqual([tree indexOfObject:@(5)], 1);
+    XCTAssertEqual([tree indexOfObject:@(2)], NSNotFound);
+}
+
+- (void)testBinarySearch
+{
+    FTOrderStatisticTree *tree = [[FTOrderStatisticTree alloc] initWithArray:@[ @(10), @(20), @(30), @(40) ]];
+
+    NSComparator comperator = ^(NSNumber *obj1, NSNumber *obj2) {
+        return [obj1 compare:obj2];
+    };
+
+    NSRange range = NSMakeRange(0, [tree count]);
+
+    XCTAssertEqual([tree indexOfObject:@(25) inSortedRange:range options:NSBinarySearchingInsertionIndex usingComparator:comperator], 2);
+    XCTAssertEqual([tree indexOfObject:@(5) inSortedRange:range options:NSBinarySearchingInsertionIndex usingComparator:comperator], 0);
+    XCTAssertEqual([tree indexOfObject:@(50) inSortedRange:range options:NSBinarySearchingInsertionIndex usingComparator:comperator], 4);
+    XCTAssertEqual([tree indexOfObject:@(30) inSortedRange:range options:NSBinarySearchingFirstEqual usingComparator:comperator], 2);
+    XCTAssertEqual([tree indexOfObject:@(30) inSortedRange:range options:NSBinarySearchingLastEqual | NSBinarySearchingInsertionIndex usingComparator:comperator], 3);
+    XCTAssertEqual([tree indexOfObject:@(35) inSortedRange:range options:0 usingComparator:comperator], NSNotFound);
+}
+
+- (void)testEnumeration
+{
+    NSMutableArray *array = [[NSMutableArray alloc] init];
+    for (NSUInteger i = 0; i < 100; i++) {
+        [array addObject:@(i)];
+    }
+
+    FTOrderStatisticTree *tree = [[FTOrderStatisticTree alloc] initWithArray:array];
+
+    NSMutableArray *enumeratedObjects = [[NSMutableArray alloc] init];
+    for (id object in tree) {
+        [enumeratedObjects addObject:object];
+    }
+    XCTAssertEqualObjects(enumeratedObjects, array);
+
+    XCTAssertEqualObjects([[tree objectEnumerator] allObjects], array);
+    XCTAssertNil([[[[FTOrderStatisticTree alloc] init] objectEnumerator] nextObject]);
+
+    // Mutating the tree during the enumeration raises an exception.
+
+    BOOL raised = NO;
+    @try {
+        for (id object in tree) {
+            [tree removeObject:object];
+        }
+    } @catch (NSException *exception) {
+        raised = YES;
+    }
+    XCTAssertTrue(raised);
+}
+
+- (void)testSorting
+{
+    FTOrderStatisticTree *tree = [[FTOrderStatisticTree alloc] initWithArray:@[ @(4), @(1), @(3), @(2) ]];
+
+    [tree sortUsingDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ]];
+
+    XCTAssertEqualObjects([NSArray arrayWithArray:tree], (@[ @(1), @(2), @(3), @(4) ]));
+    XCTAssertEqual([tree indexOfObject:@(4)], 3);
+}
+
+@end
@@ -0,0 +1,246 @@
+//
+//  FTPagedDataSourceTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 03.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#define HC_SHORTHAND
+#define MOCKITO_SHORTHAND
+
+#import <Fountain/Fountain.h>
+#import <OCHamcrest/OCHamcrest.h>
+#import <OCMockito/OCMockito.h>
+#import <XCTest/XCTest.h>
+
+#define IDX(item, section) [[NSIndexPath indexPathWithIndex:section] indexPathByAddingIndex:item]
+
+@interface FTPagedDataSourceTests : XCTestCase
+@property (nonatomic, strong) NSCountedSet *requestedPages;
+@end
+
+@implementation FTPagedDataSourceTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.requestedPages = [[NSCountedSet alloc] init];
+}
+
+#pragma mark Page Loader
+
+// Loads pages 0 to 9 with 20 items each on a background queue. The item of a
+// page is the absolute index of the item. Page 10 is empty.
+- (FTPagedDataSourcePageLoader)pageLoaderWithLatency:(NSTimeInterval)latency
+{
+    NSCountedSet *requestedPages = self.requestedPages;
+    return ^(NSInteger page, FTPagedDataSourceCompletionHandler completionHandler) {
+        @synchronized(requestedPages)
+        {
+            [requestedPages addObject:@(page)];
+        }
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(latency * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            NSMutableArray *items = [[NSMutableArray alloc] init];
+            if (page < 10) {
+                for (NSInteger i = 0; i < 20; i++) {
+                    [items addObject:@(page * 20 + i)];
+                }
+            }
+            completionHandler(items, nil);
+        });
+    };
+}
+
+- (void)waitForPage:(NSInteger)page ofDataSource:(FTPagedDataSource *)dataSource
+{
+    NSDate *timeout = [NSDate dateWithTimeIntervalSinceNow:2.0];
+    while (([dataSource firstLoadedPage] > page || [dataSource firstLoadedPage] + (NSInteger)[dataSource numberOfLoadedPages] <= page) &&
+           [timeout timeIntervalSinceNow] > 0) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+}
+
+#pragma mark Tests
+
+- (void)testLoadFirstPage
+{
+    FTPagedDataSource *dataSource = [[FTPagedDataSource alloc] initWithPageLoader:[self pageLoaderWithLatency:0.01]];
+
+    XCTAssertEqual([dataSource numberOfSections], 1);
+    XCTAssertEqual([dataSource numberOfItemsInSection:0], 0);
+    XCTAssertFalse([dataSource hasItemsBeforeFirstItem]);
+    XCTAssertTrue([dataSource hasItemsAfterLastItem]);
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Page Loaded"];
+    [dataSource loadFirstPageWithCompletionHandler:^(BOOL success, NSError *error) {
+        XCTAssertTrue(success);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+
+    XCTAssertEqual([dataSource numberOfLoadedPages], 1);
+    XCTAssertEqual([dataSource numberOfItemsInSection:0], 20);
+    XCTAssertEqualObjects([dataSource itemAtIndexPath:IDX(0, 0)], @(0));
+    XCTAssertEqualObjects([dataSource itemAtIndexPath:IDX(19, 0)], @(19));
+    XCTAssertEqualObjects([dataSource indexPathsOfItem:@(5)], @[ IDX(5, 0) ]);
+    XCTAssertFalse([dataSource hasItemsBeforeFirstItem]);
+    XCTAssertTrue([dataSource hasItemsAfterLastItem]);
+}
+
+- (void)testRequestDedupe
+{
+    FTPagedDataSource *dataSource = [[FTPagedDataSource alloc] initWithPageLoader:[self pageLoaderWithLatency:0.05]];
+
+    XCTestExpectation *firstExpectation = [self expectationWithDescription:@"First Request"];
+    XCTestExpectation *secondExpectation = [self expectationWithDescription:@"Second Request"];
+
+    [dataSource loadFirstPageWithCompletionHandler:^(BOOL success, NSError *error) {
+        [firstExpectation fulfill];
+    }];
+    [dataSource loadMoreItemsAfterLastItemCompletionHandler:^(BOOL success, NSError *error) {
+        [secondExpectation fulfill];
+    }];
+
+    XCTAssertTrue([dataSource isLoadingPage:0]);
+
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+
+    XCTAssertFalse([dataSource isLoadingPage:0]);
+    XCTAssertEqual([self.requestedPages countForObject:@(0)], 1);
+    XCTAssertEqual([dataSource numberOfItemsInSection:0], 20);
+}
+
+- (void)testInsertPages
+{
+    FTPagedDataSource *dataSource = [[FTPagedDataSource alloc] initWithPageLoader:[self pageLoaderWithLatency:0.01]];
+
+    id<FTDataSourceObserver> observer = mockProtocol(@protocol(FTDataSourceObserver));
+    [dataSource addObserver:observer];
+
+    [dataSource loadFirstPageWithCompletionHandler:nil];
+    [self waitForPage:0 ofDataSource:dataSource];
+
+    [verify(observer) dataSourceWillChange:dataSource];
+    [verify(observer) dataSource:dataSource didInsertItemsAtIndexPaths:hasCountOf(20)];
+    [verify(observer) dataSourceDidChange:dataSource];
+
+    [dataSource loadMoreItemsAfterLastItemCompletionHandler:nil];
+    [self waitForPage:1 ofDataSource:dataSource];
+
+    HCArgumentCaptor *indexPaths = [[HCArgumentCaptor alloc] init];
+    [verifyCount(observer, times(2)) dataSource:dataSource didInsertItemsAtIndexPaths:(id)indexPaths];
+
+    NSMutableArray *expectedIndexPaths = [[NSMutableArray alloc] init];
+    for (NSUInteger item = 20; item < 40; item++) {
+        [expectedIndexPaths addObject:IDX(item, 0)];
+    }
+    XCTAssertEqualObjects([[indexPaths allValues] lastObject], expectedIndexPaths);
+}
+
+- (void)testEndOfPages
+{
+    FTPagedDataSource *dataSource = [[FTPagedDataSource alloc] initWithPageLoader:[self pageLoaderWithLatency:0.01] firstPage:8];
+
+    [dataSource loadFirstPageWithCompletionHandler:nil];
+    [self waitForPage:8 ofDataSource:dataSource];
+    [dataSource loadMoreItemsAfterLastItemCompletionHandler:nil];
+    [self waitForPage:9 ofDataSource:dataSource];
+
+    XCTAssertTrue([dataSource hasItemsAfterLastItem]);
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Empty Page Loaded"];
+    [dataSource loadMoreItemsAfterLastItemCompletionHandler:^(BOOL success, NSError *error) {
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+
+    XCTAssertFalse([dataSource hasItemsAfterLastItem]);
+    XCTAssertFalse([dataSource hasItemsBeforeFirstItem]);
+    XCTAssertEqual([dataSource numberOfItemsInSection:0], 40);
+    XCTAssertEqualObjects([dataSource itemAtIndexPath:IDX(0, 0)], @(160));
+}
+
+- (void)testRemovePagesBeyondLimit
+{
+    FTPagedDataSource *dataSource = [[FTPagedDataSource alloc] initWithPageLoader:[self pageLoaderWithLatency:0.01]];
+    dataSource.maximumNumberOfPages = 3;
+
+    [dataSource loadFirstPageWithCompletionHandler:nil];
+    [self waitForPage:0 ofDataSource:dataSource];
+    for (NSInteger page = 1; page < 5; page++) {
+        [dataSource loadMoreItemsAfterLastItemCompletionHandler:nil];
+        [self waitForPage:page ofDataSource:dataSource];
+    }
+
+    XCTAssertEqual([dataSource numberOfLoadedPages], 3);
+    XCTAssertEqual([dataSource firstLoadedPage], 2);
+    XCTAssertEqual([dataSource numberOfItemsInSection:0], 60);
+    XCTAssertEqualObjects([dataSource itemAtIndexPath:IDX(0, 0)], @(40));
+    XCTAssertTrue([dataSource hasItemsBeforeFirstItem]);
+
+    // Scrolling back loads the removed pages again and removes the pages at the end
+
+    [dataSource loadMoreItemsBeforeFirstItemCompletionHandler:nil];
+    [self waitForPage:1 ofDataSource:dataSource];
+
+    XCTAssertEqual([dataSource numberOfLoadedPages], 3);
+    XCTAssertEqual([dataSource firstLoadedPage], 1);
+    XCTAssertEqualObjects([dataSource itemAtIndexPath:IDX(0, 0)], @(20));
+}
+
+- (void)testPrefetchPages
+{
+    FTPagedDataSource *dataSource = [[FTPagedDataSource alloc] initWithPageLoader:[self pageLoaderWithLatency:0.01]];
+    dataSource.prefetchDistance = 30;
+
+    [dataSource loadFirstPageWithCompletionHandler:nil];
+    [self waitForPage:0 ofDataSource:dataSource];
+
+    // Prefetching item 15 needs items up to 45, which are loaded concurrently
+
+    [dataSource prefetchItemsAtIndexPaths:@[ IDX(15, 0) ]];
+
+    XCTAssertTrue([dataSource isLoadingPage:1]);
+    XCTAssertTrue([dataSource isLoadingPage:2]);
+    XCTAssertFalse([dataSource isLoadingPage:3]);
+
+    [self waitForPage:2 ofDataSource:dataSource];
+
+    XCTAssertEqual([dataSource numberOfItemsInSection:0], 60);
+    XCTAssertEqual([self.requestedPages countForObject:@(1)], 1);
+    XCTAssertEqual([self.requestedPages countForObject:@(2)], 1);
+}
+
+- (void)testScrollingWithoutStalls
+{
+    FTPagedDataSource *dataSource = [[FTPagedDataSource alloc] initWithPageLoader:[self pageLoaderWithLatency:0.05]];
+    dataSource.prefetchDistance = 40;
+    dataSource.maximumNumberOfPages = 4;
+
+    [dataSource loadFirstPageWithCompletionHandler:nil];
+    [self waitForPage:0 ofDataSource:dataSource];
+
+    // Scrolls through all items with one item every 10ms. With the prefetch
+    // distance, each item is already loaded, when it is displayed, although
+    // loading a page takes the time of displaying five items.
+
+    for (NSInteger item = 0; item < 200; item++) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+
+        NSArray *indexPaths = [dataSource indexPathsOfItem:@(item)];
+        XCTAssertEqual([indexPaths count], 1, @"Item %ld is not loaded.", (long)item);
+        if ([indexPaths count] == 0) {
+            break;
+        }
+
+        [dataSource prefetchItemsAtIndexPaths:indexPaths];
+        XCTAssertLessThanOrEqual([dataSource numberOfLoadedPages], 4);
+    }
+
+    for (NSInteger page = 0; page < 10; page++) {
+        XCTAssertEqual([self.requestedPages countForObject:@(page)], 1);
+    }
+}
+
+@end
@@ -0,0 +1,101 @@
+//
+//  FTPrefixSumsTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 26.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTPrefixSums.h"
+#import <XCTest/XCTest.h>
+
+@interface FTPrefixSumsTests : XCTestCase
+
+@end
+
+@implementation FTPrefixSumsTests
+
+- (void)testInitWithValues
+{
+    NSUInteger values[] = {3, 0, 2, 5};
+    FTPrefixSums *sums = [[FTPrefixSums alloc] initWithValues:values count:4];
+
+    XCTAssertEqual([sums count], 4);
+    XCTAssertEqual([sums totalSum], 10);
+    XCTAssertEqual([sums valueAtIndex:2], 2);
+
+    XCTAssertEqual([sums sumOfValuesBeforeIndex:0], 0);
+    XCTAssertEqual([sums sumOfValuesBeforeIndex:1], 3);
+    XCTAssertEqual([sums sumOfValuesBeforeIndex:3], 5);
+    XCTAssertEqual([sums sumOfValuesBeforeIndex:4], 10);
+}
+
+- (void)testIndexOfPosition
+{
+    NSUInteger values[] = {3, 0, 2, 5};
+    FTPrefixSums *sums = [[FTPrefixSums alloc] initWithValues:values count:4];
+
+    NSUInteger offset = 0;
+
+    XCTAssertEqual([sums indexOfPosition:0 offset:&offset], 0);
+    XCTAssertEqual(offset, 0);
+
+    XCTAssertEqual([sums indexOfPosition:2 offset:&offset], 0);
+    XCTAssertEqual(offset, 2);
+
+    // Values of 0 never cover a position
+
+    XCTAssertEqual([sums indexOfPosition:3 offset:&offset], 2);
+    XCTAssertEqual(offset, 0);
+
+    XCTAssertEqual([sums indexOfPosition:9 offset:&offset], 3);
+    XCTAssertEqual(offset, 4);
+
+    XCTAssertEqual([sums indexOfPosition:10 offset:&offset], 4);
+    XCTAssertEqual(offset, 0);
+}
+
+- (void)testChangeValues
+{
+    FTPrefixSums *sums = [[FTPrefixSums alloc] init];
+    NSMutableArray *values = [[NSMutableArray alloc] init];
+
+    for (NSUInteger i = 0; i < 1000; i++) {
+        NSUInteger index = arc4random_uniform((uint32_t)[values count] + 1);
+        NSUInteger value = arc4random_uniform(10);
+        [sums insertValue:value atIndex:index];
+        [values insertObject:@(value) atIndex:index];
+    }
+
+    for (NSUInteger i = 0; i < 500; i++) {
+        NSUInteger index = arc4random_uniform((uint32_t)[values count]);
+        if (i % 2 == 0) {
+            [sums removeValueAtIndex:index];
+            [values removeObjectAtIndex:index];
+        } else {
+            [sums addValue:1 toValueAtIndex:index];
+            values[index] = @([values[index] unsignedIntegerValue] + 1);
+        }
+    }
+
+    XCTAssertEqual([sums count], [values count]);
+
+    NSUInteger sum = 0;
+    for (NSUInteger index = 0; index < [values count]; index++) {
+        XCTAssertEqual([sums sumOfValuesBeforeIndex:index], sum);
+        XCTAssertEqual([sums valueAtIndex:index], [values[index] unsignedIntegerValue]);
+
+        NSUInteger value = [values[index] unsignedIntegerValue];
+        if (value > 0) {
+            NSUInteger offset = 0;
+            XCTAssertEqual([sums indexOfPosition:sum + value - 1 offset:&offset], index);
+            XCTAssertEqual(offset, value - 1);
+        }
+
+        sum += value;
+    }
+
+    XCTAssertEqual([sums totalSum], sum);
+}
+
+@end
@@ -0,0 +1,190 @@
+//
+//  FTPrepareHandlerRegistryTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 04.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#define HC_SHORTHAND
+#define MOCKITO_SHORTHAND
+
+#import <Fountain/Fountain.h>
+#import <OCHamcrest/OCHamcrest.h>
+#import <OCMockito/OCMockito.h>
+#import <XCTest/XCTest.h>
+
+#import "FTTestItem.h"
+
+@interface FTPrepareHandlerRegistryTests : XCTestCase
+
+@end
+
+@implementation FTPrepareHandlerRegistryTests
+
+#pragma mark Helper
+
+- (NSPredicate *)predicateWithKindOfClass:(Class)aClass
+{
+    return [NSComparisonPredicate predicateWithLeftExpression:[NSExpression expressionForEvaluatedObject]
+                                              rightExpression:[NSExpression expressionForConstantValue:aClass]
+                                               customSelector:@selector(isKindOfClass:)];
+}
+
+- (FTPrepareHandler *)addHandlerWithPredicate:(NSPredicate *)predicate reuseIdentifier:(NSString *)reuseIdentifier toRegistry:(FTPrepareHandlerRegistry *)registry
+{
+    FTPrepareHandler *handler = [[FTPrepareHandler alloc] initWithPredicate:predicate reuseIdentifier:reuseIdentifier block:nil];
+    [registry addHandler:handler];
+    return handler;
+}
+
+- (NSDictionary * (^)(void))variablesWithItem:(NSUInteger)item
+{
+    return ^NSDictionary *
+    {
+        return @{ @"SECTION" : @(0),
+                  @"ITEM" : @(item),
+                  @"ROW" : @(item) };
+    };
+}
+
+#pragma mark Tests
+
+- (void)testResolveHandlersInOrder
+{
+    FTPrepareHandlerRegistry *registry = [[FTPrepareHandlerRegistry alloc] init];
+
+    [self addHandlerWithPredicate:[NSPredicate predicateWithFormat:@"$ITEM == 0"] reuseIdentifier:@"first" toRegistry:registry];
+    [self addHandlerWithPredicate:[self predicateWithKindOfClass:[NSString class]] reuseIdentifier:@"string" toRegistry:registry];
+    [self addHandlerWithPredicate:[NSPredicate predicateWithFormat:@"value > 10"] reuseIdentifier:@"large" toRegistry:registry];
+    [self addHandlerWithPredicate:[NSPredicate predicateWithFormat:@"$ITEM == 1"] reuseIdentifier:@"second" toRegistry:registry];
+    [self addHandlerWithPredicate:[NSPredicate predicateWithValue:YES] reuseIdentifier:@"default" toRegistry:registry];
+
+    XCTAssertEqualObjects([registry handlerForItem:@"a" substitutionVariables:[self variablesWithItem:0]].reuseIdentifier, @"first");
+    XCTAssertEqualObjects([registry handlerForItem:@"a" substitutionVariables:[self variablesWithItem:1]].reuseIdentifier, @"string");
+    XCTAssertEqualObjects([registry handlerForItem:ITEM(20) substitutionVariables:[self variablesWithItem:1]].reuseIdentifier, @"large");
+    XCTAssertEqualObjects([registry handlerForItem:ITEM(5) substitutionVariables:[self variablesWithItem:1]].reuseIdentifier, @"second");
+    XCTAssertEqualObjects([registry handlerForItem:ITEM(5) substitutionVariables:[self variablesWithItem:2]].reuseIdentifier, @"default");
+    XCTAssertEqualObjects([registry handlerForItem:nil substitutionVariables:[self variablesWithItem:2]].reuseIdentifier, @"default");
+}
+
+- (void)testNoMatchingHandler
+{
+    FTPrepareHandlerRegistry *registry = [[FTPrepareHandlerRegistry alloc] init];
+    XCTAssertNil([registry handlerForItem:@"a" substitutionVariables:[self variablesWithItem:0]]);
+
+    [self addHandlerWithPredicate:[self predicateWithKindOfClass:[NSString class]] reuseIdentifier:@"string" toRegistry:registry];
+    XCTAssertNil([registry handlerForItem:ITEM(1) substitutionVariables:[self variablesWithItem:0]]);
+
+    [self addHandlerWithPredicate:[NSPredicate predicateWithFormat:@"value > 10"] reuseIdentifier:@"large" toRegistry:registry];
+    XCTAssertNil([registry handlerForItem:ITEM(1) substitutionVariables:[self variablesWithItem:0]]);
+    XCTAssertEqualObjects([registry handlerForItem:ITEM(11) substitutionVariables:[self variablesWithItem:0]].reuseIdentifier, @"large");
+}
+
+- (void)testMemoizePerItem
+{
+    FTPrepareHandlerRegistry *registry = [[FTPrepareHandlerRegistry alloc] init];
+
+    [self addHandlerWithPredicate:[NSPredicate predicateWithFormat:@"value > 10"] reuseIdentifier:@"large" toRegistry:registry];
+    [self addHandlerWithPredicate:nil reuseIdentifier:@"default" toRegistry:registry];
+
+    FTTestItem *item = ITEM(5);
+    FTTestItem *equalItem = ITEM(5);
+
+    XCTAssertEqualObjects([registry handlerForItem:item substitutionVariables:[self variablesWithItem:0]].reuseIdentifier, @"default");
+
+    // The result is memoized until the cache is invalidated
+
+    item.value = 20;
+    XCTAssertEqualObjects([registry handlerForItem:item substitutionVariables:[self variablesWithItem:0]].reuseIdentifier, @"default");
+
+    equalItem.value = 20;
+    XCTAssertEqualObjects([registry handlerForItem:equalItem substitutionVariables:[self variablesWithItem:0]].reuseIdentifier, @"large");
+
+    [registry invalidateCache];
+    XCTAssertEqualObjects([registry handlerForItem:item substitutionVariables:[self variablesWithItem:0]].reuseIdentifier, @"large");
+}
+
+- (void)testMemoizePerClass
+{
+    FTPrepareHandlerRegistry *registry = [[FTPrepareHandlerRegistry alloc] init];
+
+    [self addHandlerWithPredicate:[self predicateWithKindOfClass:[NSString class]] reuseIdentifier:@"string" toRegistry:registry];
+    [self addHandlerWithPredicate:[NSPredicate predicateWithFormat:@"SELF.class == %@", [FTTestItem class]] reuseIdentifier:@"item" toRegistry:registry];
+    [self addHandlerWithPredicate:[NSPredicate predicateWithValue:YES] reuseIdentifier:@"default" toRegistry:registry];
+
+    registry.cacheLimit = 0;
+
+    for (NSInteger value = 0; value < 10; value++) {
+        XCTAssertEqualObjects([registry handlerForItem:ITEM(value) substitutionVariables:[self variablesWithItem:0]].reuseIdentifier, @"item");
+        XCTAssertEqualObjects([registry handlerForItem:@(value) substitutionVariables:[self variablesWithItem:0]].reuseIdentifier, @"default");
+    }
+    XCTAssertEqualObjects([registry handlerForItem:@"a" substitutionVariables:[self variablesWithItem:0]].reuseIdentifier, @"string");
+}
+
+- (void)testSubstitutionVariablesOnlyRequestedIfNeeded
+{
+    FTPrepareHandlerRegistry *registry = [[FTPrepareHandlerRegistry alloc] init];
+    [self addHandlerWithPredicate:[NSPredicate predicateWithFormat:@"value > 10"] reuseIdentifier:@"large" toRegistry:registry];
+    [self addHandlerWithPredicate:[NSPredicate predicateWithFormat:@"$ITEM == 0"] reuseIdentifier:@"first" toRegistry:registry];
+
+    __block NSUInteger numberOfRequests = 0;
+    NSDictionary * (^variables)(void) = ^NSDictionary *
+    {
+        numberOfRequests++;
+        return @{ @"ITEM" : @(0) };
+    };
+
+    XCTAssertEqualObjects([registry handlerForItem:ITEM(20) substitutionVariables:variables].reuseIdentifier, @"large");
+    XCTAssertEqual(numberOfRequests, 0);
+
+    XCTAssertEqualObjects([registry handlerForItem:ITEM(5) substitutionVariables:variables].reuseIdentifier, @"first");
+    XCTAssertEqual(numberOfRequests, 1);
+}
+
+#pragma mark Benchmark
+
+- (FTPrepareHandlerRegistry *)registryWithNumberOfHandlers:(NSUInteger)numberOfHandlers
+{
+    FTPrepareHandlerRegistry *registry = [[FTPrepareHandlerRegistry alloc] init];
+    for (NSUInteger i = 0; i < numberOfHandlers - 1; i++) {
+        [self addHandlerWithPredicate:[NSPredicate predicateWithFormat:@"value == %@", @(i)] reuseIdentifier:[NSString stringWithFormat:@"%lu", (unsigned long)i] toRegistry:registry];
+    }
+    [self addHandlerWithPredicate:nil reuseIdentifier:@"default" toRegistry:registry];
+    return registry;
+}
+
+- (void)testPerformanceOfResolvingHandlers
+{
+    FTPrepareHandlerRegistry *registry = [self registryWithNumberOfHandlers:15];
+
+    NSMutableArray *items = [[NSMutableArray alloc] init];
+    for (NSInteger value = 0; value < 100; value++) {
+        [items addObject:ITEM(value)];
+    }
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 100000; i++) {
+            [registry handlerForItem:items[i % 100] substitutionVariables:[self variablesWithItem:i]];
+        }
+    }];
+}
+
+- (void)testPerformanceOfResolvingHandlersWithoutMemoization
+{
+    FTPrepareHandlerRegistry *registry = [self registryWithNumberOfHandlers:15];
+
+    NSMutableArray *items = [[NSMutableArray alloc] init];
+    for (NSInteger value = 0; value < 100; value++) {
+        [items addObject:ITEM(value)];
+    }
+
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 100000; i++) {
+            [registry invalidateCache];
+            [registry handlerForItem:items[i % 100] substitutionVariables:[self variablesWithItem:i]];
+        }
+    }];
+}
+
+@end
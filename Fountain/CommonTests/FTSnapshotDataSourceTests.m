@@ -0,0 +1,242 @@
+//
+//  FTSnapshotDataSourceTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 09.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#define HC_SHORTHAND
+#define MOCKITO_SHORTHAND
+
+#import <Fountain/Fountain.h>
+#import <OCHamcrest/OCHamcrest.h>
+#import <OCMockito/OCMockito.h>
+#import <XCTest/XCTest.h>
+
+#import "FTTestItem.h"
+#import "FTTestItemClusterComperator.h"
+
+#define IDX(item, section) [[NSIndexPath indexPathWithIndex:section] indexPathByAddingIndex:item]
+
+@interface FTSnapshotDataSourceTests : XCTestCase
+@property (nonatomic, strong) NSURL *snapshotURL;
+@end
+
+@implementation FTSnapshotDataSourceTests
+
+#pragma mark Test Life-cycle
+
+- (void)setUp
+{
+    [super setUp];
+    NSString *filename = [NSString stringWithFormat:@"%@.snapshot", [[NSUUID UUID] UUIDString]];
+    self.snapshotURL = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:filename]];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtURL:self.snapshotURL error:nil];
+    [super tearDown];
+}
+
+#pragma mark Tests
+
+- (void)testSnapshotOfMutableSet
+{
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:@[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ]];
+    [set addObjectsFromArray:@[ @"c", @"a", @"d", @"b" ]];
+
+    NSError *error = nil;
+    BOOL success = [FTSnapshotDataSource writeSnapshotOfDataSource:set toURL:self.snapshotURL error:&error];
+    assertThatBool(success, isTrue());
+    assertThat(error, nilValue());
+
+    FTSnapshotDataSource *snapshot = [[FTSnapshotDataSource alloc] initWithContentsOfURL:self.snapshotURL error:&error];
+    assertThat(snapshot, notNilValue());
+
+    assertThatUnsignedInteger([snapshot numberOfSections], equalToUnsignedInteger(1));
+    assertThatUnsignedInteger([snapshot numberOfItemsInSection:0], equalToUnsignedInteger(4));
+    assertThatUnsignedInteger(snapshot.numberOfItems, equalToUnsignedInteger(4));
+
+    assertThat([snapshot itemAtIndexPath:IDX(0, 0)], equalTo(@"a"));
+    assertThat([snapshot itemAtIndexPath:IDX(3, 0)], equalTo(@"d"));
+    assertThat([snapshot sectionItemForSection:0], nilValue());
+
+    // Items are decoded once
+
+    XCTAssertTrue([snapshot itemAtIndexPath:IDX(1, 0)] == [snapshot itemAtIndexPath:IDX(1, 0)]);
+
+    assertThat([snapshot allItems], contains(@"a", @"b", @"c", @"d", nil));
+}
+
+- (void)testSnapshotOfClusterSet
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+    FTMutableClusterSet *set = [[FTMutableClusterSet alloc] initSortDescriptors:sortDescriptors
+                                                                     comperator:[[FTTestItemClusterComperator alloc] init]];
+    [set addObjectsFromArray:@[ ITEM(1), ITEM(2), ITEM(20), ITEM(40), ITEM(41), ITEM(45) ]];
+
+    FTSnapshotItemEncoder encoder = ^(FTTestItem *item) {
+        return [[NSString stringWithFormat:@"%ld", (long)item.value] dataUsingEncoding:NSUTF8StringEncoding];
+    };
+    FTSnapshotItemDecoder decoder = ^(NSData *data) {
+        NSString *value = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+        return ITEM([value integerValue]);
+    };
+
+    NSError *error = nil;
+    BOOL success = [FTSnapshotDataSource writeSnapshotOfDataSource:set toURL:self.snapshotURL itemEncoder:encoder error:&error];
+    assertThatBool(success, isTrue());
+
+    FTSnapshotDataSource *snapshot = [[FTSnapshotDataSource alloc] initWithContentsOfURL:self.snapshotURL itemDecoder:decoder error:&error];
+    assertThat(snapshot, notNilValue());
+
+    assertThatUnsignedInteger([snapshot numberOfSections], equalToUnsignedInteger(3));
+    assertThatUnsignedInteger([snapshot numberOfItemsInSection:0], equalToUnsignedInteger(2));
+    assertThatUnsignedInteger([snapshot numberOfItemsInSection:1], equalToUnsignedInteger(1));
+    assertThatUnsignedInteger([snapshot numberOfItemsInSection:2], equalToUnsignedInteger(3));
+
+    assertThatInteger([[snapshot itemAtIndexPath:IDX(0, 1)] value], equalToInteger(20));
+    assertThatInteger([[snapshot itemAtIndexPath:IDX(2, 2)] value], equalToInteger(45));
+}
+
+- (void)testReverseLookup
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ];
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:sortDescriptors];
+    [set addObjectsFromArray:@[ @"c", @"a", @"b" ]];
+
+    NSError *error = nil;
+    BOOL success = [FTSnapshotDataSource writeSnapshotOfDataSource:set toURL:self.snapshotURL error:&error];
+    assertThatBool(success, isTrue());
+
+    FTSnapshotDataSource *snapshot = [[FTSnapshotDataSource alloc] initWithContentsOfURL:self.snapshotURL error:&error];
+
+    assertThat([snapshot indexPathsOfItem:@"b"], contains(IDX(1, 0), nil));
+    assertThat([snapshot indexPathsOfItem:@"d"], isEmpty());
+    assertThat([snapshot sectionsOfSectionItem:@"x"], equalTo([NSIndexSet indexSet]));
+}
+
+- (void)testChangeSetToDataSource
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ];
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:sortDescriptors];
+    [set addObjectsFromArray:@[ @"a", @"b", @"c" ]];
+
+    NSError *error = nil;
+    BOOL success = [FTSnapshotDataSource writeSnapshotOfDataSource:set toURL:self.snapshotURL error:&error];
+    assertThatBool(success, isTrue());
+
+    FTSnapshotDataSource *snapshot = [[FTSnapshotDataSource alloc] initWithContentsOfURL:self.snapshotURL error:&error];
+
+    // The data source has been loaded again with other objects.
+
+    FTMutableSet *loadedSet = [[FTMutableSet alloc] initWithSortDescriptors:sortDescriptors];
+    [loadedSet addObjectsFromArray:@[ @"a", @"c", @"d" ]];
+
+    FTChangeSet *changeSet = [snapshot changeSetToDataSource:loadedSet];
+    assertThat([changeSet deletedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndex:1]));
+    assertThat([changeSet insertedItemsInSection:0], equalTo([NSIndexSet indexSetWithIndex:2]));
+    assertThatBool([changeSet isValidForNumberOfItemsInSections:@[ @(3) ]], isTrue());
+
+    NSMutableArray *sections = [@[ [[snapshot allItems] mutableCopy] ] mutableCopy];
+    NSMutableArray *sectionItems = [@[ [NSNull null] ] mutableCopy];
+    success = [changeSet applyToSections:sections
+                            sectionItems:sectionItems
+                       insertedItemBlock:^id(NSIndexPath *indexPath) {
+                           return [loadedSet itemAtIndexPath:indexPath];
+                       }
+                insertedSectionItemBlock:nil];
+    assertThatBool(success, isTrue());
+    assertThat(sections[0], contains(@"a", @"c", @"d", nil));
+}
+
+- (void)testEmptySnapshot
+{
+    FTMutableSet *set = [[FTMutableSet alloc] initWithSortDescriptors:nil includeEmptySections:NO];
+
+    NSError *error = nil;
+    BOOL success = [FTSnapshotDataSource writeSnapshotOfDataSource:set toURL:self.snapshotURL error:&error];
+    assertThatBool(success, isTrue());
+
+    FTSnapshotDataSource *snapshot = [[FTSnapshotDataSource alloc] initWithContentsOfURL:self.snapshotURL error:&error];
+    assertThatUnsignedInteger([snapshot numberOfSections], equalToUnsignedInteger(0));
+    assertThat([snapshot allItems], isEmpty());
+}
+
+- (void)testItemClasses
+{
+    NSValue *value = [NSValue valueWithRange:NSMakeRange(1, 2)];
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ value ]];
+
+    NSError *error = nil;
+    BOOL success = [FTSnapshotDataSource writeSnapshotOfDataSource:array toURL:self.snapshotURL error:&error];
+    assertThatBool(success, isTrue());
+
+    // Only objects of the expected classes are decoded
+
+    FTSnapshotDataSource *snapshot = [[FTSnapshotDataSource alloc] initWithContentsOfURL:self.snapshotURL error:&error];
+    assertThat([snapshot itemAtIndexPath:IDX(0, 0)], equalTo([NSNull null]));
+
+    snapshot = [[FTSnapshotDataSource alloc] initWithContentsOfURL:self.snapshotURL itemClasses:[NSSet setWithObject:[NSValue class]] error:&error];
+    assertThat([snapshot itemAtIndexPath:IDX(0, 0)], equalTo(value));
+}
+
+- (void)testItemsWithoutSecureCoding
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @"a", ITEM(1) ]];
+
+    NSError *error = nil;
+    BOOL success = [FTSnapshotDataSource writeSnapshotOfDataSource:array toURL:self.snapshotURL error:&error];
+    assertThatBool(success, isFalse());
+    assertThat(error.domain, equalTo(NSCocoaErrorDomain));
+    assertThatInteger(error.code, equalToInteger(NSCoderInvalidValueError));
+
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[self.snapshotURL path]]);
+}
+
+- (void)testCorruptSnapshot
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @1, @2, @3 ]];
+
+    NSError *error = nil;
+    BOOL success = [FTSnapshotDataSource writeSnapshotOfDataSource:array toURL:self.snapshotURL error:&error];
+    assertThatBool(success, isTrue());
+
+    NSData *data = [NSData dataWithContentsOfURL:self.snapshotURL];
+    [[data subdataWithRange:NSMakeRange(0, 40)] writeToURL:self.snapshotURL atomically:YES];
+
+    FTSnapshotDataSource *snapshot = [[FTSnapshotDataSource alloc] initWithContentsOfURL:self.snapshotURL error:&error];
+    assertThat(snapshot, nilValue());
+    assertThat(error.domain, equalTo(NSCocoaErrorDomain));
+    assertThatInteger(error.code, equalToInteger(NSFileReadCorruptFileError));
+}
+
+- (void)testCorruptItemRecord
+{
+    FTMutableArray *array = [FTMutableArray arrayWithArray:@[ @1, @2, @3 ]];
+
+    NSError *error = nil;
+    BOOL success = [FTSnapshotDataSource writeSnapshotOfDataSource:array toURL:self.snapshotURL error:&error];
+    assertThatBool(success, isTrue());
+
+    // The record of the second item (after the header with 24 bytes, the
+    // section table with 32 bytes and the first record with 16 bytes)
+    // points beyond the end of the file.
+
+    NSMutableData *data = [NSMutableData dataWithContentsOfURL:self.snapshotURL];
+    uint64_t offset = UINT64_MAX;
+    [data replaceBytesInRange:NSMakeRange(72, sizeof(offset)) withBytes:&offset];
+    [data writeToURL:self.snapshotURL atomically:YES];
+
+    FTSnapshotDataSource *snapshot = [[FTSnapshotDataSource alloc] initWithContentsOfURL:self.snapshotURL error:&error];
+    assertThat(snapshot, notNilValue());
+
+    assertThat([snapshot itemAtIndexPath:IDX(0, 0)], equalTo(@1));
+    assertThat([snapshot itemAtIndexPath:IDX(1, 0)], equalTo([NSNull null]));
+    assertThat([snapshot itemAtIndexPath:IDX(2, 0)], equalTo(@3));
+    assertThat([snapshot indexPathsOfItem:[NSNull null]], isEmpty());
+}
+
+@end
@@ -0,0 +1,124 @@
+//
+//  FTSortKeyCacheTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 19.09.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#import "FTSortKeyCache.h"
+#import "FTTestItem.h"
+#import "NSSortDescriptor+Fountain.h"
+#import <XCTest/XCTest.h>
+
+@interface FTSortKeyCacheTests : XCTestCase
+
+@end
+
+@implementation FTSortKeyCacheTests
+
+#pragma mark Test Sorting
+
+- (void)testSortingNumbers
+{
+    NSArray *objects = @[ @(1), @(5.5), @(2), @(6), @(-8), @(3.25), @(4), @(7) ];
+
+    for (NSNumber *ascending in @[ @YES, @NO ]) {
+        NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:[ascending boolValue]] ];
+        FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:sortDescriptors];
+
+        XCTAssertEqualObjects([sortKeyCache sortedArrayFromObjects:objects], [objects sortedArrayUsingDescriptors:sortDescriptors]);
+    }
+}
+
+- (void)testSortingStrings
+{
+    NSArray *objects = @[ @"b", @"A", @"c", @"a", @"B", @"10", @"9" ];
+
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES] ];
+    FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:sortDescriptors];
+
+    XCTAssertEqualObjects([sortKeyCache sortedArrayFromObjects:objects], [objects sortedArrayUsingDescriptors:sortDescriptors]);
+
+    sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:NO selector:@selector(localizedStandardCompare:)] ];
+    sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:sortDescriptors];
+
+    XCTAssertEqualObjects([sortKeyCache sortedArrayFromObjects:objects], [objects sortedArrayUsingDescriptors:sortDescriptors]);
+}
+
+- (void)testSortingDates
+{
+    NSDate *now = [NSDate date];
+    NSArray *objects = @[ now, [now dateByAddingTimeInterval:-10], [now dateByAddingTimeInterval:20], [NSDate distantPast] ];
+
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:NO] ];
+    FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:sortDescriptors];
+
+    XCTAssertEqualObjects([sortKeyCache sortedArrayFromObjects:objects], [objects sortedArrayUsingDescriptors:sortDescriptors]);
+}
+
+- (void)testSortingWithMultipleSortDescriptors
+{
+    NSArray *objects = @[ @"bb", @"a", @"ccc", @"c", @"aa", @"b" ];
+
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"length" ascending:NO],
+                                  [NSSortDescriptor sortDescriptorWithKey:@"self"
+                                                                ascending:YES
+                                                               comparator:^NSComparisonResult(NSString *obj1, NSString *obj2) {
+                                                                   return [obj2 compare:obj1];
+                                                               }] ];
+    FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:sortDescriptors];
+
+    XCTAssertEqualObjects([sortKeyCache sortedArrayFromObjects:objects], [objects sortedArrayUsingDescriptors:sortDescriptors]);
+}
+
+- (void)testValuesAreCachedDuringBatch
+{
+    FTTestItem *item1 = ITEM(10);
+    FTTestItem *item2 = ITEM(20);
+
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+    FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:sortDescriptors];
+    NSComparator comperator = [sortKeyCache comperator];
+
+    XCTAssertEqual(comperator(item1, item2), NSOrderedAscending);
+
+    item1.value = 30;
+
+    XCTAssertEqual(comperator(item1, item2), NSOrderedAscending);
+}
+
+#pragma mark Test Performance
+
+- (void)testPerformanceOfSortDescriptorComperator
+{
+    NSArray *objects = [self ft_itemsWithCount:100000];
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    [self measureBlock:^{
+        NSComparator comperator = [NSSortDescriptor ft_comperatorUsingSortDescriptors:sortDescriptors];
+        [objects sortedArrayUsingComparator:comperator];
+    }];
+}
+
+- (void)testPerformanceOfSortKeyCacheComperator
+{
+    NSArray *objects = [self ft_itemsWithCount:100000];
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    [self measureBlock:^{
+        FTSortKeyCache *sortKeyCache = [[FTSortKeyCache alloc] initWithSortDescriptors:sortDescriptors];
+        [sortKeyCache sortedArrayFromObjects:objects];
+    }];
+}
+
+- (NSArray *)ft_itemsWithCount:(NSUInteger)count
+{
+    NSMutableArray *items = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [items addObject:ITEM(arc4random_uniform(UINT32_MAX))];
+    }
+    return items;
+}
+
+@end
@@ -0,0 +1,229 @@
+//
+//  FTUpdateAccumulatorTests.m
+//  Fountain
+//
+//  Created by Tobias Kraentzer on 05.10.16.
+//  Copyright © 2016 Tobias Kräntzer. All rights reserved.
+//
+
+#define HC_SHORTHAND
+#define MOCKITO_SHORTHAND
+
+#import <Fountain/Fountain.h>
+#import <OCHamcrest/OCHamcrest.h>
+#import <OCMockito/OCMockito.h>
+#import <XCTest/XCTest.h>
+
+#define IDX(item, section) [[NSIndexPath indexPathWithIndex:section] indexPathByAddingIndex:item]
+
+@interface FTUpdateAccumulatorTests : XCTestCase
+
+@end
+
+@implementation FTUpdateAccumulatorTests
+
+#pragma mark Tests
+
+- (void)testSingleBatch
+{
+    FTUpdateAccumulator *updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:@[ @(5), @(3) ]];
+
+    [updates beginBatch];
+    [updates insertItemsAtIndexPaths:@[ IDX(0, 0), IDX(1, 0) ]];
+    [updates deleteItemsAtIndexPaths:@[ IDX(2, 1) ]];
+    [updates changeItemsAtIndexPaths:@[ IDX(4, 0) ]];
+    [updates endBatch];
+
+    XCTAssertEqual(updates.numberOfOpenBatches, 0);
+    XCTAssertFalse(updates.requiresReload);
+    XCTAssertEqual(updates.numberOfChanges, 4);
+
+    FTChangeSet *changeSet = updates.changeSet;
+    XCTAssertEqualObjects([changeSet insertedItemsInSection:0], [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]);
+    XCTAssertEqualObjects([changeSet deletedItemsInSection:1], [NSIndexSet indexSetWithIndex:2]);
+    XCTAssertEqualObjects([changeSet changedItemsInSection:0], [NSIndexSet indexSetWithIndex:4]);
+}
+
+- (void)testCancelInsertAndDelete
+{
+    FTUpdateAccumulator *updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:@[ @(3) ]];
+
+    [updates beginBatch];
+
+    [updates beginBatch];
+    [updates insertItemsAtIndexPaths:@[ IDX(1, 0) ]];
+    [updates endBatch];
+
+    [updates beginBatch];
+    [updates deleteItemsAtIndexPaths:@[ IDX(1, 0) ]];
+    [updates endBatch];
+
+    XCTAssertEqual(updates.numberOfOpenBatches, 1);
+
+    [updates endBatch];
+
+    XCTAssertEqual(updates.numberOfOpenBatches, 0);
+    XCTAssertFalse(updates.requiresReload);
+    XCTAssertTrue([updates.changeSet isEmpty]);
+}
+
+- (void)testCollapseRepeatedChanges
+{
+    FTUpdateAccumulator *updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:@[ @(10) ]];
+
+    for (NSUInteger i = 0; i < 5; i++) {
+        [updates beginBatch];
+        [updates changeItemsAtIndexPaths:@[ IDX(3, 0), IDX(4, 0) ]];
+        [updates endBatch];
+    }
+
+    // An item inserted in the first batch is not reported as changed.
+
+    [updates beginBatch];
+    [updates insertItemsAtIndexPaths:@[ IDX(0, 0) ]];
+    [updates endBatch];
+
+    [updates beginBatch];
+    [updates changeItemsAtIndexPaths:@[ IDX(0, 0), IDX(4, 0) ]];
+    [updates endBatch];
+
+    XCTAssertEqual(updates.numberOfChanges, 3);
+
+    FTChangeSet *changeSet = updates.changeSet;
+    XCTAssertEqualObjects([changeSet insertedItemsInSection:0], [NSIndexSet indexSetWithIndex:0]);
+    XCTAssertEqualObjects([changeSet changedItemsInSection:0], [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(3, 2)]);
+}
+
+- (void)testComposeMoves
+{
+    FTUpdateAccumulator *updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:@[ @(5), @(5) ]];
+
+    [updates beginBatch];
+    [updates moveItemAtIndexPath:IDX(0, 0) toIndexPath:IDX(4, 0)];
+    [updates endBatch];
+
+    [updates beginBatch];
+    [updates moveItemAtIndexPath:IDX(4, 0) toIndexPath:IDX(2, 1)];
+    [updates endBatch];
+
+    FTChangeSet *changeSet = updates.changeSet;
+
+    __block NSUInteger numberOfMoves = 0;
+    [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        XCTAssertEqualObjects(indexPath, IDX(0, 0));
+        XCTAssertEqualObjects(newIndexPath, IDX(2, 1));
+        numberOfMoves++;
+    }];
+
+    XCTAssertEqual(numberOfMoves, 1);
+    XCTAssertEqual(updates.numberOfChanges, 1);
+}
+
+- (void)testMovedItemsToReload
+{
+    FTUpdateAccumulator *updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:@[ @(5) ]];
+
+    [updates beginBatch];
+    [updates changeItemsAtIndexPaths:@[ IDX(1, 0) ]];
+    [updates moveItemAtIndexPath:IDX(1, 0) toIndexPath:IDX(3, 0)];
+    [updates endBatch];
+
+    XCTAssertEqualObjects(updates.movedItemsToReload, @[ IDX(3, 0) ]);
+    XCTAssertEqual([[updates.changeSet changedItemsInSection:0] count], 0);
+}
+
+- (void)testMergeRanges
+{
+    FTUpdateAccumulator *updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:@[ @(0) ]];
+
+    for (NSUInteger i = 0; i < 10; i++) {
+        [updates beginBatch];
+        [updates insertItemsAtIndexPaths:@[ IDX(i, 0) ]];
+        [updates endBatch];
+    }
+
+    XCTAssertEqualObjects([updates.changeSet insertedItemsInSection:0], [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 10)]);
+}
+
+- (void)testSectionChanges
+{
+    FTUpdateAccumulator *updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:@[ @(1), @(2), @(3) ]];
+
+    [updates beginBatch];
+    [updates deleteSections:[NSIndexSet indexSetWithIndex:0]];
+    [updates endBatch];
+
+    [updates beginBatch];
+    [updates insertSections:[NSIndexSet indexSetWithIndex:2]];
+    [updates insertItemsAtIndexPaths:@[ IDX(2, 1) ]];
+    [updates endBatch];
+
+    FTChangeSet *changeSet = updates.changeSet;
+    XCTAssertEqualObjects(changeSet.deletedSections, [NSIndexSet indexSetWithIndex:0]);
+    XCTAssertEqualObjects(changeSet.insertedSections, [NSIndexSet indexSetWithIndex:2]);
+    XCTAssertEqualObjects([changeSet insertedItemsInSection:1], [NSIndexSet indexSetWithIndex:2]);
+}
+
+- (void)testReloadAboveMaximumNumberOfChanges
+{
+    FTUpdateAccumulator *updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:@[ @(100) ]];
+    updates.maximumNumberOfChanges = 10;
+
+    [updates beginBatch];
+    for (NSUInteger i = 0; i < 10; i++) {
+        [updates deleteItemsAtIndexPaths:@[ IDX(i * 2, 0) ]];
+    }
+    [updates endBatch];
+
+    XCTAssertEqual(updates.numberOfChanges, 10);
+    XCTAssertFalse(updates.requiresReload);
+
+    [updates beginBatch];
+    [updates changeItemsAtIndexPaths:@[ IDX(50, 0) ]];
+    [updates endBatch];
+
+    XCTAssertEqual(updates.numberOfChanges, 11);
+    XCTAssertTrue(updates.requiresReload);
+}
+
+- (void)testReloadInconsistentChanges
+{
+    FTUpdateAccumulator *updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:@[ @(3) ]];
+
+    [updates beginBatch];
+    [updates deleteItemsAtIndexPaths:@[ IDX(3, 0) ]];
+    [updates endBatch];
+
+    XCTAssertTrue(updates.requiresReload);
+
+    updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:@[ @(3) ]];
+
+    [updates beginBatch];
+    [updates deleteItemsAtIndexPaths:@[ IDX(0, 0) ]];
+    [updates endBatch];
+
+    [updates beginBatch];
+    [updates insertItemsAtIndexPaths:@[ IDX(5, 0) ]];
+    [updates endBatch];
+
+    XCTAssertTrue(updates.requiresReload);
+}
+
+#pragma mark Benchmark
+
+- (void)testPerformanceOfCombiningBatches
+{
+    [self measureBlock:^{
+        FTUpdateAccumulator *updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:@[ @(1000), @(1000) ]];
+        for (NSUInteger i = 0; i < 200; i++) {
+            [updates beginBatch];
+            [updates insertItemsAtIndexPaths:@[ IDX(i, 0) ]];
+            [updates changeItemsAtIndexPaths:@[ IDX(i * 3, 1) ]];
+            [updates moveItemAtIndexPath:IDX(999, 1) toIndexPath:IDX(0, 1)];
+            [updates endBatch];
+        }
+        [updates changeSet];
+    }];
+}
+
+@end
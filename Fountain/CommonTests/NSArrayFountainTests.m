@@ -6,6 +6,7 @@
 //  Copyright © 2016 Tobias Kräntzer. All rights reserved.
 //
 
+#import "FTTestItem.h"
 #import "NSArray+Fountain.h"
 #import <XCTest/XCTest.h>
 
@@ -41,4 +42,66 @@
     XCTAssertEqualObjects(sortedObjects, [objects sortedArrayUsingDescriptors:sortDescriptors]);
 }
 
+- (void)testSortingAmbiguousObjectsByOrderInArray
+{
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+
+    FTTestItem *item1 = ITEM(1);
+    FTTestItem *item2 = ITEM(2);
+    FTTestItem *item3 = ITEM(2);
+    FTTestItem *item4 = ITEM(2);
+    FTTestItem *item5 = ITEM(3);
+
+    NSArray *referenceArray = @[ item5, item4, item1, item2, item3 ];
+
+    NSArray *sortedObjects = [NSArray ft_arrayBySortingObjects:[NSSet setWithArray:referenceArray]
+                                          usingSortDescriptors:sortDescriptors
+                           orderAmbiguousObjectsByOrderInArray:referenceArray];
+
+    XCTAssertEqualObjects(sortedObjects, (@[ item1, item4, item2, item3, item5 ]));
+}
+
+- (void)testSortingByOrderInArray
+{
+    NSArray *referenceArray = @[ @(5), @(3), @(8), @(1), @(9) ];
+    NSSet *objects = [NSSet setWithObjects:@(1), @(8), @(5), @(7), nil];
+
+    NSArray *sortedObjects = [NSArray ft_arrayBySortingObjects:objects byOrderInArray:referenceArray];
+
+    // Objects, which are not in the reference array, are ordered at the end.
+    XCTAssertEqualObjects(sortedObjects, (@[ @(5), @(8), @(1), @(7) ]));
+}
+
+- (void)testPositionsOfObjects
+{
+    NSArray *referenceArray = @[ @(5), @(3), @(8), @(1), @(9) ];
+    NSSet *objects = [NSSet setWithObjects:@(1), @(8), @(7), nil];
+
+    NSMapTable *positions = [NSArray ft_positionsOfObjects:objects inArray:referenceArray];
+
+    XCTAssertEqual([positions count], 2);
+    XCTAssertEqualObjects([positions objectForKey:@(8)], @(2));
+    XCTAssertEqualObjects([positions objectForKey:@(1)], @(3));
+    XCTAssertNil([positions objectForKey:@(7)]);
+}
+
+#pragma mark Test Performance
+
+- (void)testPerformanceOfSortingAmbiguousObjectsByOrderInArray
+{
+    NSMutableArray *referenceArray = [[NSMutableArray alloc] init];
+    for (NSUInteger i = 0; i < 10000; i++) {
+        [referenceArray addObject:ITEM(i % 10)];
+    }
+
+    NSArray *sortDescriptors = @[ [NSSortDescriptor sortDescriptorWithKey:@"value" ascending:YES] ];
+    NSSet *objects = [NSSet setWithArray:referenceArray];
+
+    [self measureBlock:^{
+        [NSArray ft_arrayBySortingObjects:objects
+                     usingSortDescriptors:sortDescriptors
+      orderAmbiguousObjectsByOrderInArray:referenceArray];
+    }];
+}
+
 @end
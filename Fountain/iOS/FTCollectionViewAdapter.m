@@ -6,42 +6,27 @@
 //  Copyright © 2015 Tobias Kräntzer. All rights reserved.
 //
 
+#import "FTChangeSet.h"
 #import "FTCollectionViewAdapter.h"
 #import "FTCollectionViewAdapter+Subclassing.h"
 #import "FTDataSource.h"
 #import "FTDataSourceObserver.h"
 #import "FTFutureItemsDataSource.h"
 #import "FTPagingDataSource.h"
+#import "FTPrefetchingDataSource.h"
+#import "FTPrepareHandlerRegistry.h"
+#import "FTUpdateAccumulator.h"
 
-@interface FTCollectionViewAdapterPreperationHandler : NSObject
-#pragma mark Life-cycle
-- (instancetype)initWithPredicate:(NSPredicate *)predicate
-                  reuseIdentifier:(NSString *)reuseIdentifier
-                            block:(id)block;
-#pragma mark Properties
-@property (nonatomic, readonly) NSString *reuseIdentifier;
-@property (nonatomic, readonly) NSPredicate *predicate;
-@property (nonatomic, readonly) id block;
-@property (nonatomic, strong) id prototype;
-@end
-
-#pragma mark -
+static NSArray *FTCollectionViewAdapterIndexPaths(NSUInteger section, NSIndexSet *items);
 
-@interface FTCollectionViewAdapter () <FTDataSourceObserver, UICollectionViewDelegate, UICollectionViewDataSource> {
+@interface FTCollectionViewAdapter () <FTDataSourceObserver, UICollectionViewDelegate, UICollectionViewDataSource, UICollectionViewDataSourcePrefetching> {
     UICollectionView *_collectionView;
     id<FTDataSource> _dataSource;
 
-    NSMutableArray *_cellPrepareHandler;
+    FTPrepareHandlerRegistry *_cellPrepareHandler;
     NSMutableDictionary *_supplementaryElementPrepareHandler;
 
-    NSMutableIndexSet *_insertedSections;
-    NSMutableIndexSet *_deletedSections;
-    NSMutableIndexSet *_reloadedSections;
-    NSMutableArray *_movedSections;
-    NSMutableArray *_insertedItems;
-    NSMutableArray *_deletedItems;
-    NSMutableArray *_reloadedItems;
-    NSMutableArray *_movedItems;
+    FTUpdateAccumulator *_updates;
 
     BOOL _isLoadingMoreItemsBeforeFirstItem;
     BOOL _isLoadingMoreItemsAfterLastItem;
@@ -65,18 +50,12 @@
         _collectionView.delegate = self;
         _collectionView.dataSource = self;
 
-        _cellPrepareHandler = [[NSMutableArray alloc] init];
-        _supplementaryElementPrepareHandler = [[NSMutableDictionary alloc] init];
-
-        _insertedSections = [[NSMutableIndexSet alloc] init];
-        _deletedSections = [[NSMutableIndexSet alloc] init];
-        _movedSections = [[NSMutableArray alloc] init];
-        _reloadedSections = [[NSMutableIndexSet alloc] init];
+        if ([_collectionView respondsToSelector:@selector(setPrefetchDataSource:)]) {
+            _collectionView.prefetchDataSource = self;
+        }
 
-        _insertedItems = [[NSMutableArray alloc] init];
-        _deletedItems = [[NSMutableArray alloc] init];
-        _movedItems = [[NSMutableArray alloc] init];
-        _reloadedItems = [[NSMutableArray alloc] init];
+        _cellPrepareHandler = [[FTPrepareHandlerRegistry alloc] init];
+        _supplementaryElementPrepareHandler = [[NSMutableDictionary alloc] init];
 
         [_collectionView reloadData];
     }
@@ -87,6 +66,10 @@
 {
     _collectionView.delegate = nil;
     _collectionView.dataSource = nil;
+
+    if ([_collectionView respondsToSelector:@selector(setPrefetchDataSource:)]) {
+        _collectionView.prefetchDataSource = nil;
+    }
 }
 
 #pragma mark Data Source
@@ -102,6 +85,7 @@
         [_dataSource removeObserver:self];
         _dataSource = dataSource;
         [_dataSource addObserver:self];
+        [self ft_invalidatePrepareHandlerCache];
         [_collectionView reloadData];
     }
 }
@@ -145,10 +129,10 @@
 {
     predicate = predicate ?: [NSPredicate predicateWithValue:YES];
 
-    FTCollectionViewAdapterPreperationHandler *handler = [[FTCollectionViewAdapterPreperationHandler alloc] initWithPredicate:predicate
-                                                                                                              reuseIdentifier:reuseIdentifier
-                                                                                                                        block:prepareBlock];
-    [_cellPrepareHandler addObject:handler];
+    FTPrepareHandler *handler = [[FTPrepareHandler alloc] initWithPredicate:predicate
+                                                            reuseIdentifier:reuseIdentifier
+                                                                      block:prepareBlock];
+    [_cellPrepareHandler addHandler:handler];
 }
 
 - (void)forSupplementaryViewsOfKind:(NSString *)kind
@@ -158,37 +142,44 @@
 {
     predicate = predicate ?: [NSPredicate predicateWithValue:YES];
 
-    FTCollectionViewAdapterPreperationHandler *handler = [[FTCollectionViewAdapterPreperationHandler alloc] initWithPredicate:predicate
-                                                                                                              reuseIdentifier:reuseIdentifier
-                                                                                                                        block:prepareBlock];
+    FTPrepareHandler *handler = [[FTPrepareHandler alloc] initWithPredicate:predicate
+                                                            reuseIdentifier:reuseIdentifier
+                                                                      block:prepareBlock];
 
-    NSMutableArray *handlers = [_supplementaryElementPrepareHandler objectForKey:kind];
+    FTPrepareHandlerRegistry *handlers = [_supplementaryElementPrepareHandler objectForKey:kind];
     if (handlers == nil) {
-        handlers = [[NSMutableArray alloc] init];
+        handlers = [[FTPrepareHandlerRegistry alloc] init];
         [_supplementaryElementPrepareHandler setObject:handlers forKey:kind];
     }
 
-    [handlers addObject:handler];
+    [handlers addHandler:handler];
 }
 
 #pragma mark Preperation
 
+- (void)ft_invalidatePrepareHandlerCache
+{
+    // The items might have changed, which invalidates the handlers memoized per item.
+    [_cellPrepareHandler invalidateCache];
+    for (FTPrepareHandlerRegistry *handlers in [_supplementaryElementPrepareHandler allValues]) {
+        [handlers invalidateCache];
+    }
+}
+
 - (void)itemPreperationForItemAtIndexPath:(NSIndexPath *)indexPath
                                 withBlock:(void (^)(NSString *, FTCollectionViewAdapterCellPrepareBlock, id))block
 {
     id item = [self itemAtIndexPath:indexPath];
-    NSDictionary *substitutionVariables = @{ @"SECTION" : @(indexPath.section),
-                                             @"ITEM" : @(indexPath.item),
-                                             @"ROW" : @(indexPath.row) };
-
-    [_cellPrepareHandler enumerateObjectsUsingBlock:^(FTCollectionViewAdapterPreperationHandler *handler, NSUInteger idx, BOOL *stop) {
-        if ([handler.predicate evaluateWithObject:item substitutionVariables:substitutionVariables]) {
-            if (block) {
-                block(handler.reuseIdentifier, handler.block, item);
-            }
-            *stop = YES;
-        }
-    }];
+    NSDictionary * (^substitutionVariables)(void) = ^NSDictionary *{
+        return @{ @"SECTION" : @(indexPath.section),
+                  @"ITEM" : @(indexPath.item),
+                  @"ROW" : @(indexPath.row) };
+    };
+
+    FTPrepareHandler *handler = [_cellPrepareHandler handlerForItem:item substitutionVariables:substitutionVariables];
+    if (handler && block) {
+        block(handler.reuseIdentifier, handler.block, item);
+    }
 }
 
 - (void)preperationForSupplementaryViewOfKind:(NSString *)kind
@@ -197,31 +188,33 @@
                                                         FTCollectionViewAdapterCellPrepareBlock prepareBlock,
                                                         id item))block
 {
-    NSMutableArray *handlers = [_supplementaryElementPrepareHandler objectForKey:kind];
+    FTPrepareHandlerRegistry *handlers = [_supplementaryElementPrepareHandler objectForKey:kind];
 
     if (handlers) {
 
-        NSDictionary *substitutionVariables = @{};
         id item = [NSNull null];
+        NSDictionary * (^substitutionVariables)(void) = ^NSDictionary *{
+            if ([indexPath length] == 1) {
+                return @{ @"SECTION" : @(indexPath.section) };
+            } else if ([indexPath length] == 2) {
+                return @{ @"SECTION" : @(indexPath.section),
+                          @"ITEM" : @(indexPath.item),
+                          @"ROW" : @(indexPath.row) };
+            } else {
+                return @{};
+            }
+        };
 
         if ([indexPath length] == 1) {
             item = [self.dataSource sectionItemForSection:indexPath.section];
-            substitutionVariables = @{ @"SECTION" : @(indexPath.section) };
         } else if ([indexPath length] == 2) {
             item = [self itemAtIndexPath:indexPath];
-            substitutionVariables = @{ @"SECTION" : @(indexPath.section),
-                                       @"ITEM" : @(indexPath.item),
-                                       @"ROW" : @(indexPath.row) };
         }
 
-        [handlers enumerateObjectsUsingBlock:^(FTCollectionViewAdapterPreperationHandler *handler, NSUInteger idx, BOOL *stop) {
-            if ([handler.predicate evaluateWithObject:item substitutionVariables:substitutionVariables]) {
-                if (block) {
-                    block(handler.reuseIdentifier, handler.block, item);
-                }
-                *stop = YES;
-            }
-        }];
+        FTPrepareHandler *handler = [handlers handlerForItem:item substitutionVariables:substitutionVariables];
+        if (handler && block) {
+            block(handler.reuseIdentifier, handler.block, item);
+        }
     }
 }
 
@@ -317,7 +310,12 @@
         if ([_dataSource conformsToProtocol:@protocol(FTPagingDataSource)]) {
             id<FTPagingDataSource> pagingDataSource = (id<FTPagingDataSource>)_dataSource;
 
-            if (indexPath.section == 0 && indexPath.row == 0) {
+            NSUInteger prefetchDistance = 0;
+            if ([pagingDataSource respondsToSelector:@selector(prefetchDistance)]) {
+                prefetchDistance = [pagingDataSource prefetchDistance];
+            }
+
+            if (indexPath.section == 0 && indexPath.row <= prefetchDistance) {
 
                 if (_isLoadingMoreItemsBeforeFirstItem == NO && [pagingDataSource hasItemsBeforeFirstItem]) {
                     _isLoadingMoreItemsBeforeFirstItem = YES;
@@ -327,8 +325,10 @@
                     }];
                 }
 
-            } else if (indexPath.section == [self.dataSource numberOfSections] - 1 &&
-                       indexPath.row == [self.dataSource numberOfItemsInSection:indexPath.section] - 1) {
+            }
+
+            if (indexPath.section == [self.dataSource numberOfSections] - 1 &&
+                indexPath.row + prefetchDistance >= [self.dataSource numberOfItemsInSection:indexPath.section] - 1) {
 
                 if (_isLoadingMoreItemsAfterLastItem == NO && [pagingDataSource hasItemsAfterLastItem]) {
                     _isLoadingMoreItemsAfterLastItem = YES;
@@ -342,6 +342,22 @@
     }
 }
 
+#pragma mark UICollectionViewDataSourcePrefetching
+
+- (void)collectionView:(UICollectionView *)collectionView prefetchItemsAtIndexPaths:(NSArray<NSIndexPath *> *)indexPaths
+{
+    if (collectionView == _collectionView && [_dataSource conformsToProtocol:@protocol(FTPrefetchingDataSource)]) {
+        [(id<FTPrefetchingDataSource>)_dataSource prefetchItemsAtIndexPaths:indexPaths];
+    }
+}
+
+- (void)collectionView:(UICollectionView *)collectionView cancelPrefetchingForItemsAtIndexPaths:(NSArray<NSIndexPath *> *)indexPaths
+{
+    if (collectionView == _collectionView && [_dataSource conformsToProtocol:@protocol(FTPrefetchingDataSource)]) {
+        [(id<FTPrefetchingDataSource>)_dataSource cancelPrefetchingForItemsAtIndexPaths:indexPaths];
+    }
+}
+
 #pragma mark Delegate Forwarding
 
 - (void)setDelegate:(id<UICollectionViewDelegate>)delegate
@@ -382,72 +398,36 @@
 
 - (void)dataSourceDidReset:(id<FTDataSource>)dataSource
 {
+    if (dataSource == _dataSource) {
+        [self ft_invalidatePrepareHandlerCache];
+    }
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
+        _updates = nil;
         [_collectionView reloadData];
     }
 }
 
 - (void)dataSourceWillChange:(id<FTDataSource>)dataSource
 {
+    if (dataSource == _dataSource) {
+        [self ft_invalidatePrepareHandlerCache];
+    }
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_insertedSections removeAllIndexes];
-        [_deletedSections removeAllIndexes];
-        [_reloadedSections removeAllIndexes];
-        [_movedSections removeAllObjects];
-        [_insertedItems removeAllObjects];
-        [_deletedItems removeAllObjects];
-        [_movedItems removeAllObjects];
-        [_reloadedItems removeAllObjects];
+        [[self ft_updates] beginBatch];
     }
 }
 
 - (void)dataSourceDidChange:(id<FTDataSource>)dataSource
 {
+    if (dataSource == _dataSource) {
+        [self ft_invalidatePrepareHandlerCache];
+    }
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-
-        NSMutableArray *movedItemsToReload = [[NSMutableArray alloc] init];
-
-        [_collectionView performBatchUpdates:^{
-            [_collectionView deleteSections:_deletedSections];
-            [_collectionView insertSections:_insertedSections];
-            [_collectionView reloadSections:_reloadedSections];
-
-            [_movedSections enumerateObjectsUsingBlock:^(NSArray *indexes, NSUInteger idx, BOOL *stop) {
-                [_collectionView moveSection:[[indexes firstObject] integerValue]
-                                   toSection:[[indexes lastObject] integerValue]];
-            }];
-
-            [_collectionView insertItemsAtIndexPaths:_insertedItems];
-            [_collectionView deleteItemsAtIndexPaths:_deletedItems];
-            [_collectionView reloadItemsAtIndexPaths:_reloadedItems];
-
-            [_movedItems enumerateObjectsUsingBlock:^(NSArray *indexPaths, NSUInteger idx, BOOL *stop) {
-                [_collectionView moveItemAtIndexPath:[indexPaths firstObject]
-                                         toIndexPath:[indexPaths lastObject]];
-                [movedItemsToReload addObject:[indexPaths lastObject]];
-            }];
-
-        }
-                                  completion:^(BOOL finished){
-
-                                  }];
-
-        [_insertedSections removeAllIndexes];
-        [_deletedSections removeAllIndexes];
-        [_reloadedSections removeAllIndexes];
-        [_movedSections removeAllObjects];
-        [_insertedItems removeAllObjects];
-        [_deletedItems removeAllObjects];
-        [_movedItems removeAllObjects];
-        [_reloadedItems removeAllObjects];
-
-        if (self.shouldSkipReloadOfUpdatedItems == NO && self.reloadMovedItems == YES) {
-            [_collectionView performBatchUpdates:^{
-                [_collectionView reloadItemsAtIndexPaths:movedItemsToReload];
-            }
-                                      completion:^(BOOL finished){
-
-                                      }];
+        FTUpdateAccumulator *updates = [self ft_updates];
+        [updates endBatch];
+        if (updates.numberOfOpenBatches == 0) {
+            _updates = nil;
+            [self ft_performUpdates:updates];
         }
     }
 }
@@ -455,56 +435,58 @@
 - (void)dataSource:(id<FTDataSource>)dataSource didInsertSections:(NSIndexSet *)sections
 {
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_insertedSections addIndexes:sections];
+        [[self ft_updates] insertSections:sections];
     }
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didDeleteSections:(NSIndexSet *)sections
 {
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_deletedSections addIndexes:sections];
+        [[self ft_updates] deleteSections:sections];
     }
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didChangeSections:(NSIndexSet *)sections
 {
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_reloadedSections addIndexes:sections];
+        [[self ft_updates] changeSections:sections];
     }
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didMoveSection:(NSInteger)section toSection:(NSInteger)newSection
 {
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_movedSections addObject:@[ @(section), @(newSection) ]];
+        [[self ft_updates] moveSection:section toSection:newSection];
     }
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didInsertItemsAtIndexPaths:(NSArray *)indexPaths
 {
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_insertedItems addObjectsFromArray:indexPaths];
+        [[self ft_updates] insertItemsAtIndexPaths:indexPaths];
     }
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didDeleteItemsAtIndexPaths:(NSArray *)indexPaths
 {
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_deletedItems addObjectsFromArray:indexPaths];
+        [[self ft_updates] deleteItemsAtIndexPaths:indexPaths];
     }
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didChangeItemsAtIndexPaths:(NSArray *)indexPaths
 {
-    if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource && !_shouldSkipReloadOfUpdatedItems) {
-        [_reloadedItems addObjectsFromArray:indexPaths];
+    // Changes are also recorded, if updated items are not reloaded,
+    // to detect moved items, which have to be reconfigured.
+    if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
+        [[self ft_updates] changeItemsAtIndexPaths:indexPaths];
     }
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didMoveItemAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath
 {
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_movedItems addObject:@[ indexPath, newIndexPath ]];
+        [[self ft_updates] moveItemAtIndexPath:indexPath toIndexPath:newIndexPath];
     }
 }
 
@@ -520,7 +502,7 @@
                 [tableViewIndexPaths addObject:tableViewIndexPath];
             }
         }
-        [_insertedItems addObjectsFromArray:tableViewIndexPaths];
+        [[self ft_updates] insertItemsAtIndexPaths:tableViewIndexPaths];
     }
 }
 
@@ -534,13 +516,13 @@
                 [tableViewIndexPaths addObject:tableViewIndexPath];
             }
         }
-        [_deletedItems addObjectsFromArray:tableViewIndexPaths];
+        [[self ft_updates] deleteItemsAtIndexPaths:tableViewIndexPaths];
     }
 }
 
 - (void)dataSource:(id<FTFutureItemsDataSource>)dataSource didChangeFutureItemsAtIndexPaths:(NSArray *)indexPaths
 {
-    if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource && !_shouldSkipReloadOfUpdatedItems && self.editing == YES) {
+    if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource && self.editing == YES) {
         NSMutableArray *tableViewIndexPaths = [[NSMutableArray alloc] init];
         for (NSIndexPath *indexPath in indexPaths) {
             NSIndexPath *tableViewIndexPath = [self tableViewIndexPathForFutureItemIndexPath:indexPath];
@@ -548,7 +530,7 @@
                 [tableViewIndexPaths addObject:tableViewIndexPath];
             }
         }
-        [_reloadedItems addObjectsFromArray:tableViewIndexPaths];
+        [[self ft_updates] changeItemsAtIndexPaths:tableViewIndexPaths];
     }
 }
 
@@ -558,11 +540,113 @@
         NSIndexPath *tableViewIndexPath = [self tableViewIndexPathForFutureItemIndexPath:indexPath];
         NSIndexPath *newTableViewIndexPath = [self tableViewIndexPathForFutureItemIndexPath:newIndexPath];
         if (tableViewIndexPath && newTableViewIndexPath) {
-            [_movedItems addObject:@[ tableViewIndexPath, newTableViewIndexPath ]];
+            [[self ft_updates] moveItemAtIndexPath:tableViewIndexPath toIndexPath:newTableViewIndexPath];
         }
     }
 }
 
+#pragma mark Updates
+
+- (FTUpdateAccumulator *)ft_updates
+{
+    if (_updates == nil) {
+        // The changes are relative to the state, the collection view is currently displaying.
+        NSInteger numberOfSections = [_collectionView numberOfSections];
+        NSMutableArray *numberOfItemsInSections = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+        for (NSInteger section = 0; section < numberOfSections; section++) {
+            [numberOfItemsInSections addObject:@([_collectionView numberOfItemsInSection:section])];
+        }
+        _updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:numberOfItemsInSections];
+    }
+    return _updates;
+}
+
+- (void)ft_performUpdates:(FTUpdateAccumulator *)updates
+{
+    if (updates.requiresReload) {
+        [_collectionView reloadData];
+        return;
+    }
+
+    FTChangeSet *changeSet = updates.changeSet;
+    if ([changeSet isEmpty]) {
+        return;
+    }
+
+    NSMutableArray *movedItems = [[NSMutableArray alloc] init];
+
+    [_collectionView performBatchUpdates:^{
+        [_collectionView deleteSections:changeSet.deletedSections];
+        [_collectionView insertSections:changeSet.insertedSections];
+        [_collectionView reloadSections:changeSet.changedSections];
+
+        [changeSet enumerateSectionMovesUsingBlock:^(NSUInteger section, NSUInteger newSection, BOOL *stop) {
+            [_collectionView moveSection:section toSection:newSection];
+        }];
+
+        [changeSet enumerateInsertedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+            [_collectionView insertItemsAtIndexPaths:FTCollectionViewAdapterIndexPaths(section, items)];
+        }];
+
+        [changeSet enumerateDeletedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+            [_collectionView deleteItemsAtIndexPaths:FTCollectionViewAdapterIndexPaths(section, items)];
+        }];
+
+        if (self.shouldSkipReloadOfUpdatedItems == NO) {
+            [changeSet enumerateChangedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+                [_collectionView reloadItemsAtIndexPaths:FTCollectionViewAdapterIndexPaths(section, items)];
+            }];
+        }
+
+        [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+            [_collectionView moveItemAtIndexPath:indexPath toIndexPath:newIndexPath];
+            [movedItems addObject:newIndexPath];
+        }];
+    }
+                              completion:^(BOOL finished){
+
+                              }];
+
+    if (self.shouldSkipReloadOfUpdatedItems == NO) {
+        [self ft_reconfigureItemsAtIndexPaths:self.reloadMovedItems ? movedItems : updates.movedItemsToReload];
+    }
+}
+
+- (void)ft_reconfigureItemsAtIndexPaths:(NSArray *)indexPaths
+{
+    // Moved items can not be reloaded in the same batch. Instead of a second
+    // batch, the visible cells are prepared again, if the reuse identifier
+    // did not change. Cells, which are not visible, are prepared on display.
+
+    NSMutableArray *indexPathsToReload = [[NSMutableArray alloc] init];
+
+    for (NSIndexPath *indexPath in indexPaths) {
+        UICollectionViewCell *cell = [_collectionView cellForItemAtIndexPath:indexPath];
+        if (cell == nil) {
+            continue;
+        }
+
+        __block BOOL prepared = NO;
+        [self itemPreperationForItemAtIndexPath:indexPath
+                                      withBlock:^(NSString *reuseIdentifier, FTCollectionViewAdapterCellPrepareBlock prepareBlock, id item) {
+                                          if ([reuseIdentifier isEqualToString:cell.reuseIdentifier]) {
+                                              if (prepareBlock) {
+                                                  prepareBlock(cell, item, indexPath, _dataSource);
+                                              }
+                                              prepared = YES;
+                                          }
+                                      }];
+
+        if (prepared == NO) {
+            [indexPathsToReload addObject:indexPath];
+        }
+    }
+
+    if ([indexPathsToReload count] > 0) {
+        [_collectionView reloadItemsAtIndexPaths:indexPathsToReload];
+    }
+}
+
 #pragma mark -
 
 - (NSIndexPath *)tableViewIndexPathForFutureItemIndexPath:(NSIndexPath *)futureItemIndexPath
@@ -590,23 +674,13 @@
 
 @end
 
-#pragma mark -
-
-@implementation FTCollectionViewAdapterPreperationHandler
-
-#pragma mark Life-cycle
+#pragma mark - Index Paths
 
-- (instancetype)initWithPredicate:(NSPredicate *)predicate
-                  reuseIdentifier:(NSString *)reuseIdentifier
-                            block:(id)block
+static NSArray *FTCollectionViewAdapterIndexPaths(NSUInteger section, NSIndexSet *items)
 {
-    self = [super init];
-    if (self) {
-        _predicate = predicate;
-        _reuseIdentifier = reuseIdentifier;
-        _block = block;
-    }
-    return self;
+    NSMutableArray *indexPaths = [[NSMutableArray alloc] initWithCapacity:[items count]];
+    [items enumerateIndexesUsingBlock:^(NSUInteger item, BOOL *stop) {
+        [indexPaths addObject:[NSIndexPath indexPathForItem:item inSection:section]];
+    }];
+    return indexPaths;
 }
-
-@end
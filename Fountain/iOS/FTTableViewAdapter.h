@@ -8,6 +8,7 @@
 
 #import <UIKit/UIKit.h>
 
+@class FTItemMetricsCache;
 @protocol FTDataSource;
 
 typedef void (^FTTableViewAdapterCellPrepareBlock)(id cell, id item, NSIndexPath *indexPath, id<FTDataSource> dataSource);
@@ -62,4 +63,10 @@ typedef NSDictionary * (^FTTableViewAdapterCellPropertiesBlock)(id cell, NSIndex
 #pragma mark Cell Properties
 @property (nonatomic, strong) FTTableViewAdapterCellPropertiesBlock cellPropertiesBlock;
 
+#pragma mark Row Heights
+
+// If set, the heights and estimated heights of the rows are taken from the cache, unless the
+// delegate implements the corresponding methods. The adapter sets the data source of the cache.
+@property (nonatomic, strong) FTItemMetricsCache *rowHeightCache;
+
 @end
@@ -8,45 +8,36 @@
 
 @import QuartzCore;
 
-#import "FTTableViewAdapter.h"
+#import "FTChangeSet.h"
 #import "FTDataSource.h"
 #import "FTDataSourceObserver.h"
 #import "FTFutureItemsDataSource.h"
+#import "FTItemMetricsCache.h"
 #import "FTMovableItemsDataSource.h"
 #import "FTMutableDataSource.h"
 #import "FTPagingDataSource.h"
+#import "FTPrefetchingDataSource.h"
+#import "FTPrepareHandlerRegistry.h"
+#import "FTTableViewAdapter.h"
 #import "FTTableViewAdapter+Subclassing.h"
+#import "FTUpdateAccumulator.h"
 
-@interface FTTableViewAdapterPreperationHandler : NSObject
-
-#pragma mark Life-cycle
-- (instancetype)initWithPredicate:(NSPredicate *)predicate
-                  reuseIdentifier:(NSString *)reuseIdentifier
-                            block:(id)block;
-
-#pragma mark Properties
-@property (nonatomic, readonly) NSString *reuseIdentifier;
-@property (nonatomic, readonly) NSPredicate *predicate;
-@property (nonatomic, readonly) id block;
-@property (nonatomic, strong) id prototype;
-@end
+static NSArray *FTTableViewAdapterIndexPaths(NSUInteger section, NSIndexSet *items);
 
-#pragma mark -
-
-@interface FTTableViewAdapter () <FTDataSourceObserver, FTFutureItemsDataSourceObserver, UITableViewDelegate, UITableViewDataSource> {
+@interface FTTableViewAdapter () <FTDataSourceObserver, FTFutureItemsDataSourceObserver, UITableViewDelegate, UITableViewDataSource, UITableViewDataSourcePrefetching> {
     UITableView *_tableView;
     id<FTDataSource> _dataSource;
 
-    NSMutableArray *_cellPrepareHandler;
-    NSMutableArray *_headerPrepareHandler;
-    NSMutableArray *_footerPrepareHandler;
+    FTPrepareHandlerRegistry *_cellPrepareHandler;
+    FTPrepareHandlerRegistry *_headerPrepareHandler;
+    FTPrepareHandlerRegistry *_footerPrepareHandler;
 
     BOOL _isLoadingMoreItemsBeforeFirstItem;
     BOOL _isLoadingMoreItemsAfterLastItem;
 
     NSInteger _isInUserDrivenChangeCallCount;
 
-    NSMutableArray *_indexPathsOfMovedItemsToReload;
+    FTUpdateAccumulator *_updates;
 }
 
 @end
@@ -63,13 +54,15 @@
         _tableView.dataSource = self;
         _tableView.delegate = self;
 
-        _cellPrepareHandler = [[NSMutableArray alloc] init];
-        _headerPrepareHandler = [[NSMutableArray alloc] init];
-        _footerPrepareHandler = [[NSMutableArray alloc] init];
+        if ([_tableView respondsToSelector:@selector(setPrefetchDataSource:)]) {
+            _tableView.prefetchDataSource = self;
+        }
 
-        _rowAnimation = UITableViewRowAnimationAutomatic;
+        _cellPrepareHandler = [[FTPrepareHandlerRegistry alloc] init];
+        _headerPrepareHandler = [[FTPrepareHandlerRegistry alloc] init];
+        _footerPrepareHandler = [[FTPrepareHandlerRegistry alloc] init];
 
-        _indexPathsOfMovedItemsToReload = [[NSMutableArray alloc] init];
+        _rowAnimation = UITableViewRowAnimationAutomatic;
 
         _collapsedSections = [NSIndexSet indexSet];
     }
@@ -80,6 +73,10 @@
 {
     self.tableView.dataSource = nil;
     self.tableView.delegate = nil;
+
+    if ([self.tableView respondsToSelector:@selector(setPrefetchDataSource:)]) {
+        self.tableView.prefetchDataSource = nil;
+    }
 }
 
 #pragma mark Data Source
@@ -94,7 +91,11 @@
     if (_dataSource != dataSource) {
         [_dataSource removeObserver:self];
         _dataSource = dataSource;
+        // The cache has to observe the data source before the adapter,
+        // to provide the heights, if the table view is updated.
+        _rowHeightCache.dataSource = dataSource;
         [_dataSource addObserver:self];
+        [self ft_invalidatePrepareHandlerCache];
         if (self.collapseSectionsByDefault) {
             _collapsedSections = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [dataSource numberOfSections])];
         }
@@ -236,6 +237,23 @@
     }
 }
 
+#pragma mark Row Heights
+
+- (void)setRowHeightCache:(FTItemMetricsCache *)rowHeightCache
+{
+    if (_rowHeightCache != rowHeightCache) {
+        [_dataSource removeObserver:self];
+        _rowHeightCache.dataSource = nil;
+        _rowHeightCache = rowHeightCache;
+        _rowHeightCache.dataSource = _dataSource;
+        [_dataSource addObserver:self];
+
+        _tableView.delegate = nil;
+        _tableView.delegate = self;
+        [_tableView reloadData];
+    }
+}
+
 #pragma mark Prepare Handler
 
 - (void)forRowsMatchingPredicate:(NSPredicate *)predicate
@@ -244,10 +262,10 @@
 {
     predicate = predicate ?: [NSPredicate predicateWithValue:YES];
 
-    FTTableViewAdapterPreperationHandler *handler = [[FTTableViewAdapterPreperationHandler alloc] initWithPredicate:predicate
-                                                                                                    reuseIdentifier:reuseIdentifier
-                                                                                                              block:prepareBlock];
-    [_cellPrepareHandler addObject:handler];
+    FTPrepareHandler *handler = [[FTPrepareHandler alloc] initWithPredicate:predicate
+                                                            reuseIdentifier:reuseIdentifier
+                                                                      block:prepareBlock];
+    [_cellPrepareHandler addHandler:handler];
 }
 
 - (void)forHeaderMatchingPredicate:(NSPredicate *)predicate
@@ -256,10 +274,10 @@
 {
     predicate = predicate ?: [NSPredicate predicateWithValue:YES];
 
-    FTTableViewAdapterPreperationHandler *handler = [[FTTableViewAdapterPreperationHandler alloc] initWithPredicate:predicate
-                                                                                                    reuseIdentifier:reuseIdentifier
-                                                                                                              block:prepareBlock];
-    [_headerPrepareHandler addObject:handler];
+    FTPrepareHandler *handler = [[FTPrepareHandler alloc] initWithPredicate:predicate
+                                                            reuseIdentifier:reuseIdentifier
+                                                                      block:prepareBlock];
+    [_headerPrepareHandler addHandler:handler];
 }
 
 - (void)forFooterMatchingPredicate:(NSPredicate *)predicate
@@ -268,14 +286,22 @@
 {
     predicate = predicate ?: [NSPredicate predicateWithValue:YES];
 
-    FTTableViewAdapterPreperationHandler *handler = [[FTTableViewAdapterPreperationHandler alloc] initWithPredicate:predicate
-                                                                                                    reuseIdentifier:reuseIdentifier
-                                                                                                              block:prepareBlock];
-    [_footerPrepareHandler addObject:handler];
+    FTPrepareHandler *handler = [[FTPrepareHandler alloc] initWithPredicate:predicate
+                                                            reuseIdentifier:reuseIdentifier
+                                                                      block:prepareBlock];
+    [_footerPrepareHandler addHandler:handler];
 }
 
 #pragma mark Preperation
 
+- (void)ft_invalidatePrepareHandlerCache
+{
+    // The items might have changed, which invalidates the handlers memoized per item.
+    [_cellPrepareHandler invalidateCache];
+    [_headerPrepareHandler invalidateCache];
+    [_footerPrepareHandler invalidateCache];
+}
+
 - (void)rowPreperationForItemAtIndexPath:(NSIndexPath *)indexPath
                                withBlock:(void (^)(NSString *reuseIdentifier,
                                                    FTTableViewAdapterCellPrepareBlock prepareBlock,
@@ -293,18 +319,16 @@
         item = [futureItemDataSource futureItemAtIndexPath:futureItemIndexPath];
     }
 
-    NSDictionary *substitutionVariables = @{ @"SECTION" : @(indexPath.section),
-                                             @"ITEM" : @(indexPath.item),
-                                             @"ROW" : @(indexPath.row) };
+    NSDictionary * (^substitutionVariables)(void) = ^NSDictionary *{
+        return @{ @"SECTION" : @(indexPath.section),
+                  @"ITEM" : @(indexPath.item),
+                  @"ROW" : @(indexPath.row) };
+    };
 
-    [_cellPrepareHandler enumerateObjectsUsingBlock:^(FTTableViewAdapterPreperationHandler *handler, NSUInteger idx, BOOL *stop) {
-        if ([handler.predicate evaluateWithObject:item substitutionVariables:substitutionVariables]) {
-            if (block) {
-                block(handler.reuseIdentifier, handler.block, item);
-            }
-            *stop = YES;
-        }
-    }];
+    FTPrepareHandler *handler = [_cellPrepareHandler handlerForItem:item substitutionVariables:substitutionVariables];
+    if (handler && block) {
+        block(handler.reuseIdentifier, handler.block, item);
+    }
 }
 
 - (void)headerPreperationForSection:(NSUInteger)section
@@ -312,17 +336,15 @@
 {
     id item = [self.dataSource sectionItemForSection:section];
 
-    NSDictionary *substitutionVariables = @{ @"SECTION" : @(section),
-                                             @"ITEMS_COUNT" : @([self.dataSource numberOfItemsInSection:section]) };
+    NSDictionary * (^substitutionVariables)(void) = ^NSDictionary *{
+        return @{ @"SECTION" : @(section),
+                  @"ITEMS_COUNT" : @([self.dataSource numberOfItemsInSection:section]) };
+    };
 
-    [_headerPrepareHandler enumerateObjectsUsingBlock:^(FTTableViewAdapterPreperationHandler *handler, NSUInteger idx, BOOL *stop) {
-        if ([handler.predicate evaluateWithObject:item ? item : [NSNull null] substitutionVariables:substitutionVariables]) {
-            if (block) {
-                block(handler.reuseIdentifier, handler.block, item);
-            }
-            *stop = YES;
-        }
-    }];
+    FTPrepareHandler *handler = [_headerPrepareHandler handlerForItem:item ? item : [NSNull null] substitutionVariables:substitutionVariables];
+    if (handler && block) {
+        block(handler.reuseIdentifier, handler.block, item);
+    }
 }
 
 - (void)footerPreperationForSection:(NSUInteger)section
@@ -332,17 +354,15 @@
 {
     id item = [self.dataSource sectionItemForSection:section];
 
-    NSDictionary *substitutionVariables = @{ @"SECTION" : @(section),
-                                             @"ITEMS_COUNT" : @([self.dataSource numberOfItemsInSection:section]) };
+    NSDictionary * (^substitutionVariables)(void) = ^NSDictionary *{
+        return @{ @"SECTION" : @(section),
+                  @"ITEMS_COUNT" : @([self.dataSource numberOfItemsInSection:section]) };
+    };
 
-    [_footerPrepareHandler enumerateObjectsUsingBlock:^(FTTableViewAdapterPreperationHandler *handler, NSUInteger idx, BOOL *stop) {
-        if ([handler.predicate evaluateWithObject:item ? item : [NSNull null] substitutionVariables:substitutionVariables]) {
-            if (block) {
-                block(handler.reuseIdentifier, handler.block, item);
-            }
-            *stop = YES;
-        }
-    }];
+    FTPrepareHandler *handler = [_footerPrepareHandler handlerForItem:item ? item : [NSNull null] substitutionVariables:substitutionVariables];
+    if (handler && block) {
+        block(handler.reuseIdentifier, handler.block, item);
+    }
 }
 
 #pragma mark UITableViewDataSource
@@ -520,6 +540,22 @@
     }
 }
 
+#pragma mark UITableViewDataSourcePrefetching
+
+- (void)tableView:(UITableView *)tableView prefetchRowsAtIndexPaths:(NSArray<NSIndexPath *> *)indexPaths
+{
+    if (tableView == _tableView && [_dataSource conformsToProtocol:@protocol(FTPrefetchingDataSource)]) {
+        [(id<FTPrefetchingDataSource>)_dataSource prefetchItemsAtIndexPaths:indexPaths];
+    }
+}
+
+- (void)tableView:(UITableView *)tableView cancelPrefetchingForRowsAtIndexPaths:(NSArray<NSIndexPath *> *)indexPaths
+{
+    if (tableView == _tableView && [_dataSource conformsToProtocol:@protocol(FTPrefetchingDataSource)]) {
+        [(id<FTPrefetchingDataSource>)_dataSource cancelPrefetchingForItemsAtIndexPaths:indexPaths];
+    }
+}
+
 #pragma mark UITableViewDelegate
 
 - (UIView *)tableView:(UITableView *)tableView viewForHeaderInSection:(NSInteger)section
@@ -573,7 +609,12 @@
         if ([_dataSource conformsToProtocol:@protocol(FTPagingDataSource)]) {
             id<FTPagingDataSource> pagingDataSource = (id<FTPagingDataSource>)_dataSource;
 
-            if (indexPath.section == 0 && indexPath.row == 0) {
+            NSUInteger prefetchDistance = 0;
+            if ([pagingDataSource respondsToSelector:@selector(prefetchDistance)]) {
+                prefetchDistance = [pagingDataSource prefetchDistance];
+            }
+
+            if (indexPath.section == 0 && indexPath.row <= prefetchDistance) {
 
                 if (_isLoadingMoreItemsBeforeFirstItem == NO && [pagingDataSource hasItemsBeforeFirstItem]) {
                     _isLoadingMoreItemsBeforeFirstItem = YES;
@@ -583,8 +624,10 @@
                     }];
                 }
 
-            } else if (indexPath.section == [self.dataSource numberOfSections] - 1 &&
-                       indexPath.row == [self.dataSource numberOfItemsInSection:indexPath.section] - 1) {
+            }
+
+            if (indexPath.section == [self.dataSource numberOfSections] - 1 &&
+                indexPath.row + prefetchDistance >= [self.dataSource numberOfItemsInSection:indexPath.section] - 1) {
 
                 if (_isLoadingMoreItemsAfterLastItem == NO && [pagingDataSource hasItemsAfterLastItem]) {
                     _isLoadingMoreItemsAfterLastItem = YES;
@@ -598,6 +641,28 @@
     }
 }
 
+- (CGFloat)tableView:(UITableView *)tableView heightForRowAtIndexPath:(NSIndexPath *)indexPath
+{
+    if ([self.delegate respondsToSelector:@selector(tableView:heightForRowAtIndexPath:)]) {
+        return [self.delegate tableView:tableView heightForRowAtIndexPath:indexPath];
+    } else if (indexPath.row < [self.dataSource numberOfItemsInSection:indexPath.section]) {
+        return [self.rowHeightCache metricForItemAtIndexPath:indexPath];
+    } else {
+        return tableView.rowHeight; // A "future item" is not contained in the cache
+    }
+}
+
+- (CGFloat)tableView:(UITableView *)tableView estimatedHeightForRowAtIndexPath:(NSIndexPath *)indexPath
+{
+    if ([self.delegate respondsToSelector:@selector(tableView:estimatedHeightForRowAtIndexPath:)]) {
+        return [self.delegate tableView:tableView estimatedHeightForRowAtIndexPath:indexPath];
+    } else if (indexPath.row < [self.dataSource numberOfItemsInSection:indexPath.section]) {
+        return [self.rowHeightCache estimatedMetricForItemAtIndexPath:indexPath];
+    } else {
+        return tableView.rowHeight;
+    }
+}
+
 #pragma mark Delegate Forwarding
 
 - (void)setDelegate:(id<UITableViewDelegate>)delegate
@@ -615,7 +680,10 @@
 
 - (BOOL)respondsToSelector:(SEL)aSelector
 {
-    if (aSelector == @selector(tableView:editingStyleForRowAtIndexPath:)
+    if (aSelector == @selector(tableView:heightForRowAtIndexPath:) ||
+        aSelector == @selector(tableView:estimatedHeightForRowAtIndexPath:)) {
+        return self.rowHeightCache != nil || [self.delegate respondsToSelector:aSelector];
+    } else if (aSelector == @selector(tableView:editingStyleForRowAtIndexPath:)
         && [self.dataSource conformsToProtocol:@protocol(FTMutableDataSource)]) {
         id<FTMutableDataSource> mutableDataSource = (id<FTMutableDataSource>)self.dataSource;
         if ([mutableDataSource respondsToSelector:@selector(editActionsForRowAtIndexPath:)]) {
@@ -651,31 +719,40 @@
 
 - (void)dataSourceDidReset:(id<FTDataSource>)dataSource
 {
+    if (dataSource == _dataSource) {
+        [self ft_invalidatePrepareHandlerCache];
+    }
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
         if (self.collapseSectionsByDefault) {
             _collapsedSections = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [dataSource numberOfSections])];
         }
+        _updates = nil;
         [_tableView reloadData];
     }
 }
 
 - (void)dataSourceWillChange:(id<FTDataSource>)dataSource
 {
+    if (dataSource == _dataSource) {
+        [self ft_invalidatePrepareHandlerCache];
+    }
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_tableView beginUpdates];
+        [[self ft_updates] beginBatch];
     }
 }
 
 - (void)dataSourceDidChange:(id<FTDataSource>)dataSource
 {
+    if (dataSource == _dataSource) {
+        [self ft_invalidatePrepareHandlerCache];
+    }
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_tableView endUpdates];
-        if (self.shouldSkipReloadOfUpdatedItems == NO && self.reloadMovedItems == YES) {
-            [_tableView beginUpdates];
-            [_tableView reloadRowsAtIndexPaths:_indexPathsOfMovedItemsToReload withRowAnimation:UITableViewRowAnimationAutomatic];
-            [_tableView endUpdates];
+        FTUpdateAccumulator *updates = [self ft_updates];
+        [updates endBatch];
+        if (updates.numberOfOpenBatches == 0) {
+            _updates = nil;
+            [self ft_performUpdates:updates];
         }
-        [_indexPathsOfMovedItemsToReload removeAllObjects];
     }
 }
 
@@ -695,7 +772,7 @@
             }];
         }];
         _collapsedSections = collapsedSections;
-        [_tableView insertSections:sections withRowAnimation:self.rowAnimation];
+        [[self ft_updates] insertSections:sections];
     }
 }
 
@@ -716,14 +793,14 @@
         }];
         _collapsedSections = collapsedSections;
 
-        [_tableView deleteSections:sections withRowAnimation:self.rowAnimation];
+        [[self ft_updates] deleteSections:sections];
     }
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didChangeSections:(NSIndexSet *)sections
 {
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_tableView reloadSections:sections withRowAnimation:self.rowAnimation];
+        [[self ft_updates] changeSections:sections];
     }
 }
 
@@ -736,39 +813,37 @@
             [collapsedSections addIndex:newSection];
             _collapsedSections = collapsedSections;
         }
-        [_tableView moveSection:section toSection:newSection];
+        [[self ft_updates] moveSection:section toSection:newSection];
     }
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didInsertItemsAtIndexPaths:(NSArray *)indexPaths
 {
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_tableView insertRowsAtIndexPaths:indexPaths withRowAnimation:self.rowAnimation];
+        [[self ft_updates] insertItemsAtIndexPaths:indexPaths];
     }
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didDeleteItemsAtIndexPaths:(NSArray *)indexPaths
 {
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_tableView deleteRowsAtIndexPaths:indexPaths withRowAnimation:self.rowAnimation];
+        [[self ft_updates] deleteItemsAtIndexPaths:indexPaths];
     }
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didChangeItemsAtIndexPaths:(NSArray *)indexPaths
 {
-    if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource && !_shouldSkipReloadOfUpdatedItems) {
-        [_tableView reloadRowsAtIndexPaths:indexPaths withRowAnimation:self.rowAnimation];
+    // Changes are also recorded, if updated items are not reloaded,
+    // to detect moved items, which have to be reconfigured.
+    if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
+        [[self ft_updates] changeItemsAtIndexPaths:indexPaths];
     }
 }
 
 - (void)dataSource:(id<FTDataSource>)dataSource didMoveItemAtIndexPath:(NSIndexPath *)indexPath toIndexPath:(NSIndexPath *)newIndexPath
 {
     if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource) {
-        [_tableView moveRowAtIndexPath:indexPath toIndexPath:newIndexPath];
-
-        if (self.shouldSkipReloadOfUpdatedItems == NO && self.reloadMovedItems == YES) {
-            [_indexPathsOfMovedItemsToReload addObject:newIndexPath];
-        }
+        [[self ft_updates] moveItemAtIndexPath:indexPath toIndexPath:newIndexPath];
     }
 }
 
@@ -784,7 +859,7 @@
                 [tableViewIndexPaths addObject:tableViewIndexPath];
             }
         }
-        [_tableView insertRowsAtIndexPaths:tableViewIndexPaths withRowAnimation:UITableViewRowAnimationAutomatic];
+        [[self ft_updates] insertItemsAtIndexPaths:tableViewIndexPaths];
     }
 }
 
@@ -798,13 +873,13 @@
                 [tableViewIndexPaths addObject:tableViewIndexPath];
             }
         }
-        [_tableView deleteRowsAtIndexPaths:tableViewIndexPaths withRowAnimation:UITableViewRowAnimationAutomatic];
+        [[self ft_updates] deleteItemsAtIndexPaths:tableViewIndexPaths];
     }
 }
 
 - (void)dataSource:(id<FTFutureItemsDataSource>)dataSource didChangeFutureItemsAtIndexPaths:(NSArray *)indexPaths
 {
-    if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource && !_shouldSkipReloadOfUpdatedItems && self.editing == YES) {
+    if (_isInUserDrivenChangeCallCount == 0 && dataSource == _dataSource && self.editing == YES) {
         NSMutableArray *tableViewIndexPaths = [[NSMutableArray alloc] init];
         for (NSIndexPath *indexPath in indexPaths) {
             NSIndexPath *tableViewIndexPath = [self tableViewIndexPathForFutureItemIndexPath:indexPath];
@@ -812,7 +887,7 @@
                 [tableViewIndexPaths addObject:tableViewIndexPath];
             }
         }
-        [_tableView reloadRowsAtIndexPaths:tableViewIndexPaths withRowAnimation:UITableViewRowAnimationAutomatic];
+        [[self ft_updates] changeItemsAtIndexPaths:tableViewIndexPaths];
     }
 }
 
@@ -822,14 +897,110 @@
         NSIndexPath *tableViewIndexPath = [self tableViewIndexPathForFutureItemIndexPath:indexPath];
         NSIndexPath *newTableViewIndexPath = [self tableViewIndexPathForFutureItemIndexPath:newIndexPath];
         if (tableViewIndexPath && newTableViewIndexPath) {
-            [_tableView moveRowAtIndexPath:tableViewIndexPath
-                               toIndexPath:newTableViewIndexPath];
+            [[self ft_updates] moveItemAtIndexPath:tableViewIndexPath toIndexPath:newTableViewIndexPath];
+        }
+    }
+}
 
-            if (!_shouldSkipReloadOfUpdatedItems && _reloadMovedItems) {
-                [_indexPathsOfMovedItemsToReload addObject:newTableViewIndexPath];
-            }
+#pragma mark Updates
+
+- (FTUpdateAccumulator *)ft_updates
+{
+    if (_updates == nil) {
+        // The changes are relative to the state, the table view is currently displaying.
+        NSInteger numberOfSections = [_tableView numberOfSections];
+        NSMutableArray *numberOfItemsInSections = [[NSMutableArray alloc] initWithCapacity:numberOfSections];
+        for (NSInteger section = 0; section < numberOfSections; section++) {
+            [numberOfItemsInSections addObject:@([_tableView numberOfRowsInSection:section])];
+        }
+        _updates = [[FTUpdateAccumulator alloc] initWithNumberOfItemsInSections:numberOfItemsInSections];
+    }
+    return _updates;
+}
+
+- (void)ft_performUpdates:(FTUpdateAccumulator *)updates
+{
+    if (updates.requiresReload) {
+        [_tableView reloadData];
+        return;
+    }
+
+    FTChangeSet *changeSet = updates.changeSet;
+    if ([changeSet isEmpty]) {
+        return;
+    }
+
+    NSMutableArray *movedItems = [[NSMutableArray alloc] init];
+
+    [_tableView beginUpdates];
+
+    [_tableView deleteSections:changeSet.deletedSections withRowAnimation:self.rowAnimation];
+    [_tableView insertSections:changeSet.insertedSections withRowAnimation:self.rowAnimation];
+    [_tableView reloadSections:changeSet.changedSections withRowAnimation:self.rowAnimation];
+
+    [changeSet enumerateSectionMovesUsingBlock:^(NSUInteger section, NSUInteger newSection, BOOL *stop) {
+        [_tableView moveSection:section toSection:newSection];
+    }];
+
+    [changeSet enumerateInsertedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [_tableView insertRowsAtIndexPaths:FTTableViewAdapterIndexPaths(section, items) withRowAnimation:self.rowAnimation];
+    }];
+
+    [changeSet enumerateDeletedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+        [_tableView deleteRowsAtIndexPaths:FTTableViewAdapterIndexPaths(section, items) withRowAnimation:self.rowAnimation];
+    }];
+
+    if (self.shouldSkipReloadOfUpdatedItems == NO) {
+        [changeSet enumerateChangedItemsUsingBlock:^(NSUInteger section, NSIndexSet *items, BOOL *stop) {
+            [_tableView reloadRowsAtIndexPaths:FTTableViewAdapterIndexPaths(section, items) withRowAnimation:self.rowAnimation];
+        }];
+    }
+
+    [changeSet enumerateItemMovesUsingBlock:^(NSIndexPath *indexPath, NSIndexPath *newIndexPath, BOOL *stop) {
+        [_tableView moveRowAtIndexPath:indexPath toIndexPath:newIndexPath];
+        [movedItems addObject:newIndexPath];
+    }];
+
+    [_tableView endUpdates];
+
+    if (self.shouldSkipReloadOfUpdatedItems == NO) {
+        [self ft_reconfigureRowsAtIndexPaths:self.reloadMovedItems ? movedItems : updates.movedItemsToReload];
+    }
+}
+
+- (void)ft_reconfigureRowsAtIndexPaths:(NSArray *)indexPaths
+{
+    // Moved rows can not be reloaded in the same batch. Instead of a second
+    // batch, the visible cells are prepared again, if the reuse identifier
+    // did not change. Cells, which are not visible, are prepared on display.
+
+    NSMutableArray *indexPathsToReload = [[NSMutableArray alloc] init];
+
+    for (NSIndexPath *indexPath in indexPaths) {
+        UITableViewCell *cell = [_tableView cellForRowAtIndexPath:indexPath];
+        if (cell == nil) {
+            continue;
+        }
+
+        __block BOOL prepared = NO;
+        [self rowPreperationForItemAtIndexPath:indexPath
+                                     withBlock:^(NSString *reuseIdentifier, FTTableViewAdapterCellPrepareBlock prepareBlock, id item) {
+                                         if ([reuseIdentifier isEqualToString:cell.reuseIdentifier]) {
+                                             if (prepareBlock) {
+                                                 prepareBlock(cell, item, indexPath, self.dataSource);
+                                             }
+                                             prepared = YES;
+                                         }
+                                     }];
+
+        if (prepared == NO) {
+            [indexPathsToReload addObject:indexPath];
         }
     }
+
+    if ([indexPathsToReload count] > 0) {
+        [_tableView reloadRowsAtIndexPaths:indexPathsToReload withRowAnimation:UITableViewRowAnimationNone];
+    }
 }
 
 #pragma mark -
@@ -859,23 +1030,13 @@
 
 @end
 
-#pragma mark -
-
-@implementation FTTableViewAdapterPreperationHandler
-
-#pragma mark Life-cycle
+#pragma mark - Index Paths
 
-- (instancetype)initWithPredicate:(NSPredicate *)predicate
-                  reuseIdentifier:(NSString *)reuseIdentifier
-                            block:(id)block
+static NSArray *FTTableViewAdapterIndexPaths(NSUInteger section, NSIndexSet *items)
 {
-    self = [super init];
-    if (self) {
-        _predicate = predicate;
-        _reuseIdentifier = reuseIdentifier;
-        _block = block;
-    }
-    return self;
+    NSMutableArray *indexPaths = [[NSMutableArray alloc] initWithCapacity:[items count]];
+    [items enumerateIndexesUsingBlock:^(NSUInteger item, BOOL *stop) {
+        [indexPaths addObject:[NSIndexPath indexPathForRow:item inSection:section]];
+    }];
+    return indexPaths;
 }
-
-@end